@@ -0,0 +1,282 @@
+// Measures passing event payloads through Anys, the way an event
+// channel forwards them from hop to hop.
+//
+// Two payloads are used: a sequence of Anys holding strings, doubles,
+// sequences of doubles and nested Anys, and a plain sequence of
+// strings. For each payload, an event is marshalled into a memory
+// stream and forwarded through a number of hops, each unmarshalling
+// the Any from the previous hop's stream and marshalling it into the
+// next one. The Any the payload was first inserted into is also copied
+// once for each of the same number of consumers, and extraction is
+// timed with the matching type and with a different one. Rates are in
+// events per second.
+//
+// Before timing anything, the event written by the last hop is checked
+// against the first one for size, and the payload extracted from it is
+// checked against the original.
+//
+// usage: anyForward [-secs n] [-hops n] [-fields n] [ORB options]
+
+#include <omniORB4/CORBA.h>
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static double secs   = 0.5;
+static int    hops   = 4;
+static int    fields = 16;
+
+
+//
+// Test data
+//
+
+static void fill(CORBA::AnySeq& seq)
+{
+  seq.length(fields);
+  for (int i = 0; i < fields; i++) {
+    switch (i % 4) {
+    case 0:
+      seq[i] <<= ("field " + to_string(i)).c_str();
+      break;
+    case 1:
+      seq[i] <<= (CORBA::Double)(i * 1.25);
+      break;
+    case 2:
+      {
+        CORBA::DoubleSeq d(16);
+        d.length(16);
+        for (CORBA::ULong j = 0; j < 16; j++)
+          d[j] = i + j * 0.5;
+        seq[i] <<= d;
+        break;
+      }
+    case 3:
+      {
+        CORBA::StringSeq s(4);
+        s.length(4);
+        for (CORBA::ULong j = 0; j < 4; j++)
+          s[j] = ("nested " + to_string(i) + "." + to_string(j)).c_str();
+        CORBA::Any nested;
+        nested <<= s;
+        seq[i] <<= nested;
+        break;
+      }
+    }
+  }
+}
+
+static void fill(CORBA::StringSeq& seq)
+{
+  seq.length(fields);
+  for (int i = 0; i < fields; i++)
+    seq[i] = ("string field " + to_string(i)).c_str();
+}
+
+static bool operator==(const CORBA::Any& a, const CORBA::Any& b);
+
+static bool operator==(const CORBA::AnySeq& a, const CORBA::AnySeq& b)
+{
+  if (a.length() != b.length())
+    return false;
+  for (CORBA::ULong i = 0; i < a.length(); i++)
+    if (!(a[i] == b[i]))
+      return false;
+  return true;
+}
+
+static bool operator==(const CORBA::StringSeq& a, const CORBA::StringSeq& b)
+{
+  if (a.length() != b.length())
+    return false;
+  for (CORBA::ULong i = 0; i < a.length(); i++)
+    if (strcmp(a[i], b[i]))
+      return false;
+  return true;
+}
+
+static bool operator==(const CORBA::Any& a, const CORBA::Any& b)
+{
+  CORBA::TypeCode_var ta = a.type();
+  CORBA::TypeCode_var tb = b.type();
+  if (!ta->equivalent(tb))
+    return false;
+
+  const char*              sa;
+  const char*              sb;
+  CORBA::Double            da, db;
+  const CORBA::DoubleSeq*  dsa;
+  const CORBA::DoubleSeq*  dsb;
+  const CORBA::StringSeq*  ssa;
+  const CORBA::StringSeq*  ssb;
+  const CORBA::Any*        aa;
+  const CORBA::Any*        ab;
+
+  if ((a >>= sa) && (b >>= sb))
+    return !strcmp(sa, sb);
+  if ((a >>= da) && (b >>= db))
+    return da == db;
+  if ((a >>= dsa) && (b >>= dsb)) {
+    if (dsa->length() != dsb->length())
+      return false;
+    for (CORBA::ULong i = 0; i < dsa->length(); i++)
+      if ((*dsa)[i] != (*dsb)[i])
+        return false;
+    return true;
+  }
+  if ((a >>= ssa) && (b >>= ssb))
+    return *ssa == *ssb;
+  if ((a >>= aa) && (b >>= ab))
+    return *aa == *ab;
+  return false;
+}
+
+
+//
+// Timing
+//
+
+// Runs f repeatedly for a while, and returns calls per second.
+static double rate(const function<void()>& f)
+{
+  typedef chrono::steady_clock Clock;
+
+  long       n     = 0;
+  auto       start = Clock::now();
+  double     elapsed;
+  do {
+    for (int i = 0; i < 10; i++)
+      f();
+    n += 10;
+    elapsed = chrono::duration<double>(Clock::now() - start).count();
+  } while (elapsed < secs);
+
+  return n / elapsed;
+}
+
+static void report(const char* payload, const char* op, double r)
+{
+  cout << payload << "\t" << op << "\t" << r << endl;
+}
+
+static void fail(const string& what)
+{
+  cerr << "Check failed: " << what << endl;
+  exit(1);
+}
+
+// Forwards the event in streams[0] through each of the others.
+static void forward(vector<cdrMemoryStream>& streams)
+{
+  for (size_t i = 1; i < streams.size(); i++) {
+    CORBA::Any a;
+    streams[i - 1].rewindInputPtr();
+    a <<= streams[i - 1];
+    streams[i].rewindPtrs();
+    a >>= streams[i];
+  }
+}
+
+template <class Seq, class Other>
+static void measure(const char* payload, const Seq& seq)
+{
+  vector<cdrMemoryStream> streams(hops + 1);
+
+  CORBA::Any event;
+  event <<= seq;
+  event >>= streams[0];
+
+  forward(streams);
+
+  cdrMemoryStream& first = streams[0];
+  cdrMemoryStream& last  = streams[hops];
+  if (first.bufSize() != last.bufSize())
+    fail(string(payload) + " forwarded with a different size");
+
+  CORBA::Any received;
+  last.rewindInputPtr();
+  received <<= last;
+
+  const Seq* back;
+  if (!(received >>= back) || !(*back == seq))
+    fail(string(payload) + " changed on the way");
+
+  report(payload, "forward", rate([&]() {
+    forward(streams);
+  }));
+
+  // The same event copied for each consumer.
+  report(payload, "fanout", rate([&]() {
+    for (int i = 0; i < hops; i++) {
+      CORBA::Any consumer(event);
+    }
+  }));
+
+  report(payload, "extract", rate([&]() {
+    CORBA::Any a;
+    last.rewindInputPtr();
+    a <<= last;
+    const Seq* s;
+    a >>= s;
+  }));
+
+  report(payload, "mismatch", rate([&]() {
+    const Other* o;
+    if (received >>= o)
+      fail(string(payload) + " extracted as the wrong type");
+  }));
+}
+
+
+int main(int argc, char** argv)
+{
+  CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-secs" && i + 1 < argc) {
+      secs = atof(argv[++i]);
+    }
+    else if (arg == "-hops" && i + 1 < argc) {
+      hops = atoi(argv[++i]);
+    }
+    else if (arg == "-fields" && i + 1 < argc) {
+      fields = atoi(argv[++i]);
+    }
+    else {
+      cerr << "usage: anyForward [-secs n] [-hops n] [-fields n] "
+           << "[ORB options]" << endl;
+      return 1;
+    }
+  }
+  if (hops < 1)
+    hops = 1;
+  if (fields < 4)
+    fields = 4;
+
+  int rc = 0;
+  try {
+    CORBA::AnySeq    anys;
+    CORBA::StringSeq strings;
+    fill(anys);
+    fill(strings);
+
+    cout << "# payload\top\tper_sec" << endl;
+
+    measure<CORBA::AnySeq, CORBA::StringSeq>("AnySeq", anys);
+    measure<CORBA::StringSeq, CORBA::AnySeq>("StringSeq", strings);
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  orb->destroy();
+  return rc;
+}
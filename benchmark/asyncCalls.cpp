@@ -0,0 +1,261 @@
+// Measures the call rate one client thread gets from a slow server,
+// calling it synchronously and asynchronously.
+//
+// A Bench::Store server is forked, which sleeps for a fixed time before
+// answering each fetch() call. The client calls it from one thread for a
+// while, first with the normal synchronous stub, so that one call is in
+// flight at a time, and then with the sendc_fetch() stub generated by
+// omniidl -Wbami, keeping a window of W calls in flight. In "future"
+// mode the thread waits for the oldest call with get() before sending
+// the next one; in "handler" mode the replies are collected by a
+// completion handler, and the thread only sends calls while the window
+// is not full.
+//
+// Every reply is checked against the id it was sent with. The program
+// fails if any does not match or any call raises an exception.
+//
+// usage: asyncCalls [-secs n] [-delay us] [-window n,n,...] [ORB options]
+
+#include "samples.h"
+#include "benchServer.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class StoreServer : public POA_Bench::Store
+{
+public:
+  StoreServer(long delay) : pd_delay(delay) {}
+
+  Bench::Sample fetch(CORBA::Long id)
+  {
+    this_thread::sleep_for(chrono::microseconds(pd_delay));
+
+    Bench::Sample s;
+    memset(&s, 0, sizeof(s));
+    s.id = id;
+    s.value[0] = id * 0.5;
+    return s;
+  }
+
+private:
+  long pd_delay;
+};
+
+
+typedef chrono::steady_clock Clock;
+
+static double      secs = 2;
+static atomic<int> failed(0);
+
+static void report(const char* mode, int window, long calls,
+                   Clock::time_point start)
+{
+  double elapsed = chrono::duration<double>(Clock::now() - start).count();
+  cout << mode << "\t" << window << "\t" << calls / elapsed << endl;
+}
+
+
+static void measureSync(Bench::Store_ptr store)
+{
+  long calls = 0;
+  auto start = Clock::now();
+  auto end   = start + chrono::duration<double>(secs);
+
+  while (Clock::now() < end) {
+    try {
+      Bench::Sample s = store->fetch(calls);
+      if (s.id != calls)
+        failed++;
+    }
+    catch (CORBA::Exception&) {
+      failed++;
+    }
+    calls++;
+  }
+  report("sync", 1, calls, start);
+}
+
+
+static void measureFuture(Bench::Store_ptr store, int window)
+{
+  deque<pair<CORBA::Long, Bench::AMI_Store_fetch_var> > inFlight;
+
+  long calls = 0;
+  auto start = Clock::now();
+  auto end   = start + chrono::duration<double>(secs);
+
+  while (Clock::now() < end || !inFlight.empty()) {
+    if ((int)inFlight.size() == window || Clock::now() >= end) {
+      try {
+        Bench::Sample s = inFlight.front().second->get();
+        if (s.id != inFlight.front().first)
+          failed++;
+      }
+      catch (CORBA::Exception&) {
+        failed++;
+      }
+      inFlight.pop_front();
+      calls++;
+    }
+    else {
+      CORBA::Long id = calls + inFlight.size();
+      inFlight.emplace_back(id, store->sendc_fetch(0, id));
+    }
+  }
+  report("future", window, calls, start);
+}
+
+
+// Collects replies, and tells the sending thread when there is room in
+// the window for another call.
+class FetchHandler : public omniAsyncCallback
+{
+public:
+  FetchHandler() : pd_inFlight(0), pd_completed(0) {}
+
+  void completed(omniAsyncCall* call)
+  {
+    Bench::AMI_Store_fetch* fetch = (Bench::AMI_Store_fetch*)call;
+    try {
+      Bench::Sample s = fetch->get();
+      if (s.value[0] != s.id * 0.5)
+        failed++;
+    }
+    catch (CORBA::Exception&) {
+      failed++;
+    }
+    fetch->_remove_ref();
+
+    lock_guard<mutex> sync(pd_lock);
+    pd_inFlight--;
+    pd_completed++;
+    pd_cond.notify_one();
+  }
+
+  // Waits until fewer than <window> calls are in flight, and counts one
+  // more.
+  void acquire(int window)
+  {
+    unique_lock<mutex> sync(pd_lock);
+    pd_cond.wait(sync, [&]() { return pd_inFlight < window; });
+    pd_inFlight++;
+  }
+
+  long drain()
+  {
+    unique_lock<mutex> sync(pd_lock);
+    pd_cond.wait(sync, [&]() { return pd_inFlight == 0; });
+    return pd_completed;
+  }
+
+private:
+  mutex              pd_lock;
+  condition_variable pd_cond;
+  int                pd_inFlight;
+  long               pd_completed;
+};
+
+static void measureHandler(Bench::Store_ptr store, int window)
+{
+  FetchHandler handler;
+
+  long sent  = 0;
+  auto start = Clock::now();
+  auto end   = start + chrono::duration<double>(secs);
+
+  while (Clock::now() < end) {
+    handler.acquire(window);
+    // The handler releases the reference sendc_fetch() returns.
+    store->sendc_fetch(&handler, sent++);
+  }
+  long calls = handler.drain();
+  if (calls != sent)
+    failed++;
+
+  report("handler", window, calls, start);
+}
+
+
+int main(int argc, char** argv)
+{
+  long        delay = 1000;
+  vector<int> windows;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-delay") && i + 1 < argc)
+      delay = atol(argv[i + 1]);
+  }
+
+  // The server is forked before this process starts any ORB threads.
+  int   iorPipe;
+  pid_t pid = BenchServer::startServer(
+    "asyncCallsServer", { "-ORBendPoint", "giop:tcp:127.0.0.1:" },
+    [=]() { return new StoreServer(delay); }, iorPipe);
+
+  int rc = 0;
+  try {
+    CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+    for (int i = 1; i < argc; i++) {
+      string arg = argv[i];
+      if (arg == "-secs" && i + 1 < argc) {
+        secs = atof(argv[++i]);
+      }
+      else if (arg == "-delay" && i + 1 < argc) {
+        ++i;
+      }
+      else if (arg == "-window" && i + 1 < argc) {
+        istringstream in(argv[++i]);
+        string n;
+        while (getline(in, n, ','))
+          windows.push_back(stoi(n));
+      }
+      else {
+        cerr << "usage: asyncCalls [-secs n] [-delay us] [-window n,n,...] "
+             << "[ORB options]" << endl;
+        rc = 1;
+      }
+    }
+    if (windows.empty())
+      windows = { 1, 8, 64 };
+
+    if (!rc) {
+      string ior = BenchServer::readLine(iorPipe);
+      CORBA::Object_var obj   = orb->string_to_object(ior.c_str());
+      Bench::Store_var  store = Bench::Store::_narrow(obj);
+
+      cout << "# mode\twindow\tcalls_per_sec" << endl;
+
+      measureSync(store);
+      for (int w : windows)
+        measureFuture(store, w);
+      for (int w : windows)
+        measureHandler(store, w);
+
+      if (failed) {
+        cerr << failed << " calls failed" << endl;
+        rc = 1;
+      }
+    }
+    orb->destroy();
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  BenchServer::stopServer(pid);
+  return rc;
+}
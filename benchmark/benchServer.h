@@ -0,0 +1,139 @@
+// Forked servers for the benchmarks.
+//
+// A benchmark that measures calls to another process forks the server
+// before it starts any ORB threads of its own, since only the forking
+// thread survives in the child. The server tells the client it is
+// ready by writing a line, usually its IOR, to a pipe, and is stopped
+// with SIGTERM once the benchmark is done.
+//
+// startServer() covers the usual case of a single servant activated in
+// the RootPOA. Servers that need more set up use forkServer() and
+// serverORB() themselves.
+
+#ifndef BENCH_SERVER_H
+#define BENCH_SERVER_H
+
+#include <omniORB4/CORBA.h>
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace BenchServer {
+
+// Forks a child process which runs <body> with the write end of a
+// pipe and then exits. Returns the child's pid, and sets <readFd> to
+// the read end of the pipe.
+inline pid_t forkServer(const std::function<void(int)>& body, int& readFd)
+{
+  int fds[2];
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    exit(1);
+  }
+
+  pid_t pid = fork();
+  if (pid != 0) {
+    close(fds[1]);
+    readFd = fds[0];
+    return pid;
+  }
+  close(fds[0]);
+
+  try {
+    body(fds[1]);
+  }
+  catch (CORBA::Exception& ex) {
+    std::cerr << "Server caught CORBA::" << ex._name() << std::endl;
+  }
+  _exit(0);
+}
+
+
+// Initialises an ORB in a forked server, with <name> as the program
+// name followed by <orbArgs>.
+inline CORBA::ORB_ptr serverORB(const char* name,
+                                std::vector<std::string> orbArgs)
+{
+  orbArgs.insert(orbArgs.begin(), name);
+
+  std::vector<char*> argv;
+  for (auto& a : orbArgs)
+    argv.push_back(&a[0]);
+  int argc = argv.size();
+  argv.push_back(0);
+
+  char** av = argv.data();
+  return CORBA::ORB_init(argc, av);
+}
+
+
+// Writes <line> and a newline to <fd>, and closes it.
+inline void writeLine(int fd, std::string line)
+{
+  line += "\n";
+  if (write(fd, line.data(), line.size()) != (ssize_t)line.size())
+    _exit(1);
+  close(fd);
+}
+
+
+// Reads a line, without its newline, from <fd>, and closes it.
+inline std::string readLine(int fd)
+{
+  std::string line;
+  char        c;
+  while (read(fd, &c, 1) == 1 && c != '\n')
+    line += c;
+  close(fd);
+  return line;
+}
+
+
+// Runs a server in a child process, with the servant <makeServant>
+// returns activated in its RootPOA, and writes the servant's IOR to
+// the pipe returned in <iorPipe>. Read it with readLine().
+inline pid_t startServer(const char* name,
+                         const std::vector<std::string>& orbArgs,
+                         const std::function<PortableServer::Servant()>&
+                           makeServant,
+                         int& iorPipe)
+{
+  return forkServer([&](int fd) {
+    CORBA::ORB_var          orb = serverORB(name, orbArgs);
+    CORBA::Object_var       obj = orb->resolve_initial_references("RootPOA");
+    PortableServer::POA_var poa = PortableServer::POA::_narrow(obj);
+
+    PortableServer::ServantBase_var servant = makeServant();
+    PortableServer::ObjectId_var id = poa->activate_object(servant);
+
+    obj = poa->id_to_reference(id);
+    CORBA::String_var sior(orb->object_to_string(obj));
+
+    PortableServer::POAManager_var pman = poa->the_POAManager();
+    pman->activate();
+
+    writeLine(fd, (const char*)sior);
+
+    orb->run();
+  }, iorPipe);
+}
+
+
+// Stops a server started by forkServer() or startServer().
+inline void stopServer(pid_t pid)
+{
+  kill(pid, SIGTERM);
+  waitpid(pid, 0, 0);
+}
+
+}
+
+#endif
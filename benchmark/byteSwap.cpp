@@ -0,0 +1,208 @@
+// Measures unmarshalling of sequences of numbers in both byte orders.
+//
+// A sequence is marshalled into a memory stream in this machine's byte
+// order and into one in the other byte order, the way it arrives from
+// a peer of the other endianness, and each is unmarshalled. Each is
+// also unmarshalled by swapping one element at a time, the way the ORB
+// used to, for comparison. The sequence is then sent through an Any in
+// the same byte orders, which copies it using its TypeCode. Rates are
+// in MB of sequence data per second.
+//
+// Before timing anything, every unmarshalled sequence is checked
+// against the original.
+//
+// usage: byteSwap [-secs n] [-length n] [ORB options]
+
+#include <omniORB4/CORBA.h>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+using namespace std;
+
+static double secs   = 0.5;
+static size_t length = 10000;
+
+
+//
+// One element at a time, as the sequence templates used to swap
+//
+
+template <class T>
+static T swapOne(T v)
+{
+  unsigned char* p = (unsigned char*)&v;
+  for (size_t i = 0; i < sizeof(T) / 2; i++) {
+    unsigned char t = p[i];
+    p[i] = p[sizeof(T) - 1 - i];
+    p[sizeof(T) - 1 - i] = t;
+  }
+  return v;
+}
+
+template <class Seq>
+static void unmarshalScalar(Seq& seq, cdrStream& s)
+{
+  typedef typename remove_reference<decltype(seq[0])>::type T;
+
+  CORBA::ULong l;
+  l <<= s;
+  seq.length(l);
+  s.get_octet_array((CORBA::Octet*)seq.get_buffer(), l * sizeof(T),
+                    (omni::alignment_t)sizeof(T));
+  if (s.unmarshal_byte_swap()) {
+    T* p = seq.get_buffer();
+    for (CORBA::ULong i = 0; i < l; i++)
+      p[i] = swapOne(p[i]);
+  }
+}
+
+
+//
+// Timing
+//
+
+// Runs f repeatedly for a while, and returns MB per second.
+static double rate(size_t bytes, const function<void()>& f)
+{
+  typedef chrono::steady_clock Clock;
+
+  long       n     = 0;
+  auto       start = Clock::now();
+  double     elapsed;
+  do {
+    for (int i = 0; i < 10; i++)
+      f();
+    n += 10;
+    elapsed = chrono::duration<double>(Clock::now() - start).count();
+  } while (elapsed < secs);
+
+  return bytes * n / elapsed / 1e6;
+}
+
+template <class Seq>
+static void check(const char* type, const char* order, const char* form,
+                  const Seq& a, const Seq& b)
+{
+  bool same = a.length() == b.length();
+  for (CORBA::ULong i = 0; same && i < a.length(); i++)
+    same = a[i] == b[i];
+
+  if (!same) {
+    cerr << type << " " << order << " " << form
+         << ": sequence changed in round trip" << endl;
+    exit(1);
+  }
+}
+
+template <class Seq>
+static void measure(const char* type, const Seq& seq)
+{
+  typedef typename remove_reference<decltype(seq[0])>::type T;
+  size_t bytes = seq.length() * sizeof(T);
+
+  for (int swap = 0; swap < 2; swap++) {
+    const char* order = swap ? "swapped" : "native";
+
+    cdrMemoryStream stream, anyStream;
+    if (swap) {
+      stream.setByteSwapFlag(!omni::myByteOrder);
+      anyStream.setByteSwapFlag(!omni::myByteOrder);
+    }
+    seq >>= stream;
+
+    CORBA::Any any;
+    any <<= seq;
+    any >>= anyStream;
+
+    // Check everything before timing it.
+    Seq        back;
+    const Seq* fromAny;
+
+    back <<= stream;
+    check(type, order, "sequence", seq, back);
+
+    stream.rewindInputPtr();
+    unmarshalScalar(back, stream);
+    check(type, order, "scalar", seq, back);
+
+    any <<= anyStream;
+    if (!(any >>= fromAny)) {
+      cerr << type << " " << order << ": Any extraction failed" << endl;
+      exit(1);
+    }
+    check(type, order, "any", seq, *fromAny);
+
+    double orb = rate(bytes, [&]() {
+      stream.rewindInputPtr();
+      back <<= stream;
+    });
+    double scalar = rate(bytes, [&]() {
+      stream.rewindInputPtr();
+      unmarshalScalar(back, stream);
+    });
+    double anyRate = rate(bytes, [&]() {
+      anyStream.rewindInputPtr();
+      any <<= anyStream;
+    });
+
+    cout << type << "\t" << order << "\t" << orb << "\t" << scalar
+         << "\t" << orb / scalar << "\t" << anyRate << endl;
+  }
+}
+
+
+template <class Seq, class T>
+static Seq makeSeq(T start, T step)
+{
+  Seq seq;
+  seq.length(length);
+  T v = start;
+  for (CORBA::ULong i = 0; i < length; i++, v += step)
+    seq[i] = v;
+  return seq;
+}
+
+int main(int argc, char** argv)
+{
+  CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-secs" && i + 1 < argc) {
+      secs = atof(argv[++i]);
+    }
+    else if (arg == "-length" && i + 1 < argc) {
+      length = atol(argv[++i]);
+    }
+    else {
+      cerr << "usage: byteSwap [-secs n] [-length n] [ORB options]" << endl;
+      return 1;
+    }
+  }
+
+  int rc = 0;
+  try {
+    cout << "# type\torder\torb_MB_per_sec\tscalar_MB_per_sec\tspeedup"
+         << "\tany_MB_per_sec" << endl;
+
+    measure("short",    makeSeq<CORBA::ShortSeq>(CORBA::Short(-3000),
+                                                  CORBA::Short(7)));
+    measure("long",     makeSeq<CORBA::LongSeq>(CORBA::Long(-100000),
+                                                 CORBA::Long(12345)));
+    measure("longlong", makeSeq<CORBA::LongLongSeq>(
+                          -(CORBA::LongLong(1) << 40), CORBA::LongLong(987654321)));
+    measure("double",   makeSeq<CORBA::DoubleSeq>(CORBA::Double(-1.5e9),
+                                                   CORBA::Double(3.25)));
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  orb->destroy();
+  return rc;
+}
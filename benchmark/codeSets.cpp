@@ -0,0 +1,427 @@
+// Measures string and wstring code set conversion.
+//
+// Strings are marshalled into and unmarshalled from a memory stream
+// with a given pair of native and transmission code sets, the same way
+// the ORB does for a call. Each conversion is also done one character
+// at a time on plain memory, the way the ORB used to, for comparison.
+// Rates are in MB of native text per second.
+//
+// The conversions are:
+//
+//   ISO-8859-1 / UTF-8   native Latin-1 strings sent as UTF-8
+//   UTF-8 / ISO-8859-1   native UTF-8 strings sent as Latin-1
+//   UTF-8 / UTF-8        no conversion; the one character at a time
+//                        version validates, so add -ORBvalidateUTF8 1
+//                        to compare like with like
+//   UTF-16 / UTF-16      wstrings
+//
+// each with all-ASCII text and with text that is partly not ASCII.
+//
+// usage: codeSets [-secs n] [-length n] [ORB options]
+
+#include <omniORB4/CORBA.h>
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using omni::omniCodeSet;
+
+typedef omniCodeSet::UniChar UniChar;
+
+static double secs   = 0.5;
+static size_t length = 1000;
+
+
+//
+// Test text
+//
+
+static const char* asciiWords[] = {
+  "lorem ", "ipsum ", "dolor ", "sit ", "amet, ", "consectetur ",
+  "adipiscing ", "elit. "
+};
+
+// Code points, mostly ASCII with some accented Latin-1.
+static vector<unsigned> latinText()
+{
+  static const unsigned accents[] = { 0xe9, 0xe8, 0xfc, 0xf1, 0xe5, 0xdf };
+  vector<unsigned> t;
+  for (size_t w = 0; t.size() < length; w++) {
+    for (const char* p = asciiWords[w % 8]; *p; p++)
+      t.push_back((unsigned char)*p);
+    t.push_back(accents[w % 6]);
+  }
+  t.resize(length);
+  return t;
+}
+
+static vector<unsigned> asciiText()
+{
+  vector<unsigned> t;
+  for (size_t w = 0; t.size() < length; w++)
+    for (const char* p = asciiWords[w % 8]; *p; p++)
+      t.push_back((unsigned char)*p);
+  t.resize(length);
+  return t;
+}
+
+// Some ASCII, some CJK.
+static vector<unsigned> cjkText()
+{
+  vector<unsigned> t;
+  for (size_t w = 0; t.size() < length; w++) {
+    for (const char* p = asciiWords[w % 8]; *p; p++)
+      t.push_back((unsigned char)*p);
+    t.push_back(0x4e00 + (w * 37) % 0x5000);
+    t.push_back(0x4e00 + (w * 91) % 0x5000);
+  }
+  t.resize(length);
+  return t;
+}
+
+static string toLatin1(const vector<unsigned>& t)
+{
+  string s;
+  for (unsigned c : t)
+    s += (char)c;
+  return s;
+}
+
+static string toUTF8(const vector<unsigned>& t)
+{
+  string s;
+  for (unsigned c : t) {
+    if (c < 0x80) {
+      s += (char)c;
+    }
+    else if (c < 0x800) {
+      s += (char)(0xc0 | (c >> 6));
+      s += (char)(0x80 | (c & 0x3f));
+    }
+    else {
+      s += (char)(0xe0 | (c >> 12));
+      s += (char)(0x80 | ((c >> 6) & 0x3f));
+      s += (char)(0x80 | (c & 0x3f));
+    }
+  }
+  return s;
+}
+
+static wstring toWide(const vector<unsigned>& t)
+{
+  wstring s;
+  for (unsigned c : t)
+    s += (wchar_t)c;
+  return s;
+}
+
+
+//
+// One character at a time conversions, as the ORB used to do them
+//
+
+static void latin1ToUTF8(const char* s, vector<char>& b)
+{
+  b.clear();
+  while (*s) {
+    unsigned char c = *s++;
+    if (c < 0x80) {
+      b.push_back(c);
+    }
+    else {
+      b.push_back(0xc0 | (c >> 6));
+      b.push_back(0x80 | (c & 0x3f));
+    }
+  }
+  b.push_back(0);
+}
+
+static void utf8ToLatin1(const char* s, vector<char>& b)
+{
+  b.clear();
+  while (*s) {
+    unsigned char c = *s++;
+    unsigned      u = c;
+    if (c >= 0xc0)
+      u = ((c & 0x1f) << 6) | (*s++ & 0x3f);
+    b.push_back(u);
+  }
+  b.push_back(0);
+}
+
+static void utf8ToUTF16(const char* s, vector<UniChar>& b)
+{
+  b.clear();
+  while (*s) {
+    unsigned char c = *s++;
+    unsigned      u = c;
+    if (c >= 0xe0) {
+      u = (c & 0x0f) << 12;
+      u |= (*s++ & 0x3f) << 6;
+      u |= (*s++ & 0x3f);
+    }
+    else if (c >= 0xc0) {
+      u = ((c & 0x1f) << 6) | (*s++ & 0x3f);
+    }
+    b.push_back(u);
+  }
+  b.push_back(0);
+}
+
+static void utf16ToUTF8(const UniChar* us, vector<char>& b)
+{
+  b.clear();
+  for (; *us; us++) {
+    UniChar uc = *us;
+    if (uc < 0x80) {
+      b.push_back(uc);
+    }
+    else if (uc < 0x800) {
+      b.push_back(0xc0 | (uc >> 6));
+      b.push_back(0x80 | (uc & 0x3f));
+    }
+    else {
+      b.push_back(0xe0 | (uc >> 12));
+      b.push_back(0x80 | ((uc >> 6) & 0x3f));
+      b.push_back(0x80 | (uc & 0x3f));
+    }
+  }
+  b.push_back(0);
+}
+
+static void wideToUTF16(const wchar_t* ws, size_t len, vector<UniChar>& b)
+{
+  b.resize(len + 1);
+  for (size_t i = 0; i <= len; i++) {
+    if ((unsigned long)ws[i] > 0xffff)
+      throw CORBA::BAD_PARAM();
+    b[i] = ws[i];
+  }
+}
+
+static void utf16ToWide(const vector<UniChar>& us, vector<wchar_t>& b)
+{
+  b.resize(us.size());
+  for (size_t i = 0; i < us.size(); i++)
+    b[i] = us[i];
+}
+
+
+//
+// Timing
+//
+
+// Runs f repeatedly for a while, and returns MB of text per second.
+static double rate(size_t bytes, const function<void()>& f)
+{
+  typedef chrono::steady_clock Clock;
+
+  long       n     = 0;
+  auto       start = Clock::now();
+  double     elapsed;
+  do {
+    for (int i = 0; i < 100; i++)
+      f();
+    n += 100;
+    elapsed = chrono::duration<double>(Clock::now() - start).count();
+  } while (elapsed < secs);
+
+  return bytes * n / elapsed / 1e6;
+}
+
+static void report(const char* conv, const char* text, const char* op,
+		   double orb, double scalar)
+{
+  cout << conv << "\t" << text << "\t" << op << "\t"
+       << orb << "\t" << scalar << "\t" << orb / scalar << endl;
+}
+
+static GIOP::Version giop12 = { 1, 2 };
+
+
+static void measureString(const char* conv, const char* text,
+			  const char* ncsName, const char* tcsName,
+			  const string& str,
+			  void (*toWire)(const char*, vector<char>&),
+			  void (*fromWire)(const char*, vector<char>&))
+{
+  omniCodeSet::NCS_C* ncs = omniCodeSet::getNCS_C(ncsName);
+  omniCodeSet::TCS_C* tcs = omniCodeSet::getTCS_C(tcsName, giop12);
+  if (!ncs || !tcs) {
+    cerr << "Code set " << ncsName << " or " << tcsName << " not found"
+	 << endl;
+    exit(1);
+  }
+
+  cdrMemoryStream stream;
+  stream.TCS_C(tcs);
+
+  double orbOut = rate(str.size(), [&]() {
+    stream.rewindPtrs();
+    ncs->marshalString(stream, tcs, 0, str.size(), str.c_str());
+  });
+  double orbIn = rate(str.size(), [&]() {
+    stream.rewindInputPtr();
+    char* s;
+    ncs->unmarshalString(stream, tcs, 0, s);
+    CORBA::string_free(s);
+  });
+
+  stream.rewindInputPtr();
+  CORBA::String_var back;
+  ncs->unmarshalString(stream, tcs, 0, back.out());
+  if (str != back.in()) {
+    cerr << conv << " " << text << ": string changed in round trip" << endl;
+    exit(1);
+  }
+
+  vector<char> wire, native;
+  toWire(str.c_str(), wire);
+  double scalarOut = rate(str.size(), [&]() {
+    toWire(str.c_str(), wire);
+  });
+  double scalarIn = rate(str.size(), [&]() {
+    fromWire(&wire[0], native);
+  });
+
+  report(conv, text, "marshal",   orbOut, scalarOut);
+  report(conv, text, "unmarshal", orbIn,  scalarIn);
+}
+
+
+static void utf8ViaUTF16(const char* s, vector<char>& b)
+{
+  // UTF-8 native to Latin-1 on the wire went through UTF-16.
+  static vector<UniChar> u;
+  utf8ToUTF16(s, u);
+  b.clear();
+  for (UniChar c : u)
+    b.push_back(c);
+}
+
+static void latin1ViaUTF16(const char* s, vector<char>& b)
+{
+  static vector<UniChar> u;
+  u.clear();
+  for (; *s; s++)
+    u.push_back((unsigned char)*s);
+  u.push_back(0);
+  utf16ToUTF8(&u[0], b);
+}
+
+static void validateCopy(const char* s, vector<char>& b)
+{
+  // What -ORBvalidateUTF8 1 did, and a copy.
+  const char* p = s;
+  while (*p) {
+    unsigned char c = *p++;
+    int more = c < 0x80 ? 0 : c < 0xe0 ? 1 : c < 0xf0 ? 2 : 3;
+    for (; more; more--) {
+      if ((*p++ & 0xc0) != 0x80)
+	throw CORBA::DATA_CONVERSION();
+    }
+  }
+  b.assign(s, p + 1);
+}
+
+
+static void measureWString(const char* text, const wstring& str)
+{
+  omniCodeSet::NCS_W* ncs = omniCodeSet::getNCS_W("UTF-16");
+  omniCodeSet::TCS_W* tcs = omniCodeSet::getTCS_W("UTF-16", giop12);
+
+  cdrMemoryStream stream;
+  stream.TCS_W(tcs);
+
+  size_t bytes = str.size() * sizeof(wchar_t);
+
+  double orbOut = rate(bytes, [&]() {
+    stream.rewindPtrs();
+    ncs->marshalWString(stream, tcs, 0, str.size(), str.c_str());
+  });
+  double orbIn = rate(bytes, [&]() {
+    stream.rewindInputPtr();
+    CORBA::WChar* s;
+    ncs->unmarshalWString(stream, tcs, 0, s);
+    CORBA::wstring_free(s);
+  });
+
+  stream.rewindInputPtr();
+  CORBA::WString_var back;
+  ncs->unmarshalWString(stream, tcs, 0, back.out());
+  if (str != back.in()) {
+    cerr << "UTF-16 " << text << ": wstring changed in round trip" << endl;
+    exit(1);
+  }
+
+  vector<UniChar> u;
+  vector<wchar_t> w;
+  double scalarOut = rate(bytes, [&]() {
+    wideToUTF16(str.c_str(), str.size(), u);
+  });
+  double scalarIn = rate(bytes, [&]() {
+    utf16ToWide(u, w);
+  });
+
+  report("UTF-16/UTF-16", text, "marshal",   orbOut, scalarOut);
+  report("UTF-16/UTF-16", text, "unmarshal", orbIn,  scalarIn);
+}
+
+
+int main(int argc, char** argv)
+{
+  CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-secs" && i + 1 < argc) {
+      secs = atof(argv[++i]);
+    }
+    else if (arg == "-length" && i + 1 < argc) {
+      length = atol(argv[++i]);
+    }
+    else {
+      cerr << "usage: codeSets [-secs n] [-length n] [ORB options]" << endl;
+      return 1;
+    }
+  }
+
+  int rc = 0;
+  try {
+    vector<unsigned> ascii = asciiText(), latin = latinText(),
+                     cjk   = cjkText();
+
+    cout << "# conversion\ttext\top\torb_MB_per_sec\tscalar_MB_per_sec"
+	 << "\tspeedup" << endl;
+
+    measureString("ISO-8859-1/UTF-8", "ascii", "ISO-8859-1", "UTF-8",
+		  toLatin1(ascii), latin1ToUTF8, utf8ToLatin1);
+    measureString("ISO-8859-1/UTF-8", "latin", "ISO-8859-1", "UTF-8",
+		  toLatin1(latin), latin1ToUTF8, utf8ToLatin1);
+
+    measureString("UTF-8/ISO-8859-1", "ascii", "UTF-8", "ISO-8859-1",
+		  toUTF8(ascii), utf8ViaUTF16, latin1ViaUTF16);
+    measureString("UTF-8/ISO-8859-1", "latin", "UTF-8", "ISO-8859-1",
+		  toUTF8(latin), utf8ViaUTF16, latin1ViaUTF16);
+
+    measureString("UTF-8/UTF-8", "ascii", "UTF-8", "UTF-8",
+		  toUTF8(ascii), validateCopy, validateCopy);
+    measureString("UTF-8/UTF-8", "cjk", "UTF-8", "UTF-8",
+		  toUTF8(cjk), validateCopy, validateCopy);
+
+    measureWString("ascii", toWide(ascii));
+    measureWString("cjk",   toWide(cjk));
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  orb->destroy();
+  return rc;
+}
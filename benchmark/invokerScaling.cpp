@@ -0,0 +1,193 @@
+// Measures how thread pool dispatch scales with the number of threads
+// submitting work.
+//
+// The first part drives an omniAsyncInvoker directly: each of P producer
+// threads inserts AnyTime tasks that do nothing but count themselves,
+// and the rate at which tasks complete is reported.
+//
+// The second part forks an echo server in thread pool mode and runs T
+// client threads, each calling echoString in a loop over its own
+// connection, and reports the total call rate.
+//
+// usage: invokerScaling [-tasks n] [-secs n] [-threads n,n,...]
+//                       [ORB options]
+
+#include "echo.h"
+#include "benchServer.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class EchoServer : public POA_Echo
+{
+public:
+  virtual char* echoString(const char* mesg)
+  {
+    return CORBA::string_dup(mesg);
+  }
+};
+
+
+class CountTask : public omniTask
+{
+public:
+  CountTask(atomic<long>& done) : omniTask(omniTask::AnyTime), pd_done(done) {}
+
+  void execute()
+  {
+    pd_done++;
+    delete this;
+  }
+
+private:
+  atomic<long>& pd_done;
+};
+
+
+static void measureInvoker(int producers, long tasks)
+{
+  omniAsyncInvoker invoker(100);
+  atomic<long>     done(0);
+  long             perProducer = tasks / producers;
+  long             total       = perProducer * producers;
+
+  auto start = chrono::steady_clock::now();
+
+  vector<thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&]() {
+      for (long i = 0; i < perProducer; i++)
+        invoker.insert(new CountTask(done));
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+
+  while (done < total)
+    this_thread::yield();
+
+  auto   end  = chrono::steady_clock::now();
+  double secs = chrono::duration<double>(end - start).count();
+
+  cout << "invoker\t" << producers << "\t" << total / secs << endl;
+}
+
+
+static void measureServer(int clients, double secs, Echo_ptr e)
+{
+  atomic<bool> stop(false);
+  atomic<long> calls(0), errors(0);
+
+  vector<thread> threads;
+  for (int c = 0; c < clients; c++) {
+    threads.emplace_back([&]() {
+      CORBA::String_var mesg = CORBA::string_dup("ping");
+      long n = 0;
+      while (!stop) {
+        try {
+          CORBA::String_var r = e->echoString(mesg);
+          n++;
+        }
+        catch (CORBA::Exception&) {
+          errors++;
+        }
+      }
+      calls += n;
+    });
+  }
+  this_thread::sleep_for(chrono::duration<double>(secs));
+  stop = true;
+  for (auto& t : threads)
+    t.join();
+
+  cout << "server\t" << clients << "\t" << calls / secs;
+  if (errors)
+    cout << "\t(" << errors << " errors)";
+  cout << endl;
+}
+
+
+int main(int argc, char** argv)
+{
+  long           tasks = 1000000;
+  double         secs  = 3;
+  vector<int>    threadCounts;
+  vector<string> orbArgs;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-tasks" && i + 1 < argc) {
+      tasks = atol(argv[++i]);
+    }
+    else if (arg == "-secs" && i + 1 < argc) {
+      secs = atof(argv[++i]);
+    }
+    else if (arg == "-threads" && i + 1 < argc) {
+      istringstream in(argv[++i]);
+      string n;
+      while (getline(in, n, ','))
+        threadCounts.push_back(stoi(n));
+    }
+    else {
+      orbArgs.push_back(arg);
+    }
+  }
+  if (threadCounts.empty()) {
+    int ncpu = thread::hardware_concurrency();
+    for (int n = 1; n <= 2 * ncpu || n <= 4; n *= 2)
+      threadCounts.push_back(n);
+  }
+
+  // The server is forked before this process starts any ORB threads.
+  orbArgs.insert(orbArgs.begin(), {
+      "-ORBendPoint",                  "giop:tcp:127.0.0.1:",
+      "-ORBthreadPerConnectionPolicy", "0",
+    });
+
+  int   iorPipe;
+  pid_t pid = BenchServer::startServer(
+    "invokerScalingServer", orbArgs,
+    []() { return new EchoServer(); }, iorPipe);
+
+  int rc = 0;
+  try {
+    // Give every client thread its own connection.
+    const char* clientArgs[] = { "-ORBmaxGIOPConnectionPerServer", "1000" };
+    vector<char*> av(argv, argv + argc);
+    for (auto a : clientArgs)
+      av.push_back((char*)a);
+    int ac = av.size();
+    av.push_back(0);
+
+    char**         avp = av.data();
+    CORBA::ORB_var orb = CORBA::ORB_init(ac, avp);
+
+    cout << "# test\tthreads\tper_sec" << endl;
+
+    for (int n : threadCounts)
+      measureInvoker(n, tasks);
+
+    string ior = BenchServer::readLine(iorPipe);
+    CORBA::Object_var obj  = orb->string_to_object(ior.c_str());
+    Echo_var          echo = Echo::_narrow(obj);
+
+    for (int n : threadCounts)
+      measureServer(n, secs, echo);
+
+    orb->destroy();
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  BenchServer::stopServer(pid);
+  return rc;
+}
@@ -0,0 +1,311 @@
+// Measures calls to servants in the same process.
+//
+// Calls with no arguments and with a string are made through an
+// object reference, by one or more threads, and the same calls are
+// made as plain virtual calls on the servant for comparison. Run it
+// with and without -ORBfastLocalCalls 1 to compare the fast path with
+// the normal one. Rates are in calls per second.
+//
+// Before timing anything, objects are repeatedly activated, called
+// from several threads, and held and deactivated while the calls are
+// in progress. No call may be in progress once hold_requests() has
+// returned, each servant checks that it has not been deleted when it
+// is called, and calls must not fail before the object is deactivated
+// but must fail once the threads have stopped.
+//
+// usage: localCalls [-secs n] [-threads n,n,...] [-cycles n]
+//                   [ORB options]
+
+#include "samples.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static double      secs    = 0.5;
+static vector<int> threads = {1, 4};
+static int         cycles  = 100;
+
+static const unsigned LIVE = 0x11fe11fe;
+static const unsigned DEAD = 0xdeadbeef;
+
+
+class EchoServant : public POA_Bench::Echo
+{
+public:
+  EchoServant() : pd_state(LIVE), pd_calls(0), pd_inside(0) {}
+  ~EchoServant() { pd_state = DEAD; }
+
+  void ping()
+  {
+    pd_inside++;
+    if (pd_state != LIVE)
+      errors++;
+    pd_calls++;
+    pd_inside--;
+  }
+
+  char* echoString(const char* s)
+  {
+    if (pd_state != LIVE)
+      errors++;
+    return CORBA::string_dup(s);
+  }
+
+  Bench::OctetSeq* echoOctets(const Bench::OctetSeq& d)
+  {
+    return new Bench::OctetSeq(d);
+  }
+
+  Bench::Sample echoSample(const Bench::Sample& s)
+  {
+    return s;
+  }
+
+  Bench::SampleSeq* echoSamples(const Bench::SampleSeq& s)
+  {
+    return new Bench::SampleSeq(s);
+  }
+
+  void push(const Bench::OctetSeq&) {}
+
+  CORBA::ULongLong pushed() { return 0; }
+
+  long calls() const  { return pd_calls; }
+  int  inside() const { return pd_inside; }
+
+  static atomic<long> errors;
+
+private:
+  volatile unsigned pd_state;
+  atomic<long>      pd_calls;
+  atomic<int>       pd_inside;
+};
+
+atomic<long> EchoServant::errors(0);
+
+
+// Registers a thread with omnithread for its lifetime. Without it,
+// each call that sets up the POA Current registers and unregisters
+// the calling thread, which costs more than the rest of a local call.
+class OmniThread
+{
+public:
+  OmniThread()  { omni_thread::create_dummy(); }
+  ~OmniThread() { omni_thread::release_dummy(); }
+};
+
+
+//
+// Timing
+//
+
+// Runs f(thread number) on n threads for a while, and returns the
+// total calls per second.
+static double rate(int n, const function<void(int)>& f)
+{
+  typedef chrono::steady_clock Clock;
+
+  atomic<bool>   stop(false);
+  vector<long>   counts(n);
+  vector<thread> pool;
+
+  auto start = Clock::now();
+  for (int t = 0; t < n; t++) {
+    pool.emplace_back([&, t]() {
+      OmniThread registered;
+      long c = 0;
+      while (!stop) {
+        for (int i = 0; i < 100; i++)
+          f(t);
+        c += 100;
+      }
+      counts[t] = c;
+    });
+  }
+  this_thread::sleep_for(chrono::duration<double>(secs));
+  stop = true;
+  for (auto& th : pool)
+    th.join();
+  double elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+  long total = 0;
+  for (long c : counts)
+    total += c;
+  return total / elapsed;
+}
+
+static void report(const char* path, int n, const char* op, double r)
+{
+  cout << path << "\t" << n << "\t" << op << "\t" << r << endl;
+}
+
+static void fail(const string& what)
+{
+  cerr << "Check failed: " << what << endl;
+  exit(1);
+}
+
+
+// Activates an object and calls it from n threads. While they are
+// calling it, holds requests and checks that none is in progress once
+// hold_requests() has returned, then deactivates it. Once the threads
+// have stopped, the object must be gone. Repeats a number of times.
+static void churn(PortableServer::POA_ptr poa,
+                  PortableServer::POAManager_ptr pman, int n)
+{
+  for (int c = 0; c < cycles; c++) {
+    EchoServant* servant = new EchoServant;
+    PortableServer::ObjectId_var oid = poa->activate_object(servant);
+    servant->_remove_ref();
+
+    CORBA::Object_var obj  = poa->id_to_reference(oid);
+    Bench::Echo_var   echo = Bench::Echo::_narrow(obj);
+
+    atomic<int>    started(0);
+    atomic<bool>   deactivated(false);
+    atomic<long>   early(0);
+    vector<thread> pool;
+
+    for (int t = 0; t < n; t++) {
+      pool.emplace_back([&]() {
+        OmniThread registered;
+        bool first = true;
+        while (!deactivated) {
+          try {
+            echo->ping();
+          }
+          catch (CORBA::OBJECT_NOT_EXIST&) {
+            if (!deactivated)
+              early++;
+            break;
+          }
+          if (first) {
+            started++;
+            first = false;
+          }
+        }
+      });
+    }
+    while (started < n)
+      this_thread::yield();
+
+    pman->hold_requests(1);
+    if (servant->inside())
+      fail("call in progress after hold_requests() returned");
+    pman->activate();
+
+    deactivated = true;
+    poa->deactivate_object(oid);
+
+    for (auto& th : pool)
+      th.join();
+
+    if (early)
+      fail("calls failed before the object was deactivated");
+
+    try {
+      echo->ping();
+      fail("object could be called after it was deactivated");
+    }
+    catch (CORBA::OBJECT_NOT_EXIST&) {
+    }
+  }
+  if (EchoServant::errors)
+    fail("servant called after it was deleted");
+}
+
+
+int main(int argc, char** argv)
+{
+  CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-secs" && i + 1 < argc) {
+      secs = atof(argv[++i]);
+    }
+    else if (arg == "-threads" && i + 1 < argc) {
+      threads.clear();
+      istringstream in(argv[++i]);
+      string n;
+      while (getline(in, n, ','))
+        threads.push_back(stoi(n));
+    }
+    else if (arg == "-cycles" && i + 1 < argc) {
+      cycles = atoi(argv[++i]);
+    }
+    else {
+      cerr << "usage: localCalls [-secs n] [-threads n,n,...] [-cycles n] "
+           << "[ORB options]" << endl;
+      return 1;
+    }
+  }
+
+  int rc = 0;
+  try {
+    CORBA::Object_var obj = orb->resolve_initial_references("RootPOA");
+    PortableServer::POA_var poa = PortableServer::POA::_narrow(obj);
+    PortableServer::POAManager_var pman = poa->the_POAManager();
+    pman->activate();
+
+    int most = 1;
+    for (int n : threads)
+      most = max(most, n);
+    churn(poa, pman, max(most, 2));
+
+    EchoServant* servant = new EchoServant;
+    PortableServer::ObjectId_var oid = poa->activate_object(servant);
+    obj = poa->id_to_reference(oid);
+
+    // One reference per thread, as threads in an application would
+    // usually hold their own.
+    vector<Bench::Echo_var> refs(most);
+    for (int t = 0; t < most; t++) {
+      CORBA::Object_var o = poa->id_to_reference(oid);
+      refs[t] = Bench::Echo::_narrow(o);
+      refs[t]->ping();
+    }
+    POA_Bench::Echo* direct = servant;
+
+    long before = servant->calls();
+    refs[0]->ping();
+    if (servant->calls() != before + 1)
+      fail("call through the reference did not reach the servant");
+
+    cout << "# path\tthreads\top\tper_sec" << endl;
+
+    for (int n : threads) {
+      report("virtual", n, "ping", rate(n, [&](int) {
+        direct->ping();
+      }));
+      report("objref", n, "ping", rate(n, [&](int t) {
+        refs[t]->ping();
+      }));
+      report("virtual", n, "echoString", rate(n, [&](int) {
+        CORBA::String_var r = direct->echoString("hello");
+      }));
+      report("objref", n, "echoString", rate(n, [&](int t) {
+        CORBA::String_var r = refs[t]->echoString("hello");
+      }));
+    }
+
+    poa->deactivate_object(oid);
+    servant->_remove_ref();
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  orb->destroy();
+  return rc;
+}
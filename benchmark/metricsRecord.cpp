@@ -0,0 +1,226 @@
+// Measures the cost of the ORB's per-operation latency histograms, and
+// checks what they record.
+//
+// An echo server is forked with a TCP loopback endpoint, and client
+// threads call ping() on it for a while. Run it with and without
+// -ORBmetrics 0 to compare the call rates. Rates are in calls per
+// second.
+//
+// With metrics on, the client's histogram for ping() must count every
+// call made. Then a number of requests with distinct operation names
+// are sent with the DII; the server rejects each with BAD_OPERATION.
+// The ORB must record at most 1024 operations, counting calls to the
+// rest under "other", and every call must be counted exactly once.
+//
+// usage: metricsRecord [-secs n] [-threads n,n,...] [-ops n]
+//                      [ORB options]
+
+#include "samples.h"
+#include "benchServer.h"
+
+#include <omniORB4/omniMetrics.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+
+using namespace std;
+
+static double      secs    = 0.5;
+static vector<int> threads = {1, 4};
+static long        ops     = 2000;
+
+static const CORBA::ULong maxRecords = 1024;
+
+
+class EchoServant : public POA_Bench::Echo
+{
+public:
+  void ping() {}
+
+  char* echoString(const char* s)
+  {
+    return CORBA::string_dup(s);
+  }
+
+  Bench::OctetSeq* echoOctets(const Bench::OctetSeq& d)
+  {
+    return new Bench::OctetSeq(d);
+  }
+
+  Bench::Sample echoSample(const Bench::Sample& s)
+  {
+    return s;
+  }
+
+  Bench::SampleSeq* echoSamples(const Bench::SampleSeq& s)
+  {
+    return new Bench::SampleSeq(s);
+  }
+
+  void push(const Bench::OctetSeq&) {}
+
+  CORBA::ULongLong pushed() { return 0; }
+};
+
+
+static void fail(const string& what)
+{
+  cerr << "Check failed: " << what << endl;
+  exit(1);
+}
+
+
+// Calls ping() from n threads for a while, and returns the number of
+// calls made and the time taken.
+static long pings(Bench::Echo_ptr echo, int n, double& elapsed)
+{
+  typedef chrono::steady_clock Clock;
+
+  atomic<bool>   stop(false);
+  vector<long>   counts(n);
+  vector<thread> pool;
+
+  auto start = Clock::now();
+  for (int t = 0; t < n; t++) {
+    pool.emplace_back([&, t]() {
+      long c = 0;
+      while (!stop) {
+        echo->ping();
+        c++;
+      }
+      counts[t] = c;
+    });
+  }
+  this_thread::sleep_for(chrono::duration<double>(secs));
+  stop = true;
+  for (auto& th : pool)
+    th.join();
+  elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+  long total = 0;
+  for (long c : counts)
+    total += c;
+  return total;
+}
+
+// Returns the number of client calls recorded for <name>, or -1 if it
+// has no record.
+static long long recorded(const omniMetrics::Snapshot& snap, const char* name)
+{
+  for (CORBA::ULong i = 0; i < snap.operationCount(); i++) {
+    const omniMetrics::Operation& op = snap.operation(i);
+    if (!op.server && !strcmp(op.name, name))
+      return op.latency.count;
+  }
+  return -1;
+}
+
+
+int main(int argc, char** argv)
+{
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-secs" && i + 1 < argc) {
+      secs = atof(argv[++i]);
+    }
+    else if (arg == "-threads" && i + 1 < argc) {
+      threads.clear();
+      istringstream in(argv[++i]);
+      string n;
+      while (getline(in, n, ','))
+        threads.push_back(stoi(n));
+    }
+    else if (arg == "-ops" && i + 1 < argc) {
+      ops = atol(argv[++i]);
+    }
+    else if (strncmp(argv[i], "-ORB", 4) == 0 && i + 1 < argc) {
+      i++;
+    }
+    else {
+      cerr << "usage: metricsRecord [-secs n] [-threads n,n,...] [-ops n] "
+           << "[ORB options]" << endl;
+      return 1;
+    }
+  }
+
+  // Fork the server before the client ORB starts any threads.
+  int   iorPipe;
+  pid_t pid = BenchServer::startServer(
+    "metricsRecordServer", { "-ORBendPoint", "giop:tcp:127.0.0.1:" },
+    []() { return new EchoServant(); }, iorPipe);
+  string ior = BenchServer::readLine(iorPipe);
+
+  CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+  int rc = 0;
+  try {
+    CORBA::Object_var obj  = orb->string_to_object(ior.c_str());
+    Bench::Echo_var   echo = Bench::Echo::_narrow(obj);
+    echo->ping();
+
+    cout << "# test\tthreads\tper_sec" << endl;
+
+    omniMetrics::reset();
+    long calls = 0;
+    for (int n : threads) {
+      double elapsed;
+      long made = pings(echo, n, elapsed);
+      calls += made;
+      cout << "ping\t" << n << "\t" << made / elapsed << endl;
+    }
+
+    omniMetrics::Snapshot before;
+    long long counted = recorded(before, "ping");
+    if (counted < 0) {
+      cout << "# metrics are off; not checking what they record" << endl;
+    }
+    else {
+      if (counted != calls)
+        fail("ping() histogram counted " + to_string(counted) +
+             " calls, not " + to_string(calls));
+
+      // Calls to operations the server does not have. Each must be
+      // counted, but the number of records must stay bounded.
+      for (long i = 0; i < ops; i++) {
+        string name = "unknownOperation" + to_string(i);
+        CORBA::Request_var req = obj->_request(name.c_str());
+        req->invoke();
+        if (!req->env()->exception())
+          fail(name + " did not raise an exception");
+      }
+
+      omniMetrics::Snapshot after;
+      CORBA::ULongLong total = 0;
+      for (CORBA::ULong i = 0; i < after.operationCount(); i++) {
+        const omniMetrics::Operation& op = after.operation(i);
+        if (!op.server)
+          total += op.latency.count;
+      }
+      cout << "# " << ops << " distinct operations called, "
+           << after.operationCount() << " recorded, "
+           << recorded(after, "other") << " calls counted as other" << endl;
+
+      if (after.operationCount() > maxRecords + 2)
+        fail("more than " + to_string(maxRecords) + " operations recorded");
+      if (total != (CORBA::ULongLong)(calls + ops))
+        fail("calls were not all counted exactly once");
+    }
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  BenchServer::stopServer(pid);
+
+  orb->destroy();
+  return rc;
+}
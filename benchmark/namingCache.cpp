@@ -0,0 +1,328 @@
+// Compares looking an object up in the naming service on every call
+// with going through a NamingCache.
+//
+// An echo server is started which, like echoNsServer, binds itself as
+// test.my_context/Echo.Object, together with N more objects
+// Echo0.Object ... in the same context. Then:
+//
+//  - T client threads each resolve, narrow and call the echo object in a
+//    loop, first straight through the naming service and then through a
+//    shared NamingCache, and the call rates are reported.
+//
+//  - The N extra names are resolved one by one, and then in one batch by
+//    a new cache, and the rates are reported.
+//
+//  - The server is restarted, and the time taken for a client using the
+//    cache to reach the new server is reported.
+//
+// The server runs as a separate process, started by running this
+// program again with -server. The naming service is found with
+// resolve_initial_references, so run it with e.g.
+// -ORBInitRef NameService=corbaname::localhost
+//
+// usage: namingCache [-secs n] [-threads n,n,...] [-objects n]
+//                    [ORB options]
+
+#include "echo.h"
+#include "NamingCache.h"
+#include "benchServer.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+static const char* echoName = "test.my_context/Echo.Object";
+
+class EchoServer : public POA_Echo
+{
+public:
+  virtual char* echoString(const char* mesg)
+  {
+    return CORBA::string_dup(mesg);
+  }
+};
+
+
+static CosNaming::NamingContext_ptr rootContext(CORBA::ORB_ptr orb)
+{
+  CORBA::Object_var obj = orb->resolve_initial_references("NameService");
+  return CosNaming::NamingContext::_narrow(obj);
+}
+
+
+static void bindName(CosNaming::NamingContext_ptr nc, const char* name,
+                     CORBA::Object_ptr obj)
+{
+  CosNaming::Name_var n = NamingCache::toName(name);
+  nc->rebind(n, obj);
+}
+
+
+static int runServer(int argc, char** argv, long objects)
+{
+  try {
+    CORBA::ORB_var          orb = CORBA::ORB_init(argc, argv);
+    CORBA::Object_var       obj = orb->resolve_initial_references("RootPOA");
+    PortableServer::POA_var poa = PortableServer::POA::_narrow(obj);
+
+    PortableServer::Servant_var<EchoServer> echo = new EchoServer();
+    PortableServer::ObjectId_var id = poa->activate_object(echo);
+    obj = echo->_this();
+
+    PortableServer::POAManager_var pman = poa->the_POAManager();
+    pman->activate();
+
+    CosNaming::NamingContext_var root = rootContext(orb);
+    CosNaming::Name ctxName;
+    ctxName.length(1);
+    ctxName[0].id   = "test";
+    ctxName[0].kind = "my_context";
+    try {
+      CosNaming::NamingContext_var ctx = root->bind_new_context(ctxName);
+    }
+    catch (CosNaming::NamingContext::AlreadyBound&) {
+    }
+
+    bindName(root, echoName, obj);
+    for (long i = 0; i < objects; i++) {
+      ostringstream name;
+      name << "test.my_context/Echo" << i << ".Object";
+      bindName(root, name.str().c_str(), obj);
+    }
+
+    // Tell the client the bindings are in place.
+    cout << "ready" << endl;
+
+    orb->run();
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Server caught CORBA::" << ex._name() << endl;
+    return 1;
+  }
+  return 0;
+}
+
+
+// Runs this program again as the server, and waits until it is ready.
+static pid_t startServer(const vector<string>& orbArgs, long objects)
+{
+  int   ready;
+  pid_t pid = BenchServer::forkServer([&](int fd) {
+    dup2(fd, 1);
+    close(fd);
+
+    vector<string> args = {
+      "namingCache", "-server", to_string(objects),
+      "-ORBendPoint", "giop:tcp:127.0.0.1:",
+    };
+    args.insert(args.end(), orbArgs.begin(), orbArgs.end());
+
+    vector<char*> argv;
+    for (auto& a : args)
+      argv.push_back(&a[0]);
+    argv.push_back(0);
+
+    execv("/proc/self/exe", argv.data());
+    perror("execv");
+    _exit(1);
+  }, ready);
+
+  if (BenchServer::readLine(ready) != "ready") {
+    cerr << "Server failed to start" << endl;
+    exit(1);
+  }
+  return pid;
+}
+
+
+static void measureCalls(const char* test, int clients, double secs,
+                         const function<Echo_ptr()>& getEcho)
+{
+  atomic<bool> stop(false);
+  atomic<long> calls(0), errors(0);
+
+  vector<thread> threads;
+  for (int c = 0; c < clients; c++) {
+    threads.emplace_back([&]() {
+      CORBA::String_var mesg = CORBA::string_dup("ping");
+      long n = 0;
+      while (!stop) {
+        try {
+          Echo_var          e = getEcho();
+          CORBA::String_var r = e->echoString(mesg);
+          n++;
+        }
+        catch (CORBA::Exception&) {
+          errors++;
+        }
+      }
+      calls += n;
+    });
+  }
+  this_thread::sleep_for(chrono::duration<double>(secs));
+  stop = true;
+  for (auto& t : threads)
+    t.join();
+
+  cout << test << "\t" << clients << "\t" << calls / secs;
+  if (errors)
+    cout << "\t(" << errors << " errors)";
+  cout << endl;
+}
+
+
+static double since(chrono::steady_clock::time_point start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+static void measureBatch(CosNaming::NamingContext_ptr root, long objects)
+{
+  vector<CosNaming::Name> names;
+  for (long i = 0; i < objects; i++) {
+    ostringstream name;
+    name << "test.my_context/Echo" << i << ".Object";
+    CosNaming::Name_var n = NamingCache::toName(name.str().c_str());
+    names.push_back(n.in());
+  }
+
+  auto start = chrono::steady_clock::now();
+  for (auto& n : names)
+    CORBA::Object_var obj = root->resolve(n);
+  cout << "resolve_each\t1\t" << objects / since(start) << endl;
+
+  NamingCache cache(root);
+  start = chrono::steady_clock::now();
+  vector<CORBA::Object_var> objs = cache.resolve(names);
+  cout << "resolve_batch\t1\t" << objects / since(start) << endl;
+}
+
+
+// Restarts the server and times how long a client using the cache takes
+// to reach the new one.
+static pid_t measureRecovery(NamingCache& cache, pid_t pid,
+                             const vector<string>& orbArgs)
+{
+  Echo_var          e    = cache.resolve<Echo>(echoName);
+  CORBA::String_var mesg = CORBA::string_dup("ping");
+  CORBA::String_var r    = e->echoString(mesg);
+
+  BenchServer::stopServer(pid);
+  auto start = chrono::steady_clock::now();
+  pid = startServer(orbArgs, 0);
+
+  long failures = 0;
+  for (;;) {
+    try {
+      e = cache.resolve<Echo>(echoName);
+      r = e->echoString(mesg);
+      break;
+    }
+    catch (CORBA::Exception&) {
+      failures++;
+    }
+  }
+  cout << "# recovered from server restart in " << since(start) * 1000
+       << " ms, " << failures << " failed calls" << endl;
+  return pid;
+}
+
+
+int main(int argc, char** argv)
+{
+  if (argc > 2 && string(argv[1]) == "-server") {
+    long objects = atol(argv[2]);
+    argv[2] = argv[0];
+    argc -= 2;
+    return runServer(argc, argv + 2, objects);
+  }
+
+  double         secs    = 3;
+  long           objects = 100;
+  vector<int>    threadCounts;
+  vector<string> orbArgs;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-secs" && i + 1 < argc) {
+      secs = atof(argv[++i]);
+    }
+    else if (arg == "-objects" && i + 1 < argc) {
+      objects = atol(argv[++i]);
+    }
+    else if (arg == "-threads" && i + 1 < argc) {
+      istringstream in(argv[++i]);
+      string n;
+      while (getline(in, n, ','))
+        threadCounts.push_back(stoi(n));
+    }
+    else {
+      orbArgs.push_back(arg);
+    }
+  }
+  if (threadCounts.empty()) {
+    int ncpu = thread::hardware_concurrency();
+    for (int n = 1; n <= 2 * ncpu || n <= 4; n *= 2)
+      threadCounts.push_back(n);
+  }
+
+  pid_t pid = startServer(orbArgs, objects);
+
+  int rc = 0;
+  try {
+    CORBA::ORB_var               orb  = CORBA::ORB_init(argc, argv);
+    CosNaming::NamingContext_var root = rootContext(orb);
+    CosNaming::Name_var          name = NamingCache::toName(echoName);
+
+    cout << "# test\tthreads\tper_sec" << endl;
+
+    for (int n : threadCounts) {
+      measureCalls("uncached", n, secs, [&]() {
+        CORBA::Object_var obj = root->resolve(name);
+        return Echo::_narrow(obj);
+      });
+    }
+
+    {
+      NamingCache cache(root);
+      for (int n : threadCounts) {
+        measureCalls("cached", n, secs, [&]() {
+          return cache.resolve<Echo>(name.in());
+        });
+      }
+      cout << "# " << cache.stats() << endl;
+    }
+
+    if (objects > 0)
+      measureBatch(root, objects);
+
+    {
+      NamingCache cache(root);
+      pid = measureRecovery(cache, pid, orbArgs);
+      cout << "# " << cache.stats() << endl;
+    }
+
+    orb->destroy();
+  }
+  catch (CosNaming::NamingContext::NotFound&) {
+    cerr << "Caught NotFound" << endl;
+    rc = 1;
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  BenchServer::stopServer(pid);
+  return rc;
+}
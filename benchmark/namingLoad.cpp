@@ -0,0 +1,230 @@
+// Loads a naming service with many bindings in a single context and
+// measures how fast they can be bound, resolved, listed and unbound.
+//
+// A new context is bound in the root context under a name unique to
+// this process, and N objects are bound in it. T client threads then
+// resolve randomly chosen names for a fixed time, and the context is
+// listed in chunks through a BindingIterator. Finally everything is
+// unbound and the context destroyed.
+//
+// The naming service is found with resolve_initial_references, so run
+// it with e.g. -ORBInitRef NameService=corbaname::localhost
+//
+// The objects are bound by B threads at once, to show the effect of
+// the naming service combining their log writes.
+//
+// usage: namingLoad [-objects n] [-secs n] [-threads n,n,...]
+//                   [-binders n] [-chunk n] [ORB options]
+
+#include <omniORB4/CORBA.h>
+#include <omniORB4/Naming.hh>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+
+static CosNaming::Name makeName(long i)
+{
+  ostringstream id;
+  id << "obj" << i;
+
+  CosNaming::Name name;
+  name.length(1);
+  name[0].id   = id.str().c_str();
+  name[0].kind = "bench";
+  return name;
+}
+
+
+static double since(chrono::steady_clock::time_point start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+static void measureBind(CosNaming::NamingContext_ptr nc, long objects,
+                        CORBA::Object_ptr obj, int binders)
+{
+  auto start = chrono::steady_clock::now();
+
+  // Concurrent binds share the naming service's log writes.
+  atomic<long>   next(0);
+  vector<thread> threads;
+  for (int b = 0; b < binders; b++) {
+    threads.emplace_back([&]() {
+      long i;
+      while ((i = next++) < objects)
+        nc->bind(makeName(i), obj);
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+
+  cout << "bind\t" << binders << "\t" << objects / since(start) << endl;
+}
+
+
+static void measureResolve(CosNaming::NamingContext_ptr nc, long objects,
+                           int clients, double secs)
+{
+  atomic<bool> stop(false);
+  atomic<long> calls(0), errors(0);
+
+  vector<thread> threads;
+  for (int c = 0; c < clients; c++) {
+    threads.emplace_back([&, c]() {
+      mt19937 rng(c);
+      uniform_int_distribution<long> pick(0, objects - 1);
+      long n = 0;
+      while (!stop) {
+        try {
+          CORBA::Object_var r = nc->resolve(makeName(pick(rng)));
+          n++;
+        }
+        catch (CORBA::Exception&) {
+          errors++;
+        }
+      }
+      calls += n;
+    });
+  }
+  this_thread::sleep_for(chrono::duration<double>(secs));
+  stop = true;
+  for (auto& t : threads)
+    t.join();
+
+  cout << "resolve\t" << clients << "\t" << calls / secs;
+  if (errors)
+    cout << "\t(" << errors << " errors)";
+  cout << endl;
+}
+
+
+static void measureList(CosNaming::NamingContext_ptr nc, long objects,
+                        CORBA::ULong chunk)
+{
+  auto start = chrono::steady_clock::now();
+
+  CosNaming::BindingList_var     bl;
+  CosNaming::BindingIterator_var bi;
+  nc->list(chunk, bl, bi);
+
+  long count = bl->length();
+  if (!CORBA::is_nil(bi)) {
+    while (bi->next_n(chunk, bl))
+      count += bl->length();
+    bi->destroy();
+  }
+
+  double secs = since(start);
+  cout << "list\t1\t" << count / secs;
+  if (count != objects)
+    cout << "\t(listed " << count << " of " << objects << ")";
+  cout << endl;
+}
+
+
+static void measureUnbind(CosNaming::NamingContext_ptr nc, long objects)
+{
+  auto start = chrono::steady_clock::now();
+
+  for (long i = 0; i < objects; i++)
+    nc->unbind(makeName(i));
+
+  cout << "unbind\t1\t" << objects / since(start) << endl;
+}
+
+
+int main(int argc, char** argv)
+{
+  CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+  long         objects = 50000;
+  double       secs    = 3;
+  CORBA::ULong chunk   = 1000;
+  int          binders = 1;
+  vector<int>  threadCounts;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-objects" && i + 1 < argc) {
+      objects = atol(argv[++i]);
+    }
+    else if (arg == "-secs" && i + 1 < argc) {
+      secs = atof(argv[++i]);
+    }
+    else if (arg == "-binders" && i + 1 < argc) {
+      binders = atoi(argv[++i]);
+    }
+    else if (arg == "-chunk" && i + 1 < argc) {
+      chunk = atol(argv[++i]);
+    }
+    else if (arg == "-threads" && i + 1 < argc) {
+      istringstream in(argv[++i]);
+      string n;
+      while (getline(in, n, ','))
+        threadCounts.push_back(stoi(n));
+    }
+    else {
+      cerr << "usage: namingLoad [-objects n] [-secs n] [-threads n,n,...] "
+           << "[-binders n] [-chunk n] [ORB options]" << endl;
+      return 1;
+    }
+  }
+  if (threadCounts.empty()) {
+    int ncpu = thread::hardware_concurrency();
+    for (int n = 1; n <= 2 * ncpu || n <= 4; n *= 2)
+      threadCounts.push_back(n);
+  }
+
+  int rc = 0;
+  try {
+    CORBA::Object_var obj = orb->resolve_initial_references("NameService");
+    CosNaming::NamingContext_var root = CosNaming::NamingContext::_narrow(obj);
+
+    ostringstream id;
+    id << "namingLoad-" << getpid();
+
+    CosNaming::Name ctxName;
+    ctxName.length(1);
+    ctxName[0].id   = id.str().c_str();
+    ctxName[0].kind = "";
+
+    CosNaming::NamingContext_var nc = root->bind_new_context(ctxName);
+
+    cout << "# test\tthreads\tper_sec" << endl;
+
+    // Any object reference will do as the bound object.
+    measureBind(nc, objects, root, binders);
+
+    for (int n : threadCounts)
+      measureResolve(nc, objects, n, secs);
+
+    measureList(nc, objects, chunk);
+    measureUnbind(nc, objects);
+
+    nc->destroy();
+    root->unbind(ctxName);
+  }
+  catch (CosNaming::NamingContext::NotFound&) {
+    cerr << "Caught NotFound" << endl;
+    rc = 1;
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  orb->destroy();
+  return rc;
+}
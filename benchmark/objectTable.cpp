@@ -0,0 +1,304 @@
+// Measures the object table under churn.
+//
+// A server is forked with a TCP loopback endpoint. It activates a set
+// of stable objects, then activates and deactivates objects in waves,
+// reporting how many activations and deactivations it manages per
+// second. Meanwhile, client threads call the stable objects, and now
+// and then an object that is being churned, so that every incoming
+// request looks its object up in the table while it changes and
+// resizes. Call rates are reported before and during the churn.
+//
+// Calls on stable objects must all succeed, and calls on churned
+// objects must either succeed or raise OBJECT_NOT_EXIST. The program
+// fails if any call does otherwise.
+//
+// Objects are activated in omniINSPOA, so that the client can name
+// them with corbaloc URIs of the form corbaloc::127.0.0.1:port/c123.
+//
+// usage: objectTable [-secs n] [-objects n] [-waves n] [-stable n]
+//                    [-threads n] [-port n] [ORB options]
+
+#include "samples.h"
+#include "benchServer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double secs    = 0.5;
+static long   objects = 100000;
+static int    waves   = 10;
+static int    stable  = 100;
+static int    clients = 4;
+static int    port    = 21580;
+
+
+class EchoServant : public POA_Bench::Echo
+{
+public:
+  void ping() {}
+
+  char* echoString(const char* s)
+  {
+    return CORBA::string_dup(s);
+  }
+
+  Bench::OctetSeq* echoOctets(const Bench::OctetSeq& d)
+  {
+    return new Bench::OctetSeq(d);
+  }
+
+  Bench::Sample echoSample(const Bench::Sample& s)
+  {
+    return s;
+  }
+
+  Bench::SampleSeq* echoSamples(const Bench::SampleSeq& s)
+  {
+    return new Bench::SampleSeq(s);
+  }
+
+  void push(const Bench::OctetSeq&) {}
+
+  CORBA::ULongLong pushed() { return 0; }
+};
+
+
+static PortableServer::ObjectId* objectId(char kind, long i)
+{
+  string name = kind + to_string(i);
+  return PortableServer::string_to_ObjectId(name.c_str());
+}
+
+static void report(const char* phase, long n, double rate)
+{
+  cout << phase << "\t" << n << "\t" << rate << endl;
+}
+
+
+//
+// Server
+//
+
+// Activates the stable objects, says so on <ready>, waits for a byte
+// on <go>, churns the table and says so on <ready> again.
+static void runServer(int ready, int go)
+{
+  CORBA::ORB_var orb = BenchServer::serverORB(
+    "objectTableServer",
+    { "-ORBendPoint", "giop:tcp:127.0.0.1:" + to_string(port) });
+
+  CORBA::Object_var       obj = orb->resolve_initial_references("omniINSPOA");
+  PortableServer::POA_var poa = PortableServer::POA::_narrow(obj);
+
+  for (int i = 0; i < stable; i++) {
+    EchoServant* servant = new EchoServant;
+    PortableServer::ObjectId_var oid = objectId('s', i);
+    poa->activate_object_with_id(oid, servant);
+    servant->_remove_ref();
+  }
+  PortableServer::POAManager_var pman = poa->the_POAManager();
+  pman->activate();
+
+  char c = 0;
+  if (write(ready, &c, 1) != 1 || read(go, &c, 1) != 1)
+    _exit(1);
+
+  // Each wave activates <objects> objects, which grows the table
+  // through its sizes the first time, then deactivates them all,
+  // which shrinks it again.
+  double activating = 0, deactivating = 0;
+
+  for (int w = 0; w < waves; w++) {
+    auto start = Clock::now();
+    for (long i = 0; i < objects; i++) {
+      EchoServant* servant = new EchoServant;
+      PortableServer::ObjectId_var oid = objectId('c', i);
+      poa->activate_object_with_id(oid, servant);
+      servant->_remove_ref();
+    }
+    auto middle = Clock::now();
+    for (long i = 0; i < objects; i++) {
+      PortableServer::ObjectId_var oid = objectId('c', i);
+      poa->deactivate_object(oid);
+    }
+    auto end = Clock::now();
+
+    activating   += chrono::duration<double>(middle - start).count();
+    deactivating += chrono::duration<double>(end - middle).count();
+  }
+  report("activate",   objects * waves, objects * waves / activating);
+  report("deactivate", objects * waves, objects * waves / deactivating);
+
+  if (write(ready, &c, 1) != 1)
+    _exit(1);
+
+  orb->run();
+}
+
+
+//
+// Client
+//
+
+static atomic<long> errors(0);
+
+static Bench::Echo_ptr reference(CORBA::ORB_ptr orb, char kind, long i)
+{
+  string uri = "corbaloc::127.0.0.1:" + to_string(port) + "/" + kind +
+               to_string(i);
+  CORBA::Object_var obj = orb->string_to_object(uri.c_str());
+  return Bench::Echo::_unchecked_narrow(obj);
+}
+
+// Calls the objects from the client threads until <stop> is set, and
+// returns the total calls per second.
+static double callRate(const vector<Bench::Echo_var>& stables,
+                       const vector<Bench::Echo_var>& churned,
+                       const atomic<bool>& stop)
+{
+  vector<long>   counts(clients);
+  vector<thread> pool;
+
+  auto start = Clock::now();
+  for (int t = 0; t < clients; t++) {
+    pool.emplace_back([&, t]() {
+      long c = 0;
+      while (!stop) {
+        try {
+          stables[(c + t) % stables.size()]->ping();
+        }
+        catch (CORBA::Exception& ex) {
+          cerr << "Call on a stable object raised CORBA::" << ex._name()
+               << endl;
+          errors++;
+        }
+        if (c % 8 == 0) {
+          try {
+            churned[(c / 8 + t) % churned.size()]->ping();
+          }
+          catch (CORBA::OBJECT_NOT_EXIST&) {
+          }
+          catch (CORBA::Exception& ex) {
+            cerr << "Call on a churned object raised CORBA::" << ex._name()
+                 << endl;
+            errors++;
+          }
+        }
+        c++;
+      }
+      counts[t] = c;
+    });
+  }
+  for (auto& th : pool)
+    th.join();
+  double elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+  long total = 0;
+  for (long c : counts)
+    total += c;
+  return total / elapsed;
+}
+
+
+int main(int argc, char** argv)
+{
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-secs" && i + 1 < argc)
+      secs = atof(argv[++i]);
+    else if (arg == "-objects" && i + 1 < argc)
+      objects = atol(argv[++i]);
+    else if (arg == "-waves" && i + 1 < argc)
+      waves = atoi(argv[++i]);
+    else if (arg == "-stable" && i + 1 < argc)
+      stable = atoi(argv[++i]);
+    else if (arg == "-threads" && i + 1 < argc)
+      clients = atoi(argv[++i]);
+    else if (arg == "-port" && i + 1 < argc)
+      port = atoi(argv[++i]);
+    else if (strncmp(argv[i], "-ORB", 4) == 0 && i + 1 < argc)
+      i++;
+    else {
+      cerr << "usage: objectTable [-secs n] [-objects n] [-waves n] "
+           << "[-stable n] [-threads n] [-port n] [ORB options]" << endl;
+      return 1;
+    }
+  }
+
+  // Fork the server before the client ORB starts any threads.
+  int goPipe[2];
+  if (pipe(goPipe) != 0) {
+    perror("pipe");
+    return 1;
+  }
+  int   ready;
+  pid_t pid = BenchServer::forkServer([&](int fd) {
+    close(goPipe[1]);
+    runServer(fd, goPipe[0]);
+  }, ready);
+  close(goPipe[0]);
+
+  char c;
+  if (read(ready, &c, 1) != 1) {
+    cerr << "Server failed to start" << endl;
+    return 1;
+  }
+
+  CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+  int rc = 0;
+  try {
+    vector<Bench::Echo_var> stables(stable), churned(256);
+    for (int i = 0; i < stable; i++)
+      stables[i] = reference(orb, 's', i);
+    for (size_t i = 0; i < churned.size(); i++)
+      churned[i] = reference(orb, 'c', i * objects / churned.size());
+
+    cout << "# phase\tobjects\tper_sec" << endl;
+
+    atomic<bool> stop(false);
+    thread timer([&]() {
+      this_thread::sleep_for(chrono::duration<double>(secs));
+      stop = true;
+    });
+    report("calls idle", stable, callRate(stables, churned, stop));
+    timer.join();
+
+    // Call the objects for as long as the server is churning.
+    stop = false;
+    thread waiter([&]() {
+      char c = 0;
+      if (write(goPipe[1], &c, 1) != 1 || read(ready, &c, 1) != 1)
+        errors++;
+      stop = true;
+    });
+    report("calls churning", stable, callRate(stables, churned, stop));
+    waiter.join();
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  BenchServer::stopServer(pid);
+
+  if (errors) {
+    cerr << errors << " calls failed" << endl;
+    rc = 1;
+  }
+  orb->destroy();
+  return rc;
+}
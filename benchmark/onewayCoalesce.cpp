@@ -0,0 +1,214 @@
+// Measures the rate of small oneway requests to one server, with and
+// without oneway coalescing.
+//
+// A Bench::Sink server is forked, and T client threads post samples to
+// it with oneway calls for a while, first with coalescing switched off
+// for the object reference and then with it switched on. The client
+// then polls the server until every sample has arrived. The send rate
+// is the rate at which the client threads could make calls; the
+// delivered rate counts until the last sample reached the server.
+//
+// The client uses a single connection to the server, which dispatches
+// one call at a time from it and checks that each client thread's
+// samples arrive in the order they were sent. The program fails if any
+// do not.
+//
+// usage: onewayCoalesce [-secs n] [-threads n,n,...] [ORB options]
+//
+// ORB options such as -ORBonewayCoalesceWindow and
+// -ORBonewayCoalesceSize are passed to the client.
+
+#include "samples.h"
+#include "benchServer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class SinkServer : public POA_Bench::Sink
+{
+public:
+  SinkServer() : pd_received(0), pd_reordered(0) {}
+
+  // Sample ids are the client thread number in the top 8 bits and a
+  // sequence number in the rest.
+  void post(const Bench::Sample& s)
+  {
+    CORBA::ULong thread = CORBA::ULong(s.id) >> 24;
+    CORBA::ULong seq    = s.id & 0xffffff;
+    {
+      lock_guard<mutex> sync(pd_lock);
+      if (thread >= pd_next.size())
+        pd_next.resize(thread + 1, 0);
+      if (seq != pd_next[thread])
+        pd_reordered++;
+      pd_next[thread] = (seq + 1) & 0xffffff;
+    }
+    pd_received++;
+  }
+
+  CORBA::ULongLong received()
+  {
+    return pd_received;
+  }
+
+  CORBA::ULong reordered()
+  {
+    return pd_reordered;
+  }
+
+private:
+  mutex                  pd_lock;
+  vector<CORBA::ULong>   pd_next;
+  atomic<unsigned long>  pd_received;
+  atomic<unsigned long>  pd_reordered;
+};
+
+
+// Next sequence number for each client thread, carried on from one
+// measurement to the next since the server remembers them.
+static CORBA::ULong nextSeq[256];
+
+static void measure(Bench::Sink_ptr sink, bool coalesce, int clients,
+                    double secs)
+{
+  typedef chrono::steady_clock Clock;
+
+  omniORB::setClientOnewayCoalescing(sink, coalesce);
+
+  CORBA::ULongLong before = sink->received();
+
+  atomic<bool> stop(false);
+  atomic<long> sent(0), errors(0);
+
+  auto start = Clock::now();
+
+  vector<thread> threads;
+  for (int c = 0; c < clients; c++) {
+    threads.emplace_back([&, c]() {
+      Bench::Sample s;
+      memset(&s, 0, sizeof(s));
+      s.flags = c;
+
+      long n = 0;
+      while (!stop) {
+        CORBA::ULong seq = nextSeq[c];
+        s.id        = (c << 24) | seq;
+        s.timestamp = n;
+        s.value[0]  = n * 0.5;
+        try {
+          sink->post(s);
+          nextSeq[c] = (seq + 1) & 0xffffff;
+          n++;
+        }
+        catch (CORBA::Exception&) {
+          errors++;
+        }
+      }
+      sent += n;
+    });
+  }
+  this_thread::sleep_for(chrono::duration<double>(secs));
+  stop = true;
+  for (auto& t : threads)
+    t.join();
+
+  double sendSecs = chrono::duration<double>(Clock::now() - start).count();
+
+  // received() is a two-way call, so it writes any requests still held
+  // back, but the server may not have dispatched them all yet.
+  CORBA::ULongLong target = before + sent;
+  while (sink->received() < target)
+    this_thread::sleep_for(chrono::microseconds(200));
+
+  double deliverSecs = chrono::duration<double>(Clock::now() - start).count();
+
+  cout << (coalesce ? "coalesced" : "direct") << "\t" << clients
+       << "\t" << sent / sendSecs << "\t" << sent / deliverSecs;
+  if (errors)
+    cout << "\t(" << errors << " errors)";
+  cout << endl;
+}
+
+
+int main(int argc, char** argv)
+{
+  double      secs = 2;
+  vector<int> threadCounts;
+
+  // The server is forked before this process starts any ORB threads.
+  int   iorPipe;
+  pid_t pid = BenchServer::startServer(
+    "onewayCoalesceServer",
+    { "-ORBendPoint",                     "giop:tcp:127.0.0.1:",
+      "-ORBmaxServerThreadPerConnection", "1" },
+    []() { return new SinkServer(); }, iorPipe);
+
+  int rc = 0;
+  try {
+    // One connection, so that the order of each thread's calls is kept.
+    const char* clientArgs[] = { "-ORBmaxGIOPConnectionPerServer", "1" };
+    vector<char*> av(argv, argv + argc);
+    for (auto a : clientArgs)
+      av.push_back((char*)a);
+    argc = av.size();
+    av.push_back(0);
+    argv = av.data();
+
+    CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+    for (int i = 1; i < argc; i++) {
+      string arg = argv[i];
+      if (arg == "-secs" && i + 1 < argc) {
+        secs = atof(argv[++i]);
+      }
+      else if (arg == "-threads" && i + 1 < argc) {
+        istringstream in(argv[++i]);
+        string n;
+        while (getline(in, n, ','))
+          threadCounts.push_back(stoi(n));
+      }
+      else {
+        cerr << "usage: onewayCoalesce [-secs n] [-threads n,n,...] "
+             << "[ORB options]" << endl;
+        rc = 1;
+      }
+    }
+    if (threadCounts.empty())
+      threadCounts = { 1, 4 };
+
+    if (!rc) {
+      string ior = BenchServer::readLine(iorPipe);
+      CORBA::Object_var obj  = orb->string_to_object(ior.c_str());
+      Bench::Sink_var   sink = Bench::Sink::_narrow(obj);
+
+      cout << "# mode\tthreads\tsent_per_sec\tdelivered_per_sec" << endl;
+
+      for (int n : threadCounts) {
+        measure(sink, false, n, secs);
+        measure(sink, true,  n, secs);
+      }
+
+      if (CORBA::ULong n = sink->reordered()) {
+        cerr << n << " samples arrived out of order" << endl;
+        rc = 1;
+      }
+    }
+    orb->destroy();
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  BenchServer::stopServer(pid);
+  return rc;
+}
@@ -0,0 +1,566 @@
+// Measures call latency and throughput over each path a call can take,
+// for arguments of each kind and size.
+//
+// A Bench::Echo server is forked for each combination of transport and
+// server threading model: a TCP loopback endpoint or a unix socket,
+// served by a thread per connection or by the thread pool. A colocated
+// Echo servant is also activated in the client itself. For each path,
+// number of client threads, test and argument size, the client threads
+// call the server for a while and the time of every call is recorded.
+//
+// The tests are
+//
+//   ping     an operation with no arguments
+//   string   echoString() with a string of <size> characters
+//   octets   echoOctets() with a sequence of <size> octets
+//   struct   echoSample() with one fixed-length struct
+//   samples  echoSamples() with a sequence of <size> / 48 structs
+//   oneway   push() with a sequence of <size> octets, as a oneway call
+//
+// Each result gives the call rate, the rate of argument data sent, and
+// the 50th, 90th, 99th and 99.9th percentile and maximum call times.
+// For oneway calls the time is how long the call took to send, and the
+// rate counts until the server had received every call. Results are
+// written one per line, tab separated or, with -json, as JSON objects,
+// so that runs can be compared by a script.
+//
+// Every reply is checked against its arguments, and the program fails
+// if any does not match or any call raises an exception.
+//
+// usage: orbBench [-secs n] [-threads n,n,...] [-sizes n,n,...]
+//                 [-transports colocated,unix,tcp] [-servers pool,connection]
+//                 [-tests name,name,...] [-json] [ORB options]
+
+#include "samples.h"
+#include "benchServer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+class EchoServer : public POA_Bench::Echo
+{
+public:
+  EchoServer() : pd_pushed(0) {}
+
+  void ping() {}
+
+  char* echoString(const char* s)
+  {
+    return CORBA::string_dup(s);
+  }
+
+  Bench::OctetSeq* echoOctets(const Bench::OctetSeq& data)
+  {
+    return new Bench::OctetSeq(data);
+  }
+
+  Bench::Sample echoSample(const Bench::Sample& s)
+  {
+    return s;
+  }
+
+  Bench::SampleSeq* echoSamples(const Bench::SampleSeq& s)
+  {
+    return new Bench::SampleSeq(s);
+  }
+
+  void push(const Bench::OctetSeq&)
+  {
+    pd_pushed++;
+  }
+
+  CORBA::ULongLong pushed()
+  {
+    return pd_pushed;
+  }
+
+private:
+  atomic<unsigned long long> pd_pushed;
+};
+
+
+// A forked server, listening on one endpoint.
+struct Server
+{
+  string transport;
+  string model;
+  string unixPath;
+  pid_t  pid;
+  int    iorPipe;
+};
+
+// Runs an echo server in a child process and writes its IOR to a pipe.
+static void startServer(Server& server)
+{
+  string endpoint;
+  if (server.transport == "unix") {
+    server.unixPath = "/tmp/orbBench-" + to_string(getpid()) + "-" +
+                      server.model;
+    unlink(server.unixPath.c_str());
+    endpoint = "giop:unix:" + server.unixPath;
+  }
+  else {
+    endpoint = "giop:tcp:127.0.0.1:";
+  }
+
+  server.pid = BenchServer::startServer(
+    "orbBenchServer",
+    { "-ORBendPoint",                  endpoint,
+      "-ORBthreadPerConnectionPolicy", server.model == "pool" ? "0" : "1" },
+    []() { return new EchoServer(); },
+    server.iorPipe);
+}
+
+
+//
+// Tests
+//
+
+// Makes one call, and returns false if the reply does not match.
+typedef function<bool()> Call;
+
+struct Test
+{
+  const char* name;
+  bool        sized;   // Run once for each of the -sizes.
+  bool        oneway;
+
+  // Makes the call for one client thread, with its arguments built
+  // once, up front.
+  function<Call(Bench::Echo_ptr, size_t)> make;
+
+  // Argument bytes sent by each call.
+  function<size_t(size_t)> bytes;
+};
+
+static Bench::OctetSeq makeOctets(size_t size)
+{
+  Bench::OctetSeq data;
+  data.length(size);
+  for (size_t i = 0; i < size; i++)
+    data[i] = CORBA::Octet(i * 7);
+  return data;
+}
+
+static Bench::Sample makeSample(CORBA::Long id)
+{
+  Bench::Sample s;
+  memset(&s, 0, sizeof(s));
+  s.id        = id;
+  s.timestamp = id * 0.25;
+  s.value[0]  = id * 0.5;
+  s.x         = CORBA::Short(id);
+  return s;
+}
+
+// CDR size of a Bench::Sample.
+static const size_t sampleBytes = 48;
+
+static size_t sampleCount(size_t size)
+{
+  return max(size / sampleBytes, size_t(1));
+}
+
+static vector<Test> makeTests()
+{
+  vector<Test> tests;
+
+  tests.push_back({
+    "ping", false, false,
+    [](Bench::Echo_ptr echo, size_t) -> Call {
+      return [echo]() {
+        echo->ping();
+        return true;
+      };
+    },
+    [](size_t) { return size_t(0); }
+  });
+
+  tests.push_back({
+    "string", true, false,
+    [](Bench::Echo_ptr echo, size_t size) -> Call {
+      string s(size, 'x');
+      return [echo, s]() {
+        CORBA::String_var r = echo->echoString(s.c_str());
+        return strlen(r) == s.size();
+      };
+    },
+    [](size_t size) { return size; }
+  });
+
+  tests.push_back({
+    "octets", true, false,
+    [](Bench::Echo_ptr echo, size_t size) -> Call {
+      Bench::OctetSeq data = makeOctets(size);
+      return [echo, data]() {
+        Bench::OctetSeq_var r = echo->echoOctets(data);
+        CORBA::ULong l = data.length();
+        return r->length() == l && (l == 0 || r[l - 1] == data[l - 1]);
+      };
+    },
+    [](size_t size) { return size; }
+  });
+
+  tests.push_back({
+    "struct", false, false,
+    [](Bench::Echo_ptr echo, size_t) -> Call {
+      Bench::Sample s = makeSample(42);
+      return [echo, s]() {
+        Bench::Sample r = echo->echoSample(s);
+        return r.id == s.id && r.value[0] == s.value[0];
+      };
+    },
+    [](size_t) { return sampleBytes; }
+  });
+
+  tests.push_back({
+    "samples", true, false,
+    [](Bench::Echo_ptr echo, size_t size) -> Call {
+      Bench::SampleSeq seq;
+      seq.length(sampleCount(size));
+      for (CORBA::ULong i = 0; i < seq.length(); i++)
+        seq[i] = makeSample(i);
+      return [echo, seq]() {
+        Bench::SampleSeq_var r = echo->echoSamples(seq);
+        CORBA::ULong l = seq.length();
+        return r->length() == l && r[l - 1].id == seq[l - 1].id;
+      };
+    },
+    [](size_t size) { return sampleCount(size) * sampleBytes; }
+  });
+
+  tests.push_back({
+    "oneway", true, true,
+    [](Bench::Echo_ptr echo, size_t size) -> Call {
+      Bench::OctetSeq data = makeOctets(size);
+      return [echo, data]() {
+        echo->push(data);
+        return true;
+      };
+    },
+    [](size_t size) { return size; }
+  });
+
+  return tests;
+}
+
+
+//
+// Measurement
+//
+
+typedef chrono::steady_clock Clock;
+
+static double secs = 0.5;
+static bool   json = false;
+static long   failed = 0;
+
+struct Result
+{
+  string path;
+  string server;
+  int    threads;
+  string test;
+  size_t size;
+  long   calls;
+  double elapsed;
+  size_t bytes;
+  long   errors;
+  vector<long> nanos;   // Sorted call times.
+};
+
+static double percentile(const vector<long>& nanos, double p)
+{
+  if (nanos.empty())
+    return 0;
+  size_t i = min(size_t(p * nanos.size()), nanos.size() - 1);
+  return nanos[i] / 1e3;
+}
+
+static void report(const Result& r)
+{
+  double rate = r.calls / r.elapsed;
+  double mb   = rate * r.bytes / 1e6;
+  double p50  = percentile(r.nanos, 0.5);
+  double p90  = percentile(r.nanos, 0.9);
+  double p99  = percentile(r.nanos, 0.99);
+  double p999 = percentile(r.nanos, 0.999);
+  double max  = r.nanos.empty() ? 0 : r.nanos.back() / 1e3;
+
+  char line[512];
+  if (json) {
+    snprintf(line, sizeof(line),
+             "{\"path\": \"%s\", \"server\": \"%s\", \"threads\": %d, "
+             "\"test\": \"%s\", \"size\": %zu, \"calls\": %ld, "
+             "\"calls_per_sec\": %.1f, \"MB_per_sec\": %.2f, "
+             "\"p50_us\": %.1f, \"p90_us\": %.1f, \"p99_us\": %.1f, "
+             "\"p999_us\": %.1f, \"max_us\": %.1f, \"errors\": %ld}",
+             r.path.c_str(), r.server.c_str(), r.threads, r.test.c_str(),
+             r.size, r.calls, rate, mb, p50, p90, p99, p999, max, r.errors);
+  }
+  else {
+    snprintf(line, sizeof(line),
+             "%s\t%s\t%d\t%s\t%zu\t%ld\t%.1f\t%.2f\t%.1f\t%.1f\t%.1f\t"
+             "%.1f\t%.1f\t%ld",
+             r.path.c_str(), r.server.c_str(), r.threads, r.test.c_str(),
+             r.size, r.calls, rate, mb, p50, p90, p99, p999, max, r.errors);
+  }
+  cout << line << endl;
+}
+
+static void measure(Bench::Echo_ptr echo, const string& path,
+                    const string& server, int clients, const Test& test,
+                    size_t size)
+{
+  Result r;
+  r.path    = path;
+  r.server  = server;
+  r.threads = clients;
+  r.test    = test.name;
+  r.size    = test.sized ? size : 0;
+  r.bytes   = test.bytes(size);
+
+  CORBA::ULongLong before = test.oneway ? echo->pushed() : 0;
+
+  atomic<int>  ready(0);
+  atomic<bool> go(false), stop(false);
+  atomic<long> errors(0);
+
+  vector<vector<long> > nanos(clients);
+  vector<thread>        threads;
+
+  for (int c = 0; c < clients; c++) {
+    threads.emplace_back([&, c]() {
+      Call call = test.make(echo, size);
+
+      // A few calls first, so that connections are open and buffers
+      // allocated before anything is timed.
+      for (int i = 0; i < 10; i++) {
+        try {
+          call();
+        }
+        catch (CORBA::Exception&) {
+        }
+      }
+      ready++;
+      while (!go)
+        this_thread::yield();
+
+      vector<long>& times = nanos[c];
+      times.reserve(100000);
+      while (!stop) {
+        auto start = Clock::now();
+        try {
+          if (!call())
+            errors++;
+        }
+        catch (CORBA::Exception&) {
+          errors++;
+        }
+        times.push_back(chrono::duration_cast<chrono::nanoseconds>(
+                          Clock::now() - start).count());
+      }
+    });
+  }
+  while (ready < clients)
+    this_thread::sleep_for(chrono::milliseconds(1));
+
+  auto start = Clock::now();
+  go = true;
+  this_thread::sleep_for(chrono::duration<double>(secs));
+  stop = true;
+  for (auto& t : threads)
+    t.join();
+
+  for (auto& times : nanos)
+    r.nanos.insert(r.nanos.end(), times.begin(), times.end());
+  sort(r.nanos.begin(), r.nanos.end());
+  r.calls  = r.nanos.size();
+  r.errors = errors;
+
+  if (test.oneway) {
+    // The warm up calls were oneways too.
+    CORBA::ULongLong target = before + r.calls + 10 * clients;
+    while (echo->pushed() < target)
+      this_thread::sleep_for(chrono::microseconds(200));
+  }
+  r.elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+  failed += r.errors;
+  report(r);
+}
+
+static void measurePath(Bench::Echo_ptr echo, const string& path,
+                        const string& server, const vector<int>& threadCounts,
+                        const vector<Test>& tests,
+                        const vector<size_t>& sizes)
+{
+  for (const Test& test : tests) {
+    vector<size_t> testSizes = test.sized ? sizes : vector<size_t>(1, 0);
+    for (size_t size : testSizes) {
+      for (int n : threadCounts)
+        measure(echo, path, server, n, test, size);
+    }
+  }
+}
+
+
+static vector<string> split(const string& list)
+{
+  vector<string> items;
+  istringstream  in(list);
+  string         item;
+  while (getline(in, item, ','))
+    items.push_back(item);
+  return items;
+}
+
+static bool contains(const vector<string>& items, const string& item)
+{
+  return find(items.begin(), items.end(), item) != items.end();
+}
+
+int main(int argc, char** argv)
+{
+  vector<int>    threadCounts;
+  vector<size_t> sizes;
+  vector<string> transports = { "colocated", "unix", "tcp" };
+  vector<string> models     = { "pool", "connection" };
+  vector<string> testNames;
+
+  // The servers are forked before this process starts any ORB threads,
+  // so the options that choose them are read first.
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-transports" && i + 1 < argc)
+      transports = split(argv[i + 1]);
+    else if (arg == "-servers" && i + 1 < argc)
+      models = split(argv[i + 1]);
+  }
+
+  vector<Server> servers;
+  for (const string& transport : transports) {
+    if (transport != "unix" && transport != "tcp")
+      continue;
+    for (const string& model : models) {
+      Server server;
+      server.transport = transport;
+      server.model     = model;
+      startServer(server);
+      servers.push_back(server);
+    }
+  }
+
+  int rc = 0;
+  try {
+    CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+    for (int i = 1; i < argc; i++) {
+      string arg = argv[i];
+      if (arg == "-secs" && i + 1 < argc) {
+        secs = atof(argv[++i]);
+      }
+      else if (arg == "-threads" && i + 1 < argc) {
+        for (const string& n : split(argv[++i]))
+          threadCounts.push_back(stoi(n));
+      }
+      else if (arg == "-sizes" && i + 1 < argc) {
+        for (const string& n : split(argv[++i]))
+          sizes.push_back(stoul(n));
+      }
+      else if (arg == "-tests" && i + 1 < argc) {
+        testNames = split(argv[++i]);
+      }
+      else if ((arg == "-transports" || arg == "-servers") && i + 1 < argc) {
+        ++i;
+      }
+      else if (arg == "-json") {
+        json = true;
+      }
+      else {
+        cerr << "usage: orbBench [-secs n] [-threads n,n,...] "
+             << "[-sizes n,n,...]\n"
+             << "                [-transports colocated,unix,tcp] "
+             << "[-servers pool,connection]\n"
+             << "                [-tests name,name,...] [-json] "
+             << "[ORB options]" << endl;
+        rc = 1;
+      }
+    }
+    if (threadCounts.empty())
+      threadCounts = { 1, 4 };
+    if (sizes.empty())
+      sizes = { 64, 4096, 65536 };
+
+    vector<Test> tests;
+    for (const Test& test : makeTests()) {
+      if (testNames.empty() || contains(testNames, test.name))
+        tests.push_back(test);
+    }
+    if (tests.empty()) {
+      cerr << "No tests selected. The tests are ping, string, octets, "
+           << "struct, samples and oneway." << endl;
+      rc = 1;
+    }
+
+    if (!rc) {
+      if (!json)
+        cout << "# path\tserver\tthreads\ttest\tsize\tcalls\tcalls_per_sec"
+             << "\tMB_per_sec\tp50_us\tp90_us\tp99_us\tp999_us\tmax_us"
+             << "\terrors" << endl;
+
+      if (contains(transports, "colocated")) {
+        CORBA::Object_var obj = orb->resolve_initial_references("RootPOA");
+        PortableServer::POA_var poa = PortableServer::POA::_narrow(obj);
+
+        PortableServer::Servant_var<EchoServer> servant = new EchoServer();
+        PortableServer::ObjectId_var id = poa->activate_object(servant);
+
+        PortableServer::POAManager_var pman = poa->the_POAManager();
+        pman->activate();
+
+        Bench::Echo_var echo = servant->_this();
+        measurePath(echo, "colocated", "local", threadCounts, tests, sizes);
+      }
+
+      for (Server& server : servers) {
+        string ior = BenchServer::readLine(server.iorPipe);
+        CORBA::Object_var obj  = orb->string_to_object(ior.c_str());
+        Bench::Echo_var   echo = Bench::Echo::_narrow(obj);
+
+        measurePath(echo, server.transport, server.model, threadCounts,
+                    tests, sizes);
+      }
+
+      if (failed) {
+        cerr << failed << " calls failed" << endl;
+        rc = 1;
+      }
+    }
+    orb->destroy();
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  for (Server& server : servers) {
+    BenchServer::stopServer(server.pid);
+    if (!server.unixPath.empty())
+      unlink(server.unixPath.c_str());
+  }
+  return rc;
+}
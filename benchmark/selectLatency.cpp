@@ -0,0 +1,200 @@
+// Measures how the server's connection watching (SocketCollection::Select)
+// scales with the number of idle client connections.
+//
+// Two echo servers are forked, one watching connections with poll() and
+// one with epoll (-ORBconnectionWatchEpoll). Both run in thread pool mode
+// with threadPoolWatchConnection disabled, so every call is dispatched by
+// the Select thread. For each connection count, that many idle raw TCP
+// connections are opened to the server, then the round trip latency of
+// echoString calls is measured on a separate connection.
+//
+// usage: selectLatency [-calls n] [-conns n,n,...] [ORB options]
+
+#include "echo.h"
+#include "benchServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+class EchoServer : public POA_Echo
+{
+public:
+  virtual char* echoString(const char* mesg)
+  {
+    return CORBA::string_dup(mesg);
+  }
+};
+
+
+static int freePort()
+{
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family      = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bind(sock, (sockaddr*)&addr, sizeof(addr));
+
+  socklen_t len = sizeof(addr);
+  getsockname(sock, (sockaddr*)&addr, &len);
+  close(sock);
+  return ntohs(addr.sin_port);
+}
+
+
+// Runs an echo server in a child process, listening on <port>, and
+// writes its IOR to the returned pipe.
+static pid_t startServer(int port, bool epoll, vector<string> orbArgs,
+                         int& iorPipe)
+{
+  orbArgs.insert(orbArgs.begin(), {
+      "-ORBendPoint",                  "giop:tcp:127.0.0.1:" + to_string(port),
+      "-ORBthreadPerConnectionPolicy", "0",
+      "-ORBthreadPoolWatchConnection", "0",
+      "-ORBconnectionWatchImmediate",  "1",
+      "-ORBconnectionWatchEpoll",      epoll ? "1" : "0"
+    });
+
+  return BenchServer::startServer("selectLatencyServer", orbArgs,
+                                  []() { return new EchoServer(); },
+                                  iorPipe);
+}
+
+
+static void openIdleConnections(int port, size_t count, vector<int>& socks)
+{
+  sockaddr_in addr = {};
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  while (socks.size() < count) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0 || connect(sock, (sockaddr*)&addr, sizeof(addr)) != 0) {
+      perror("idle connection");
+      if (sock >= 0)
+        close(sock);
+      return;
+    }
+    socks.push_back(sock);
+  }
+}
+
+
+static void closeIdleConnections(vector<int>& socks)
+{
+  for (int sock : socks)
+    close(sock);
+  socks.clear();
+}
+
+
+static void measure(const char* mode, size_t conns, Echo_ptr e, int calls)
+{
+  CORBA::String_var mesg = CORBA::string_dup("ping");
+  vector<double> samples;
+  samples.reserve(calls);
+
+  for (int i = 0; i < calls / 10; i++) {
+    CORBA::String_var r = e->echoString(mesg);
+  }
+
+  for (int i = 0; i < calls; i++) {
+    auto start = chrono::steady_clock::now();
+    CORBA::String_var r = e->echoString(mesg);
+    auto end   = chrono::steady_clock::now();
+    samples.push_back(chrono::duration<double, micro>(end - start).count());
+  }
+  sort(samples.begin(), samples.end());
+
+  double total = 0;
+  for (double s : samples)
+    total += s;
+
+  cout << mode << "\t" << conns << "\t"
+       << total / samples.size() << "\t"
+       << samples[samples.size() / 2] << "\t"
+       << samples[samples.size() * 99 / 100] << endl;
+}
+
+
+int main(int argc, char** argv)
+{
+  int            calls = 2000;
+  vector<size_t> connCounts = { 0, 100, 1000, 5000, 10000 };
+  vector<string> orbArgs;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-calls" && i + 1 < argc) {
+      calls = atoi(argv[++i]);
+    }
+    else if (arg == "-conns" && i + 1 < argc) {
+      connCounts.clear();
+      istringstream in(argv[++i]);
+      string n;
+      while (getline(in, n, ','))
+        connCounts.push_back(stoul(n));
+    }
+    else {
+      orbArgs.push_back(arg);
+    }
+  }
+
+  // Each idle connection costs a descriptor in both processes.
+  rlimit rl;
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+  }
+
+  // Servers are forked before this process starts any ORB threads.
+  const char* modes[] = { "poll", "epoll" };
+  int         ports[2], pipes[2];
+  pid_t       pids[2];
+
+  for (int m = 0; m < 2; m++) {
+    ports[m] = freePort();
+    pids[m]  = startServer(ports[m], m == 1, orbArgs, pipes[m]);
+  }
+
+  int rc = 0;
+  try {
+    CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+    cout << "# mode\tconnections\tmean_us\tp50_us\tp99_us" << endl;
+
+    for (int m = 0; m < 2; m++) {
+      string ior = BenchServer::readLine(pipes[m]);
+      CORBA::Object_var obj  = orb->string_to_object(ior.c_str());
+      Echo_var          echo = Echo::_narrow(obj);
+
+      vector<int> idle;
+      for (size_t conns : connCounts) {
+        openIdleConnections(ports[m], conns, idle);
+        measure(modes[m], idle.size(), echo, calls);
+      }
+      closeIdleConnections(idle);
+    }
+    orb->destroy();
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  for (int m = 0; m < 2; m++)
+    BenchServer::stopServer(pids[m]);
+  return rc;
+}
@@ -0,0 +1,311 @@
+// Measures marshalling of structs and sequences of structs.
+//
+// Bench::Sample has no padding in its CDR encoding, so omniidl lets it
+// be marshalled as a block of octets when the stream is in native byte
+// order. Bench::PaddedSample has the same members in an order that
+// needs padding, so it is marshalled one member at a time. Both are
+// marshalled into and unmarshalled from a memory stream, as a sequence
+// and one struct at a time, and Sample is also marshalled member by
+// member, the way the generated code used to do it. Rates are in
+// elements per second.
+//
+// Before timing anything, the block encoding is checked against the
+// member by member one, at each starting alignment and in both byte
+// orders, and the program fails if they differ.
+//
+// usage: structMarshal [-secs n] [-length n] [ORB options]
+
+#include "samples.h"
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static double secs   = 0.5;
+static size_t length = 1000;
+
+
+//
+// Member by member marshalling, as omniidl generated it for every struct
+//
+
+static void marshalMembers(const Bench::Sample& s, cdrStream& n)
+{
+  s.timestamp >>= n;
+  for (int i = 0; i < 3; i++)
+    s.value[i] >>= n;
+  s.id    >>= n;
+  s.flags >>= n;
+  s.x     >>= n;
+  s.y     >>= n;
+  s.z     >>= n;
+  s.w     >>= n;
+}
+
+static void unmarshalMembers(Bench::Sample& s, cdrStream& n)
+{
+  s.timestamp <<= n;
+  for (int i = 0; i < 3; i++)
+    s.value[i] <<= n;
+  s.id    <<= n;
+  s.flags <<= n;
+  s.x     <<= n;
+  s.y     <<= n;
+  s.z     <<= n;
+  s.w     <<= n;
+}
+
+static void marshalMembers(const Bench::SampleSeq& seq, cdrStream& n)
+{
+  seq.length() >>= n;
+  for (CORBA::ULong i = 0; i < seq.length(); i++)
+    marshalMembers(seq[i], n);
+}
+
+static void unmarshalMembers(Bench::SampleSeq& seq, cdrStream& n)
+{
+  CORBA::ULong len;
+  len <<= n;
+  seq.length(len);
+  for (CORBA::ULong i = 0; i < len; i++)
+    unmarshalMembers(seq[i], n);
+}
+
+
+//
+// Test data
+//
+
+template <class T>
+static void fill(T& s, CORBA::ULong i)
+{
+  s.timestamp = 1.5e9 + i * 0.001;
+  for (int j = 0; j < 3; j++)
+    s.value[j] = i * 3.25 - j;
+  s.id    = i;
+  s.flags = 0x10203040 ^ i;
+  s.x     = i & 0x7fff;
+  s.y     = -(CORBA::Short)(i & 0x7fff);
+  s.z     = 0x1234;
+  s.w     = (i * 7) & 0x7fff;
+}
+
+template <class Seq>
+static void fill(Seq& seq)
+{
+  seq.length(length);
+  for (CORBA::ULong i = 0; i < length; i++)
+    fill(seq[i], i);
+}
+
+static bool operator==(const Bench::Sample& a, const Bench::Sample& b)
+{
+  return (a.timestamp == b.timestamp &&
+          a.value[0]  == b.value[0] &&
+          a.value[1]  == b.value[1] &&
+          a.value[2]  == b.value[2] &&
+          a.id == b.id && a.flags == b.flags &&
+          a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w);
+}
+
+static bool operator==(const Bench::SampleSeq& a, const Bench::SampleSeq& b)
+{
+  if (a.length() != b.length())
+    return false;
+  for (CORBA::ULong i = 0; i < a.length(); i++)
+    if (!(a[i] == b[i]))
+      return false;
+  return true;
+}
+
+
+//
+// Wire compatibility
+//
+
+static void fail(const string& what)
+{
+  cerr << "Wire check failed: " << what << endl;
+  exit(1);
+}
+
+static bool sameBytes(cdrMemoryStream& a, cdrMemoryStream& b)
+{
+  return (a.bufSize() == b.bufSize() &&
+          memcmp(a.bufPtr(), b.bufPtr(), a.bufSize()) == 0);
+}
+
+// Checks the generated code against marshalMembers for a stream in the
+// given byte order, with the data starting at each offset up to 8.
+static void checkWire(const Bench::SampleSeq& seq, bool swap)
+{
+  string order = swap ? "swapped" : "native";
+
+  for (int offset = 0; offset < 8; offset++) {
+    string where = order + " byte order, offset " + to_string(offset);
+
+    cdrMemoryStream generated, members;
+    if (swap) {
+      generated.setByteSwapFlag(!omni::myByteOrder);
+      members.setByteSwapFlag(!omni::myByteOrder);
+    }
+    for (int i = 0; i < offset; i++) {
+      generated.marshalOctet(0);
+      members.marshalOctet(0);
+    }
+
+    seq    >>= generated;
+    seq[1] >>= generated;
+    marshalMembers(seq,    members);
+    marshalMembers(seq[1], members);
+
+    if (!sameBytes(generated, members))
+      fail("sequence marshalled differently, " + where);
+
+    // Unmarshal what marshalMembers wrote with the generated code, and
+    // the other way round.
+    Bench::SampleSeq back;
+    Bench::Sample    one;
+
+    for (int i = 0; i < offset; i++)
+      members.unmarshalOctet();
+    back <<= members;
+    one  <<= members;
+    if (!(back == seq) || !(one == seq[1]))
+      fail("generated code unmarshalled differently, " + where);
+
+    for (int i = 0; i < offset; i++)
+      generated.unmarshalOctet();
+    unmarshalMembers(back, generated);
+    unmarshalMembers(one,  generated);
+    if (!(back == seq) || !(one == seq[1]))
+      fail("generated data unmarshalled differently, " + where);
+  }
+}
+
+
+//
+// Timing
+//
+
+// Runs f repeatedly for a while, and returns elements per second.
+static double rate(size_t elements, const function<void()>& f)
+{
+  typedef chrono::steady_clock Clock;
+
+  long       n     = 0;
+  auto       start = Clock::now();
+  double     elapsed;
+  do {
+    for (int i = 0; i < 10; i++)
+      f();
+    n += 10;
+    elapsed = chrono::duration<double>(Clock::now() - start).count();
+  } while (elapsed < secs);
+
+  return elements * n / elapsed;
+}
+
+static void report(const char* type, const char* form, const char* op,
+                   double r)
+{
+  cout << type << "\t" << form << "\t" << op << "\t" << r << endl;
+}
+
+template <class Seq>
+static void measure(const char* type, const Seq& seq)
+{
+  cdrMemoryStream stream;
+  Seq             back;
+
+  report(type, "sequence", "marshal", rate(length, [&]() {
+    stream.rewindPtrs();
+    seq >>= stream;
+  }));
+  report(type, "sequence", "unmarshal", rate(length, [&]() {
+    stream.rewindInputPtr();
+    back <<= stream;
+  }));
+
+  report(type, "structs", "marshal", rate(length, [&]() {
+    stream.rewindPtrs();
+    for (CORBA::ULong i = 0; i < length; i++)
+      seq[i] >>= stream;
+  }));
+  back.length(length);
+  report(type, "structs", "unmarshal", rate(length, [&]() {
+    stream.rewindInputPtr();
+    for (CORBA::ULong i = 0; i < length; i++)
+      back[i] <<= stream;
+  }));
+}
+
+static void measureMembers(const Bench::SampleSeq& seq)
+{
+  cdrMemoryStream  stream;
+  Bench::SampleSeq back;
+
+  report("Sample", "members", "marshal", rate(length, [&]() {
+    stream.rewindPtrs();
+    marshalMembers(seq, stream);
+  }));
+  report("Sample", "members", "unmarshal", rate(length, [&]() {
+    stream.rewindInputPtr();
+    unmarshalMembers(back, stream);
+  }));
+}
+
+
+int main(int argc, char** argv)
+{
+  CORBA::ORB_var orb = CORBA::ORB_init(argc, argv);
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-secs" && i + 1 < argc) {
+      secs = atof(argv[++i]);
+    }
+    else if (arg == "-length" && i + 1 < argc) {
+      length = atol(argv[++i]);
+    }
+    else {
+      cerr << "usage: structMarshal [-secs n] [-length n] [ORB options]"
+           << endl;
+      return 1;
+    }
+  }
+  if (length < 2)
+    length = 2;
+
+  int rc = 0;
+  try {
+    Bench::SampleSeq       samples;
+    Bench::PaddedSampleSeq padded;
+    fill(samples);
+    fill(padded);
+
+    if (!Bench::Sample::_cdrLayout())
+      cout << "# Sample is marshalled member by member on this platform"
+           << endl;
+
+    checkWire(samples, false);
+    checkWire(samples, true);
+
+    cout << "# type\tform\top\tper_sec" << endl;
+
+    measure("Sample", samples);
+    measureMembers(samples);
+    measure("PaddedSample", padded);
+  }
+  catch (CORBA::Exception& ex) {
+    cerr << "Caught CORBA::" << ex._name() << endl;
+    rc = 1;
+  }
+
+  orb->destroy();
+  return rc;
+}
@@ -520,6 +520,7 @@ extern void _omni_set_NameService(CORBA::Object_ptr);
 #include <omniORB4/minorCode.h>
 
 #include <omniORB4/omniAsyncInvoker.h>
+#include <omniORB4/omniAsyncCall.h>
 
 #include <omniORB4/corbaidl_operators.hh>
 
@@ -154,6 +154,9 @@ public:
 
   operator IOP_C& () { return *pd_iop_c; }
 
+  IOP_C* _retn() { IOP_C* c = pd_iop_c; pd_iop_c = 0; return c; }
+  // Give up the IOP_C without releasing it to the rope.
+
 private:
   Rope*  pd_rope;
   IOP_C* pd_iop_c;
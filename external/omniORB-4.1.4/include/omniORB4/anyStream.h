@@ -73,6 +73,11 @@ public:
     pd_values = 0;
   }
 
+  inline CORBA::Boolean hasValues()
+  {
+    return pd_values.operator->() != 0;
+  }
+
 private:
   // ValueTypes inside Anys cannot be stored inside the marshalled
   // stream like other types, because to do so would not have the
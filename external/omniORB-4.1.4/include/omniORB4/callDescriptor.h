@@ -112,6 +112,7 @@
 class omniObjRef;
 class omniServant;
 class omniCurrent;
+class omniAsyncCall;
 
 OMNI_NAMESPACE_BEGIN(omni)
 class omniOrbPOA;
@@ -144,7 +145,8 @@ public:
       pd_poa(0),
       pd_localId(0),
       pd_deadline_secs(0),
-      pd_deadline_nanosecs(0) {}
+      pd_deadline_nanosecs(0),
+      pd_asyncCall(0) {}
 
   virtual ~omniCallDescriptor() {}
 
@@ -228,6 +230,9 @@ public:
     pd_deadline_nanosecs = nanosecs;
   }
 
+  inline void asyncCall(omniAsyncCall* c) { pd_asyncCall = c; }
+  inline omniAsyncCall* asyncCall() const { return pd_asyncCall; }
+
   inline void containsValues(_CORBA_Boolean v) {
     pd_contains_values = v;
   }
@@ -301,6 +306,10 @@ private:
   unsigned long                pd_deadline_secs;
   unsigned long                pd_deadline_nanosecs;
 
+  omniAsyncCall*               pd_asyncCall;
+  // Set on the client side if the caller does not wait for the reply.
+  // See omniAsyncCall.h.
+
   omniCallDescriptor(const omniCallDescriptor&);
   omniCallDescriptor& operator = (const omniCallDescriptor&);
   // Not implemented.
@@ -803,6 +803,13 @@ public:
 
   virtual void declareArrayLength(omni::alignment_t align, size_t size);
 
+  static void swapArray16(void* a, _CORBA_ULong n);
+  static void swapArray32(void* a, _CORBA_ULong n);
+  static void swapArray64(void* a, _CORBA_ULong n);
+  // Reverse the byte order of each of the <n> 2, 4 or 8 byte items at
+  // <a>. Used on arrays unmarshalled from a stream in the other byte
+  // order.
+
   inline void
   unmarshalArrayChar(_CORBA_Short* a, int length)
   {
@@ -827,8 +834,7 @@ public:
     get_octet_array((_CORBA_Char*) a, length * 2, omni::ALIGN_2);
 
     if( unmarshal_byte_swap() )
-      for( int i = 0; i < length; i++ )
-	a[i] = Swap16(a[i]);
+      swapArray16(a, length);
   }
 
 
@@ -838,8 +844,7 @@ public:
     get_octet_array((_CORBA_Char*) a, length * 2, omni::ALIGN_2);
 
     if( unmarshal_byte_swap() )
-      for( int i = 0; i < length; i++ )
-	a[i] = Swap16(a[i]);
+      swapArray16(a, length);
   }
 
   inline void
@@ -848,8 +853,7 @@ public:
     get_octet_array((_CORBA_Char*) a, length * 4, omni::ALIGN_4);
 
     if( unmarshal_byte_swap() )
-      for( int i = 0; i < length; i++ )
-	a[i] = Swap32(a[i]);
+      swapArray32(a, length);
   }
 
   inline void
@@ -858,8 +862,7 @@ public:
     get_octet_array((_CORBA_Char*) a, length * 4, omni::ALIGN_4);
 
     if( unmarshal_byte_swap() )
-      for( int i = 0; i < length; i++ )
-	a[i] = Swap32(a[i]);
+      swapArray32(a, length);
   }
 
 #ifdef HAS_LongLong
@@ -869,8 +872,7 @@ public:
     get_octet_array((_CORBA_Char*) a, length * 8, omni::ALIGN_8);
 
     if( unmarshal_byte_swap() )
-      for( int i = 0; i < length; i++ )
-	a[i] = Swap64(a[i]);
+      swapArray64(a, length);
   }
 
   inline void
@@ -879,8 +881,7 @@ public:
     get_octet_array((_CORBA_Char*) a, length * 8, omni::ALIGN_8);
 
     if( unmarshal_byte_swap() )
-      for( int i = 0; i < length; i++ )
-	a[i] = Swap64(a[i]);
+      swapArray64(a, length);
   }
 #endif
 
@@ -890,12 +891,8 @@ public:
   {
     get_octet_array((_CORBA_Char*) a, length * 4, omni::ALIGN_4);
 
-    if( unmarshal_byte_swap() ) {
-      _CORBA_ULong* p=(_CORBA_ULong*)a;
-      for( int i = 0; i < length; i++ ) {
-	p[i] = Swap32(p[i]);
-      }
-    }
+    if( unmarshal_byte_swap() )
+      swapArray32(a, length);
   }
 
 
@@ -904,18 +901,8 @@ public:
   {
     get_octet_array((_CORBA_Char*) a, length * 8, omni::ALIGN_8);
 
-    if( unmarshal_byte_swap() ) {
-      struct LongArray2 {
-        _CORBA_ULong l[2];
-      };
-      LongArray2* p=(LongArray2*)a;
-      for( int i = 0; i < length; i++ ) {
-        LongArray2 l;
-        l.l[0] = Swap32(p[i].l[1]);
-        l.l[1] = Swap32(p[i].l[0]);
-        p[i] = l;
-      }
-    }
+    if( unmarshal_byte_swap() )
+      swapArray64(a, length);
 #ifdef OMNI_MIXED_ENDIAN_DOUBLE
     {
       struct LongArray2 {
@@ -404,6 +404,13 @@ public:
   // index zero means there is no mapping for the character in
   // question, and a DATA_CONVERSION exception should be thrown.
 
+  static inline _CORBA_Boolean isASCII(const UniChar* toU) {
+    for (UniChar c=0; c < 0x80; c++)
+      if (toU[c] != c) return 0;
+    return 1;
+  }
+  // True if an 8 bit to Unicode table leaves ASCII characters alone.
+
   class NCS_C_8bit : public NCS_C {
   public:
 
@@ -424,6 +431,10 @@ public:
     inline const UniChar*      toU()   const { return pd_toU; }
     inline const _CORBA_Char** fromU() const { return pd_fromU; }
 
+    inline _CORBA_Boolean asciiCompatible() const { return pd_ascii; }
+    // True if the code set agrees with ASCII for 0 to 0x7f, so strings
+    // of only those characters need no conversion to or from UTF-8.
+
     NCS_C_8bit(CONV_FRAME::CodeSetId id_,
 	       const char*           name_,
 	       const UniChar*        toU_,
@@ -431,7 +442,8 @@ public:
 
       : NCS_C(id_, name_, CS_8bit),
 	pd_toU(toU_),
-	pd_fromU(fromU_)
+	pd_fromU(fromU_),
+	pd_ascii(isASCII(toU_))
     { }
 
     virtual ~NCS_C_8bit() {};
@@ -439,6 +451,7 @@ public:
   private:
     const UniChar*      pd_toU;
     const _CORBA_Char** pd_fromU;
+    _CORBA_Boolean      pd_ascii;
   };
 
   class TCS_C_8bit : public TCS_C {
@@ -478,6 +491,8 @@ public:
     inline const UniChar*      toU()   const { return pd_toU; }
     inline const _CORBA_Char** fromU() const { return pd_fromU; }
 
+    inline _CORBA_Boolean asciiCompatible() const { return pd_ascii; }
+
     TCS_C_8bit(CONV_FRAME::CodeSetId id_,
 	       const char*           name_,
 	       GIOP::Version         giopVersion_,
@@ -486,7 +501,8 @@ public:
 
       : TCS_C(id_, name_, CS_8bit, giopVersion_),
 	pd_toU(toU_),
-	pd_fromU(fromU_)
+	pd_fromU(fromU_),
+	pd_ascii(isASCII(toU_))
     { }
 
     virtual ~TCS_C_8bit() {}
@@ -494,6 +510,7 @@ public:
   private:
     const UniChar*      pd_toU;
     const _CORBA_Char** pd_fromU;
+    _CORBA_Boolean      pd_ascii;
   };
 
   static _core_attr const _CORBA_Char empty8BitTable[];
@@ -118,6 +118,20 @@ public:
 		   unsigned long deadline_nanosecs = 0) = 0;
   virtual void Shutdown() = 0;
 
+  struct SendBuffer {
+    void*  buf;
+    size_t sz;
+  };
+
+  virtual int Sendv(const SendBuffer* bufs, int count,
+		    unsigned long deadline_secs = 0,
+		    unsigned long deadline_nanosecs = 0);
+  // Gathering version of Send(). Send as much of the <count> buffers,
+  // in order, as can be sent in one go and return the number of bytes
+  // sent, with the same error returns as Send(). The default
+  // implementation just calls Send() on the first non-empty buffer;
+  // transports that can do better override it.
+
   virtual const char* myaddress() = 0;
   virtual const char* peeraddress() = 0;
 
@@ -160,7 +174,10 @@ public:
 
   int decrRefCount(_CORBA_Boolean forced=0);
   // Thread Safety preconditions:
-  //    Caller must hold omniTransportLock unless forced == 1.
+  //    None. The count is updated atomically, since client strands
+  //    release their connection holding their rope's lock, while the
+  //    giopServer releases server and bidirectional connections
+  //    holding omniTransportLock.
 
   void incrRefCount();
   // Thread Safety preconditions:
@@ -184,7 +201,8 @@ protected:
 
 private:
 
-  int            pd_refcount;
+  volatile int   pd_refcount;
+  // Updated atomically. See decrRefCount().
 
   _CORBA_Boolean pd_dying;
   // Initialised to 0. Read and write by giopServer exclusively.
@@ -143,6 +143,13 @@ class GIOP_C : public IOP_C, public giopStream, public giopStreamList {
 
   inline giopRope* rope() const { return pd_rope; }
 
+  void sleepOnRdLock();
+  // override giopStream member. Block on this call's own condition
+  // variable rather than the strand's, so that the caller is only woken
+  // when its reply has arrived or it may take over the read lock.
+
+  friend class giopStrand;
+
 private:
   IOP_C::State            pd_state;
   omniCallDescriptor*     pd_calldescriptor;
@@ -154,6 +161,14 @@ private:
   GIOP::LocateStatusType  pd_locateStatus;
   CORBA::ULong            pd_reply_id;
 
+  // Used by the strand to demultiplex replies. See giopStrand.h.
+  GIOP_C*                 pd_nextCall;
+  omni_tracedcondition    pd_replyCond;
+  GIOP_C*                 pd_nextWaiter;
+  GIOP_C*                 pd_prevWaiter;
+  CORBA::Boolean          pd_replyWaiting;
+  GIOP_C*                 pd_nextAsync;
+
   void UnMarshallSystemException();
 
   GIOP_C();
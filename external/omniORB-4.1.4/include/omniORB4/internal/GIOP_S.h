@@ -150,6 +150,12 @@ class GIOP_S : public IOP_S, public giopStream, public giopStreamList {
   omniCallDescriptor* calldescriptor() { return pd_calldescriptor; }
   void calldescriptor(omniCallDescriptor* c) { pd_calldescriptor = c; }
 
+  //////////////////////////////////////////////////////////////////
+  const char* targetRepoId() const { return pd_targetRepoId; }
+  // Most derived repository id of the servant the current request has
+  // been dispatched to, or 0 if it has not got that far. Unlike the
+  // call descriptor, it remains valid after a user exception.
+
   //////////////////////////////////////////////////////////////////
   GIOP::MsgType requestType() const { return pd_requestType; }
   void requestType(GIOP::MsgType m) { pd_requestType = m; }
@@ -236,6 +242,7 @@ private:
   IOP_S::State             pd_state;
   giopWorker*              pd_worker;
   omniCallDescriptor*      pd_calldescriptor;
+  const char*              pd_targetRepoId;
   const char* const*       pd_user_excns;
   int                      pd_n_user_excns;
   GIOP::MsgType            pd_requestType;
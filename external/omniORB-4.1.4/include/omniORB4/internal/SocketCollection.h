@@ -176,6 +176,17 @@
 #   undef USE_POLL
 #endif
 
+#if defined(USE_POLL) && defined(__linux__)
+    // epoll is available as an alternative to poll(), selected at
+    // runtime with the connectionWatchEpoll parameter.
+#   define USE_EPOLL
+#endif
+
+#if !defined(__WIN32__) && !defined(__vxWorks__) && !defined(__VMS)
+    // Gathering sends with writev() for giopConnection::Sendv().
+#   define USE_WRITEV
+#endif
+
 #if defined(__hpux__)
 #   if __OSVERSION__ < 11
 #       undef USE_POLL
@@ -258,6 +269,15 @@ OMNI_NAMESPACE_END(omni)
 #    include <poll.h>
 #  endif
 
+#  if defined(USE_EPOLL)
+#    include <sys/epoll.h>
+#  endif
+
+#  if defined(USE_WRITEV)
+#    include <sys/uio.h>
+#    include <limits.h>
+#  endif
+
 #  include <fcntl.h>
 
 #  if defined (__uw7__)
@@ -384,6 +404,13 @@ public:
   // return true if the socket becomes readable, otherwise return
   // false.
 
+  int waitWritable(unsigned long deadline_secs,
+		   unsigned long deadline_nanosecs);
+  // Used by the transports' Send() and Sendv(). If a deadline is
+  // given, wait until the socket can be written without blocking.
+  // Return 1 if it can, or if there is no deadline, 0 if the deadline
+  // passes first, and -1 on error.
+
   friend class SocketCollection;
 
 protected:
@@ -404,7 +431,8 @@ private:
   int                  	pd_fd_index;       // -1 if select thread is not
 					   // watching; otherwise, index of
 					   // the fd within the poll / select
-					   // list.
+					   // list. With epoll, 0 if registered
+					   // but disarmed, 1 if armed.
   SocketHolder*        	pd_next;
   SocketHolder**       	pd_prev;
 };
@@ -488,6 +516,57 @@ private:
   void growPollLists();
   // Expand the pd_pollfds and pd_pollsockets to fit more values.
 
+#  if defined(USE_EPOLL)
+  // If connectionWatchEpoll is set and an epoll instance can be
+  // created, pd_epoll_fd is its descriptor and the poll lists above
+  // are not used; otherwise it is -1. Sockets are registered with
+  // EPOLLONESHOT, so a socket reported readable is disarmed until it
+  // is next made selectable, in the same way that the poll()
+  // implementation drops it from pd_pollfds. The cost of a Select()
+  // is therefore proportional to the number of ready sockets, not
+  // the number of connections.
+  //
+  // Events identify sockets by fd and a generation number, looked up
+  // in pd_epoll_entries, so that an event for a socket removed while
+  // the Select thread was outside the lock is safely discarded.
+  // Sockets made selectable with data_in_buffer are queued in
+  // pd_epoll_pending and dispatched at the start of the next Select().
+
+  struct EpollEntry {
+    SocketHolder* sock;
+    CORBA::ULong  gen;
+  };
+  struct EpollKey {
+    SocketHandle_t fd;
+    CORBA::ULong   gen;
+  };
+
+  int                  pd_epoll_fd;
+  struct epoll_event*  pd_epoll_events;
+  EpollEntry*          pd_epoll_entries;
+  unsigned             pd_epoll_entries_len;
+  CORBA::ULong         pd_epoll_gen;
+  EpollKey*            pd_epoll_pending;
+  unsigned             pd_epoll_pending_n;
+  unsigned             pd_epoll_pending_len;
+
+  CORBA::Boolean epollSelect();
+  // Select() implementation used when pd_epoll_fd is valid.
+
+  void epollAdd(SocketHolder* sock);
+  void epollRemove(SocketHolder* sock);
+  // Maintain pd_epoll_entries as sockets join and leave the collection.
+
+  void epollArm(SocketHolder* sock);
+  // Ensure sock is registered and armed for readability.
+
+  void epollPending(SocketHolder* sock);
+  // Queue sock for dispatch in the next Select().
+
+  void epollDispatchPending();
+  // Dispatch queued sockets that still have data in their buffer.
+#  endif
+
 #elif defined(__WIN32__)
   // Windows has select() but its fd_sets are more like pollfds, just
   // less convenient...
@@ -171,6 +171,18 @@ public:
       }
       pd_buf[pd_i++] = c;
     }
+    // Make room for n more characters, to be written at the returned
+    // pointer and then accounted for with advance().
+    inline char* room(_CORBA_ULong n) {
+      if (pd_i + n > pd_len) {
+	_CORBA_ULong newlen = pd_len * 2;
+	if (newlen < pd_i + n) newlen = pd_i + n;
+	pd_buf = reallocC(pd_buf, pd_i, newlen);
+	pd_len = newlen;
+      }
+      return pd_buf + pd_i;
+    }
+    inline void advance(_CORBA_ULong n) { pd_i += n; }
     inline _CORBA_ULong length() { return pd_i; }
     inline char*        buffer() { return pd_buf; }
     inline char* extract() {
@@ -201,6 +213,16 @@ public:
       }
       pd_buf[pd_i++] = c;
     }
+    inline omniCodeSet::UniChar* room(_CORBA_ULong n) {
+      if (pd_i + n > pd_len) {
+	_CORBA_ULong newlen = pd_len * 2;
+	if (newlen < pd_i + n) newlen = pd_i + n;
+	pd_buf = reallocU(pd_buf, pd_i, newlen);
+	pd_len = newlen;
+      }
+      return pd_buf + pd_i;
+    }
+    inline void advance(_CORBA_ULong n) { pd_i += n; }
     inline _CORBA_ULong          length() { return pd_i; }
     inline omniCodeSet::UniChar* buffer() { return pd_buf; }
     inline omniCodeSet::UniChar* extract() {
@@ -244,6 +266,42 @@ public:
     _CORBA_WChar* pd_buf;
   };
 
+  //
+  // Conversion kernels
+  //
+  // These deal with runs of ASCII characters a block at a time, using
+  // SSE2, or AVX2 where the processor has it, and one word or
+  // character at a time elsewhere. Converters use them to get through
+  // the ASCII parts of a string quickly, and convert anything else one
+  // character at a time themselves.
+
+  static _CORBA_ULong asciiLength(const char* s, _CORBA_ULong len);
+  // Returns the number of ASCII characters at the start of s[0..len).
+
+  static _CORBA_ULong widenASCII(const char* s, _CORBA_ULong len,
+				 omniCodeSet::UniChar* us);
+  // Copies the ASCII characters at the start of s[0..len) to us, and
+  // returns how many there were.
+
+  static _CORBA_ULong narrowASCII(const omniCodeSet::UniChar* us,
+				  _CORBA_ULong len, char* s);
+  // Copies the characters below 0x80 at the start of us[0..len) to s,
+  // and returns how many there were.
+
+  static void swapU(omniCodeSet::UniChar* us, _CORBA_ULong len);
+  // Byte swaps us[0..len) in place.
+
+#if (SIZEOF_WCHAR == 4)
+  static _CORBA_ULong narrowW(const _CORBA_WChar* ws, _CORBA_ULong len,
+			      omniCodeSet::UniChar* us);
+  // Copies the characters up to 0xffff at the start of ws[0..len) to
+  // us, and returns how many there were.
+
+  static void widenW(const omniCodeSet::UniChar* us, _CORBA_ULong len,
+		     _CORBA_WChar* ws);
+  // Copies us[0..len) to ws.
+#endif
+
   //
   // Memory holders
   //
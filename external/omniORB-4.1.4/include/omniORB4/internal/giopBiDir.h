@@ -156,7 +156,9 @@ class BiDirClientRope : public giopRope {
 		       omniCallDescriptor*);  // override giopRope
  private:
 
-  omni_tracedmutex pd_lock;
+  omni_tracedmutex pd_connectLock;
+  // Serialises connecting the rope's strand and registering it with the
+  // giopServer.
 
   BiDirClientRope();
   BiDirClientRope(const BiDirClientRope&);
@@ -114,20 +114,27 @@ class giopRope : public Rope, public RopeLink {
   // This is normally the entry function that causes a rope to be created
   // in the first place.
   //
+  // The existing ropes are found through a hash table indexed by their
+  // address lists.
   //
   // Thread Safety preconditions:
   //    Caller must not hold omniTransportLock, it is used internally for
   //    synchronisation.
 
   giopRope(const giopAddressList& addrlist, 
-	   const omnivector<CORBA::ULong>& preferred);
+	   const omnivector<CORBA::ULong>& preferred,
+	   CORBA::Boolean sharedLock = 0);
   // <list> & <preferred> are copied.
   // Reference count is initialised to 0.
+  // If <sharedLock> is TRUE(1), the strands of the rope are protected by
+  // omniTransportLock. Otherwise the rope has a lock of its own, so that
+  // calls through this rope do not contend with calls through other ropes.
   // No thread safety precondition
 
-  giopRope(giopAddress* addr, int i = 0);
+  giopRope(giopAddress* addr, int i = 0, CORBA::Boolean sharedLock = 0);
   // <addr> is consumed by this instance.
   // Reference count is initialised to <i>
+  // <sharedLock> is as above.
   // No thread safety precondition
 
   virtual ~giopRope();
@@ -141,7 +148,7 @@ class giopRope : public Rope, public RopeLink {
   // Acquire a GIOP_C from this rope.
   //
   // Thread Safety preconditions:
-  //    Caller must not hold omniTransportLock, it is used internally for
+  //    Caller must not hold the rope's lock, it is used internally for
   //    synchronisation.
 
   void releaseClient(IOP_C*);
@@ -150,7 +157,7 @@ class giopRope : public Rope, public RopeLink {
   // from a different rope would result in undefined behaviour.
   //
   // Thread Safety preconditions:
-  //    Caller must not hold omniTransportLock, it is used internally for
+  //    Caller must not hold the rope's lock, it is used internally for
   //    synchronisation.
 
 
@@ -192,7 +199,7 @@ class giopRope : public Rope, public RopeLink {
   // the first call is made.
   //
   // Thread Safety preconditions:
-  //    Internally, omniTransportLock is used for synchronisation, if
+  //    Internally, the rope's lock is used for synchronisation, if
   //    <heldlock> is TRUE(1), the caller already hold the lock.
 
   // Access functions to change the rope parameters. Notice that these
@@ -232,11 +239,22 @@ class giopRope : public Rope, public RopeLink {
 
   friend class giopStream;
   friend class giopStrand;
+  friend class Scavenger;
   friend class omni_giopRope_initialiser;
+  friend class omni_giopStrand_initialiser;
   friend class omni_giopbidir_initialiser;
 
  protected:
-  int                  pd_refcount;  // reference count
+  omni_tracedmutex     pd_ownLock;
+  omni_tracedmutex*    pd_lock;      // Protects the strands of this rope,
+				     // pd_nwaiting and pd_address_in_use.
+				     // Either &pd_ownLock or
+				     // omniTransportLock.
+  int                  pd_refcount;  // reference count. Protected by
+				     // omniTransportLock.
+  volatile int         pd_nstrands;  // Number of strands using pd_lock,
+				     // whether on pd_strands or not.
+				     // Updated atomically.
   giopAddressList      pd_addresses; // Addresses of the remote address space
   omnivector<CORBA::ULong>              pd_addresses_order;
   omnivector<CORBA::ULong>::size_type   pd_address_in_use;
@@ -246,18 +264,69 @@ class giopRope : public Rope, public RopeLink {
   omni_tracedcondition pd_cond;
   CORBA::Boolean       pd_offerBiDir; // State of orbParameters::offerBiDir...
 				      // at time of creation.
+  CORBA::ULong         pd_hashValue;  // Hash of pd_addresses.
+  giopRope*            pd_nextInRopeTable;
+  CORBA::Boolean       pd_inRopeTable;
+
+  static giopRope**    ropeTable;
+  static CORBA::ULong  ropeTableSize;
+  static int           ropeTableSizeI;
+  static CORBA::ULong  numRopesInTable;
+  static CORBA::ULong  maxNumRopes;
+  // All ropes created by selectRope and its equivalents are entered in
+  // this hash table, chained through pd_nextInRopeTable. The table only
+  // ever grows. Protected by omniTransportLock.
+
+  static void addToRopeTable(giopRope*);
+  // Enter the rope into the rope table.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold omniTransportLock.
+
+  static void deleteRope(giopRope*);
+  // Remove the rope from the rope table and from the RopeLink list it is
+  // a member of, if any, then delete it. The rope must have no strands
+  // and a reference count of 0.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold omniTransportLock.
 
-  static _core_attr RopeLink ropes;
-  // All ropes created by selectRope are linked together by this list.
+  static CORBA::ULong hashAddresses(const giopAddressList&);
+  // Return the hash value of the address list.
+  // No thread safety precondition
+
+  CORBA::Boolean isGarbage();
+  // Return TRUE(1) if the rope is not used by anything and can be
+  // deleted. Strands that have been taken off the rope but not yet
+  // deleted still use its lock, so the rope is not garbage until they
+  // are gone. The strands are looked at under the rope's lock, so that
+  // a thread that deleted the last of them has released it.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold omniTransportLock but not the rope's lock, unless
+  //    the two are the same. Once the reference count has gone to 0, no
+  //    other thread adds strands to the rope.
+
+  void strandCreated();
+  void strandDeleted();
+  // Count a strand that uses this rope's lock in and out.
+  //
+  // Thread Safety preconditions:
+  //    strandCreated(): caller must hold the rope's lock.
+  //    strandDeleted(): none; the strand must not touch the rope's lock
+  //    afterwards, except that a caller holding it may release it.
 
   virtual void realIncrRefCount();
   // Really increment the reference count.
   //
   // Thread Safety preconditions:
-  //    Caller must hold omniTransportLock.
+  //    Caller must hold omniTransportLock but not the rope's lock, unless
+  //    the two are the same.
 
-  CORBA::Boolean match(const giopAddressList&) const;
-  // Return TRUE(1) if the address list matches EXACTLY those of this rope.
+  virtual CORBA::Boolean match(const giopAddressList&) const;
+  // Return TRUE(1) if the address list matches EXACTLY those of this rope
+  // and the rope can be shared by any object reference with these
+  // addresses.
   // No thread safety precondition
 
   static void filterAndSortAddressList(const giopAddressList& list,
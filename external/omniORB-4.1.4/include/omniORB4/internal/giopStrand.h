@@ -88,6 +88,7 @@
 #define __GIOPSTRAND_H__
 
 #include <omniORB4/omniTransport.h>
+#include <timerWheel.h>
 
 #ifdef _core_attr
 # error "A local CPP macro _core_attr has already been defined."
@@ -106,7 +107,9 @@ class giopStream;
 class giopStreamImpl;
 class giopWorker;
 class giopServer;
+class giopRope;
 class GIOP_S;
+class GIOP_C;
 struct giopStream_Buffer;
 
 ////////////////////////////////////////////////////////////////////////
@@ -148,18 +151,23 @@ private:
 class giopStrand : public Strand {
 public:
 
-  giopStrand(const giopAddress*);
+  giopStrand(const giopAddress*,giopRope*);
   // Ctor for an active strand. I.e. those that are used to connect to
   // a remote address space.
   // When a connection is establshed, the reference count goes to 1.
+  // The strand's state is protected by the lock of the given rope, so
+  // the strand is counted in the rope, which is not deleted until the
+  // strand has been.
   //
-  // No thread safety precondition
+  // Thread Safety preconditions:
+  //    Caller must hold the rope's lock.
 
 
   giopStrand(giopConnection*,giopServer*);
   // Ctor for a passive strand. I.e. those that are created because a
   // client has connected to this address space.
   // Increment the reference count on the connection.
+  // The strand's state is protected by omniTransportLock.
   //
   // No thread safety precondition
 
@@ -189,10 +197,13 @@ public:
   // reference count goes to 0 as well.
   //
   // Thread Safety preconditions:
-  //    Caller must hold omniTransportLock unless forced == 1.
+  //    Caller must hold <mutex> unless forced == 1.
 
 private:
   CORBA::Boolean pd_safelyDeleted;
+  giopRope*      pd_rope;
+  // The rope whose lock is <mutex>, for an active strand; 0 for a
+  // passive strand. Immutable.
 
 public:
 
@@ -212,7 +223,7 @@ public:
   //
   // 
   // Thread Safety preconditions:
-  //    Caller must hold omniTransportLock.
+  //    Caller must hold <mutex>.
 
 
   GIOP_S* acquireServer(giopWorker*);
@@ -223,7 +234,7 @@ public:
   // Return 0 if a GIOP_S cannot be acquired.
   //
   // Thread Safety preconditions:
-  //    Caller must not hold omniTransportLock, it is used internally for
+  //    Caller must not hold <mutex>, it is used internally for
   //    synchronisation.
 
   void   releaseServer(IOP_S*);
@@ -232,7 +243,7 @@ public:
   // from a different strand would result in undefined behaviour.
   //
   // Thread Safety preconditions:
-  //    Caller must not hold omniTransportLock, it is used internally for
+  //    Caller must not hold <mutex>, it is used internally for
   //    synchronisation.
 
 
@@ -259,7 +270,7 @@ public:
   // returns 0 if the idle counter is already active or has already expired.
   //
   // Thread Safety preconditions:
-  //    Caller must hold omniTransportLock.
+  //    Caller must hold <mutex>.
 
   CORBA::Boolean stopIdleCounter();
   // returns 1 if the idle counter has been successfully stopped.
@@ -268,16 +279,38 @@ public:
   // to be shutdown and hence should cleanup its usage accordingly.
   //
   // Thread Safety preconditions:
-  //    Caller must hold omniTransportLock.
+  //    Caller must hold <mutex>.
 
 
   ////////////////////////////////////////////////////////////////////////
-  // When idlebeats go to 0, the strand has been idle for a sufficently
-  // long time and should be deleted.
+  // -1 if the idle counter is not running, 1 while it is and 0 once it
+  // has expired. When it expires, the strand has been idle for a
+  // sufficently long time and should be deleted.
   // This variable SHOULD NOT be manipulated outside the implementation of
   // giopStrand.
   CORBA::Long         idlebeats;
 
+  class IdleTimer : public omniTimer {
+  public:
+    IdleTimer(giopStrand* s) : pd_strand(s), pd_since(0), pd_armed(0) {}
+    void expire();
+    void stopped();
+  private:
+    giopStrand*      pd_strand;
+    CORBA::ULongLong pd_since;   // When the idle counter was started.
+    CORBA::Boolean   pd_armed;   // Whether the timer is scheduled.
+    // Protected by the strand's mutex.
+
+    friend class giopStrand;
+  };
+  IdleTimer           idleTimer;
+  // Armed when the idle counter is started. It is not disarmed when
+  // the counter is stopped, which would cost a visit to the timer
+  // wheel for every call; instead, when the timer goes off it checks
+  // whether the strand has been idle for the whole period, and is
+  // scheduled again for the rest of the period if not. If the strand
+  // is busy, the timer lapses until the counter is next started.
+
 
   giopStreamList      servers;
   giopStreamList      clients;
@@ -374,6 +407,13 @@ public:
   //   and the GIOP version for which the convertors apply.
 
 
+  omni_tracedmutex*    mutex;
+  // Protects the state of this strand, its giopStream lists and the
+  // locking counters below. For an active strand, this is the lock of
+  // the rope it belongs to; for a passive strand it is omniTransportLock.
+  // Bidirectional ropes also use omniTransportLock, since their strands
+  // are managed by the giopServer as well.
+
   // conditional variables and counters to implement giopStream locking
   // functions.
   omni_tracedcondition rdcond;
@@ -387,49 +427,183 @@ public:
   // Return a number suitable for use as the GIOP request id.
   //
   // Thread Safety preconditions:
-  //    Caller must hold omniTransportLock.
+  //    Caller must hold <mutex>.
 
 private:
   CORBA::ULong         seqNumber;
   // monotonically increasing number to be used as the GIOP request id.
 
+public:
+  ////////////////////////////////////////////////////////////////////////
+  // From GIOP 1.2 onwards, any number of calls may be outstanding on
+  // the strand. Each GIOP_C is entered in a hash table keyed by its
+  // request id for as long as it is in use, so that the thread holding
+  // the read lock can hand each incoming reply straight to its caller.
+
+  void addCall(GIOP_C*);
+  // Enter the GIOP_C in the table under its current request id.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold <mutex>.
+
+  void removeCall(GIOP_C*);
+  // Remove the GIOP_C from the table. Does nothing if it is not there.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold <mutex>.
+
+  GIOP_C* findCall(CORBA::ULong reqid);
+  // Return the GIOP_C waiting for a reply to <reqid>, or 0 if there is
+  // none.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold <mutex>.
+
+  inline CORBA::ULong outstandingCalls() const { return pd_ncalls; }
+  // Number of GIOP_Cs currently in the table.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold <mutex>.
+
+  ////////////////////////////////////////////////////////////////////////
+  // Clients waiting for a reply do not all block on <rdcond>. Each
+  // GIOP_C sleeps on its own condition variable and is queued here, so
+  // that when its reply is buffered by another thread only that caller
+  // is woken, and when the read lock is released only one waiter is
+  // woken to take it over.
+
+  void addReplyWaiter(GIOP_C*);
+  void removeReplyWaiter(GIOP_C*);
+  // Queue or dequeue a waiting GIOP_C. removeReplyWaiter() does nothing
+  // if the GIOP_C is not queued.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold <mutex>.
+
+  CORBA::Boolean isReplyWaiter(GIOP_C*);
+  // True if the GIOP_C is queued, i.e. its thread is blocked waiting
+  // for its reply or for the read lock.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold <mutex>.
+
+  void wakeUpReplyWaiter(GIOP_C*);
+  // Wake up the GIOP_C if it is queued.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold <mutex>.
+
+  void wakeUpReplyWaiter();
+  // Wake up the longest waiting GIOP_C, if any.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold <mutex>.
+
+  void wakeUpReplyWaiters();
+  // Wake up all queued GIOP_Cs.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold <mutex>.
+
+  ////////////////////////////////////////////////////////////////////////
+  // Asynchronous calls whose requests have been sent are queued here in
+  // the order they were sent. While the queue is not empty, a task run
+  // by the async invoker receives their replies one at a time, and
+  // completes each call with omniRemoteIdentity::receiveAsyncReply().
+
+  void addAsyncCall(GIOP_C*);
+  // Queue the GIOP_C, and start the task if it is not running.
+  //
+  // Thread Safety preconditions:
+  //    Caller must not hold <mutex>.
+
+  GIOP_C* removeAsyncCall(CORBA::Boolean& last);
+  // Dequeue the oldest GIOP_C. <last> is set to true if the queue is
+  // then empty, in which case the task must stop.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold <mutex>.
+
+private:
+  GIOP_C**             pd_callTable;
+  CORBA::ULong         pd_callTableSize;   // always a power of 2
+  CORBA::ULong         pd_ncalls;
+  GIOP_C*              pd_replyWaiters;
+  GIOP_C*              pd_replyWaitersTail;
+  GIOP_C*              pd_asyncHead;
+  GIOP_C*              pd_asyncTail;
+  CORBA::Boolean       pd_asyncReading;
+  // The queue of asynchronous calls, and whether the task receiving
+  // their replies is running.
+
 
 public:
   giopStream_Buffer*   head;
   giopStream_Buffer*   spare;
 
 public:
-  static _core_attr StrandList  active;
-  static _core_attr StrandList  active_timedout;
+  ////////////////////////////////////////////////////////////////////////
+  // Oneway requests held back by giopStream::sendChunk(), to be written
+  // together with the next message sent on the strand, or by the oneway
+  // flusher when the coalescing window expires.
+
+  CORBA::Octet*        coalesced;
+  CORBA::ULong         coalescedSize;
+  // The requests, and the number of bytes of them. <coalesced> holds
+  // orbParameters::onewayCoalesceSize bytes once allocated.
+  // Protected by the write lock of the strand.
+
+  CORBA::Boolean       coalesceScheduled;
+  // True while the strand is queued for the flusher. The strand is
+  // neither deleted nor retired by the scavenger while this is set.
+  // Protected by <mutex>.
+
+  CORBA::Boolean scheduleFlush();
+  // Queue the strand for the flusher, unless it is queued already.
+  // Return false if the flusher has been shut down, in which case the
+  // caller must write the requests itself.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold the write lock but not <mutex>.
+
+private:
+  giopStrand*          pd_flushNext;
+  unsigned long        pd_flushSecs;
+  unsigned long        pd_flushNanosecs;
+  // The flusher's queue, and when the strand is due to be flushed.
+  // Protected by the flusher's lock.
+
+  friend class OnewayFlusher;
+
+public:
   static _core_attr StrandList  passive;
-  // Throughout the lifetime of a strand, it is a member of one and only one
-  // of the lists:
-  //   active           - the ORB uses this connection in the role of a client
-  //                      it is 'active' in the sense that the connection was
-  //                      initiated by this ORB
-  //   active_timedout  - the connection was previously active and has been
-  //                      idled for some time. It will be deleted soon.
-  //   passive          - the ORB uses this connection in the role of a server
-  //                      it is 'passive' because the connection was initiated
-  //                      by the remote party.
+  // All passive strands are members of this list. The ORB uses these
+  // connections in the role of a server. They are 'passive' because the
+  // connection was initiated by the remote party.
+  //
+  // Active strands, the connections initiated by this ORB, are only
+  // linked to the rope they belong to.
   //
+  // Protected by omniTransportLock.
 
 
-  static _core_attr CORBA::ULong idleOutgoingBeats;
-  // Number to instantiate idlebeats when the active strand becomes idle.
+  static _core_attr CORBA::ULong idleOutgoingPeriod;
+  // No. of msec. an active strand should be allowed to stay idle, or 0
+  // if it may stay idle forever.
 
-  static _core_attr CORBA::ULong idleIncomingBeats;
-  // idleIncomingBeats * scanPeriod == no. of sec. a passive strand should
-  // be allowed to stay idle.
+  static _core_attr CORBA::ULong idleIncomingPeriod;
+  // No. of msec. a passive strand should be allowed to stay idle, or 0
+  // if it may stay idle forever.
 
 public:
   void deleteStrandAndConnection(CORBA::Boolean forced=0);
   // Decrement connection's reference count. If it goes to 0, delete
   // this strand as well. This call ensures that both the strand and
-  // connection die at the same time.
+  // connection die at the same time. Once the strand is deleted, it
+  // is no longer counted in its rope.
   //
   // Thread Safety preconditions:
-  //    Caller must hold omniTransportLock unless forced == 1.
+  //    Caller must hold <mutex> unless forced == 1.
 
 #ifdef __GNUG__
   friend class keep_gcc_happy;
@@ -146,12 +146,34 @@ public:
     pd_deadline_nanosecs = nanosecs;
   }
   // No thread safety precondition
+
+  inline void coalesce(CORBA::Boolean yes) { pd_coalesce = yes; }
+  // If true, the message being marshalled is a oneway request that
+  // sendChunk() may hold back in the strand, to be written together
+  // with later messages. See orbParameters::onewayCoalesce.
+  // reset() sets it to false.
+  //
+  // No thread safety precondition
+
+  inline CORBA::ULongLong startTime() const { return pd_startTime; }
+  inline void startTime(CORBA::ULongLong t) { pd_startTime = t; }
+  // When the call on this stream started, in nanoseconds, as recorded
+  // by the call metrics interceptors.
+  //
+  // No thread safety precondition
+
+  void flushCoalesced();
+  // Write the oneway requests held back in the strand, if there are
+  // any.
+  //
+  // Thread Safety preconditions:
+  //   Caller must have acquired the write lock on the strand.
   
   ////////////////////////////////////////////////////////////////////////
   ////////////////////////////////////////////////////////////////////////
   // Thread Safety preconditions:
   //   Caller of these strand locking functions must hold the
-  //   omniTransportLock before calling.
+  //   strand's mutex before calling.
 
   virtual void rdLock();
   // Acquire read lock on the strand.
@@ -244,7 +266,7 @@ public:
   // retry = 0.
   //
   // Thread Safety preconditions:
-  //    Internally, omniTransportLock is used for synchronisation, if
+  //    Internally, the strand's mutex is used for synchronisation, if
   //    <heldlock> is TRUE(1), the caller already hold the lock.
 
   ////////////////////////////////////////////////////////////////////////
@@ -312,6 +334,8 @@ protected:
   giopStreamImpl*            pd_impl;
   unsigned long              pd_deadline_secs;
   unsigned long              pd_deadline_nanosecs;
+  CORBA::Boolean             pd_coalesce;
+  CORBA::ULongLong           pd_startTime;
 
 private:
   giopStream();
@@ -325,6 +349,13 @@ public:
   static _core_attr CORBA::ULong directSendCutOff;
   static _core_attr CORBA::ULong directReceiveCutOff;
 
+  static _core_attr CORBA::ULong handOffReadCutOff;
+  // When a thread reading a connection meets the reply for another
+  // caller, and more than this number of bytes of the reply are still
+  // to come, it passes the read lock to that caller instead of staging
+  // the rest of the reply in buffers. The caller can then receive
+  // large octet arrays straight into their final storage.
+
   static _core_attr CORBA::ULong bufferSize;
   // Allocate this number of bytes for each giopStream_Buffer.
 
@@ -513,8 +544,16 @@ private:
 
   // GIOP message are sent via these member functions
 
-  void sendChunk(giopStream_Buffer*);
-  // Send the buffer to the strand.
+  void sendChunk(giopStream_Buffer*, void* data = 0, CORBA::ULong size = 0);
+  // Send the buffer to the strand. If <data> is not 0, <size> bytes of
+  // application data are sent straight after the buffer, gathered into
+  // the same network sends with giopConnection::Sendv(). Neither is
+  // copied.
+  //
+  // Oneway requests held back in the strand are written first, in the
+  // same network send. If coalesce() is set, the buffer is instead
+  // added to them, unless that would take them past
+  // orbParameters::onewayCoalesceSize.
   //
   // The function honours the deadline set on the the object. If the deadline
   // is reached, the function should give up waiting.
@@ -537,6 +576,11 @@ protected:
   inline CORBA::ULong  requestId() const { return pd_request_id; }
   inline void requestId(CORBA::ULong v) { pd_request_id = v; }
 
+  void sleepOnRdLock(omni_tracedcondition& cond);
+  // Same as sleepOnRdLock() except that the thread blocks on <cond>
+  // instead of the strand's rdcond. The caller is responsible for
+  // arranging for <cond> to be signalled.
+
 };
 
 
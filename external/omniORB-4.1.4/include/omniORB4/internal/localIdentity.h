@@ -109,8 +109,24 @@ class omniCallHandle;
 OMNI_NAMESPACE_BEGIN(omni)
 class omniObjAdapter;
 class omniLocalIdentity_RefHolder;
+class omniLocalIdentity_FastHolder;
 OMNI_NAMESPACE_END(omni)
 
+// Atomic operations on the invocation counts, which fast local calls
+// update without holding <omni::internalLock>. Without them, fast
+// local calls are not available, and the counts are only ever updated
+// with the lock held.
+#if defined(__GNUC__)
+#  define LOCALID_HAVE_ATOMICS
+#  define LOCALID_ADD(p,v)    __sync_add_and_fetch(p,v)
+#  define LOCALID_CAS(p,o,n)  __sync_bool_compare_and_swap(p,o,n)
+#  define LOCALID_FENCE()     __sync_synchronize()
+#else
+#  define LOCALID_ADD(p,v)    (*(p) += (v))
+#  define LOCALID_CAS(p,o,n)  (*(p) == (o) ? (*(p) = (n), 1) : 0)
+#  define LOCALID_FENCE()
+#endif
+
 class omniLocalIdentity : public omniIdentity {
 public:
   inline ~omniLocalIdentity() {}
@@ -195,7 +211,7 @@ public:
 					   const omniIdentity*);
 
 protected:
-  int pd_nInvocations;
+  volatile int pd_nInvocations;
   // This count gives the number of method calls in progress
   // on this object.  When it goes to zero, we check to see
   // if anyone is interested in such an event.
@@ -204,6 +220,10 @@ protected:
   // that it never goes to zero.  The initial value is 1 for
   // this reason.  deactivate() decrements this value, so that
   // the adapter will be told when there are no invocations.
+  //  Updated with LOCALID_ADD() and LOCALID_CAS(), since fast local
+  // calls change it without holding <omni::internalLock>. They only
+  // do so while it is above 1, so it only ever reaches zero with
+  // the lock held, and once zero it does not change again.
 
   omniServant* pd_servant;
   // Nil if this object is not yet incarnated, but once set
@@ -225,6 +245,7 @@ protected:
 
 private:
   friend class _OMNI_NS(omniLocalIdentity_RefHolder);
+  friend class _OMNI_NS(omniLocalIdentity_FastHolder);
 
   omniLocalIdentity(const omniLocalIdentity&);
   omniLocalIdentity& operator = (const omniLocalIdentity&);
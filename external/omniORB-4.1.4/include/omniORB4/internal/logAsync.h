@@ -0,0 +1,78 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// logAsync.h                 Created on: 2026/10/17
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//    Asynchronous output of log messages.
+//
+
+#ifndef __LOGASYNC_H__
+#define __LOGASYNC_H__
+
+#include <stdio.h>
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+class omniAsyncLog {
+public:
+  static inline CORBA::Boolean queue(const char* msg, size_t len) {
+    return active && put(msg, len);
+  }
+  // Queue a formatted log message of <len> bytes for the flusher task
+  // to write. Returns false if asynchronous logging is not running, in
+  // which case the caller must write the message itself. A message
+  // that does not fit in the calling thread's buffer is dropped, and
+  // counted; that still returns true.
+
+  static volatile CORBA::Boolean active;
+
+  static CORBA::Boolean put(const char* msg, size_t len);
+
+  // Record format written to the log file with traceAsyncBinary. The
+  // fields are in the byte order of the host that wrote them; a
+  // reader can tell by the magic number. <length> bytes of message
+  // text, with no terminating null, follow the header. A record with
+  // a length of 0 reports that <dropped> messages from the thread
+  // were lost.
+  struct binaryRecord {
+    CORBA::ULong     magic;
+    CORBA::ULong     length;
+    CORBA::ULong     thread;       // omni_thread id, or 0xffffffff.
+    CORBA::ULong     dropped;
+    CORBA::ULongLong time;         // Nanoseconds since the epoch.
+  };
+  enum { BINARY_MAGIC = 0x6f4c4f47 };   // "oLOG" big-endian.
+};
+
+
+// Implemented in logIOstream.cc. Write a log message synchronously,
+// to the log function if one is set, otherwise to the log file.
+void omniLogOutput(const char* msg);
+
+FILE* omniLogFile();
+// The file log messages are written to, or zero if a log function
+// is set.
+
+OMNI_NAMESPACE_END(omni)
+
+#endif // __LOGASYNC_H__
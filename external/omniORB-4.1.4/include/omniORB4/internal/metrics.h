@@ -0,0 +1,78 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// metrics.h                  Created on: 2026/10/17
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//    Runtime counters, updated by the transport code. The public side
+//    is in omniMetrics.h.
+//
+
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <omniORB4/CORBA.h>
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+class omniMetricsP {
+public:
+  // Cumulative counters.
+  static volatile CORBA::ULongLong bytesSent;
+  static volatile CORBA::ULongLong bytesReceived;
+  static volatile CORBA::ULongLong connectionsOpened;
+  static volatile CORBA::ULongLong connectionsAccepted;
+  static volatile CORBA::ULongLong clientConnectionsClosed;
+  static volatile CORBA::ULongLong serverConnectionsClosed;
+  static volatile CORBA::ULongLong connectionsReadable;
+  static volatile CORBA::ULongLong logMessagesDropped;
+
+  // Current values.
+  static volatile CORBA::ULong     ropes;
+  static volatile CORBA::ULong     strands;
+  static volatile CORBA::ULong     watchedSockets;
+  static volatile CORBA::ULong     upcallThreads;
+
+#if defined(__GNUC__)
+  static inline void add(volatile CORBA::ULongLong& c, CORBA::ULongLong n) {
+    __sync_fetch_and_add(&c, n);
+  }
+  static inline void incr(volatile CORBA::ULong& c) {
+    __sync_fetch_and_add(&c, 1);
+  }
+  static inline void decr(volatile CORBA::ULong& c) {
+    __sync_fetch_and_sub(&c, 1);
+  }
+#else
+  // Without atomic operations, concurrent updates can be lost, so the
+  // counters are only approximate.
+  static inline void add(volatile CORBA::ULongLong& c, CORBA::ULongLong n) {
+    c += n;
+  }
+  static inline void incr(volatile CORBA::ULong& c) { c++; }
+  static inline void decr(volatile CORBA::ULong& c) { c--; }
+#endif
+};
+
+OMNI_NAMESPACE_END(omni)
+
+#endif // __METRICS_H__
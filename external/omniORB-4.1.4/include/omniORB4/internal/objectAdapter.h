@@ -187,6 +187,20 @@ public:
   virtual void dispatch(omniCallDescriptor&, omniLocalIdentity*) = 0;
   // Dispatch a local request.
 
+  virtual _CORBA_Boolean fastDispatch(omniCallDescriptor&,
+				      omniLocalIdentity*);
+  // Dispatch a local request without holding <omni::internalLock>,
+  // counting it with enterFast() and leaveFast(). Returns false,
+  // without making the call, if the adapter is not accepting
+  // requests; the caller then goes through dispatch() instead. The
+  // default implementation always returns false.
+
+  virtual _CORBA_Boolean fastDispatch(omniCallHandle&, omniLocalIdentity*);
+  // As above, for a request from another address space, or one made
+  // through a call handle, to an object entered with
+  // omniObjTableEntry::fastEnter(). The default implementation always
+  // returns false.
+
   virtual int objectExists(const _CORBA_Octet* key, int keysize) = 0;
   // This is only called for objects which are not in the active
   // object map.  Should return true if the adapter is able to
@@ -231,6 +245,16 @@ public:
     if( do_signal )  pd_signal->broadcast();
   }
 
+  inline _CORBA_Boolean fastCalls() const { return pd_fastCalls; }
+  // True if fast local calls may be made into this adapter.
+
+  void enterFast();
+  void leaveFast(int locked);
+  // Count a fast local call in and out of the adapter. These do not
+  // need <omni::internalLock>; <locked> says whether it is held.
+  // Threads waiting for requests to complete wait for these calls
+  // too.
+
   inline void detached_object() {
     sd_detachedObjectLock.lock();
     pd_nDetachedObjects++;
@@ -315,11 +339,22 @@ protected:
   // when done.
   //  Protected by <omni::internalLock>.
 
+  volatile int         pd_nReqFast;
+  // The number of fast local calls in progress in this adapter.
+  // Counted in both <pd_nReqInThis> and <pd_nReqActive> by threads
+  // waiting for them to go to zero.
+  //  Updated atomically, without <omni::internalLock>.
+
+  _CORBA_Boolean       pd_fastCalls;
+  // True if this adapter accepts fast local calls.
+  //  Immutable once the adapter is in use.
+
   omni_tracedcondition* pd_signal;
   // Uses <omni::internalLock> as mutex.
   //  Used to signal changes to:
   //     pd_nReqInThis,
   //     pd_nReqActive,
+  //     pd_nReqFast,
   //  Used in POA for changes to:
   //     pd_rq_state
 
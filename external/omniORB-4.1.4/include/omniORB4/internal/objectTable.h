@@ -170,6 +170,30 @@ public:
   virtual void loseRef(omniObjRef* obj = 0);
   // Overrides omniIdentity.
 
+  _CORBA_Boolean fastDispatch(omniCallDescriptor&);
+  // Dispatches a local call without taking <omni::internalLock>, if
+  // the object is active and its adapter is accepting fast calls.
+  // Returns false, without making the call, if it must go through
+  // dispatch() instead.
+  //  Must not hold <omni::internalLock>.
+
+  _CORBA_Boolean fastDispatch(omniCallHandle&);
+  // As above, for a request the caller has already entered with
+  // fastEnter(). The entry is left on return, whether or not the
+  // request was dispatched.
+  //  Must not hold <omni::internalLock>.
+
+  _CORBA_Boolean fastEnter();
+  // Count a call into the object without <omni::internalLock>.
+  // Returns false, without counting it, if the object is not active,
+  // or if the compiler has no atomic operations.
+
+  void fastLeave();
+  // Count a call entered with fastEnter() out again. Takes
+  // <omni::internalLock> if it is the last call into a deactivated
+  // object.
+  //  Must not hold <omni::internalLock>.
+
   //
   // Linked lists for object table and POA AOM.
 
@@ -232,7 +256,9 @@ private:
 
   omniObjTableEntry* pd_nextInObjectTable;
   // Object table is a hash table with chaining.  This is the linked
-  // list of objects which hash to the same entry.
+  // list of objects which hash to the same entry.  Changed only while
+  // holding <omni::internalLock>, but read without it by
+  // omniObjTable::lockActive().
 
   omniObjTableEntry*  pd_nextInOAObjList;
   omniObjTableEntry** pd_prevInOAObjList;
@@ -276,6 +302,33 @@ public:
   //  Must hold <omni::internalLock>.
   //  Does not throw any exceptions.
 
+  static omniObjTableEntry* lockActive(const _CORBA_Octet* key, int keysize,
+				       _CORBA_ULong hash);
+  // As locateActive() with <wait> true, but called without holding
+  // <omni::internalLock>. The table is searched without the lock. If
+  // an entry is returned, <omni::internalLock> is held on exit;
+  // otherwise it is not.
+  //  Does not throw any exceptions.
+
+  static _CORBA_Boolean fastDispatch(const _CORBA_Octet* key, int keysize,
+				     _CORBA_ULong hash,
+				     omniCallHandle& handle);
+  // Dispatch a request to the ACTIVE object with the given key, if
+  // there is one and its adapter accepts requests without
+  // <omni::internalLock>. Neither the search nor the dispatch takes
+  // the lock, unless the object is deactivated during the call.
+  // Returns false, without dispatching the request, if the caller must
+  // use lockActive() instead.
+  //  Must not hold <omni::internalLock>.
+
+  static _CORBA_Boolean isActive(const _CORBA_Octet* key, int keysize,
+				 _CORBA_ULong hash);
+  // Returns true if an ACTIVE or DEACTIVATING entry with the given
+  // key is in the table. The state is read without
+  // <omni::internalLock>, so the answer may be out of date by the
+  // time it is returned.
+  //  Must not hold <omni::internalLock>.
+
   static omniObjTableEntry*
   locate(const _CORBA_Octet* key, int keysize, _CORBA_ULong hash,
 	 _CORBA_ULong set = omniObjTableEntry::ALL_STATES);
@@ -299,9 +352,21 @@ public:
 
 
   static void resize();
-  // Resize the object table if necessary. Does nothing if the table
-  // does not need resizing.
+  // Start resizing the object table if necessary. Does nothing if the
+  // table does not need resizing. Entries are moved to the new table
+  // a few buckets at a time by later changes to the table.
   //  Must hold <omni::internalLock>.
+
+private:
+  static omniObjTableEntry* find(const _CORBA_Octet* key, int keysize,
+				 _CORBA_ULong hash);
+  static omniObjTableEntry* findUnlocked(const _CORBA_Octet* key,
+					 int keysize, _CORBA_ULong hash);
+  static void remove(omniObjTableEntry* entry);
+  static void retire(omniObjTableEntry* entry);
+  static void moveBuckets(_CORBA_ULong n);
+
+  friend class omniObjTableEntry;
 };
 
 #undef _core_attr
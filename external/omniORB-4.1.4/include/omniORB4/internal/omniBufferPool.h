@@ -0,0 +1,68 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// omniBufferPool.h           Created on: 2026/10/17
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//    Size-class pool for GIOP message buffers and cdrMemoryStream storage.
+//
+
+#ifndef __OMNIBUFFERPOOL_H__
+#define __OMNIBUFFERPOOL_H__
+
+#include <omniORB4/CORBA.h>
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+class omniBufferPool {
+public:
+
+  static void* allocate(size_t size);
+  // Return a block of at least <size> bytes, aligned to 8 bytes.
+  // Blocks of up to 64KB come from a per-thread free list if one is
+  // available, then from the shared free lists, and only then from the
+  // heap. Larger blocks always come from the heap.
+  // Thread Safety preconditions:
+  //    None.
+
+  static void release(void* block);
+  // Return a block obtained from allocate(). It is kept for reuse if
+  // the pool limits allow, otherwise it is deleted. It is safe to
+  // release a block in a different thread from the one that allocated
+  // it. A nil <block> is ignored.
+  // Thread Safety preconditions:
+  //    None.
+
+  static void stats(unsigned long& hits, unsigned long& misses,
+		    unsigned long& bytesRetained);
+  // Return the number of allocations satisfied from the pool, the
+  // number that went to the heap, and the total size of the free
+  // blocks currently held by the pool. Counters belonging to other
+  // threads are read without synchronisation, so the values are only
+  // approximate while the ORB is busy.
+  // Thread Safety preconditions:
+  //    None.
+};
+
+OMNI_NAMESPACE_END(omni)
+
+#endif // __OMNIBUFFERPOOL_H__
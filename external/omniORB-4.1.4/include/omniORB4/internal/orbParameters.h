@@ -144,6 +144,21 @@ _CORBA_MODULE_VAR _core_attr size_t maxSocketRecv;
 //
 //   Valid values = (n >= 8192)
 
+_CORBA_MODULE_VAR _core_attr size_t bufferPoolThreadCache;
+//   Maximum number of bytes of free GIOP and cdrMemoryStream buffers
+//   each thread keeps for its own reuse. 0 disables the per-thread
+//   caches.
+//
+//   Valid values = (n >= 0)
+
+_CORBA_MODULE_VAR _core_attr size_t bufferPoolMaxRetained;
+//   Maximum number of bytes of free buffers held in the pool shared by
+//   all threads. Blocks released by threads whose cache is full go
+//   here; beyond this limit they are returned to the heap. 0 disables
+//   the shared pool.
+//
+//   Valid values = (n >= 0)
+
 _CORBA_MODULE_VAR _core_attr int socketSendBuffer;
 //   Sets the socket send buffer size. -1 means leave the system
 //   default unchanged.
@@ -190,6 +205,15 @@ _CORBA_MODULE_VAR _core_attr CORBA::Boolean copyValuesInLocalCalls;
 //  copy is not performed, so the call is faster but the semantics are
 //  non-standard.
 
+_CORBA_MODULE_VAR _core_attr CORBA::Boolean fastLocalCalls;
+//  If the value of this variable is TRUE, calls to active objects
+//  in the same process, in POAs with the ORB_CTRL_MODEL threading
+//  policy, are dispatched without taking the ORB's internal lock,
+//  once the first call through an object reference has found the
+//  object.
+//
+//  Valid values = 0 or 1
+
 _CORBA_MODULE_VAR _core_attr CORBA::Boolean strictIIOP;
 //   Enable vigorous check on incoming IIOP messages
 //
@@ -217,12 +241,12 @@ _CORBA_MODULE_VAR _core_attr CORBA::Boolean strictIIOP;
 
 
 _CORBA_MODULE_VAR _core_attr CORBA::ULong scanGranularity;
-//  The granularity at which the ORB scans for idle connections.
-//  This value determines the minimum value that inConScanPeriod or
-//  outConScanPeriod can be implemented.
+//  Idle connections are closed when their idle timers expire, with
+//  millisecond resolution, so the value no longer matters other than
+//  to switch that off. Kept for compatibility.
 //
 //  Valid values = (n >= 0 in seconds) 
-//                  0 --> do not scan for idle connections.
+//                  0 --> do not close idle connections.
 //
 
 
@@ -307,6 +331,16 @@ _CORBA_MODULE_VAR _core_attr CORBA::Boolean oneCallPerConnection;
 //
 //  Valid values = 0 or 1
 
+_CORBA_MODULE_VAR _core_attr CORBA::Boolean multiplexGIOP12Calls;
+//  1 means that when oneCallPerConnection is 1 and all
+//  maxGIOPConnectionPerServer connections to a server are busy, a
+//  GIOP 1.2 call is multiplexed onto the least busy connection
+//  rather than waiting for one to become free. 0 means such calls
+//  block. Has no effect if oneCallPerConnection is 0, or for
+//  GIOP 1.0 and 1.1 calls, which always wait.
+//
+//  Valid values = 0 or 1
+
 _CORBA_MODULE_VAR _core_attr CORBA::ULong maxGIOPConnectionPerServer;
 //  The ORB could open more than one connection to a server
 //  depending on the number of concurrent invocations to the same
@@ -316,7 +350,28 @@ _CORBA_MODULE_VAR _core_attr CORBA::ULong maxGIOPConnectionPerServer;
 //  extra invocations are blocked until the the outstanding ones
 //  return.
 //
-//  Valid values = (n >= 1) 
+//  Valid values = (n >= 1)
+
+_CORBA_MODULE_VAR _core_attr CORBA::Boolean onewayCoalesce;
+//  1 means oneway requests are held back for up to onewayCoalesceWindow
+//  and written to the connection together with the requests that
+//  follow them. Can be overridden per object reference with
+//  omniORB::setClientOnewayCoalescing().
+//
+//  Valid values = 0 or 1
+
+_CORBA_MODULE_VAR _core_attr CORBA::ULong onewayCoalesceSize;
+//  Coalesced oneway requests are written as soon as they add up to
+//  this many bytes.
+//
+//  Valid values = (n >= 1 in bytes)
+
+_CORBA_MODULE_VAR _core_attr CORBA::ULong onewayCoalesceWindow;
+//  Coalesced oneway requests are written no later than this long after
+//  the first of them, if no other message has been sent on the
+//  connection by then.
+//
+//  Valid values = (n >= 1 in microseconds)
 
 
 _CORBA_MODULE_VAR _core_attr GIOP::AddressingDisposition giopTargetAddressMode;
@@ -346,10 +401,9 @@ _CORBA_MODULE_VAR _core_attr CORBA::Boolean  diiThrowsSysExceptions;
 // Valid values = 0 or 1
 
 _CORBA_MODULE_VAR _core_attr CORBA::ULong outConScanPeriod;
-//  Idle connections shutdown. The ORB periodically scans all the
-//  incoming connections to detect if they are idle.
-//  If no operation has passed through a connection for a scan period,
-//  the ORB would treat this connection idle and shut it down.
+//  Idle connections shutdown. If no operation has passed through an
+//  outgoing connection for this period, the ORB treats the connection
+//  as idle and shuts it down.
 //
 //  Valid values = (n >= 0 in seconds) 
 //                  0 --> do not close idle connections.
@@ -395,6 +449,16 @@ _CORBA_MODULE_VAR _core_attr CORBA::Boolean resetTimeOutOnRetries;
 //
 //   Valid values = 0 or 1
 
+_CORBA_MODULE_VAR _core_attr CORBA::ULong trustIsACache;
+//   Answers to _is_a() from remote objects are cached by the pair of
+//   the object's most derived repository id and the id asked about.
+//   This says which cached answers are believed for other objects
+//   with the same most derived id, instead of asking each of them.
+//
+//   Valid values = 0 (always ask the object)
+//                  1 (believe answers of TRUE)
+//                  2 (believe answers of TRUE and FALSE)
+
 _CORBA_MODULE_VAR _core_attr CORBA::String_var bootstrapAgentHostname;
 //   Applies to the client side. Non-zero enables the use of Sun's
 //   bootstrap agent protocol to resolve initial references. The value
@@ -488,10 +552,9 @@ _CORBA_MODULE_VAR _core_attr CORBA::ULong   maxInterleavedCallsPerConnection;
 //  Valid values = (n >= 1) 
 
 _CORBA_MODULE_VAR _core_attr CORBA::ULong  inConScanPeriod;
-//  Idle connections shutdown. The ORB periodically scans all the
-//  outgoing connections to detect if they are idle.
-//  If no operation has passed through a connection for a scan period,
-//  the ORB would treat this connection idle and shut it down.
+//  Idle connections shutdown. If no operation has passed through an
+//  incoming connection for this period, the ORB treats the connection
+//  as idle and shuts it down.
 //
 //   Valid values = (n >= 0 in seconds) 
 //                   0 --> do not close idle connections.
@@ -527,6 +590,14 @@ _CORBA_MODULE_VAR _core_attr CORBA::UShort unixTransportPermission;
 //
 //  Valid values = unix permission mode bits in octal radix (e.g. 0755)
 
+_CORBA_MODULE_VAR _core_attr CORBA::ULong shmTransportBufferSize;
+//  Applies to the server side. The size in bytes of each of the two
+//  shared memory ring buffers, one per direction, that connections
+//  to a giop:shm endpoint use. Messages larger than the buffer are
+//  streamed through it.
+//
+//  Valid values = a power of 2, (n >= 8192)
+
 _CORBA_MODULE_VAR _core_attr CORBA::Boolean supportBootstrapAgent;
 //  Applies to the server side. 1 means enable the support for Sun's
 //  bootstrap agent protocol.  This enables interoperability between omniORB
@@ -542,6 +613,51 @@ _CORBA_MODULE_VAR _core_attr CORBA::Boolean connectionWatchImmediate;
 //  handled; otherwise, they are not watched until the
 //  SocketCollection next scans the connection list.
 
+_CORBA_MODULE_VAR _core_attr CORBA::Boolean connectionWatchEpoll;
+//  If true, on platforms that support it, the SocketCollection uses
+//  epoll rather than poll() to watch connections, so the cost of
+//  watching is proportional to the number of active connections
+//  rather than the total number. Has no effect on other platforms.
+
+_CORBA_MODULE_VAR _core_attr CORBA::Boolean metrics;
+//  1 means the ORB keeps a latency histogram for each operation it
+//  calls or dispatches, available through omniMetrics. The other
+//  runtime counters are always kept.
+//
+//  Valid values = 0 or 1
+
+_CORBA_MODULE_VAR _core_attr CORBA::String_var metricsDumpFile;
+//  If not empty, the name of a file the metrics are written to, as a
+//  JSON document, every metricsDumpPeriod seconds and when the ORB
+//  is shut down.
+//
+//  Valid values = a pathname, or the empty string
+
+_CORBA_MODULE_VAR _core_attr CORBA::ULong metricsDumpPeriod;
+//  Seconds between writes of metricsDumpFile.
+//
+//  Valid values = (n >= 0 in seconds)
+//                  0 --> only written when the ORB is shut down.
+
+_CORBA_MODULE_VAR _core_attr CORBA::Boolean traceAsync;
+//  1 means log messages are queued in per-thread buffers and written
+//  by a background task, rather than by the thread that logs them.
+//
+//  Valid values = 0 or 1
+
+_CORBA_MODULE_VAR _core_attr size_t traceAsyncBufferSize;
+//  Size in bytes of each thread's log buffer when traceAsync is set,
+//  rounded up to a power of two. Messages logged while the buffer is
+//  full are dropped.
+//
+//  Valid values = (n >= 4096)
+
+_CORBA_MODULE_VAR _core_attr CORBA::Boolean traceAsyncBinary;
+//  1 means asynchronous log messages are written to the log file as
+//  binary records, to be decoded with the decodetrace utility.
+//
+//  Valid values = 0 or 1
+
 _CORBA_MODULE_END
 
 OMNI_NAMESPACE_END(omni)
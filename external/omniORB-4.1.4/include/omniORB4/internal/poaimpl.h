@@ -224,6 +224,9 @@ public:
   virtual void  dispatch(omniCallHandle&,
 			 const _CORBA_Octet* key, int keysize);
   virtual void  dispatch(omniCallDescriptor&, omniLocalIdentity*);
+  virtual _CORBA_Boolean fastDispatch(omniCallDescriptor&,
+				      omniLocalIdentity*);
+  virtual _CORBA_Boolean fastDispatch(omniCallHandle&, omniLocalIdentity*);
   virtual int   objectExists(const _CORBA_Octet* key, int keysize);
   virtual void  lastInvocationHasCompleted(omniLocalIdentity* id);
 
@@ -369,6 +372,10 @@ private:
   int adapter_name_is_valid(const char* name);
   // Return true if <name> is a valid name for an adapter.
 
+  void upcall(omniCallHandle& handle, omniLocalIdentity* id);
+  // Make the upcall for a request that has been admitted to the POA.
+  //  Must not hold <omni::internalLock>.
+
   void synchronise_request(omniLocalIdentity* lid);
   // Must hold <omni::internalLock> on entry.  If the POA is in the
   // DISCARDING or INACTIVE state, <omni::internalLock> is released,
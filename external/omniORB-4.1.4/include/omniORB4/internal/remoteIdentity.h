@@ -94,6 +94,8 @@
 OMNI_NAMESPACE_BEGIN(omni)
 
 class omniRemoteIdentity_RefHolder;
+class GIOP_C;
+class IOP_C;
 
 OMNI_NAMESPACE_END(omni)
 
@@ -134,6 +136,11 @@ public:
   virtual _CORBA_Boolean inThisAddressSpace();
   // Override omniIdentity.
 
+  static void receiveAsyncReply(_OMNI_NS(GIOP_C)*);
+  // Receive the reply to an asynchronous call that dispatch() has sent,
+  // complete the call, and release the GIOP_C and the reference to the
+  // identity that dispatch() kept for the call.
+
 
   virtual void* ptrToClass(int* cptr);
   static inline omniRemoteIdentity* downcast(omniIdentity* i) {
@@ -147,6 +154,10 @@ private:
 
   ~omniRemoteIdentity();
 
+  _CORBA_Boolean receiveReply(_OMNI_NS(IOP_C)&, omniCallDescriptor&);
+  // Receive the reply to a request, and unmarshal the results into the
+  // call descriptor. Returns true if the request has to be sent again.
+
   omniRemoteIdentity(const omniRemoteIdentity&);
   omniRemoteIdentity& operator = (const omniRemoteIdentity&);
   // Not implemented.
@@ -79,15 +79,14 @@ void copyStreamToMemStream_flush(const CORBA::TypeCode_ptr tc,
 // stream first.
 // Same exception behaviour as copyStreamToStream.
   
-inline _CORBA_MODULE_FN
+_CORBA_MODULE_FN
 void copyMemStreamToStream_rdonly(const CORBA::TypeCode_ptr tc,
 				  const cdrAnyMemoryStream& src,
-				  cdrStream& dest) {
-  cdrAnyMemoryStream tmp_mbs(src, 1);
-  copyStreamToStream(tc, tmp_mbs, dest);
-}
+				  cdrStream& dest);
 // Read data of type <tc> from a memory stream to a cdrStream.
-// Data will be read through a read-only memory stream.
+// Data will be read through a read-only memory stream, or copied as
+// a single block if the destination's alignment, byte order and code
+// sets match the memory stream's.
 // Same exception behaviour as copyStreamToStream.
 
 _CORBA_MODULE_END
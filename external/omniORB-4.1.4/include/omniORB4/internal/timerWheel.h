@@ -0,0 +1,123 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// timerWheel.h               Created on: 2026/10/17
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//    Timer service shared by the ORB, with millisecond resolution and
+//    constant time scheduling and cancelling of timers.
+//
+
+#ifndef __TIMERWHEEL_H__
+#define __TIMERWHEEL_H__
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+class omniTimerWheel;
+class timerWheelTask;
+
+class omniTimer {
+public:
+  omniTimer() : pd_next(0), pd_prev(0), pd_slot(0), pd_expiry(0) {}
+  virtual ~omniTimer() {}
+
+  virtual void expire() = 0;
+  // Called by the timer wheel's task when the timer is due. The
+  // wheel's lock is held, so expire() must not block. In particular it
+  // must not wait for another lock: it should use trylock() and, if
+  // that fails, call omniTimerWheel::reschedule() to try again a
+  // little later. Other than reschedule(), it must not call the
+  // timer wheel.
+
+  virtual void stopped() {}
+  // Called instead of expire() for each timer still pending when the
+  // timer wheel is stopped at ORB shutdown. The timer is cancelled,
+  // not expired, so a call with a deadline is not timed out early;
+  // a timer with a thread waiting on it wakes the thread, which finds
+  // the wheel stopped and waits for its deadline by itself. The same
+  // rules as for expire() apply.
+
+private:
+  omniTimer*       pd_next;
+  omniTimer**      pd_prev;     // Non-zero while the timer is pending.
+  CORBA::ULong     pd_slot;
+  CORBA::ULongLong pd_expiry;   // Milliseconds since the epoch.
+
+  friend class omniTimerWheel;
+  friend class timerWheelTask;
+
+  omniTimer(const omniTimer&);
+  omniTimer& operator=(const omniTimer&);
+};
+
+
+class omniTimerWheel {
+public:
+  static CORBA::Boolean schedule(omniTimer* t, CORBA::ULong msecs);
+  // Arm <t> to expire <msecs> milliseconds from now. If <t> is already
+  // pending it is moved. Returns false if the timer wheel is not
+  // running, in which case the timer never expires.
+  //
+  // Thread Safety preconditions:
+  //    Must not be called from a timer's expire().
+
+  static CORBA::Boolean scheduleAt(omniTimer* t,
+				   unsigned long secs, unsigned long nanosecs);
+  // As schedule(), with an absolute time as returned by
+  // omni_thread::get_time(), rounded up to the next millisecond.
+
+  static CORBA::Boolean cancel(omniTimer* t);
+  // Disarm <t>. Returns true if it was pending, false if it was not
+  // scheduled or has already expired. Once cancel() returns, <t> is
+  // not touched by the timer wheel again, so it may be deleted.
+  //
+  // Thread Safety preconditions:
+  //    Must not be called from a timer's expire().
+
+  static void reschedule(omniTimer* t, CORBA::ULong msecs);
+  // Arm <t> again, <msecs> milliseconds from now.
+  //
+  // Thread Safety preconditions:
+  //    Only to be called from <t>'s expire() or stopped().
+
+  static int timedwait(omni_tracedcondition& cond, omni_tracedmutex& mutex,
+		       unsigned long secs, unsigned long nanosecs);
+  // Equivalent to cond.timedwait(secs,nanosecs): wait until <cond> is
+  // signalled or the absolute time <secs>,<nanosecs> has passed, with
+  // the deadline kept on the timer wheel. Returns 0 if the deadline
+  // passed. <cond> is woken with broadcast() when the deadline passes,
+  // so other threads waiting on it must be prepared to wake early.
+  //
+  // Thread Safety preconditions:
+  //    Caller must hold <mutex>, the mutex of <cond>.
+
+  static void sleep(CORBA::ULong msecs);
+  // Sleep for <msecs> milliseconds. Returns early if the ORB is shut
+  // down in the meantime.
+
+  static CORBA::ULongLong now();
+  // The current time in milliseconds since the epoch.
+};
+
+OMNI_NAMESPACE_END(omni)
+
+#endif // __TIMERWHEEL_H__
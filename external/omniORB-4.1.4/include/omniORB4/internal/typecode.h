@@ -359,6 +359,13 @@ public:
   //     perform equality test as defined in the CORBA 2.3 TypeCode::equal()
   //     operation.
 
+  CORBA::ULong NP_hash() const;
+  // Returns a hash of the parts of the TypeCode that the equivalent
+  // test compares, computed on first use and cached. TypeCodes with
+  // different hashes are neither equal nor equivalent. Returns 0 if
+  // the TypeCode cannot be hashed, for instance because it has
+  // unresolved recursive members.
+
   virtual CORBA::Boolean NP_extendedEqual(const TypeCode_base* TCp,
 					  CORBA::Boolean equivalent,
 					  const TypeCode_pairlist* pl) const;
@@ -463,6 +470,10 @@ protected:
   // The Kind of this TypeCode object
   CORBA::TCKind pd_tck;
 
+  // Cached result of NP_hash(). 0 if it has not been computed yet, 1
+  // if the TypeCode cannot be hashed.
+  CORBA::ULong pd_hash;
+
   // Linked list within the TypeCode tracker for static TypeCodes
   // allocated in stubs.
   TypeCode_base* pd_next;
@@ -0,0 +1,172 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// omniAsyncCall.h
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//	*** PROPRIETORY INTERFACE ***
+//
+
+#ifndef __OMNIASYNCCALL_H__
+#define __OMNIASYNCCALL_H__
+
+// Usage:
+//
+//    Stubs generated by omniidl with -Wbami have, for each two-way
+//    operation <op> of interface <I>, a member of the object reference
+//
+//      AMI_I_op* sendc_op(omniAsyncCallback* ami_handler, <in args>);
+//
+//    which sends the request and returns without waiting for the
+//    reply. The returned AMI_I_op object is an omniAsyncCall, the
+//    future for the call. Its get() member waits for the reply and
+//    returns the result and out arguments as the normal operation
+//    would, or raises the exception the call ended with.
+//
+//    The reply is received by a task reading the connection the
+//    request was sent on, which completes the call, so no thread is
+//    blocked for each outstanding call. If <ami_handler> is not zero,
+//    its completed() member is called by that task once the call is
+//    complete. completed() may call get() on the call, which then
+//    does not block. It should not itself block for long, since the
+//    other replies on the connection wait for it to return.
+//
+//    A call to a colocated object is made by sendc_ itself, so it is
+//    complete when sendc_ returns, and the handler has been called.
+//
+//    If the request cannot be sent, the call is completed with the
+//    exception straight away; sendc_ does not raise it. The usual
+//    retries are made while the request is being sent, but once it has
+//    been sent the arguments are no longer available, so a request
+//    that has to be sent again, for example because it is forwarded
+//    to another location, completes with a TRANSIENT exception.
+//
+//    The caller owns a reference to the returned object, and must
+//    release it with _remove_ref() when it is done with it. The
+//    omniAsyncCall_var template does this automatically:
+//
+//      AMI_I_op_var call = ref->sendc_op(0, ...);
+//      ...
+//      result = call->get();
+
+class omniAsyncCall;
+
+class omniAsyncCallback {
+public:
+  virtual ~omniAsyncCallback();
+
+  virtual void completed(omniAsyncCall* call) = 0;
+  // Called once the reply to <call> has been received, or the call has
+  // otherwise completed.
+};
+
+
+class omniAsyncCall {
+public:
+  void _add_ref();
+  void _remove_ref();
+
+  _CORBA_Boolean poll();
+  // True if the call has completed.
+
+  void wait();
+  // Wait until the call has completed.
+
+  _CORBA_Boolean wait(_CORBA_ULong millisecs);
+  // Wait at most <millisecs> milliseconds for the call to complete.
+  // Returns true if it has.
+
+  inline omniCallDescriptor* _callDescriptor() { return pd_cd; }
+
+protected:
+  omniAsyncCall(omniCallDescriptor* cd, omniAsyncCallback* handler);
+  // Takes ownership of <cd>. Constructed with a reference count of 1.
+
+  virtual ~omniAsyncCall();
+
+  omniCallDescriptor* _retrieve();
+  // Wait until the call has completed, and return its call descriptor
+  // for the results to be taken from it. Raises the exception the call
+  // completed with, or BAD_INV_ORDER if the results have already been
+  // retrieved.
+
+private:
+  omniCallDescriptor*        pd_cd;
+  omniAsyncCallback*         pd_handler;
+  omniObjRef*                pd_objref;
+  omniRemoteIdentity*        pd_identity;
+  CORBA::Exception*          pd_exception;
+  omni_tracedcondition*      pd_cond;
+  int                        pd_refCount;
+  _CORBA_Boolean             pd_sent;
+  _CORBA_Boolean             pd_completed;
+  _CORBA_Boolean             pd_retrieved;
+  // pd_objref is held until the call completes. pd_identity is set,
+  // and held, while a remote call waits for its reply. pd_cond is
+  // allocated by the first thread to wait.
+
+  void complete(CORBA::Exception* ex);
+  // Record the outcome, wake any waiting threads, call the handler and
+  // release the ORB's reference to the call. Takes ownership of <ex>.
+
+  omniAsyncCall(const omniAsyncCall&);
+  omniAsyncCall& operator=(const omniAsyncCall&);
+  // Not implemented.
+
+  friend class omniObjRef;
+  friend class omniRemoteIdentity;
+};
+
+
+template <class T>
+class omniAsyncCall_var {
+public:
+  inline omniAsyncCall_var() : pd_data(0) {}
+  inline omniAsyncCall_var(T* p) : pd_data(p) {}
+  inline omniAsyncCall_var(const omniAsyncCall_var<T>& v) : pd_data(v.pd_data) {
+    if (pd_data) pd_data->_add_ref();
+  }
+  inline ~omniAsyncCall_var() {
+    if (pd_data) pd_data->_remove_ref();
+  }
+  inline omniAsyncCall_var<T>& operator=(T* p) {
+    if (pd_data) pd_data->_remove_ref();
+    pd_data = p;
+    return *this;
+  }
+  inline omniAsyncCall_var<T>& operator=(const omniAsyncCall_var<T>& v) {
+    if (v.pd_data) v.pd_data->_add_ref();
+    if (pd_data) pd_data->_remove_ref();
+    pd_data = v.pd_data;
+    return *this;
+  }
+
+  inline T* operator->() const { return pd_data; }
+  inline operator T*() const   { return pd_data; }
+  inline T* in() const         { return pd_data; }
+  inline T* _retn() { T* p = pd_data; pd_data = 0; return p; }
+
+private:
+  T* pd_data;
+};
+
+#endif  // __OMNIASYNCCALL_H__
@@ -117,6 +117,13 @@
 //   Once inserted, a task may be cancelled by calling the cancel() method.
 //   However, this call only has an effect if the task is still sitting in a
 //   queue waiting for its turn to be executed.
+//
+//   Anytime tasks are kept in a set of queues, one per worker slot. A
+//   task inserted by one of the invoker's own threads goes on that
+//   thread's queue; other threads spread their tasks round-robin. Tasks
+//   are added without taking the invoker's lock. A thread with nothing
+//   on its own queue steals from the others before it goes idle, so
+//   the order in which Anytime tasks start is only roughly FIFO.
 
 
 class omniAsyncWorker;
@@ -202,6 +209,13 @@ class omniAsyncInvoker {
   // returns 0 if the task is not found in the pending queue
   // returns 1 if the task is successfully removed from the pending queue.
 
+  void stats(unsigned int& threads, unsigned int& idle,
+	     unsigned int& queued);
+  // Return the number of threads serving Anytime tasks, how many of
+  // them are idle, and the number of Anytime tasks waiting for a
+  // thread. The values are read without locking, so they are only
+  // approximate while tasks are being inserted.
+
   virtual int work_pending();
   // Return 1 if there are DedicatedThread tasks pending, 0 if none.
   // Default implementation always returns 0.
@@ -232,14 +246,30 @@ protected:
 
 private:
 
-  unsigned int          pd_keep_working;// 0 means all threads should exit.
+  struct TaskQueue;
+  // Queue of Anytime tasks. Defined in invoker.cc.
+
+  omniTask* findTask(unsigned int home);
+  // Take the oldest task from queue <home>, or failing that steal one
+  // from another queue. Returns 0 if all the queues are empty.
+
+  void wakeIdleThread();
+  // Hand queued work to an idle thread, or start a new thread if there
+  // is no idle one. Caller must hold pd_lock.
+
+  volatile unsigned int pd_keep_working;// 0 means all threads should exit.
   omni_tracedmutex*     pd_lock;
   omni_tracedcondition* pd_cond;        // signal this conditional when all
                                         // the threads serving Anytime tasks
 					// are exiting.
-  omniTaskLink          pd_anytime_tq;  // Anytime tasks
+  TaskQueue*            pd_queues;      // Anytime tasks, one queue per
+					// worker slot.
+  unsigned int          pd_nqueues;
+  volatile unsigned int pd_next_queue;  // Queue for the next task inserted
+					// by a non-worker thread.
   omniAsyncWorker*      pd_idle_threads;// idle threads ready for Anytime tasks
-  unsigned int          pd_nthreads;    // No. of threads serving Anytime tasks
+  volatile unsigned int pd_nidle;       // No. of threads in pd_idle_threads
+  volatile unsigned int pd_nthreads;    // No. of threads serving Anytime tasks
   unsigned int          pd_maxthreads;  // Max. no. of threads serving Anytime
 					// tasks
   unsigned int          pd_totalthreads;// total no. of threads.
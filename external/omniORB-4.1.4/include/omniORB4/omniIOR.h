@@ -331,6 +331,12 @@ public:
   static char* dump_TAG_OMNIORB_UNIX_TRANS(const IOP::TaggedComponent&);
   static void  add_TAG_OMNIORB_UNIX_TRANS(const char* filename);
 
+  ////
+  static void  unmarshal_TAG_OMNIORB_SHM_TRANS(const IOP::TaggedComponent&,
+					       omniIOR&);
+  static char* dump_TAG_OMNIORB_SHM_TRANS(const IOP::TaggedComponent&);
+  static void  add_TAG_OMNIORB_SHM_TRANS(const char* filename);
+
   ////
   static void  unmarshal_TAG_OMNIORB_PERSISTENT_ID(const IOP::TaggedComponent&,
 						   omniIOR&);
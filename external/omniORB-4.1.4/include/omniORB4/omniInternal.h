@@ -319,9 +319,11 @@ _CORBA_MODULE_BEG
 
   _CORBA_MODULE_VAR _core_attr int remoteInvocationCount;
   _CORBA_MODULE_VAR _core_attr int localInvocationCount;
-  // These are updated whilst internalLock is held.  However it is
-  // suggested that they may be read without locking, since integer
-  // reads are likely to be atomic.
+  // These are updated whilst internalLock is held, except that fast
+  // local calls and requests dispatched without the lock update them
+  // atomically.
+  // However it is suggested that they may be read without locking,
+  // since integer reads are likely to be atomic.
 
   _CORBA_MODULE_VAR _core_attr int mainThreadId;
   // id of the main thread. 0 by default. Can be changed by calling
@@ -0,0 +1,181 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// omniMetrics.h              Created on: 2026/10/17
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//    Proprietary omniORB runtime metrics API
+//
+
+#ifndef __OMNIMETRICS_H__
+#define __OMNIMETRICS_H__
+
+#include <omniORB4/CORBA.h>
+
+// Usage:
+//
+//    While the metrics option is set, which it is by default, the ORB
+//    keeps a latency histogram for every operation it makes remote
+//    calls to, and one for every operation it dispatches from remote
+//    clients. A client call is timed from when its request is
+//    marshalled to when its reply arrives; a server call from when its
+//    request header has been read to when its reply or exception is
+//    about to be sent. Oneway calls, colocated calls, calls that fail
+//    without a reply, and server calls for which no object was found
+//    are not timed.
+//
+//    At most 1024 operations are recorded. Once there are that many,
+//    calls to any other operation are counted together under the
+//    name "other", with an empty interface id, one for each side.
+//
+//    The ORB also always keeps the counters in omniMetrics::Counters.
+//
+//    omniMetrics::Snapshot takes a copy of all of them:
+//
+//      omniMetrics::Snapshot snap;
+//      for (CORBA::ULong i=0; i < snap.operationCount(); i++) {
+//        const omniMetrics::Operation& op = snap.operation(i);
+//        cout << op.interfaceId << " " << op.name << " "
+//             << op.latency.percentile(99) << "ns" << endl;
+//      }
+//
+//    The metricsDumpFile option makes the ORB write a snapshot to a
+//    file every metricsDumpPeriod seconds and when it shuts down.
+
+_CORBA_MODULE omniMetrics
+
+_CORBA_MODULE_BEG
+
+  ////////////////////////////////////////////////////////////////////////
+  class Histogram {
+  public:
+    // Distribution of call times in nanoseconds. Times below 64ns
+    // have a bucket each. Above that, each power of two is split
+    // into 32 buckets, so a time is recorded to within about 3%.
+    // Times of 2^37 ns (about 137 seconds) or more all go in the
+    // last bucket.
+
+    enum { SUB_BUCKET_BITS = 5, MAX_BITS = 37,
+	   BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS };
+
+    _CORBA_ULongLong count;   // Number of calls timed.
+    _CORBA_ULongLong total;   // Sum of their times.
+    _CORBA_ULongLong max;     // Longest time, exactly.
+    _CORBA_ULongLong buckets[BUCKETS];
+
+    _CORBA_ULongLong mean() const;
+
+    _CORBA_ULongLong percentile(double p) const;
+    // Return the time that <p> percent of the calls took no longer
+    // than, to the precision of the buckets. Returns 0 if no calls
+    // have been timed.
+
+    static _CORBA_ULong bucketIndex(_CORBA_ULongLong ns);
+    // Return the bucket in which a time of <ns> is counted.
+
+    static _CORBA_ULongLong bucketLimit(_CORBA_ULong index);
+    // Return the largest time counted in bucket <index>.
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  struct Operation {
+    const char*      interfaceId;
+    // Repository id of the object. For client calls it is the most
+    // derived interface the object reference is known to support; for
+    // server calls it is the servant's most derived interface. Empty
+    // if it is not known.
+
+    const char*      name;        // Operation name.
+    _CORBA_Boolean   server;      // True for calls dispatched by this
+				  // ORB, false for calls it made.
+    _CORBA_ULongLong exceptions;  // Calls that ended in an exception.
+    Histogram        latency;
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  struct Counters {
+    _CORBA_ULongLong bytesSent;             // On all connections.
+    _CORBA_ULongLong bytesReceived;
+    _CORBA_ULongLong connectionsOpened;     // By this ORB as a client.
+    _CORBA_ULongLong connectionsAccepted;   // By this ORB as a server.
+    _CORBA_ULongLong clientConnectionsClosed;
+    _CORBA_ULongLong serverConnectionsClosed;
+    _CORBA_ULongLong connectionsReadable;   // Times an idle server
+					    // connection was found to
+					    // have a request waiting.
+    _CORBA_ULongLong logMessagesDropped;    // By traceAsync logging,
+					    // because a thread's buffer
+					    // was full.
+
+    // Values at the time of the snapshot.
+    _CORBA_ULong     ropes;                 // Sets of connections to
+					    // one server.
+    _CORBA_ULong     strands;               // Connections, including
+					    // ones not yet connected.
+    _CORBA_ULong     watchedSockets;        // Connections being watched
+					    // for requests.
+    _CORBA_ULong     upcallThreads;         // Threads dispatching calls
+					    // from remote clients.
+    _CORBA_ULong     invokerThreads;        // Threads in the ORB's
+					    // thread pool,
+    _CORBA_ULong     invokerIdleThreads;    // of which idle,
+    _CORBA_ULong     invokerQueuedTasks;    // and tasks waiting for one.
+  };
+
+  ////////////////////////////////////////////////////////////////////////
+  class Snapshot {
+  public:
+    Snapshot();
+    // Copy the current metrics. Calls in progress are not stopped, so
+    // the values taken are each consistent, but not with each other.
+
+    ~Snapshot();
+
+    _CORBA_ULong operationCount() const { return pd_count; }
+
+    const Operation& operation(_CORBA_ULong i) const {
+      return pd_operations[i];
+    }
+    // The strings in an Operation remain valid until the process
+    // exits.
+
+    const Counters& counters() const { return pd_counters; }
+
+  private:
+    Operation*   pd_operations;
+    _CORBA_ULong pd_count;
+    Counters     pd_counters;
+
+    Snapshot(const Snapshot&);
+    Snapshot& operator=(const Snapshot&);
+  };
+
+  _CORBA_MODULE_FN void reset();
+  // Empty every histogram and set the cumulative counters to zero.
+
+  _CORBA_MODULE_FN _CORBA_Boolean dump(const char* filename);
+  // Write a snapshot to <filename> as a JSON document, replacing the
+  // file as a whole. Returns false if it cannot be written.
+
+_CORBA_MODULE_END
+
+#endif  // __OMNIMETRICS_H__
@@ -357,6 +357,20 @@ _CORBA_MODULE_BEG
                                                                         //
   ////////////////////////////////////////////////////////////////////////
 
+  ////////////////////////////////////////////////////////////////////////
+  //                                                                    //
+  // setClientOnewayCoalescing()                                        //
+  //                                                                    //
+  // Choose whether oneway requests through the specified object        //
+  // reference are coalesced, overriding the onewayCoalesce ORB option  //
+  // for that reference. Coalesced requests are held back and written   //
+  // to the connection together, at most onewayCoalesceWindow           //
+  // microseconds after the first of them.                              //
+  //                                                                    //
+  _CORBA_MODULE_FN void setClientOnewayCoalescing(CORBA::Object_ptr obj,//
+						  CORBA::Boolean yes);  //
+  ////////////////////////////////////////////////////////////////////////
+
   ////////////////////////////////////////////////////////////////////////
   //                                                                    //
   // giopMaxMsgSize()                                                   //
@@ -367,6 +381,27 @@ _CORBA_MODULE_BEG
   _CORBA_MODULE_FN _CORBA_ULong giopMaxMsgSize();                       //
   ////////////////////////////////////////////////////////////////////////
 
+  ////////////////////////////////////////////////////////////////////////
+  //                                                                    //
+  // getBufferPoolStats()                                               //
+  //                                                                    //
+  // Return statistics for the pool used to recycle GIOP message        //
+  // buffers and cdrMemoryStream storage. <hits> counts allocations     //
+  // satisfied from the pool, <misses> counts those that went to the    //
+  // heap, and <bytesRetained> is the total size of the free buffers    //
+  // the pool currently holds. The pool is sized by the ORB options     //
+  // bufferPoolThreadCache and bufferPoolMaxRetained. The values are    //
+  // approximate while other threads are making calls.                  //
+  //                                                                    //
+  struct bufferPoolStats {                                              //
+    unsigned long hits;                                                 //
+    unsigned long misses;                                               //
+    unsigned long bytesRetained;                                        //
+  };                                                                    //
+                                                                        //
+  _CORBA_MODULE_FN void getBufferPoolStats(bufferPoolStats& stats);     //
+  ////////////////////////////////////////////////////////////////////////
+
   ////////////////////////////////////////////////////////////////////////
   //                                                                    //
   // setPersistentServerIdentifier()                                    //
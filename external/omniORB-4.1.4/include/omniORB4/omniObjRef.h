@@ -124,6 +124,7 @@ class omniLocalIdentity;
 class omniObjTableEntry;
 class omniRemoteIdentity;
 class omniServant;
+class omniAsyncCall;
 
 class omniObjRef {
 public:
@@ -295,6 +296,11 @@ public:
   // the call to the object identity, and deals with exception
   // handlers, retries and location forwarding.
 
+  void _invokeAsync(omniAsyncCall*);
+  // Sends the request of the call, without waiting for the reply.
+  // Exceptions are not raised but complete the call. See
+  // omniAsyncCall.h.
+
   omniIOR* _getIOR();
   // Returns an omniIOR. The object contains all the fields in
   // the IOR of the object reference. The object is read-only
@@ -334,12 +340,28 @@ public:
   // speed.
   //  No concurrency control!
 
+  void _enableFastCalls(omniLocalIdentity* id);
+  // Called when a local call on <id> is being dispatched through an
+  // object adapter that accepts fast local calls. If <id> is an
+  // entry in the object table, _invoke() then calls it directly,
+  // without <omni::internalLock>, for as long as it is still this
+  // reference's identity and is still active. Holds a reference to
+  // the entry until the object reference is deleted, or until the
+  // object is reactivated and a call enables fast calls to its new
+  // entry.
+  //  Must hold <omni::internalLock>.
+
   inline void _setTimeout(unsigned long secs, unsigned long ns)
   {
     pd_timeout_secs     = secs;
     pd_timeout_nanosecs = ns;
   }
 
+  inline void _setOnewayCoalescing(int v) { pd_onewayCoalescing = v; }
+  inline int  _onewayCoalescing() const   { return pd_onewayCoalescing; }
+  // 1 if oneway requests through this reference may be coalesced, 0 if
+  // not, -1 (the default) to follow the onewayCoalesce ORB parameter.
+
 protected:
   virtual ~omniObjRef();
   // Must not hold <omni::internalLock>.
@@ -428,6 +450,20 @@ private:
   // key of a remote object.
   //  Mutable.  Protected by <omni::internalLock>.
 
+  omniObjTableEntry* pd_fastId;
+  // If non-zero, the local identity that calls may be dispatched to
+  // without holding <omni::internalLock>. See _enableFastCalls().
+  //  Set with <omni::internalLock> held; read without it.
+
+  omniObjTableEntry* pd_fastRetired;
+  // An entry replaced in <pd_fastId> while calls were using it, to be
+  // released once they have finished.
+  //  Protected by <omni::internalLock>.
+
+  volatile int pd_fastCalls;
+  // The number of calls reading or using <pd_fastId>.
+  //  Updated atomically.
+
   omniObjRef*  pd_next;
   omniObjRef** pd_prev;
   // Doubly linked list of all non-nil object references, so they may
@@ -470,6 +506,7 @@ private:
 
   unsigned long pd_timeout_secs;
   unsigned long pd_timeout_nanosecs;
+  int           pd_onewayCoalescing;
 };
 
 
@@ -672,6 +672,95 @@ public:
 
 
 
+//////////////////////////////////////////////////////////////////////
+//////////// _CORBA_Unbounded_Sequence_w_FixLayoutElement ////////////
+//////////////////////////////////////////////////////////////////////
+
+// Sequence of a struct whose CDR encoding may be the same as its
+// memory image. T is a struct generated by omniidl, and
+// T::_cdrLayout() says whether its layout matches on this platform.
+// If it does, and the stream uses native byte order, the elements are
+// marshalled as a single block of elmSize octets each. Otherwise they
+// are marshalled one by one.
+
+template <class T,int elmSize,int elmAlignment>
+class _CORBA_Unbounded_Sequence_w_FixLayoutElement : 
+  public _CORBA_Unbounded_Sequence<T> {
+public:
+  typedef _CORBA_Unbounded_Sequence_w_FixLayoutElement<T,elmSize,elmAlignment>  T_seq;
+  typedef _CORBA_Unbounded_Sequence<T> Base_T_seq;
+
+  inline _CORBA_Unbounded_Sequence_w_FixLayoutElement() {}
+  inline _CORBA_Unbounded_Sequence_w_FixLayoutElement(_CORBA_ULong max) : 
+    Base_T_seq(max) {}
+
+  inline _CORBA_Unbounded_Sequence_w_FixLayoutElement(const T_seq& s) : 
+    Base_T_seq(s) {}
+
+  inline _CORBA_Unbounded_Sequence_w_FixLayoutElement(_CORBA_ULong max,
+						      _CORBA_ULong len,
+						      T           *value,
+						      _CORBA_Boolean rel = 0) : 
+    Base_T_seq(max,len,value,rel) {}
+
+  inline T_seq& operator= (const T_seq& s)
+  {
+    Base_T_seq::operator= (s);
+    return *this;
+  }
+  inline ~_CORBA_Unbounded_Sequence_w_FixLayoutElement() {}
+
+  // CORBA 2.3 additions
+
+  inline void replace(_CORBA_ULong max, _CORBA_ULong len, T* data,
+		      _CORBA_Boolean release_ = 0) {
+    Base_T_seq::replace(max,len,data,release_);
+  }
+
+  inline void operator>>= (cdrStream &s) const;
+  inline void operator<<= (cdrStream &s);
+};
+
+
+//////////////////////////////////////////////////////////////////////
+///////////// _CORBA_Bounded_Sequence_w_FixLayoutElement /////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T,int max,int elmSize, int elmAlignment>
+class _CORBA_Bounded_Sequence_w_FixLayoutElement : 
+  public _CORBA_Bounded_Sequence<T,max> {
+public:
+  typedef _CORBA_Bounded_Sequence_w_FixLayoutElement<T,max,elmSize,elmAlignment> T_seq;
+  typedef _CORBA_Bounded_Sequence<T,max> Base_T_seq;
+
+
+  inline _CORBA_Bounded_Sequence_w_FixLayoutElement() {}
+  inline _CORBA_Bounded_Sequence_w_FixLayoutElement(_CORBA_ULong len,
+						    T           *value,
+						    _CORBA_Boolean rel = 0) : 
+    Base_T_seq(len,value,rel) {}
+
+  inline _CORBA_Bounded_Sequence_w_FixLayoutElement(const T_seq& s) : 
+    Base_T_seq(s) {}
+
+  inline ~_CORBA_Bounded_Sequence_w_FixLayoutElement() {}
+
+  inline T_seq& operator=(const T_seq& s) {
+    Base_T_seq::operator= (s);
+    return *this;
+  }
+
+  // CORBA 2.3 additions
+
+  inline void replace(_CORBA_ULong len, T* data,_CORBA_Boolean release_ = 0) {
+    Base_T_seq::replace(len,data,release_);
+  }
+
+  inline void operator>>= (cdrStream &s) const;
+  inline void operator<<= (cdrStream &s);
+};
+
+
 //////////////////////////////////////////////////////////////////////
 ////////////////// _CORBA_Sequence_Char  /////////////////////////////
 //////////////////////////////////////////////////////////////////////
@@ -88,21 +88,6 @@
 #ifndef __SEQTEMPLATEDEFNS_H__
 #define __SEQTEMPLATEDEFNS_H__
 
-#ifndef Swap16
-#define Swap16(s) ((((s) & 0xff) << 8) | (((s) >> 8) & 0xff))
-#else
-#error "Swap16 has already been defined"
-#endif
-
-#ifndef Swap32
-#define Swap32(l) ((((l) & 0xff000000) >> 24) | \
-		   (((l) & 0x00ff0000) >> 8)  | \
-		   (((l) & 0x0000ff00) << 8)  | \
-		   (((l) & 0x000000ff) << 24))
-#else
-#error "Swap32 has already been defined"
-#endif
-
 //////////////////////////////////////////////////////////////////////
 template <class T>
 inline void
@@ -188,34 +173,21 @@ _CORBA_Unbounded_Sequence_w_FixSizeElement<T,elmSize,elmAlignment>::operator<<=
     _CORBA_marshal_sequence_range_check_error(s);
     // never reach here
   }
+  // Discard the old contents first, so that growing the buffer does
+  // not copy elements that are about to be overwritten.
+  Base_T_seq::length(0);
   Base_T_seq::length(l);
   if (l==0) return;
   s.get_octet_array((_CORBA_Octet*)Base_T_seq::NP_data(),
 		    (int)l*elmSize,
 		    (omni::alignment_t)elmAlignment);
   if (s.unmarshal_byte_swap() && elmAlignment != 1) {
-    if (elmSize == 2) {
-      for (_CORBA_ULong i=0; i<l; i++) {
-	_CORBA_UShort t = ((_CORBA_UShort*)Base_T_seq::NP_data())[i];
-	((_CORBA_UShort*)Base_T_seq::NP_data())[i] = Swap16(t);
-      }
-    }
-    else if (elmSize == 4) {
-      for (_CORBA_ULong i=0; i<l; i++) {
-	_CORBA_ULong t = ((_CORBA_ULong*)Base_T_seq::NP_data())[i];
-	((_CORBA_ULong*)Base_T_seq::NP_data())[i] = Swap32(t);
-      }
-    }
-    else if (elmSize == 8) {
-      l *= 2;
-      for (_CORBA_ULong i=0; i<l; i+=2) {
-	_CORBA_ULong tl1 = ((_CORBA_ULong*)Base_T_seq::NP_data())[i+1];
-	_CORBA_ULong tl2 = Swap32(tl1);
-	tl1 = ((_CORBA_ULong*)Base_T_seq::NP_data())[i];
-	((_CORBA_ULong*)Base_T_seq::NP_data())[i] = tl2;
-	((_CORBA_ULong*)Base_T_seq::NP_data())[i+1] = Swap32(tl1);
-      }
-    }
+    if (elmSize == 2)
+      cdrStream::swapArray16(Base_T_seq::NP_data(), l);
+    else if (elmSize == 4)
+      cdrStream::swapArray32(Base_T_seq::NP_data(), l);
+    else if (elmSize == 8)
+      cdrStream::swapArray64(Base_T_seq::NP_data(), l);
   }
 }
 
@@ -250,34 +222,19 @@ _CORBA_Bounded_Sequence_w_FixSizeElement<T,max,elmSize,elmAlignment>::operator<<
     _CORBA_marshal_sequence_range_check_error(s);
     // never reach here
   }
+  Base_T_seq::length(0);
   Base_T_seq::length(l);
   if (l==0) return;
   s.get_octet_array((_CORBA_Octet*)Base_T_seq::NP_data(),
 		    (int)l*elmSize,
 		    (omni::alignment_t)elmAlignment);
   if (s.unmarshal_byte_swap() && elmAlignment != 1) {
-    if (elmSize == 2) {
-      for (_CORBA_ULong i=0; i<l; i++) {
-	_CORBA_UShort t = ((_CORBA_UShort*)Base_T_seq::NP_data())[i];
-	((_CORBA_UShort*)Base_T_seq::NP_data())[i] = Swap16(t);
-      }
-    }
-    else if (elmSize == 4) {
-      for (_CORBA_ULong i=0; i<l; i++) {
-	_CORBA_ULong t = ((_CORBA_ULong*)Base_T_seq::NP_data())[i];
-	((_CORBA_ULong*)Base_T_seq::NP_data())[i] = Swap32(t);
-      }
-    }
-    else if (elmSize == 8) {
-      l *= 2;
-      for (_CORBA_ULong i=0; i<l; i+=2) {
-	_CORBA_ULong tl1 = ((_CORBA_ULong*)Base_T_seq::NP_data())[i+1];
-	_CORBA_ULong tl2 = Swap32(tl1);
-	tl1 = ((_CORBA_ULong*)Base_T_seq::NP_data())[i];
-	((_CORBA_ULong*)Base_T_seq::NP_data())[i] = tl2;
-	((_CORBA_ULong*)Base_T_seq::NP_data())[i+1] = Swap32(tl1);
-      }
-    }
+    if (elmSize == 2)
+      cdrStream::swapArray16(Base_T_seq::NP_data(), l);
+    else if (elmSize == 4)
+      cdrStream::swapArray32(Base_T_seq::NP_data(), l);
+    else if (elmSize == 8)
+      cdrStream::swapArray64(Base_T_seq::NP_data(), l);
   }
 }
 
@@ -323,6 +280,94 @@ _CORBA_Bounded_Sequence_w_FixSizeElement<_CORBA_Double,max,8,8>::operator<<= (cd
 #endif
 
 
+//////////////////////////////////////////////////////////////////////
+template <class T,int elmSize,int elmAlignment>
+inline
+void
+_CORBA_Unbounded_Sequence_w_FixLayoutElement<T,elmSize,elmAlignment>::operator>>= (cdrStream& s) const
+{
+  if (!T::_cdrLayout() || s.marshal_byte_swap()) {
+    Base_T_seq::operator>>=(s);
+    return;
+  }
+  _CORBA_ULong l = Base_T_seq::length();
+  l >>= s;
+  if (l==0) return;
+  s.put_octet_array((const _CORBA_Octet*)Base_T_seq::NP_data(),
+		    (int)l*elmSize,
+		    (omni::alignment_t)elmAlignment);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+template <class T,int elmSize,int elmAlignment>
+inline
+void
+_CORBA_Unbounded_Sequence_w_FixLayoutElement<T,elmSize,elmAlignment>::operator<<= (cdrStream& s)
+{
+  if (!T::_cdrLayout() || s.unmarshal_byte_swap()) {
+    Base_T_seq::operator<<=(s);
+    return;
+  }
+  _CORBA_ULong l;
+  l <<= s;
+  if (!s.checkInputOverrun(elmSize,l)) {
+    _CORBA_marshal_sequence_range_check_error(s);
+    // never reach here
+  }
+  Base_T_seq::length(0);
+  Base_T_seq::length(l);
+  if (l==0) return;
+  s.get_octet_array((_CORBA_Octet*)Base_T_seq::NP_data(),
+		    (int)l*elmSize,
+		    (omni::alignment_t)elmAlignment);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+template <class T,int max,int elmSize,int elmAlignment>
+inline
+void
+_CORBA_Bounded_Sequence_w_FixLayoutElement<T,max,elmSize,elmAlignment>::operator>>= (cdrStream& s) const
+{
+  if (!T::_cdrLayout() || s.marshal_byte_swap()) {
+    Base_T_seq::operator>>=(s);
+    return;
+  }
+  _CORBA_ULong l = Base_T_seq::length();
+  l >>= s;
+  if (l==0) return;
+  s.put_octet_array((const _CORBA_Octet*)Base_T_seq::NP_data(),
+		    (int)l*elmSize,
+		    (omni::alignment_t)elmAlignment);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+template <class T,int max,int elmSize,int elmAlignment>
+inline
+void
+_CORBA_Bounded_Sequence_w_FixLayoutElement<T,max,elmSize,elmAlignment>::operator<<= (cdrStream& s)
+{
+  if (!T::_cdrLayout() || s.unmarshal_byte_swap()) {
+    Base_T_seq::operator<<=(s);
+    return;
+  }
+  _CORBA_ULong l;
+  l <<= s;
+  if (!s.checkInputOverrun(elmSize,l) || (l > max)) {
+    _CORBA_marshal_sequence_range_check_error(s);
+    // never reach here
+  }
+  Base_T_seq::length(0);
+  Base_T_seq::length(l);
+  if (l==0) return;
+  s.get_octet_array((_CORBA_Octet*)Base_T_seq::NP_data(),
+		    (int)l*elmSize,
+		    (omni::alignment_t)elmAlignment);
+}
+
+
 //////////////////////////////////////////////////////////////////////
 inline
 void
@@ -378,6 +423,7 @@ _CORBA_Sequence_Boolean::operator<<= (cdrStream& s)
     _CORBA_marshal_sequence_range_check_error(s);
     // never reach here
   }
+  this->length(0);
   this->length(l);
   if (l==0) return;
 # if !defined(HAS_Cplusplus_Bool) || (SIZEOF_BOOL == 1)
@@ -410,6 +456,7 @@ _CORBA_Sequence_Octet::operator<<= (cdrStream& s)
     _CORBA_marshal_sequence_range_check_error(s);
     // never reach here
   }
+  this->length(0);
   this->length(l);
   if (l==0) return;
   s.get_octet_array(this->pd_buf,l);
@@ -573,6 +620,7 @@ _CORBA_Sequence_Array_Boolean<T,T_slice,dimension>::operator<<=(cdrStream& s)
     _CORBA_marshal_sequence_range_check_error(s);
     // never reach here
   }
+  this->length(0);
   this->length(l);
   if (l==0) return;
 # if !defined(HAS_Cplusplus_Bool) || (SIZEOF_BOOL == 1)
@@ -606,6 +654,7 @@ _CORBA_Sequence_Array_Octet<T,T_slice,dimension>::operator<<=(cdrStream& s)
     _CORBA_marshal_sequence_range_check_error(s);
     // never reach here
   }
+  this->length(0);
   this->length(l);
   if (l==0) return;
   s.get_octet_array((_CORBA_Octet*)this->pd_buf,(int)l*dimension);
@@ -675,36 +724,19 @@ _CORBA_Unbounded_Sequence_Array_w_FixSizeElement<T,T_slice,Telm,dimension,elmSiz
     _CORBA_marshal_sequence_range_check_error(s);
     // never reach here
   }
+  Base_T_seq::length(0);
   Base_T_seq::length(l);
   if (l==0) return;
   s.get_octet_array((_CORBA_Octet*)Base_T_seq::NP_data(),
 		    (int)l*dimension*elmSize,
 		    (omni::alignment_t)elmAlignment);
   if (s.unmarshal_byte_swap() && elmAlignment != 1) {
-    if (elmSize == 2) {
-      l *= dimension;
-      for (_CORBA_ULong i=0; i<l; i++) {
-	_CORBA_UShort t = ((_CORBA_UShort*)Base_T_seq::NP_data())[i];
-	((_CORBA_UShort*)Base_T_seq::NP_data())[i] = Swap16(t);
-      }
-    }
-    else if (elmSize == 4) {
-      l *= dimension;
-      for (_CORBA_ULong i=0; i<l; i++) {
-	_CORBA_ULong t = ((_CORBA_ULong*)Base_T_seq::NP_data())[i];
-	((_CORBA_ULong*)Base_T_seq::NP_data())[i] = Swap32(t);
-      }
-    }
-    else if (elmSize == 8) {
-      l *= 2*dimension;
-      for (_CORBA_ULong i=0; i<l; i+=2) {
-	_CORBA_ULong tl1 = ((_CORBA_ULong*)Base_T_seq::NP_data())[i+1];
-	_CORBA_ULong tl2 = Swap32(tl1);
-	tl1 = ((_CORBA_ULong*)Base_T_seq::NP_data())[i];
-	((_CORBA_ULong*)Base_T_seq::NP_data())[i] = tl2;
-	((_CORBA_ULong*)Base_T_seq::NP_data())[i+1] = Swap32(tl1);
-      }
-    }
+    if (elmSize == 2)
+      cdrStream::swapArray16(Base_T_seq::NP_data(), l*dimension);
+    else if (elmSize == 4)
+      cdrStream::swapArray32(Base_T_seq::NP_data(), l*dimension);
+    else if (elmSize == 8)
+      cdrStream::swapArray64(Base_T_seq::NP_data(), l*dimension);
   }
 }
 
@@ -740,36 +772,19 @@ _CORBA_Bounded_Sequence_Array_w_FixSizeElement<T,T_slice,Telm,dimension,max,elmS
     _CORBA_marshal_sequence_range_check_error(s);
     // never reach here
   }
+  Base_T_seq::length(0);
   Base_T_seq::length(l);
   if (l==0) return;
   s.get_octet_array((_CORBA_Octet*)Base_T_seq::NP_data(),
 		    (int)l*dimension*elmSize,
 		    (omni::alignment_t)elmAlignment);
   if (s.unmarshal_byte_swap() && elmAlignment != 1) {
-    if (elmSize == 2) {
-      l *= dimension;
-      for (_CORBA_ULong i=0; i<l; i++) {
-	_CORBA_UShort t = ((_CORBA_UShort*)Base_T_seq::NP_data())[i];
-	((_CORBA_UShort*)Base_T_seq::NP_data())[i] = Swap16(t);
-      }
-    }
-    else if (elmSize == 4) {
-      l *= dimension;
-      for (_CORBA_ULong i=0; i<l; i++) {
-	_CORBA_ULong t = ((_CORBA_ULong*)Base_T_seq::NP_data())[i];
-	((_CORBA_ULong*)Base_T_seq::NP_data())[i] = Swap32(t);
-      }
-    }
-    else if (elmSize == 8) {
-      l *= 2*dimension;
-      for (_CORBA_ULong i=0; i<l; i+=2) {
-	_CORBA_ULong tl1 = ((_CORBA_ULong*)Base_T_seq::NP_data())[i+1];
-	_CORBA_ULong tl2 = Swap32(tl1);
-	tl1 = ((_CORBA_ULong*)Base_T_seq::NP_data())[i];
-	((_CORBA_ULong*)Base_T_seq::NP_data())[i] = tl2;
-	((_CORBA_ULong*)Base_T_seq::NP_data())[i+1] = Swap32(tl1);
-      }
-    }
+    if (elmSize == 2)
+      cdrStream::swapArray16(Base_T_seq::NP_data(), l*dimension);
+    else if (elmSize == 4)
+      cdrStream::swapArray32(Base_T_seq::NP_data(), l*dimension);
+    else if (elmSize == 8)
+      cdrStream::swapArray64(Base_T_seq::NP_data(), l*dimension);
   }
 }
 
@@ -800,7 +815,4 @@ _CORBA_Sequence_ObjRef<T,ElemT,T_Helper>::operator<<= (cdrStream& s)
     operator[](i) = T_Helper::unmarshalObjRef(s);
 }
 
-#undef Swap16
-#undef Swap32
-
 #endif // __SEQTEMPLATEDEFNS_H__
@@ -89,6 +89,7 @@ public:
 
   void lock();
   void unlock();
+  int trylock();
   inline void acquire(void) { lock();   }
   inline void release(void) { unlock(); }
 
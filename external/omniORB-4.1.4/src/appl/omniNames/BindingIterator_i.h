@@ -26,6 +26,7 @@
 #define _BindingIterator_i_h_
 
 #include <NamingContext_i.h>
+#include <ObjectBinding.h>
 
 
 #if defined(__sgi) && defined(_COMPILER_VERSION)
@@ -35,15 +36,43 @@
 #endif
 
 
+//
+// A BindingIterator_i does not hold a copy of the bindings it has yet to
+// return.  It keeps a pointer to the next ObjectBinding in its context,
+// and copies bindings out a chunk at a time as next_n() is called, so
+// listing a large context never builds a list of the whole of it.
+// Bindings added to the context while the iterator is in use may be
+// returned by it; removed bindings are skipped.
+//
+// The iterator holds a reference to the context servant, and is linked
+// into the context's list of iterators while it exists.  Both the list
+// and the cursors are protected by the context's bindingsLock.
+//
+
 class BindingIterator_i : public POA_CosNaming::BindingIterator,
 			  public PortableServer::RefCountServantBase
 {
 
+  friend class NamingContext_i;
+
 public:
 
-  BindingIterator_i(PortableServer::POA_ptr poa, CosNaming::BindingList* l)
-    : list(l)
+  //
+  // The caller must hold the context's bindingsLock as a writer.
+  //
+
+  BindingIterator_i(PortableServer::POA_ptr poa, NamingContext_i* context,
+		    ObjectBinding* start)
+    : nc(context), cursor(start)
   {
+    nc->_add_ref();
+
+    prev = 0;
+    next = nc->headIterator;
+    if (next)
+      next->prev = this;
+    nc->headIterator = this;
+
     PortableServer::ObjectId_var id = poa->activate_object(this);
   }
 
@@ -67,27 +96,17 @@ public:
   CORBA::Boolean next_n(CORBA::ULong how_many, CosNaming::BindingList_out bl) {
 
     //
-    // What we do here is return the current list to the caller, shortening
-    // it to the required length.  Before this however, we create a new list
-    // and copy the rest of the bindings into the new list.
+    // Several callers may share an iterator, so moving the cursor needs
+    // cursorLock as well as the context's lock.
     //
 
-    if (list->length() < how_many) {
-      how_many = list->length();
-    }
-    bl = list;
-    list = new CosNaming::BindingList(bl->length() - how_many);
-    list->length(bl->length() - how_many);
-    for (unsigned int i = 0; i < list->length(); i++) {
-      (*list)[i] = (*bl)[i + how_many];
-    }
+    ReaderLock r(nc->bindingsLock);
+    omni_mutex_lock l(cursorLock);
 
-    bl->length(how_many);
+    bl = new CosNaming::BindingList;
+    fill(how_many, *bl.ptr());
 
-    if (how_many == 0)
-      return 0;
-    else
-      return 1;
+    return bl->length() != 0;
   }
 
   void destroy(void) {
@@ -98,11 +117,47 @@ public:
 
 private:
 
-  CosNaming::BindingList* list;
+  NamingContext_i* nc;
+  ObjectBinding* cursor;
+  omni_mutex cursorLock;
+
+  BindingIterator_i* prev;
+  BindingIterator_i* next;
+
+  //
+  // Copy up to how_many bindings from the cursor onwards into bl and move
+  // the cursor past them.  The caller must hold the context's bindingsLock.
+  //
+
+  void fill(CORBA::ULong how_many, CosNaming::BindingList& bl) {
+
+    CORBA::ULong n = 0;
+    ObjectBinding* ob;
+
+    for (ob = cursor; ob && n < how_many; ob = ob->next)
+      n++;
+
+    bl.length(n);
+
+    for (CORBA::ULong i = 0; i < n; i++, cursor = cursor->next)
+      bl[i] = cursor->binding;
+  }
 
   // remember the destructor for an object should never be called explicitly.
   ~BindingIterator_i() {
-    delete list;
+    {
+      WriterLock w(nc->bindingsLock);
+
+      if (prev) {
+	prev->next = next;
+      } else {
+	nc->headIterator = next;
+      }
+      if (next) {
+	next->prev = prev;
+      }
+    }
+    nc->_remove_ref();
   }
 };
 
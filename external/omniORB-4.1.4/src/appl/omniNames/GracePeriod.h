@@ -0,0 +1,146 @@
+// -*- Mode: C++; -*-
+//                          Package   : omniNames
+// GracePeriod.h
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//  This file is part of omniNames.
+//
+//  omniNames is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+//  USA.
+//
+
+//
+// This class lets readers look at a data structure without taking a lock,
+// while writers change it and free the parts they have removed once no
+// reader can still be looking at them.
+//
+// A reader brackets its accesses with readerIn() and readerOut().  These
+// only count the reader in and out, in one of several counters chosen by
+// the reader's thread id so that threads mostly use different cache
+// lines.  There are two sets of counters, selected by the current epoch.
+//
+// A writer first unlinks whatever it is removing, so that new readers
+// cannot find it, then calls synchronize().  That switches the epoch and
+// waits until every reader counted in the old epoch has left, after which
+// the removed items can be freed.  A reader that read the epoch just
+// before the switch checks it again after counting itself in, and retries
+// if it has changed.
+//
+
+#ifndef _GracePeriod_h_
+#define _GracePeriod_h_
+
+#include <omnithread.h>
+
+#if defined(__GNUC__)
+#  define GRACEPERIOD_ATOMIC 1
+#endif
+
+
+class GracePeriod {
+
+public:
+
+  GracePeriod(void) : epoch(0) {
+    for (int e = 0; e < 2; e++)
+      for (int i = 0; i < SLOTS; i++)
+	count[e][i].n = 0;
+  }
+
+#ifdef GRACEPERIOD_ATOMIC
+
+  unsigned int readerIn(void) {
+    unsigned int slot = readerSlot();
+    for (;;) {
+      unsigned int e = epoch;
+      __sync_fetch_and_add(&count[e][slot].n, 1);
+      __sync_synchronize();
+      if (e == epoch)
+	return e * SLOTS + slot;
+      __sync_fetch_and_add(&count[e][slot].n, -1);
+    }
+  }
+
+  void readerOut(unsigned int token) {
+    __sync_fetch_and_add(&count[token / SLOTS][token % SLOTS].n, -1);
+  }
+
+  void synchronize(void) {
+    omni_mutex_lock l(m);
+
+    unsigned int old = epoch;
+    epoch = 1 - old;
+    __sync_synchronize();
+
+    for (int i = 0; i < SLOTS; i++) {
+      while (count[old][i].n)
+	omni_thread::yield();
+    }
+    __sync_synchronize();
+  }
+
+#else
+
+  //
+  // Without atomic operations, readers and writers simply exclude each
+  // other.
+  //
+
+  unsigned int readerIn(void) { m.lock(); return 0; }
+  void readerOut(unsigned int) { m.unlock(); }
+  void synchronize(void) { omni_mutex_lock l(m); }
+
+#endif
+
+private:
+
+  enum { SLOTS = 16 };
+
+  static unsigned int readerSlot(void) {
+    omni_thread* self = omni_thread::self();
+    if (self)
+      return (unsigned int)self->id() & (SLOTS - 1);
+
+    // Not an omni_thread.  Thread stacks are usually a large power of two
+    // apart, so mix the bits of a stack address before picking a slot.
+    unsigned long addr = (unsigned long)&self >> 12;
+    return (unsigned int)((addr * 2654435761UL) >> 16) & (SLOTS - 1);
+  }
+
+  struct Counter {
+    volatile int n;
+    char pad[64 - sizeof(int)];
+  };
+
+  Counter count[2][SLOTS];
+  volatile unsigned int epoch;
+  omni_mutex m;
+};
+
+
+//
+// As with ReaderLock, a GracePeriodReader brackets a block as a reader.
+//
+
+class GracePeriodReader {
+  GracePeriod& gp;
+  unsigned int token;
+public:
+  GracePeriodReader(GracePeriod& g) : gp(g) { token = gp.readerIn(); }
+  ~GracePeriodReader(void) { gp.readerOut(token); }
+};
+
+#endif
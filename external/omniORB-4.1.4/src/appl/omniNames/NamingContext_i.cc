@@ -45,6 +45,7 @@
 #endif
 
 ReadersWritersLock NamingContext_i::lock;
+GracePeriod NamingContext_i::readers;
 NamingContext_i* NamingContext_i::headContext = (NamingContext_i*)0;
 NamingContext_i* NamingContext_i::tailContext = (NamingContext_i*)0;
 
@@ -56,10 +57,15 @@ OMNI_USING_NAMESPACE(omni)
 NamingContext_i::NamingContext_i(PortableServer::POA_ptr poa,
 				 const PortableServer::ObjectId& id,
 				 omniNameslog* l)
-  : redolog(l), nc_poa(poa)
+  : redolog(l), nc_poa(poa), nc_id(id), destroyed(0)
 {
   headBinding = tailBinding = (ObjectBinding*)0;
   size = 0;
+  table = (BindingTable*)0;
+  retiredTables = (BindingTable*)0;
+  retiredBindings = (ObjectBinding*)0;
+  retiredCount = 0;
+  headIterator = (BindingIterator_i*)0;
 
   WriterLock w(lock);
 
@@ -93,15 +99,234 @@ NamingContext_i::new_context()
   CosNaming::NamingContext_ptr ncref = nc->_this();
   nc->_remove_ref();
 
+  redolog->sync();
+
   return ncref;
 }
 
 
 
+//
+// hash() returns the hash of a name component's id and kind.  It is an
+// FNV-1a hash, with the id's terminating null included so that ("ab","c")
+// and ("a","bc") hash differently.
+//
+
+unsigned long
+NamingContext_i::hash(const CosNaming::NameComponent& c)
+{
+  CORBA::ULong h = 2166136261U;
+  const unsigned char* p;
+
+  for (p = (const unsigned char*)(const char*)c.id; ; p++) {
+    h = (h ^ *p) * 16777619U;
+    if (!*p) break;
+  }
+  for (p = (const unsigned char*)(const char*)c.kind; *p; p++) {
+    h = (h ^ *p) * 16777619U;
+  }
+  return h;
+}
+
+
+//
+// A slot of the hash table holds a null pointer if it has never been
+// used, a pointer to removedBinding if its binding has been removed, or a
+// pointer to a binding.
+//
+
+static char removedBindingMark;
+#define removedBinding ((ObjectBinding*)&removedBindingMark)
+
+#if defined(__GNUC__)
+#  define PUBLISH() __sync_synchronize()
+#else
+#  define PUBLISH()
+#endif
+
+
+//
+// lookup() returns the binding for a name component, or 0 if there is
+// none.  It needs no lock, but the caller must be counted in as a reader
+// of the grace period, or hold bindingsLock as a writer, until it has
+// finished with the binding.
+//
+
+ObjectBinding*
+NamingContext_i::lookup(const CosNaming::NameComponent& c)
+{
+  BindingTable* t = table;
+  if (!t)
+    return 0;
+
+  unsigned long h    = hash(c);
+  unsigned long mask = t->tableSize - 1;
+
+  for (unsigned long i = h & mask; ; i = (i + 1) & mask) {
+    ObjectBinding* ob = t->slot[i];
+
+    if (!ob)
+      return 0;
+
+    if (ob != removedBinding && ob->hash == h &&
+	(strcmp(c.id,ob->binding.binding_name[0].id) == 0) &&
+	(strcmp(c.kind,ob->binding.binding_name[0].kind) == 0))
+      return ob;
+  }
+#ifdef NEED_DUMMY_RETURN
+  return 0;
+#endif
+}
+
+
+//
+// tableInsert(), tableReplace() and tableRemove() change the hash table.
+// The caller must hold bindingsLock as a writer.  tableInsert() must only
+// be given a binding whose name is not already in the table.
+//
+
+void
+NamingContext_i::tableInsert(ObjectBinding* ob)
+{
+  BindingTable* t = table;
+
+  if (!t || (t->used + 1) * 4 > t->tableSize * 3) {
+
+    //
+    // Build a new table with room for twice the current bindings, which
+    // also drops any tombstones, and switch readers over to it.
+    //
+
+    unsigned long newSize = 32;
+    while (newSize < (size + 1) * 2)
+      newSize *= 2;
+
+    BindingTable* nt = (BindingTable*)
+      new char[sizeof(BindingTable) + (newSize - 1) * sizeof(ObjectBinding*)];
+
+    nt->tableSize = newSize;
+    nt->used      = 0;
+    nt->retired   = 0;
+
+    unsigned long i;
+    for (i = 0; i < newSize; i++)
+      nt->slot[i] = 0;
+
+    for (ObjectBinding* b = headBinding; b; b = b->next) {
+      if (b == ob)
+	continue;
+      for (i = b->hash & (newSize - 1); nt->slot[i]; i = (i + 1) & (newSize - 1));
+      nt->slot[i] = b;
+      nt->used++;
+    }
+
+    PUBLISH();
+    table = nt;
+
+    if (t) {
+      t->retired = retiredTables;
+      retiredTables = t;
+      retiredCount++;
+    }
+    t = nt;
+  }
+
+  unsigned long mask = t->tableSize - 1;
+  unsigned long i;
+
+  for (i = ob->hash & mask; t->slot[i] && t->slot[i] != removedBinding;
+       i = (i + 1) & mask);
+
+  if (!t->slot[i])
+    t->used++;
+
+  PUBLISH();
+  t->slot[i] = ob;
+}
+
+void
+NamingContext_i::tableReplace(ObjectBinding* old, ObjectBinding* ob)
+{
+  BindingTable* t = table;
+  unsigned long mask = t->tableSize - 1;
+  unsigned long i;
+
+  for (i = old->hash & mask; t->slot[i] != old; i = (i + 1) & mask)
+    assert(t->slot[i]);
+
+  PUBLISH();
+  t->slot[i] = ob;
+}
+
+void
+NamingContext_i::tableRemove(ObjectBinding* ob)
+{
+  BindingTable* t = table;
+  unsigned long mask = t->tableSize - 1;
+  unsigned long i;
+
+  for (i = ob->hash & mask; t->slot[i] != ob; i = (i + 1) & mask)
+    assert(t->slot[i]);
+
+  t->slot[i] = removedBinding;
+}
+
+
+//
+// retire() is called with bindingsLock held as a writer, once a binding
+// is no longer in the hash table.  It takes the binding out of the list,
+// moves on any iterator that would have returned it next, and keeps it
+// until the next grace period.
+//
+
+void
+NamingContext_i::retire(ObjectBinding* ob)
+{
+  for (BindingIterator_i* bi = headIterator; bi; bi = bi->next) {
+    if (bi->cursor == ob)
+      bi->cursor = ob->next;
+  }
+
+  ob->unlink();
+
+  ob->next = retiredBindings;
+  retiredBindings = ob;
+
+  if (++retiredCount >= 256)
+    reclaim();
+}
+
+
+//
+// reclaim() waits for a grace period to pass and frees everything retired
+// before it.  The caller must hold bindingsLock as a writer.
+//
+
+void
+NamingContext_i::reclaim()
+{
+  if (!retiredCount)
+    return;
+
+  readers.synchronize();
+
+  while (retiredBindings) {
+    ObjectBinding* ob = retiredBindings;
+    retiredBindings = ob->next;
+    delete ob;
+  }
+  while (retiredTables) {
+    BindingTable* t = retiredTables;
+    retiredTables = t->retired;
+    delete [] (char*)t;
+  }
+  retiredCount = 0;
+}
+
+
 //
 // resolve_simple() returns the ObjectBinding for a given simple name.
-// The thread calling this must have called either lock.readerIn() or
-// lock.writerIn() before calling this routine.
+// The thread calling this must hold bindingsLock as a writer.
 //
 
 ObjectBinding* 
@@ -112,19 +337,14 @@ NamingContext_i::resolve_simple(const CosNaming::Name& n)
   DB(cerr << "  resolve_simple name (" << n[0].id << "," << n[0].kind << ")"
      << " in context " << this << endl);
 
-  for (ObjectBinding* ob = headBinding; ob; ob = ob->next) {
+  ObjectBinding* ob = lookup(n[0]);
 
-    assert(ob->binding.binding_name.length() == 1);
+  if (ob) {
+    DB(cerr << "  resolve_simple: found (" << n[0].id << "," << n[0].kind
+       << ")" << " in context " << this << ", bound to "
+       << (void*)((CORBA::Object_ptr)ob->object) << endl);
 
-    if ((strcmp(n[0].id,ob->binding.binding_name[0].id) == 0) &&
-	(strcmp(n[0].kind,ob->binding.binding_name[0].kind) == 0))
-      {
-	DB(cerr << "  resolve_simple: found (" << n[0].id << "," << n[0].kind
-	   << ")" << " in context " << this << ", bound to "
-	   << (void*)((CORBA::Object_ptr)ob->object) << endl);
-
-	return ob;
-      }
+    return ob;
   }
 
   DB(cerr << "  resolve_simple: didn't find (" << n[0].id << "," << n[0].kind
@@ -143,6 +363,10 @@ NamingContext_i::resolve_simple(const CosNaming::Name& n)
 // resolve_compound() returns an object reference for the first component of
 // the given name (which must be a context), and the rest of the name.
 //
+// The first component is looked up without locking.  The rest of the name
+// is then resolved by the context it names, so a compound resolve only
+// touches the contexts along its path.
+//
 
 CosNaming::NamingContext_ptr
 NamingContext_i::resolve_compound(const CosNaming::Name& n,
@@ -158,33 +382,43 @@ NamingContext_i::resolve_compound(const CosNaming::Name& n,
     throw CosNaming::NamingContext::InvalidName();
   }
 
-  CosNaming::Name contextName = n;
-  contextName.length(1);
   restOfName.length(n.length() - 1);
   for (unsigned int i = 0; i < n.length() - 1; i++) {
     restOfName[i] = n[i + 1];
   }
 
-  ObjectBinding* ob;
+  CORBA::Object_var obj;
+  CosNaming::BindingType type = CosNaming::nobject;
 
-  ReaderLock r(lock);
+  waitForStartUp();
+  {
+    GracePeriodReader r(readers);
 
-  try {
-    ob = resolve_simple(contextName);
+    ObjectBinding* ob = lookup(n[0]);
+    if (ob) {
+      obj  = CORBA::Object::_duplicate(ob->object);
+      type = ob->binding.binding_type;
+    }
   }
-  catch (CosNaming::NamingContext::NotFound& ex) {
-    ex.rest_of_name = n;
-    throw;
+
+  if (CORBA::is_nil(obj)) {
+    throw CosNaming::NamingContext::NotFound(CosNaming::NamingContext::
+					     missing_node, n);
   }
 
+  //
+  // Narrowing may need to contact the object, so it is done outside the
+  // reader section.
+  //
+
   CosNaming::NamingContext_var context
-    = CosNaming::NamingContext::_narrow(ob->object);
+    = CosNaming::NamingContext::_narrow(obj);
 
   if (CORBA::is_nil((CosNaming::NamingContext_ptr)context) ||
-      (ob->binding.binding_type != CosNaming::ncontext))
+      (type != CosNaming::ncontext))
   {
     DB(cerr << "  resolve_compound: object "
-       << (void*)((CORBA::Object_ptr)ob->object)
+       << (void*)((CORBA::Object_ptr)obj)
        << " not (bound as) a context; raising exception" << endl);
     throw CosNaming::NamingContext::NotFound(CosNaming::NamingContext::
 					     not_context, n);
@@ -205,13 +439,26 @@ NamingContext_i::resolve(const CosNaming::Name& n)
     DB(cerr << "resolve simple name (" << n[0].id << "," << n[0].kind
        << ") in context " << this << endl);
 
-    ReaderLock r(lock);
+    waitForStartUp();
+    {
+      GracePeriodReader r(readers);
+
+      ObjectBinding* ob = lookup(n[0]);
 
-    ObjectBinding* ob = resolve_simple(n);
+      if (ob) {
+	DB(cerr << "returning " << (void*)((CORBA::Object_ptr)ob->object)
+	   << endl);
+
+	return CORBA::Object::_duplicate(ob->object);
+      }
+    }
 
-    DB(cerr << "returning " << (void*)((CORBA::Object_ptr)ob->object) << endl);
+    DB(cerr << "  resolve: didn't find (" << n[0].id << "," << n[0].kind
+       << ")" << " in context " << this << "; raising exception"
+       << endl);
 
-    return CORBA::Object::_duplicate(ob->object);
+    throw CosNaming::NamingContext::NotFound(CosNaming::NamingContext::
+					     missing_node, n);
 
   } else {
 
@@ -226,6 +473,9 @@ NamingContext_i::resolve(const CosNaming::Name& n)
 
     return context->resolve(restOfName);
   }
+#ifdef NEED_DUMMY_RETURN
+  return 0;
+#endif
 }
 
 
@@ -249,39 +499,52 @@ NamingContext_i::bind_helper(const CosNaming::Name& n, CORBA::Object_ptr obj,
     DB(cerr << "  bind simple name (" << n[0].id << "," << n[0].kind << ") to "
        << obj << " in context " << this << endl);
 
-    WriterLock w(lock);
+    unsigned long ticket;
+    {
+      ReaderLock r(lock);
+      WriterLock w(bindingsLock);
 
-    ObjectBinding* ob = 0;
+      ObjectBinding* ob = 0;
 
-    try {
-      ob = resolve_simple(n);
-      if (!rebind)
-	throw CosNaming::NamingContext::AlreadyBound();
-    }
-    catch (CosNaming::NamingContext::NotFound& ex) {
-      ob = 0;
-      DB(cerr << "  bind in context " << this
-	 << ": caught not found exception from resolving simple name\n"
-	 << "    reason " << ex.why << " rest of name ");
-
-      for (unsigned int i = 0; i < ex.rest_of_name.length(); i++) {
-	DB(cerr << "(" << ex.rest_of_name[i].id << ","
-	   << ex.rest_of_name[i].kind << ")");
+      try {
+	ob = resolve_simple(n);
+	if (!rebind)
+	  throw CosNaming::NamingContext::AlreadyBound();
+      }
+      catch (CosNaming::NamingContext::NotFound& ex) {
+	ob = 0;
+	DB(cerr << "  bind in context " << this
+	   << ": caught not found exception from resolving simple name\n"
+	   << "    reason " << ex.why << " rest of name ");
+
+	for (unsigned int i = 0; i < ex.rest_of_name.length(); i++) {
+	  DB(cerr << "(" << ex.rest_of_name[i].id << ","
+	     << ex.rest_of_name[i].kind << ")");
+	}
+	DB(cerr << endl);
       }
-      DB(cerr << endl);
-    }
 
-    CosNaming::NamingContext_var nc = _this();
-    redolog->bind(nc, n, obj, t);
+      ticket = redolog->bind(this, n, obj, t);
 
-    if (ob) {
-      DB(cerr << "  rebind in context " << this
-	 << ": unbinding simple name (" << n[0].id << "," << n[0].kind
-	 << ") from " << (void*)((CORBA::Object_ptr)ob->object) << endl);
-      delete ob;
+      ObjectBinding* nob = new ObjectBinding(n, t, obj, this);
+
+      if (ob) {
+	DB(cerr << "  rebind in context " << this
+	   << ": unbinding simple name (" << n[0].id << "," << n[0].kind
+	   << ") from " << (void*)((CORBA::Object_ptr)ob->object) << endl);
+
+	// Readers see either the old binding or the new one, never neither.
+	tableReplace(ob, nob);
+	retire(ob);
+      }
+      else {
+	tableInsert(nob);
+      }
     }
 
-    new ObjectBinding(n, t, obj, this);
+    // Wait for the log record outside the locks, so that other binds in
+    // this context can share its disk write.
+    redolog->sync(ticket);
 
     DB(cerr << "  bind in context " << this << ": bound simple name ("
        << n[0].id << "," << n[0].kind << ") to " << obj << endl);
@@ -337,18 +600,23 @@ NamingContext_i::unbind(const CosNaming::Name& n)
     DB(cerr << "  unbind simple name (" << n[0].id << "," << n[0].kind << ")"
        << " in context " << this << endl);
 
-    WriterLock w(lock);
+    unsigned long ticket;
+    {
+      ReaderLock r(lock);
+      WriterLock w(bindingsLock);
 
-    ObjectBinding* ob = resolve_simple(n);
+      ObjectBinding* ob = resolve_simple(n);
 
-    CosNaming::NamingContext_var nc = _this();
-    redolog->unbind(nc, n);
+      ticket = redolog->unbind(this, n);
 
-    DB(cerr << "  unbind: removing (" << n[0].id << "," << n[0].kind << ")"
-       << " from context " << this << " (was bound to "
-       << (void*)((CORBA::Object_ptr)ob->object) << ")" << endl);
+      DB(cerr << "  unbind: removing (" << n[0].id << "," << n[0].kind << ")"
+	 << " from context " << this << " (was bound to "
+	 << (void*)((CORBA::Object_ptr)ob->object) << ")" << endl);
 
-    delete ob;
+      tableRemove(ob);
+      retire(ob);
+    }
+    redolog->sync(ticket);
 
   } else {
 
@@ -428,16 +696,20 @@ NamingContext_i::destroy()
 {
   DB(cerr << "destroy" << endl);
 
-  WriterLock w(lock);
+  unsigned long ticket;
+  {
+    WriterLock w(lock);
+    ReaderLock b(bindingsLock);
 
-  if (headBinding)
-    throw CosNaming::NamingContext::NotEmpty();
+    if (headBinding)
+      throw CosNaming::NamingContext::NotEmpty();
 
-  CosNaming::NamingContext_var nc = _this();
-  redolog->destroy(nc);
+    ticket = redolog->destroy(this);
+    destroyed = 1;
 
-  PortableServer::ObjectId_var id = nc_poa->servant_to_id(this);
-  nc_poa->deactivate_object(id);
+    nc_poa->deactivate_object(nc_id);
+  }
+  redolog->sync(ticket);
 }
 
 
@@ -449,49 +721,63 @@ void
 NamingContext_i::list(CORBA::ULong how_many, CosNaming::BindingList_out bl,
 		      CosNaming::BindingIterator_out bi)
 {
-  lock.readerIn();
+  //
+  // Only the first how_many bindings are copied.  If there are more, an
+  // iterator is created to hand out the rest on demand.  Registering the
+  // iterator with this context needs bindingsLock as a writer, so it is
+  // only taken as a reader if everything fits in the list.
+  //
+
+  CosNaming::BindingList* first = new CosNaming::BindingList;
+  BindingIterator_i* bii = 0;
+  CORBA::Boolean writer = 0;
+
+  waitForStartUp();
+  bindingsLock.readerIn();
+
+  if (size > how_many) {
+    bindingsLock.readerOut();
+    bindingsLock.writerIn();
+    writer = 1;
+  }
 
   DB(cerr << "list context " << this << ", how_many " << how_many
      << ", size " << size << endl);
 
-  CosNaming::BindingList* all = new CosNaming::BindingList(size);
-  all->length(size);
+  CORBA::ULong n = size < how_many ? size : how_many;
+  first->length(n);
 
   unsigned int i;
   ObjectBinding* ob;
 
-  for (ob = headBinding, i = 0; ob; ob = ob->next, i++) {
-    assert(i < size);
-    (*all)[i] = ob->binding;
-    DB(cerr << "  (" << (*all)[i].binding_name[0].id << ","
-       << (*all)[i].binding_name[0].kind << ") binding type "
-       << (((*all)[i].binding_type == CosNaming::nobject) ?
+  for (ob = headBinding, i = 0; i < n; ob = ob->next, i++) {
+    (*first)[i] = ob->binding;
+    DB(cerr << "  (" << (*first)[i].binding_name[0].id << ","
+       << (*first)[i].binding_name[0].kind << ") binding type "
+       << (((*first)[i].binding_type == CosNaming::nobject) ?
 	   "nobject" : "ncontext")
        << endl);
   }
 
-  lock.readerOut();
+  if (ob)
+    bii = new BindingIterator_i(names_poa, this, ob);
 
-  if( all->length() <= how_many ) {
+  if (writer)
+    bindingsLock.writerOut();
+  else
+    bindingsLock.readerOut();
+
+  bl = first;
+
+  if (!bii) {
     // don't need an iterator.  All results can go back as a
     // result of this call
     bi = CosNaming::BindingIterator::_nil();
-    bl = all;
     return;
   }
 
-  BindingIterator_i* bii = new BindingIterator_i(names_poa, all);
-
   bi = bii->_this();
   bii->_remove_ref();
-
-  if (CORBA::is_nil(bi.ptr())) {
-    cerr << "couldn't narrow binding iterator" << endl;
-    return;
-  }
-
-  DB(cerr << "  calling next_n()" << endl);
-  bi->next_n(how_many, bl);
 }
 
 
@@ -516,8 +802,27 @@ NamingContext_i::~NamingContext_i()
     tailContext = prev;
   }
 
-  while (headBinding)
-    delete headBinding;
+  //
+  // No call can be in progress on this context any more, so the
+  // bindings can be freed straight away.
+  //
+
+  while (headBinding) {
+    ObjectBinding* ob = headBinding;
+    ob->unlink();
+    delete ob;
+  }
+  while (retiredBindings) {
+    ObjectBinding* ob = retiredBindings;
+    retiredBindings = ob->next;
+    delete ob;
+  }
+  while (retiredTables) {
+    BindingTable* t = retiredTables;
+    retiredTables = t->retired;
+    delete [] (char*)t;
+  }
+  delete [] (char*)table;
 }
 
 
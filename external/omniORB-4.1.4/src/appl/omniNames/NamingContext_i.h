@@ -27,6 +27,7 @@
 #define _NamingContext_i_h_
 
 #include <ReadersWritersLock.h>
+#include <GracePeriod.h>
 #include <log.h>
 #include <omniORB4/Naming.hh>
 
@@ -34,12 +35,14 @@ extern PortableServer::POA_var names_poa;
 
 
 class ObjectBinding;
+class BindingIterator_i;
 
 class NamingContext_i : public POA_CosNaming::NamingContextExt,
 			public PortableServer::RefCountServantBase
 {
 
   friend class ObjectBinding;
+  friend class BindingIterator_i;
   friend class omniNameslog;
 
 public:
@@ -101,10 +104,18 @@ private:
   omniNameslog* redolog;
   PortableServer::POA_ptr nc_poa; // The POA this NamingContext is
                                   // activated in
+  PortableServer::ObjectId nc_id; // and its id there, which the log uses
+				  // to refer to it
+  CORBA::Boolean destroyed;	  // set by destroy(), so that checkpoints
+				  // leave it out
 
   //
-  // This multiple-readers, single-writer lock is used to control access to
-  // all NamingContexts served by this process.
+  // This multiple-readers, single-writer lock protects the state of the
+  // naming service as a whole.  Operations which change a context's
+  // bindings hold it as readers, so they only exclude each other within
+  // a context (see bindingsLock).  Creating and destroying contexts, and
+  // writing a checkpoint, hold it as a writer.  Resolving names does not
+  // use it at all.
   //
 
   static ReadersWritersLock lock;
@@ -121,6 +132,13 @@ private:
   NamingContext_i* next;
   NamingContext_i* prev;
 
+  //
+  // bindingsLock is held as a writer while the bindings of this context
+  // are changed, and as a reader to walk the list of bindings.
+  //
+
+  ReadersWritersLock bindingsLock;
+
   //
   // The following represent the list of bindings within this context.
   //
@@ -129,6 +147,57 @@ private:
   ObjectBinding* tailBinding;
   unsigned long size;
 
+  //
+  // The bindings are also indexed by name in an open addressing hash
+  // table, which is looked up without any lock.  Writers only ever change
+  // a slot with a single pointer store, and replace the whole table when
+  // it fills up.  A binding that is removed leaves a tombstone in its
+  // slot.  Removed bindings and replaced tables are kept until a grace
+  // period has passed, after which no reader can still be using them.
+  //
+
+  struct BindingTable {
+    unsigned long tableSize;		// a power of two
+    unsigned long used;			// slots not null
+    BindingTable* retired;
+    ObjectBinding* volatile slot[1];
+  };
+
+  BindingTable* volatile table;
+  BindingTable* retiredTables;
+  ObjectBinding* retiredBindings;
+  unsigned long retiredCount;
+
+  static GracePeriod readers;
+
+  //
+  // Lookups do not wait for writers, but while the log is replayed at
+  // start up they must not see a half built naming graph.  The replay
+  // holds lock as a writer, so they wait for that.
+  //
+
+  void waitForStartUp() {
+    if (redolog->isStartingUp()) {
+      ReaderLock r(lock);
+    }
+  }
+
+  static unsigned long hash(const CosNaming::NameComponent& c);
+  ObjectBinding* lookup(const CosNaming::NameComponent& c);
+  void tableInsert(ObjectBinding* ob);
+  void tableReplace(ObjectBinding* old, ObjectBinding* ob);
+  void tableRemove(ObjectBinding* ob);
+  void retire(ObjectBinding* ob);
+  void reclaim();
+
+  //
+  // The BindingIterators still working through this context.  Each one
+  // refers to the next binding it will return, so it must be moved on
+  // when that binding is removed.
+  //
+
+  BindingIterator_i* headIterator;
+
   //
   // These are private routines which do most of the job of the various
   // IDL operations.
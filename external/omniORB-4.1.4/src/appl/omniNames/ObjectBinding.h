@@ -38,6 +38,8 @@ public:
   ObjectBinding* prev;
   ObjectBinding* next;
 
+  unsigned long hash;
+
   ObjectBinding(const CosNaming::Name& n, CosNaming::BindingType t,
 		CORBA::Object_ptr o, NamingContext_i* nct,
 		ObjectBinding* nx = 0)
@@ -62,9 +64,16 @@ public:
       nc->headBinding = this;
     }
     nc->size++;
+
+    hash = NamingContext_i::hash(n[0]);
   }
 
-  ~ObjectBinding()
+  //
+  // Take this binding out of its context's list.  The binding itself is
+  // freed later, since readers may still be looking at it.
+  //
+
+  void unlink()
   {
     if (prev) {
       prev->next = next;
@@ -64,24 +64,11 @@
 #  include <sys/param.h>
 #endif
 
-#ifndef O_SYNC
-#  ifdef  O_FSYNC              // FreeBSD 3.2 does not have O_SYNC???
-#    define O_SYNC O_FSYNC
-#  endif
-#endif
-
-#ifdef HAVE_STD
-#  define USE_STREAM_OPEN
-#  define OPEN(name,mode,perm) open(name,mode)
-#elif defined(__SUNPRO_CC) && __SUNPRO_CC >= 0x500
-#  define USE_STREAM_OPEN
-#  define OPEN(name,mode,perm) open(name,mode,perm)
-#elif defined(__DMC__)
-#  define USE_STREAM_OPEN
-#  define OPEN(name,mode,perm) open(name,mode,perm)
-#elif defined(__ICC)
-#  define USE_STREAM_OPEN
-#  define OPEN(name,mode,perm) open(name,mode,perm)
+#ifdef __WIN32__
+#  define LOG_BINARY O_BINARY
+#else
+#  define LOG_BINARY 0
+#  include <sys/mman.h>
 #endif
 
 #ifndef HAVE_STRDUP
@@ -100,15 +87,271 @@ strdup (char* str)
 #endif  // not HAVE_STRDUP
 
 
-static
-inline void reallyFlush(ofstream& f) {
-    f.flush();
-#ifdef needsExplicitFsync
-    ::fsync(f.rdbuf()->fd());
+extern void usage();
+
+static int getBinaryPort(const char* file);
+
+
+//
+// Binary log format.  A log file starts with logMagic, followed by a
+// sequence of records.  Each record has an 8 byte header holding the
+// length of its body and a checksum of the body, both little-endian.  The
+// body is a CDR encapsulation starting with the record type, and is
+// padded with zeros to a multiple of 8 bytes, so that every body starts
+// suitably aligned for reading in place.
+//
+// Log files written by earlier versions consist of lines of text, the
+// first of which starts "port".  They are still read, and are replaced
+// by a binary checkpoint as soon as they have been read.
+//
+
+static const char logMagic[8] = { 'o','m','n','i','N','S','L','1' };
+
+enum {
+  LOG_PORT       = 1,	// ULong port
+  LOG_PERSISTENT = 2,	// ObjectId persistent identifier
+  LOG_CREATE     = 3,	// ObjectId of the new context
+  LOG_DESTROY    = 4,	// ObjectId of the context
+  LOG_BIND       = 5,	// ObjectId of the context, string id, string kind,
+			// ULong binding type, Object
+  LOG_UNBIND     = 6	// ObjectId of the context, string id, string kind
+};
+
+static const size_t recordHeaderSize = 8;
+
+// Checkpoints are written in chunks of about this size.
+static const size_t checkpointChunk = 1024 * 1024;
+
+static inline size_t
+recordPadding(size_t len)
+{
+  return (8 - (len & 7)) & 7;
+}
+
+static inline void
+putLittleULong(char* p, CORBA::ULong v)
+{
+  p[0] = (char)v;
+  p[1] = (char)(v >> 8);
+  p[2] = (char)(v >> 16);
+  p[3] = (char)(v >> 24);
+}
+
+static inline CORBA::ULong
+getLittleULong(const char* p)
+{
+  const unsigned char* u = (const unsigned char*)p;
+  return u[0] | (u[1] << 8) | (u[2] << 16) | ((CORBA::ULong)u[3] << 24);
+}
+
+//
+// FNV-1a hash of a record body.  It only has to catch a record that was
+// not completely written before a crash.
+//
+
+static CORBA::ULong
+checksum(const char* p, size_t len)
+{
+  CORBA::ULong h = 2166136261U;
+  const unsigned char* u = (const unsigned char*)p;
+  for (size_t i = 0; i < len; i++) {
+    h ^= u[i];
+    h *= 16777619U;
+  }
+  return h;
+}
+
+
+//
+// Low level file access.  The log is written with plain file descriptors,
+// so that we know exactly when data reaches the disk.
+//
+
+static int
+openLog(const char* name, int create)
+{
+#ifdef __WIN32__
+  if (create)
+    return _open(name, O_WRONLY | O_CREAT | O_TRUNC | LOG_BINARY,
+		 _S_IREAD | _S_IWRITE);
+  return _open(name, O_WRONLY | O_APPEND | LOG_BINARY);
+#else
+  if (create)
+    return open(name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  return open(name, O_WRONLY | O_APPEND);
 #endif
 }
 
-extern void usage();
+static int
+writeFully(int fd, const char* p, size_t len)
+{
+  while (len) {
+#ifdef __WIN32__
+    int n = _write(fd, p, (unsigned int)len);
+#else
+    int n = write(fd, p, len);
+#endif
+    if (n < 0) {
+      if (errno == EINTR)
+	continue;
+      return 0;
+    }
+    p   += n;
+    len -= n;
+  }
+  return 1;
+}
+
+static int
+syncFile(int fd)
+{
+#if defined(__WIN32__)
+  return _commit(fd) == 0;
+#elif defined(__linux__)
+  return fdatasync(fd) == 0;
+#else
+  return fsync(fd) == 0;
+#endif
+}
+
+static int
+closeFile(int fd)
+{
+#ifdef __WIN32__
+  return _close(fd) == 0;
+#else
+  return close(fd) == 0;
+#endif
+}
+
+static int
+truncateFile(const char* name, size_t len)
+{
+#ifdef __WIN32__
+  int fd = _open(name, O_WRONLY | LOG_BINARY);
+  if (fd < 0)
+    return 0;
+  int ok = _chsize(fd, (long)len) == 0;
+  _close(fd);
+  return ok;
+#else
+  return truncate(name, len) == 0;
+#endif
+}
+
+
+//
+// The contents of a log file, mapped into memory where that is possible
+// and read into a buffer otherwise.
+//
+
+class logImage {
+public:
+  const char* data;
+  size_t      len;
+  int         ok;
+
+  logImage(const char* name) : data(0), len(0), ok(0), mapped(0) {
+#ifdef __WIN32__
+    int fd = _open(name, O_RDONLY | LOG_BINARY);
+#else
+    int fd = open(name, O_RDONLY);
+#endif
+    if (fd < 0)
+      return;
+
+#ifdef __WIN32__
+    struct _stat sb;
+    if (_fstat(fd, &sb) < 0) {
+#else
+    struct stat sb;
+    if (fstat(fd, &sb) < 0) {
+#endif
+      closeFile(fd);
+      return;
+    }
+    len = sb.st_size;
+
+#if !defined(__WIN32__) && !defined(__VMS)
+    if (len) {
+      void* p = mmap(0, len, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+#  ifdef MADV_SEQUENTIAL
+	madvise(p, len, MADV_SEQUENTIAL);
+#  endif
+	data   = (const char*)p;
+	mapped = 1;
+      }
+    }
+#endif
+    if (len && !mapped) {
+      char*  buf = new char[len];
+      size_t got = 0;
+      while (got < len) {
+#ifdef __WIN32__
+	int n = _read(fd, buf + got, (unsigned int)(len - got));
+#else
+	int n = read(fd, buf + got, len - got);
+#endif
+	if (n < 0 && errno == EINTR)
+	  continue;
+	if (n <= 0)
+	  break;
+	got += n;
+      }
+      data = buf;
+      len  = got;
+    }
+    closeFile(fd);
+    ok = 1;
+  }
+
+  ~logImage() {
+#if !defined(__WIN32__) && !defined(__VMS)
+    if (mapped) {
+      munmap((void*)data, len);
+      return;
+    }
+#endif
+    delete [] (char*)data;
+  }
+
+  int isBinary() const {
+    return len >= sizeof(logMagic) &&
+           memcmp(data, logMagic, sizeof(logMagic)) == 0;
+  }
+
+private:
+  int mapped;
+};
+
+
+void
+omniNameslog::Buffer::append(const void* p, size_t n)
+{
+  if (len + n > max) {
+    size_t newmax = max ? max * 2 : 4096;
+    while (newmax < len + n)
+      newmax *= 2;
+    char* newdata = new char[newmax];
+    if (len)
+      memcpy(newdata, data, len);
+    delete [] data;
+    data = newdata;
+    max  = newmax;
+  }
+  memcpy(data + len, p, n);
+  len += n;
+}
+
+void
+omniNameslog::Buffer::swap(Buffer& b)
+{
+  char*  d = data; data = b.data; b.data = d;
+  size_t l = len;  len  = b.len;  b.len  = l;
+  size_t m = max;  max  = b.max;  b.max  = m;
+}
+
 
 
 //
@@ -156,12 +399,18 @@ timestamp ts;
 
 omniNameslog::omniNameslog(int& p, const char* arg_logdir,
 			   int nohostname, int always)
-  : port(p)
+  : port(p), logCond(&logLock)
 {
   startingUp = 1;
   checkpointNeeded = 1;
   line = 1;
 
+  logfd = -1;
+  appended = durable = 0;
+  writerActive = ioFailed = 0;
+  checkpointing = 0;
+  tailSkip = 0;
+
 #ifdef __WIN32__
   struct _stat sb;
 #else
@@ -356,8 +605,25 @@ omniNameslog::omniNameslog(int& p, const char* arg_logdir,
       }
     }
 
+    //
+    // Logs written by earlier versions are text, and start with "port".
+    //
+
+    int binary = 0;
+    if (initf) {
+      char magic[sizeof(logMagic)];
+      if (initf.read(magic, sizeof(magic)) &&
+	  memcmp(magic, logMagic, sizeof(magic)) == 0)
+	binary = 1;
+      initf.clear();
+      initf.seekg(0);
+    }
+
     try {
-      getPort(initf);
+      if (binary)
+	port = getBinaryPort(active);
+      else
+	getPort(initf);
     }
     catch (IOError&) {
 
@@ -370,8 +636,10 @@ omniNameslog::omniNameslog(int& p, const char* arg_logdir,
     }
     catch (ParseError&) {
 
-      cerr << ts.t() << "Error: parse error in log file '" << active
-	   << "' at line " << line << "." << endl;
+      cerr << ts.t() << "Error: parse error in log file '" << active << "'";
+      if (!binary)
+	cerr << " at line " << line;
+      cerr << "." << endl;
       initf.close();
       exit(1);
     }
@@ -406,55 +674,42 @@ omniNameslog::init(CORBA::ORB_ptr          the_orb,
 
     cerr << ts.t() << "Starting omniNames for the first time." << endl;
 
-    try {
-#ifdef USE_STREAM_OPEN
-      logf.OPEN(active,ios::out|ios::trunc,0666);
-      if (!logf)
-	throw IOError();
-#else
-#  ifdef __WIN32__
-      int fd = _open(active, O_WRONLY | O_CREAT | O_TRUNC, _S_IWRITE);
-#  else
-      int fd = open(active, O_WRONLY | O_CREAT | O_TRUNC | O_SYNC, 0666);
-#  endif
-      if (fd < 0)
-	throw IOError();
-      logf.attach(fd);
-#endif
-      putPort(port, logf);
+    Buffer buf;
+    buf.append(logMagic, sizeof(logMagic));
+    {
+      cdrEncapsulationStream s;
+      putPort(port, s);
+      putRecord(s, buf);
+    }
 
-      // Build persistent identifier
-      {
-	CORBA::Object_var ref = the_poa->create_reference("");
-	PortableServer::ObjectId_var pid = the_poa->reference_to_id(ref);
-	persistentId = pid;
-
-	// POA's ids are 12 bytes, the last 4 incrementing with each
-	// activated object. We use the first 8 as the persistent
-	// identifier.
-	persistentId.length(8);
-	putPersistent(persistentId, logf);
-      }
-      reallyFlush(logf);
+    // Build persistent identifier
+    {
+      CORBA::Object_var ref = the_poa->create_reference("");
+      PortableServer::ObjectId_var pid = the_poa->reference_to_id(ref);
+      persistentId = pid;
 
-      {
-	PortableServer::ObjectId_var refid =
-	  PortableServer::string_to_ObjectId("NameService");
+      // POA's ids are 12 bytes, the last 4 incrementing with each
+      // activated object. We use the first 8 as the persistent
+      // identifier.
+      persistentId.length(8);
 
-	putCreate(refid, logf);
-      }
+      cdrEncapsulationStream s;
+      putPersistent(persistentId, s);
+      putRecord(s, buf);
+    }
+    {
+      PortableServer::ObjectId_var refid =
+	PortableServer::string_to_ObjectId("NameService");
 
-      logf.close();
-      if (!logf)
-	throw IOError();
+      cdrEncapsulationStream s;
+      putCreate(refid, s);
+      putRecord(s, buf);
+    }
 
-// a bug in sparcworks C++ means that the fd doesn't get closed.
-#if defined(__sunos__) && defined(__SUNPRO_CC) && __SUNPRO_CC < 0x500
-      if (close(fd) < 0)
-	throw IOError();
-#endif
+    int fd = openLog(active, 1);
 
-    } catch (IOError& ex) {
+    if (fd < 0 || !writeFully(fd, buf.data, buf.len) || !syncFile(fd) ||
+	!closeFile(fd)) {
 
       cerr << ts.t() << "Error: cannot create initial log file '" << active
 	   << "': " << endl;
@@ -462,7 +717,6 @@ omniNameslog::init(CORBA::ORB_ptr          the_orb,
       cerr << "\nYou can set the environment variable " << LOGDIR_ENV_VAR
 	   << " to specify the\ndirectory where the log files are kept.\n"
 	   << endl;
-      logf.close();
       unlink(active);
       exit(1);
     }
@@ -474,63 +728,104 @@ omniNameslog::init(CORBA::ORB_ptr          the_orb,
 
   NamingContext_i::lock.writerIn();
 
-  ifstream initf(active);
+  int    textLog = 0;
+  size_t valid   = 0;
+  size_t len     = 0;
+  {
+    logImage image(active);
 
-  if (!initf) {
-    cerr << ts.t() << "Error: cannot open log file '" << active << "'."
-	 << endl;
-    exit(1);
-  }
+    if (!image.ok) {
+      cerr << ts.t() << "Error: cannot open log file '" << active << "'."
+	   << endl;
+      exit(1);
+    }
 
-  try {
-    line = 1;
-
-    while (initf && (initf.peek() != EOF)) {
-
-      char* cmd;
-
-      getNonfinalString(cmd, initf);
-
-      if (strcmp(cmd, "port") == 0) {
-	while (initf && (initf.get() != '\n'));	// ignore rest of line
-	line++;
-      } else if (strcmp(cmd, "persistent") == 0) {
-	getPersistent(initf);
-      } else if (strcmp(cmd, "create") == 0) {
-	getCreate(initf);
-      } else if (strcmp(cmd, "destroy") == 0) {
-	getDestroy(initf);
-      } else if (strcmp(cmd, "bind") == 0) {
-	getBind(initf);
-      } else if (strcmp(cmd, "unbind") == 0) {
-	getUnbind(initf);
-      } else {
-	cerr << ts.t() << "Error: unknown command '" << cmd
-	     << "' in log file '" << active << "'." << endl;
-	throw ParseError();
+    if (image.isBinary()) {
+      try {
+	valid = replay(image.data, image.len);
+	len   = image.len;
+      }
+      catch (ParseError&) {
+	exit(1);
       }
+    }
+    else {
+      textLog = 1;
+    }
+  }
 
-      delete [] cmd;
+  if (valid < len) {
+    // The last write before a crash was incomplete.  Cut it off, so that
+    // new records follow on from the last complete one.
+    cerr << ts.t() << "Ignoring incomplete record at offset " << valid
+	 << " in log file '" << active << "'." << endl;
+
+    if (!truncateFile(active, valid)) {
+      cerr << ts.t() << "Error: cannot truncate log file '" << active
+	   << "'." << endl;
+      exit(1);
     }
+  }
 
-    initf.close();
+  if (textLog) {
 
-  } catch (IOError&) {
+    ifstream initf(active);
 
-    cerr << ts.t() << "Error: reading log file '" << active << "' failed: "
-	 << flush;
-    perror("");
-    initf.close();
-    exit(1);
+    if (!initf) {
+      cerr << ts.t() << "Error: cannot open log file '" << active << "'."
+	   << endl;
+      exit(1);
+    }
+
+    try {
+      line = 1;
+
+      while (initf && (initf.peek() != EOF)) {
+
+	char* cmd;
+
+	getNonfinalString(cmd, initf);
+
+	if (strcmp(cmd, "port") == 0) {
+	  while (initf && (initf.get() != '\n'));	// ignore rest of line
+	  line++;
+	} else if (strcmp(cmd, "persistent") == 0) {
+	  getPersistent(initf);
+	} else if (strcmp(cmd, "create") == 0) {
+	  getCreate(initf);
+	} else if (strcmp(cmd, "destroy") == 0) {
+	  getDestroy(initf);
+	} else if (strcmp(cmd, "bind") == 0) {
+	  getBind(initf);
+	} else if (strcmp(cmd, "unbind") == 0) {
+	  getUnbind(initf);
+	} else {
+	  cerr << ts.t() << "Error: unknown command '" << cmd
+	       << "' in log file '" << active << "'." << endl;
+	  throw ParseError();
+	}
 
-  } catch (ParseError&) {
+	delete [] cmd;
+      }
 
-    cerr << ts.t() << "Error: parse error in log file '" << active
-	 << "' at line " << line << "." << endl;
-    initf.close();
-    exit(1);
-  }
+      initf.close();
+
+    } catch (IOError&) {
+
+      cerr << ts.t() << "Error: reading log file '" << active << "' failed: "
+	   << flush;
+      perror("");
+      initf.close();
+      exit(1);
+
+    } catch (ParseError&) {
 
+      cerr << ts.t() << "Error: parse error in log file '" << active
+	   << "' at line " << line << "." << endl;
+      initf.close();
+      exit(1);
+    }
+  }
 
   cerr << ts.t() << "Read log file successfully." << endl;
 
@@ -568,110 +863,195 @@ omniNameslog::init(CORBA::ORB_ptr          the_orb,
 
   CORBA::release(rootContext);	// dispose of the object reference
 
-#ifdef USE_STREAM_OPEN
-  logf.OPEN(active,ios::out|ios::app,0666);
-  if (!logf) {
-    cerr << ts.t() << "Error: cannot open log file '" << active
-	 << "' for writing." << endl;
-    exit(1);
-  }
-#else
-#  ifdef __WIN32__
-  int fd = _open(active, O_WRONLY | O_APPEND);
-#  else
-  int fd = open(active, O_WRONLY | O_APPEND | O_SYNC);
-#  endif
+  // remove checkpoint. This will protect us from trouble if the previous
+  // incarnation crashed during checkpointing and at the
+  // time when both active and checkpoint are linked to the same file.
 
-  if (fd < 0) {
-    cerr << ts.t() << "Error: cannot open log file '" << active
-	 << "' for writing." << endl;
-    exit(1);
+  unlink(checkpt);
+
+  if (textLog) {
+    //
+    // Replace the text log with a binary one straight away.  The
+    // checkpoint opens the new log for appending.
+    //
+    cerr << ts.t() << "Converting log file to binary format." << endl;
+    checkpointNeeded = 1;
+    checkpoint();
+    if (logfd < 0)
+      exit(1);
+  }
+  else {
+    logfd = openLog(active, 0);
+    if (logfd < 0) {
+      cerr << ts.t() << "Error: cannot open log file '" << active
+	   << "' for writing." << endl;
+      exit(1);
+    }
   }
-  logf.attach(fd);
-#endif
 
   startingUp = 0;
 
   NamingContext_i::lock.writerOut();
+}
 
-  // remove checkpoint. This will protect us from trouble if the previous
-  // incarnation crashed during checkpointing and at the
-  // time when both active and checkpoint are linked to the same file.
 
-  unlink(checkpt);
+omniNameslog::~omniNameslog()
+{
+  if (logfd >= 0)
+    closeFile(logfd);
 }
 
 
-void
-omniNameslog::create(const PortableServer::ObjectId& id)
+//
+// appendRecord() adds a record to the pending buffer and returns its
+// ticket.
+//
+
+unsigned long
+omniNameslog::appendRecord(cdrEncapsulationStream& s)
 {
-  if (!startingUp) {
-    try {
-      putCreate(id, logf);
-      reallyFlush(logf);
-    } catch (IOError& ex) {
-      cerr << ts.t() << flush;
-      perror("I/O error writing log file");
-      logf.clear();
-      throw CORBA::PERSIST_STORE();
-    }
-    checkpointNeeded = 1;
-  }
+  omni_mutex_lock l(logLock);
+
+  if (ioFailed)
+    throw CORBA::PERSIST_STORE();
+
+  putRecord(s, pending);
+  checkpointNeeded = 1;
+  return ++appended;
 }
 
+
+//
+// writeBatch() writes everything pending to the log.  It is called with
+// logLock held, and releases it while writing, so that more records can
+// be appended for the next batch.  Threads which want their records
+// written while a batch is in progress wait on logCond, and one of them
+// writes the next batch.
+//
+
 void
-omniNameslog::destroy(CosNaming::NamingContext_ptr nc)
+omniNameslog::writeBatch()
 {
-  if (!startingUp) {
-    try {
-      putDestroy(nc, logf);
-      reallyFlush(logf);
-    } catch (IOError& ex) {
-      cerr << ts.t() << flush;
-      perror("I/O error writing log file");
-      logf.clear();
-      throw CORBA::PERSIST_STORE();
-    }
-    checkpointNeeded = 1;
+  writerActive = 1;
+
+  unsigned long upto = appended;
+  writing.swap(pending);
+
+  if (checkpointing)
+    tail.append(writing.data + tailSkip, writing.len - tailSkip);
+  tailSkip = 0;
+
+  int fd = logfd;
+
+  logLock.unlock();
+  int ok = writeFully(fd, writing.data, writing.len) && syncFile(fd);
+  logLock.lock();
+
+  if (ok) {
+    durable = upto;
+  }
+  else {
+    cerr << ts.t() << flush;
+    perror("I/O error writing log file");
+    ioFailed = 1;
   }
+  writing.len  = 0;
+  writerActive = 0;
+  logCond.broadcast();
 }
 
+
 void
-omniNameslog::bind(CosNaming::NamingContext_ptr nc, const CosNaming::Name& n,
-	  CORBA::Object_ptr obj, CosNaming::BindingType t)
+omniNameslog::sync(unsigned long ticket)
 {
-  if (!startingUp) {
-    try {
-      putBind(nc, n, obj, t, logf);
-      reallyFlush(logf);
-    } catch (IOError& ex) {
-      cerr << ts.t() << flush;
-      perror("I/O error writing log file");
-      logf.clear();
+  if (!ticket)
+    return;
+
+  omni_mutex_lock l(logLock);
+
+  while ((long)(ticket - durable) > 0) {
+    if (ioFailed)
       throw CORBA::PERSIST_STORE();
-    }
-    checkpointNeeded = 1;
+
+    if (writerActive)
+      logCond.wait();
+    else
+      writeBatch();
   }
 }
 
+
 void
-omniNameslog::unbind(CosNaming::NamingContext_ptr nc, const CosNaming::Name& n)
+omniNameslog::sync(void)
 {
-  if (!startingUp) {
-    try {
-      putUnbind(nc, n, logf);
-      reallyFlush(logf);
-    } catch (IOError& ex) {
-      cerr << ts.t() << flush;
-      perror("I/O error writing log file");
-      logf.clear();
-      throw CORBA::PERSIST_STORE();
-    }
-    checkpointNeeded = 1;
+  unsigned long ticket;
+  {
+    omni_mutex_lock l(logLock);
+    ticket = appended;
   }
+  sync(ticket);
 }
 
 
+unsigned long
+omniNameslog::create(const PortableServer::ObjectId& id)
+{
+  if (startingUp)
+    return 0;
+
+  cdrEncapsulationStream s;
+  putCreate(id, s);
+  return appendRecord(s);
+}
+
+unsigned long
+omniNameslog::destroy(NamingContext_i* nc)
+{
+  if (startingUp)
+    return 0;
+
+  cdrEncapsulationStream s;
+  putDestroy(nc->nc_id, s);
+  return appendRecord(s);
+}
+
+unsigned long
+omniNameslog::bind(NamingContext_i* nc, const CosNaming::Name& n,
+		   CORBA::Object_ptr obj, CosNaming::BindingType t)
+{
+  if (startingUp)
+    return 0;
+
+  cdrEncapsulationStream s;
+  putBind(nc->nc_id, n, obj, t, s);
+  return appendRecord(s);
+}
+
+unsigned long
+omniNameslog::unbind(NamingContext_i* nc, const CosNaming::Name& n)
+{
+  if (startingUp)
+    return 0;
+
+  cdrEncapsulationStream s;
+  putUnbind(nc->nc_id, n, s);
+  return appendRecord(s);
+}
+
+
+//
+// A checkpoint writes the whole naming graph to a new file, which then
+// replaces the log.  Updates carry on while it is written: from the
+// moment the list of contexts is taken, every record appended to the log
+// is also kept aside, and these are added to the end of the checkpoint
+// file before it is committed.  Replaying the checkpoint then gives each
+// context the bindings it had when it was written, and the records that
+// follow bring it up to date.  A record in the tail may repeat a change
+// that the checkpoint already holds, which is harmless since bindings
+// are replayed as rebinds, and unbinding a name that is not there is
+// ignored.
+//
+
 void
 omniNameslog::checkpoint(void)
 {
@@ -683,96 +1063,140 @@ omniNameslog::checkpoint(void)
   cerr << ts.t() << "Checkpointing Phase 1: Prepare." << endl;
 
   //
-  // Get the global lock as a reader.  This means clients will still be able
-  // to do "resolve" and "list" operations, but anyone who tries to alter
-  // the state in any way will block until we've finished.
+  // Take the list of contexts with the global lock held as a reader, so
+  // that no context is created or destroyed meanwhile.  Each context is
+  // held by its POA until it is destroyed, so the ones not yet destroyed
+  // can safely be given another reference.
   //
 
-  NamingContext_i::lock.readerIn();
-
-  ofstream ckpf;
-  int fd = -1;
+  NamingContext_i** contexts;
+  unsigned long     count = 0;
+  {
+    ReaderLock r(NamingContext_i::lock);
 
-  try {
+    NamingContext_i* nci;
 
-#ifdef USE_STREAM_OPEN
-    ckpf.OPEN(checkpt,ios::out|ios::trunc,0666);
-    if (!ckpf) {
-      cerr << ts.t() << "Error: cannot open checkpoint file '"
-	   << checkpt << "' for writing." << endl;
-      throw IOError();
+    for (nci = NamingContext_i::headContext; nci; nci = nci->next) {
+      if (!nci->destroyed)
+	count++;
     }
-#else
-#  ifdef __WIN32__
-    fd = _open(checkpt, O_WRONLY | O_CREAT | O_TRUNC, _S_IWRITE);
-#  else
-    fd = open(checkpt, O_WRONLY | O_CREAT | O_TRUNC | O_SYNC, 0666);
-#  endif
+    contexts = new NamingContext_i*[count];
+    count    = 0;
 
-    if (fd < 0) {
-      cerr << ts.t() << "Error: cannot open checkpoint file '"
-	   << checkpt << "' for writing." << endl;
-      throw IOError();
+    for (nci = NamingContext_i::headContext; nci; nci = nci->next) {
+      if (!nci->destroyed) {
+	nci->_add_ref();
+	contexts[count++] = nci;
+      }
     }
 
-    ckpf.attach(fd);
-#endif
-    putPort(port, ckpf);
+    omni_mutex_lock l(logLock);
+    checkpointing    = 1;
+    checkpointNeeded = 0;
+    tail.len         = 0;
+    tailSkip         = pending.len;
+  }
 
-    if (persistentId.length())
-      putPersistent(persistentId, ckpf);
+  int ok = 1;
+  int fd = openLog(checkpt, 1);
 
-    NamingContext_i* nci;
+  if (fd < 0) {
+    cerr << ts.t() << "Error: cannot open checkpoint file '"
+	 << checkpt << "' for writing." << endl;
+    ok = 0;
+  }
+  else {
+    Buffer buf;
+    buf.append(logMagic, sizeof(logMagic));
+    {
+      cdrEncapsulationStream s;
+      putPort(port, s);
+      putRecord(s, buf);
+    }
+    if (persistentId.length()) {
+      cdrEncapsulationStream s;
+      putPersistent(persistentId, s);
+      putRecord(s, buf);
+    }
 
-    for (nci = NamingContext_i::headContext; nci; nci = nci->next) {
-      PortableServer::ObjectId_var id = nci->PR_id();
-      putCreate(id, ckpf);
+    unsigned long i;
+
+    for (i = 0; i < count; i++) {
+      cdrEncapsulationStream s;
+      putCreate(contexts[i]->nc_id, s);
+      putRecord(s, buf);
     }
 
-    for (nci = NamingContext_i::headContext; nci; nci = nci->next) {
-      for (ObjectBinding* ob = nci->headBinding; ob; ob = ob->next) {
-	putBind(nci->_this(), ob->binding.binding_name, ob->object,
-		ob->binding.binding_type, ckpf);
+    for (i = 0; ok && i < count; i++) {
+      NamingContext_i* nci = contexts[i];
+      {
+	// Updates to this context wait while its bindings are copied.
+	ReaderLock b(nci->bindingsLock);
+
+	for (ObjectBinding* ob = nci->headBinding; ob; ob = ob->next) {
+	  cdrEncapsulationStream s;
+	  putBind(nci->nc_id, ob->binding.binding_name, ob->object,
+		  ob->binding.binding_type, s);
+	  putRecord(s, buf);
+	}
+      }
+      if (buf.len >= checkpointChunk) {
+	ok = writeFully(fd, buf.data, buf.len);
+	buf.len = 0;
       }
     }
+    if (ok)
+      ok = writeFully(fd, buf.data, buf.len);
+  }
 
-    ckpf.close();
-    if (!ckpf)
-      throw IOError();
+  for (unsigned long i = 0; i < count; i++)
+    contexts[i]->_remove_ref();
+  delete [] contexts;
 
-// a bug in sparcworks C++ means that the fd doesn't get closed.
-#if defined(__sunos__) && defined(__SUNPRO_CC) && __SUNPRO_CC < 0x500
-    if (close(fd) < 0)
-      throw IOError();
-#endif
+  //
+  // Now commit the checkpoint to become the active log.  Records are not
+  // appended while the tail is added and the files are renamed.
+  //
+
+  if (ok)
+    cerr << ts.t() << "Checkpointing Phase 2: Commit." << endl;
+
+  omni_mutex_lock l(logLock);
+
+  while (writerActive)
+    logCond.wait();
+
+  if (ok) {
+    ok = (writeFully(fd, tail.data, tail.len) &&
+	  writeFully(fd, pending.data + tailSkip, pending.len - tailSkip) &&
+	  syncFile(fd));
+  }
+  checkpointing = 0;
+  tail.len      = 0;
+  tailSkip      = 0;
+
+  if (fd >= 0 && !closeFile(fd))
+    ok = 0;
 
-  } catch (IOError& ex) {
+  if (!ok) {
     cerr << ts.t() << flush;
     perror("I/O error writing checkpoint file");
     cerr << "Abandoning checkpoint" << endl;
-    ckpf.close();
-// a bug in sparcworks C++ means that the fd doesn't get closed.
-#if defined(__sunos__) && defined(__SUNPRO_CC) && __SUNPRO_CC < 0x500
-    close(fd);
-#endif
-    NamingContext_i::lock.readerOut();
     unlink(checkpt);
+    checkpointNeeded = 1;
     return;
   }
 
+  // Everything appended so far is in the checkpoint.
+  pending.len = 0;
+  durable     = appended;
+  ioFailed    = 0;
+  logCond.broadcast();
 
-  //
-  // Now commit the checkpoint to become the active log.
-  //
-
-  cerr << ts.t() << "Checkpointing Phase 2: Commit." << endl;
-
-// a bug in sparcworks C++ means that the fd doesn't get closed.
-#if defined(__sunos__) && defined(__SUNPRO_CC) && __SUNPRO_CC < 0x500
-  close(logf.rdbuf()->fd());
-#endif
-
-  logf.close();
+  if (logfd >= 0) {
+    closeFile(logfd);
+    logfd = -1;
+  }
 
   unlink(backup);
 
@@ -820,41 +1244,324 @@ omniNameslog::checkpoint(void)
   }
 #endif
 
-#ifdef USE_STREAM_OPEN
-  logf.OPEN(active,ios::out|ios::app,0666);
-  if (!logf) {
-    cerr << ts.t() << "Error: cannot open log file '" << active
+  logfd = openLog(active, 0);
+  if (logfd < 0) {
+    cerr << ts.t() << "Error: cannot open new log file '" << active
 	 << "' for writing." << endl;
     exit(1);
   }
-#else
-#  ifdef __WIN32__
-  fd = _open(active, O_WRONLY | O_APPEND);
-#  else
-  fd = open(active, O_WRONLY | O_APPEND | O_SYNC);
-#  endif
 
-  if (fd < 0) {
-    cerr << ts.t() << "Error: cannot open new log file '" << active
-	 << "' for writing." << endl;
-    exit(1);
+  cerr << ts.t() << "Checkpointing completed." << endl;
+}
+
+
+void
+omniNameslog::putRecord(cdrEncapsulationStream& s, Buffer& buf)
+{
+  const char* body = (const char*)s.bufPtr();
+  size_t      len  = s.bufSize();
+
+  char header[recordHeaderSize];
+  putLittleULong(header, (CORBA::ULong)len);
+  putLittleULong(header + 4, checksum(body, len));
+
+  static const char zeros[8] = { 0 };
+
+  buf.append(header, sizeof(header));
+  buf.append(body, len);
+  buf.append(zeros, recordPadding(len));
+}
+
+
+void
+omniNameslog::putPort(int p, cdrEncapsulationStream& s)
+{
+  CORBA::ULong(LOG_PORT) >>= s;
+  CORBA::ULong(p) >>= s;
+}
+
+
+void
+omniNameslog::putPersistent(const PortableServer::ObjectId& id,
+			    cdrEncapsulationStream& s)
+{
+  CORBA::ULong(LOG_PERSISTENT) >>= s;
+  id >>= s;
+}
+
+
+void
+omniNameslog::putCreate(const PortableServer::ObjectId& id,
+			cdrEncapsulationStream& s)
+{
+  CORBA::ULong(LOG_CREATE) >>= s;
+  id >>= s;
+}
+
+
+void
+omniNameslog::putDestroy(const PortableServer::ObjectId& nc,
+			 cdrEncapsulationStream& s)
+{
+  CORBA::ULong(LOG_DESTROY) >>= s;
+  nc >>= s;
+}
+
+
+void
+omniNameslog::putBind(const PortableServer::ObjectId& nc,
+		      const CosNaming::Name& n, CORBA::Object_ptr obj,
+		      CosNaming::BindingType t, cdrEncapsulationStream& s)
+{
+  CORBA::ULong(LOG_BIND) >>= s;
+  nc >>= s;
+  s.marshalRawString(n[0].id);
+  s.marshalRawString(n[0].kind);
+  CORBA::ULong(t) >>= s;
+  CORBA::Object::_marshalObjRef(obj, s);
+}
+
+
+void
+omniNameslog::putUnbind(const PortableServer::ObjectId& nc,
+			const CosNaming::Name& n, cdrEncapsulationStream& s)
+{
+  CORBA::ULong(LOG_UNBIND) >>= s;
+  nc >>= s;
+  s.marshalRawString(n[0].id);
+  s.marshalRawString(n[0].kind);
+}
+
+
+//
+// Check the record at offset pos of a binary log.  Returns the length of
+// its body, or 0 if there is no complete record there.
+//
+
+static size_t
+checkRecord(const char* data, size_t len, size_t pos)
+{
+  if (len - pos < recordHeaderSize)
+    return 0;
+
+  size_t rlen = getLittleULong(data + pos);
+
+  if (rlen == 0 || rlen > len - pos - recordHeaderSize)
+    return 0;
+
+  if (getLittleULong(data + pos + 4) !=
+      checksum(data + pos + recordHeaderSize, rlen))
+    return 0;
+
+  return rlen;
+}
+
+
+//
+// Read the port from the first record of a binary log.  As with the text
+// version, this happens before the ORB is initialised.
+//
+
+static int
+getBinaryPort(const char* file)
+{
+  logImage image(file);
+
+  if (!image.ok)
+    throw omniNameslog::IOError();
+
+  size_t pos  = sizeof(logMagic);
+  size_t rlen = image.isBinary() ? checkRecord(image.data, image.len, pos) : 0;
+
+  CORBA::ULong type = 0, p = 0;
+
+  if (rlen) {
+    try {
+      cdrEncapsulationStream s((const CORBA::Octet*)image.data + pos +
+			       recordHeaderSize, rlen);
+      type <<= s;
+      p    <<= s;
+    }
+    catch (CORBA::SystemException&) {
+      type = 0;
+    }
   }
-  logf.attach(fd);
-#endif
+  if (type != LOG_PORT) {
+    cerr << ts.t() << "Error: log file doesn't start with a port record."
+	 << endl;
+    throw omniNameslog::ParseError();
+  }
+  if (p == 0) {
+    cerr << ts.t() << "Error: invalid port specified in log file." << endl;
+    throw omniNameslog::ParseError();
+  }
+  return p;
+}
 
-  NamingContext_i::lock.readerOut();
 
-  cerr << ts.t() << "Checkpointing completed." << endl;
+//
+// replay() applies the records of a binary log held in memory, and
+// returns the length of the part of the log it used.  That is less than
+// the whole log if the last record was not completely written.
+//
+// Records are applied directly to the NamingContext_i servants, found by
+// their object ids, so unlike the text log no object references to
+// contexts have to be parsed and narrowed.
+//
+
+size_t
+omniNameslog::replay(const char* data, size_t len)
+{
+  size_t pos = sizeof(logMagic);
+
+  PortableServer::ObjectId id;
+  PortableServer::ObjectId lastId;
+  NamingContext_i*         lastContext = 0;
+
+  while (pos < len) {
+
+    size_t rlen = checkRecord(data, len, pos);
+
+    if (!rlen) {
+      //
+      // An incomplete record can only be the last thing in the file.  If
+      // the rest of the file is not zeros, and does not end part way
+      // through the record, the log is damaged.
+      //
+      size_t rest = len - pos;
+
+      if (rest >= recordHeaderSize) {
+	size_t claimed = getLittleULong(data + pos);
+	size_t end     = pos + recordHeaderSize + claimed +
+	                 recordPadding(claimed);
+	if (claimed && end < len) {
+	  cerr << ts.t() << "Error: damaged record at offset " << pos
+	       << " in log file '" << active << "'." << endl;
+	  throw ParseError();
+	}
+      }
+      break;
+    }
+
+    try {
+      cdrEncapsulationStream s((const CORBA::Octet*)data + pos +
+			       recordHeaderSize, rlen);
+      CORBA::ULong type;
+      type <<= s;
+
+      switch (type) {
+
+      case LOG_PORT:
+	break;
+
+      case LOG_PERSISTENT:
+	persistentId <<= s;
+	omniORB::setPersistentServerIdentifier(persistentId);
+	break;
+
+      case LOG_CREATE:
+	id <<= s;
+	createContext(id);
+	break;
 
-  checkpointNeeded = 0;
+      case LOG_DESTROY:
+	id <<= s;
+	findContext(id)->destroy();
+	lastContext = 0;
+	break;
+
+      case LOG_BIND:
+      case LOG_UNBIND:
+	{
+	  id <<= s;
+
+	  if (!lastContext || id.length() != lastId.length() ||
+	      memcmp(id.get_buffer(), lastId.get_buffer(), id.length()) != 0) {
+	    lastContext = findContext(id);
+	    lastId      = id;
+	  }
+
+	  CosNaming::Name name(1);
+	  name.length(1);
+	  name[0].id   = s.unmarshalRawString();
+	  name[0].kind = s.unmarshalRawString();
+
+	  if (type == LOG_BIND) {
+	    CORBA::ULong t;
+	    t <<= s;
+	    CORBA::Object_var obj = CORBA::Object::_unmarshalObjRef(s);
+	    lastContext->bind_helper(name, obj, (CosNaming::BindingType)t, 1);
+	  }
+	  else {
+	    try {
+	      lastContext->unbind(name);
+	    }
+	    catch (CosNaming::NamingContext::NotFound&) {
+	      // Already unbound when the checkpoint before it was taken.
+	    }
+	  }
+	}
+	break;
+
+      default:
+	cerr << ts.t() << "Error: unknown record type " << type
+	     << " at offset " << pos << " in log file '" << active << "'."
+	     << endl;
+	throw ParseError();
+      }
+    }
+    catch (CORBA::SystemException& ex) {
+      cerr << ts.t() << "Error: record at offset " << pos
+	   << " in log file '" << active << "' caused " << ex._name()
+	   << "." << endl;
+      throw ParseError();
+    }
+    catch (CORBA::UserException& ex) {
+      cerr << ts.t() << "Error: record at offset " << pos
+	   << " in log file '" << active << "' caused " << ex._name()
+	   << "." << endl;
+      throw ParseError();
+    }
+
+    pos += recordHeaderSize + rlen + recordPadding(rlen);
+  }
+  return pos < len ? pos : len;
 }
 
 
 void
-omniNameslog::putPort(int p, ostream& file)
+omniNameslog::createContext(const PortableServer::ObjectId& id)
+{
+  NamingContext_i* rc;
+
+  if (id.length() == 12) // SYS_ASSIGNED_ID_SIZE + TRANSIENT_SUFFIX_SIZE
+    rc = new NamingContext_i(poa, id, this);
+  else
+    rc = new NamingContext_i(ins_poa, id, this);
+
+  rc->_remove_ref();
+}
+
+
+NamingContext_i*
+omniNameslog::findContext(const PortableServer::ObjectId& id)
 {
-  file << "port " << p << '\n';
-  if (!file) throw IOError();
+  PortableServer::POA_ptr p = (id.length() == 12) ? poa : ins_poa;
+
+  NamingContext_i* nc = 0;
+  try {
+    PortableServer::ServantBase* servant = p->id_to_servant(id);
+    nc = dynamic_cast<NamingContext_i*>(servant);
+    servant->_remove_ref();	// the POA still holds it
+  }
+  catch (PortableServer::POA::ObjectNotActive&) {
+  }
+  if (!nc) {
+    cerr << ts.t() << "Error: log file refers to an unknown naming context."
+	 << endl;
+    throw ParseError();
+  }
+  return nc;
 }
 
 
@@ -891,16 +1598,6 @@ omniNameslog::getPort(istream& file)
 }
 
 
-void
-omniNameslog::putPersistent(const PortableServer::ObjectId& id, ostream& file)
-{
-  file << "persistent ";
-  putKey(id, file);
-  file << '\n';
-  if (!file) throw IOError();
-}
-
-
 void
 omniNameslog::getPersistent(istream& file)
 {
@@ -909,16 +1606,6 @@ omniNameslog::getPersistent(istream& file)
 }
 
 
-void
-omniNameslog::putCreate(const PortableServer::ObjectId& id, ostream& file)
-{
-  file << "create ";
-  putKey(id, file);
-  file << '\n';
-  if (!file) throw IOError();
-}
-
-
 void
 omniNameslog::getCreate(istream& file)
 {
@@ -927,27 +1614,9 @@ omniNameslog::getCreate(istream& file)
   //
 
   PortableServer::ObjectId id;
-  NamingContext_i*         rc;
 
   getKey(id, file);
-
-  if (id.length() == 12) // SYS_ASSIGNED_ID_SIZE + TRANSIENT_SUFFIX_SIZE
-    rc = new NamingContext_i(poa, id, this);
-  else
-    rc = new NamingContext_i(ins_poa, id, this);
-
-  rc->_remove_ref();
-}
-
-
-void
-omniNameslog::putDestroy(CosNaming::NamingContext_ptr nc, ostream& file)
-{
-  file << "destroy ";
-  CORBA::String_var s = orb->object_to_string(nc);
-  putString(s, file);
-  file << '\n';
-  if (!file) throw IOError();
+  createContext(id);
 }
 
 
@@ -981,28 +1650,6 @@ omniNameslog::getDestroy(istream& file)
 }
 
 
-void
-omniNameslog::putBind(CosNaming::NamingContext_ptr nc, const CosNaming::Name& n,
-	     CORBA::Object_ptr obj, CosNaming::BindingType t, ostream& file)
-{
-  file << "bind ";
-  CORBA::String_var s = orb->object_to_string(nc);
-  putString(s, file);
-  file << ' ';
-  putString(n[0].id, file);
-  file << ' ';
-  putString(n[0].kind, file);
-  if (t == CosNaming::nobject)
-    file << " nobject ";
-  else
-    file << " ncontext ";
-  s = orb->object_to_string(obj);
-  putString(s, file);
-  file << '\n';
-  if (!file) throw IOError();
-}
-
-
 void
 omniNameslog::getBind(istream& file)
 {
@@ -1083,22 +1730,6 @@ omniNameslog::getBind(istream& file)
 
 
 
-void
-omniNameslog::putUnbind(CosNaming::NamingContext_ptr nc, const CosNaming::Name& n,
-	       ostream& file)
-{
-  file << "unbind ";
-  CORBA::String_var s = orb->object_to_string(nc);
-  putString(s, file);
-  file << ' ';
-  putString(n[0].id, file);
-  file << ' ';
-  putString(n[0].kind, file);
-  file << '\n';
-  if (!file) throw IOError();
-}
-
-
 void
 omniNameslog::getUnbind(istream& file)
 {
@@ -1141,17 +1772,6 @@ omniNameslog::getUnbind(istream& file)
 }
 
 
-void
-omniNameslog::putKey(const PortableServer::ObjectId& id, ostream& file)
-{
-  file << hex;
-  for (unsigned int i = 0; i < id.length(); i++) {
-    file << setfill('0') << setw(2) << (int)id[i];
-  }
-  file << dec;
-}
-
-
 void
 omniNameslog::getKey(PortableServer::ObjectId& id, istream& file)
 {
@@ -1171,39 +1791,6 @@ omniNameslog::getKey(PortableServer::ObjectId& id, istream& file)
 }
 
 
-void
-omniNameslog::putString(const char* str, ostream& file)
-{
-  for (int i = strlen(str); i > 0; i--, str++) {
-    switch (*str) {
-      case '\\':
-	file.put('\\');
-	file.put('\\');
-	break;
-      case ' ':
-	file.put('\\');
-	file.put(' ');
-	break;
-      case '\n':
-	file.put('\\');
-	file.put('n');
-	break;
-      case '\t':
-	file.put('\\');
-	file.put('t');
-	break;
-      case '\r':
-	file.put('\\');
-	file.put('r');
-	break;
-      default:
-	file.put(*str);
-	break;
-    }
-  }
-}
-
-
 void
 omniNameslog::getFinalString(char*& buf, istream& file)
 {
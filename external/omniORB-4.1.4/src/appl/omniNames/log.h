@@ -27,6 +27,7 @@
 #define _log_h_
 
 #include <omniORB4/CORBA.h>
+#include <omnithread.h>
 
 #ifdef HAVE_STD
 #  include <fstream>
@@ -39,6 +40,8 @@
 #  define LOGDIR_ENV_VAR "OMNINAMES_LOGDIR"
 #endif
 
+class NamingContext_i;
+
 class omniNameslog {
 
   CORBA::ORB_ptr orb;
@@ -47,42 +50,98 @@ class omniNameslog {
   CORBA::String_var active;
   CORBA::String_var backup;
   CORBA::String_var checkpt;
-  ofstream logf;
 
   int port;
   PortableServer::ObjectId persistentId;
 
-  int startingUp;	// true while reading log file initially.
+  volatile int startingUp; // true while reading log file initially.
   int firstTime;	// true if running for the first time
   int checkpointNeeded;	// true if changes have been made since last checkpoint
 
   int line;		// current line number when reading log file initially.
 
   //
-  // functions to write to a file
+  // The log is a sequence of binary records, each one a CDR encapsulation
+  // preceded by its length and checksum.  Records are appended to a
+  // buffer in memory, and written out by whichever thread next needs its
+  // record to be on disk.  That thread writes the whole buffer with a
+  // single write and fdatasync, so updates made at the same time share
+  // one disk flush.
+  //
+
+  class Buffer {
+  public:
+    char*  data;
+    size_t len;
+    size_t max;
+
+    Buffer() : data(0), len(0), max(0) {}
+    ~Buffer() { delete [] data; }
+
+    void append(const void* p, size_t n);
+    void swap(Buffer& b);
+  };
+
+  int            logfd;		// active log, open for appending
+  omni_mutex     logLock;	// protects the following members
+  omni_condition logCond;	// signalled when a batch has been written
+  Buffer         pending;	// records not yet given to a writer
+  Buffer         writing;	// records being written
+  unsigned long  appended;	// number of records appended so far
+  unsigned long  durable;	// number of records on disk
+  int            writerActive;	// true while a thread writes a batch
+  int            ioFailed;	// true if writing the log failed
+
+  //
+  // While a checkpoint is written, records appended to the log are also
+  // kept in tail, so that they can be added to the end of the checkpoint
+  // file when it becomes the new log.  The first tailSkip bytes of the
+  // pending buffer belong before the checkpoint and are not kept.
+  //
+
+  int            checkpointing;
+  Buffer         tail;
+  size_t         tailSkip;
+
+  unsigned long appendRecord(cdrEncapsulationStream& s);
+  void writeBatch();
+
+  //
+  // functions to encode records
   //
 
-  void putPort(int port, ostream& file);
+  static void putRecord(cdrEncapsulationStream& s, Buffer& buf);
 
-  void putPersistent(const PortableServer::ObjectId& id, ostream& file);
+  static void putPort(int port, cdrEncapsulationStream& s);
 
-  void putCreate(const PortableServer::ObjectId& id, ostream& file);
+  static void putPersistent(const PortableServer::ObjectId& id,
+			    cdrEncapsulationStream& s);
 
-  void putDestroy(CosNaming::NamingContext_ptr nc, ostream& file);
+  static void putCreate(const PortableServer::ObjectId& id,
+			cdrEncapsulationStream& s);
 
-  void putBind(CosNaming::NamingContext_ptr nc,
-	       const CosNaming::Name& n, CORBA::Object_ptr obj,
-	       CosNaming::BindingType t, ostream& file);
+  static void putDestroy(const PortableServer::ObjectId& nc,
+			 cdrEncapsulationStream& s);
 
-  void putUnbind(CosNaming::NamingContext_ptr nc, const CosNaming::Name& n,
-		 ostream& file);
+  static void putBind(const PortableServer::ObjectId& nc,
+		      const CosNaming::Name& n, CORBA::Object_ptr obj,
+		      CosNaming::BindingType t, cdrEncapsulationStream& s);
 
-  void putKey(const PortableServer::ObjectId& id, ostream& file);
+  static void putUnbind(const PortableServer::ObjectId& nc,
+			const CosNaming::Name& n, cdrEncapsulationStream& s);
 
-  void putString(const char* str, ostream& file);
+  //
+  // functions to read the binary log
+  //
+
+  size_t replay(const char* data, size_t len);
+
+  void createContext(const PortableServer::ObjectId& id);
+
+  NamingContext_i* findContext(const PortableServer::ObjectId& id);
 
   //
-  // functions to read from a file
+  // functions to read the text log written by earlier versions
   //
 
   void getPort(istream& file);
@@ -111,20 +170,35 @@ public:
   class ParseError {};
 
   omniNameslog(int& port, const char* logdir, int nohostname, int always);
+  ~omniNameslog();
 
   void init(CORBA::ORB_ptr o,
 	    PortableServer::POA_ptr p,
 	    PortableServer::POA_ptr ip);
 
-  void create(const PortableServer::ObjectId& id);
-  void destroy(CosNaming::NamingContext_ptr nc);
-  void bind(CosNaming::NamingContext_ptr nc,
-	    const CosNaming::Name& n, CORBA::Object_ptr obj,
-	    CosNaming::BindingType t);
-  void unbind(CosNaming::NamingContext_ptr nc, const CosNaming::Name& n);
+  //
+  // These functions append a record to the log and return a ticket for
+  // it.  The record is not necessarily on disk until sync() has been
+  // called with the ticket, which the caller should do after releasing
+  // its locks, so that other updates can join the same disk write.
+  // sync() with no argument waits for every record appended so far.
+  // Both throw PERSIST_STORE if the log cannot be written.
+  //
+
+  unsigned long create(const PortableServer::ObjectId& id);
+  unsigned long destroy(NamingContext_i* nc);
+  unsigned long bind(NamingContext_i* nc,
+		     const CosNaming::Name& n, CORBA::Object_ptr obj,
+		     CosNaming::BindingType t);
+  unsigned long unbind(NamingContext_i* nc, const CosNaming::Name& n);
+
+  void sync(unsigned long ticket);
+  void sync(void);
 
   void checkpoint(void);
 
+  int isStartingUp(void) const { return startingUp; }
+
 };
 
 #endif
@@ -0,0 +1,274 @@
+// -*- Mode: C++; -*-
+//                          Package   : decodetrace
+// decodetrace.cc           Created on: 2026/10/17
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//  This file is part of decodetrace.
+//
+//  Decodetrace is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+//  USA.
+//
+//
+// Prints the binary log records written by an ORB with the traceAsync
+// and traceAsyncBinary options as text, with the time and thread of
+// each message.
+//
+// The record layout must match omniAsyncLog::binaryRecord in
+// include/omniORB4/internal/logAsync.h.
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <omniORB4/CORBA.h>
+
+
+struct binaryRecord {
+  CORBA::ULong     magic;
+  CORBA::ULong     length;
+  CORBA::ULong     thread;
+  CORBA::ULong     dropped;
+  CORBA::ULongLong time;
+};
+
+static const CORBA::ULong BINARY_MAGIC = 0x6f4c4f47;
+static const CORBA::ULong NO_THREAD    = 0xffffffff;
+
+
+struct traceRecord {
+  binaryRecord   header;
+  char*          text;
+  unsigned long  seq;     // Position in the input, to keep the sort stable.
+  CORBA::Boolean plain;   // A line of text, rather than a record.
+};
+
+static traceRecord*  records  = 0;
+static unsigned long nrecords = 0;
+static unsigned long maxrecords = 0;
+
+
+static void usage(char* progname)
+{
+  fprintf(stderr, "usage: %s [-s] [file ...]\n", progname);
+  fprintf(stderr, "  -s  sort the messages of all threads by time.\n");
+  fprintf(stderr, "Reads standard input if no file is given.\n");
+}
+
+
+static inline CORBA::ULong swap32(CORBA::ULong v)
+{
+  return (((v & 0xff000000) >> 24) | ((v & 0x00ff0000) >> 8) |
+	  ((v & 0x0000ff00) << 8)  | ((v & 0x000000ff) << 24));
+}
+
+static inline CORBA::ULongLong swap64(CORBA::ULongLong v)
+{
+  return (((CORBA::ULongLong)swap32((CORBA::ULong)v) << 32) |
+	  swap32((CORBA::ULong)(v >> 32)));
+}
+
+
+static void print(FILE* out, const traceRecord& r)
+{
+  if (r.plain) {
+    fwrite(r.text, 1, r.header.length, out);
+    return;
+  }
+
+  time_t secs  = (time_t)(r.header.time / 1000000000);
+  long   usecs = (long)((r.header.time % 1000000000) / 1000);
+
+  char tbuf[40];
+  strftime(tbuf, sizeof(tbuf), "%Y-%m-%d %H:%M:%S", localtime(&secs));
+  fprintf(out, "%s.%06ld ", tbuf, usecs);
+
+  if (r.header.thread == NO_THREAD)
+    fprintf(out, "(?) ");
+  else
+    fprintf(out, "(%lu) ", (unsigned long)r.header.thread);
+
+  if (r.header.length) {
+    fwrite(r.text, 1, r.header.length, out);
+    if (r.text[r.header.length - 1] != '\n')
+      fputc('\n', out);
+  }
+  else {
+    fprintf(out, "[%lu log messages dropped]\n",
+	    (unsigned long)r.header.dropped);
+  }
+}
+
+
+// Messages logged before asynchronous logging started, or after it
+// stopped, are written as text to the same file. They are passed
+// through unchanged, with the time of the record before them.
+
+static void keepRecord(const traceRecord& r)
+{
+  if (nrecords == maxrecords) {
+    maxrecords = maxrecords ? maxrecords * 2 : 1024;
+    traceRecord* n = new traceRecord[maxrecords];
+    for (unsigned long i = 0; i < nrecords; i++)
+      n[i] = records[i];
+    delete [] records;
+    records = n;
+  }
+  records[nrecords++] = r;
+}
+
+
+static char* readAll(FILE* in, size_t& size)
+{
+  size_t max = 65536;
+  char*  buf = new char[max];
+  size = 0;
+
+  size_t n;
+  while ((n = fread(buf + size, 1, max - size, in)) > 0) {
+    size += n;
+    if (size == max) {
+      char* b = new char[max * 2];
+      memcpy(b, buf, size);
+      delete [] buf;
+      buf = b;
+      max *= 2;
+    }
+  }
+  return buf;
+}
+
+
+// Returns false if the input ends in the middle of a record.
+static CORBA::Boolean readTrace(FILE* in, const char* name,
+				CORBA::Boolean keep, FILE* out)
+{
+  size_t size;
+  char*  buf  = readAll(in, size);
+  size_t pos  = 0;
+  CORBA::ULongLong last = 0;
+  CORBA::Boolean   ok   = 1;
+
+  while (pos < size) {
+    traceRecord r;
+    binaryRecord& h = r.header;
+
+    if (size - pos >= sizeof(h)) {
+      memcpy(&h, buf + pos, sizeof(h));
+    }
+    else {
+      h.magic = 0;
+    }
+
+    if (h.magic == swap32(BINARY_MAGIC)) {
+      h.magic   = BINARY_MAGIC;
+      h.length  = swap32(h.length);
+      h.thread  = swap32(h.thread);
+      h.dropped = swap32(h.dropped);
+      h.time    = swap64(h.time);
+    }
+
+    if (h.magic == BINARY_MAGIC) {
+      if (size - pos - sizeof(h) < h.length) {
+	fprintf(stderr, "%s: truncated record at offset %lu.\n",
+		name, (unsigned long)pos);
+	ok = 0;
+	break;
+      }
+      pos += sizeof(h);
+      r.plain = 0;
+    }
+    else {
+      // A line of text.
+      const char* nl = (const char*)memchr(buf + pos, '\n', size - pos);
+      h.length  = nl ? (nl - (buf + pos)) + 1 : size - pos;
+      h.thread  = NO_THREAD;
+      h.dropped = 0;
+      h.time    = last;
+      r.plain   = 1;
+    }
+    last = h.time;
+
+    r.text = new char[h.length + 1];
+    memcpy(r.text, buf + pos, h.length);
+    r.seq  = nrecords;
+    pos   += h.length;
+
+    if (keep) {
+      keepRecord(r);
+    }
+    else {
+      print(out, r);
+      delete [] r.text;
+    }
+  }
+  delete [] buf;
+  return ok;
+}
+
+
+static int compare(const void* a, const void* b)
+{
+  const traceRecord* ra = (const traceRecord*)a;
+  const traceRecord* rb = (const traceRecord*)b;
+
+  if (ra->header.time != rb->header.time)
+    return ra->header.time < rb->header.time ? -1 : 1;
+
+  return ra->seq < rb->seq ? -1 : (ra->seq > rb->seq ? 1 : 0);
+}
+
+
+int main(int argc, char** argv)
+{
+  CORBA::Boolean sort = 0;
+  int i = 1;
+
+  for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+    if (!strcmp(argv[i], "-s")) {
+      sort = 1;
+    }
+    else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  int rc = 0;
+
+  if (i == argc) {
+    if (!readTrace(stdin, "<stdin>", sort, stdout))
+      rc = 1;
+  }
+  for (; i < argc; i++) {
+    FILE* in = fopen(argv[i], "rb");
+    if (!in) {
+      fprintf(stderr, "%s: cannot open.\n", argv[i]);
+      rc = 1;
+      continue;
+    }
+    if (!readTrace(in, argv[i], sort, stdout))
+      rc = 1;
+    fclose(in);
+  }
+
+  if (sort) {
+    qsort(records, nrecords, sizeof(traceRecord), compare);
+    for (unsigned long j = 0; j < nrecords; j++)
+      print(stdout, records[j]);
+  }
+  return rc;
+}
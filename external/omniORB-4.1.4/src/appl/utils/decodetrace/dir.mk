@@ -0,0 +1,25 @@
+
+CXXSRCS = decodetrace.cc
+
+CorbaImplementation = OMNIORB
+
+DIR_CPPFLAGS = $(CORBA_CPPFLAGS)
+
+DECODETRACE = $(patsubst %,$(BinPattern),decodetrace)
+
+
+all:: $(DECODETRACE)
+
+clean::
+	$(RM) $(DECODETRACE)
+
+$(DECODETRACE): decodetrace.o $(CORBA_LIB_NODYN_DEPEND)
+	@(libs="$(CORBA_LIB_NODYN)"; $(CXXExecutable))
+
+export:: $(DECODETRACE)
+	@$(ExportExecutable)
+
+ifdef INSTALLTARGET
+install:: $(DECODETRACE)
+	@$(InstallExecutable)
+endif
@@ -1,5 +1,5 @@
 ifndef ATMos
-SUBDIRS = genior catior convertior nameclt
+SUBDIRS = genior catior convertior nameclt decodetrace
 endif
 
 all::
@@ -88,6 +88,10 @@ protected:
   // Returns true if the address list and connection id match those of
   // this rope.
 
+  virtual CORBA::Boolean match(const giopAddressList&) const { return 0; }
+  // Override giopRope match. Restricted ropes share the rope table with
+  // normal ones, but must never be selected by giopRope::selectRope.
+
 private:
   CORBA::ULong   pd_connection_id;
   CORBA::Boolean pd_data_batch;
@@ -159,13 +163,10 @@ restrictedGiopRope::selectRope(const giopAddressList& addrlist,
       r = (Rope*)gr; loc = 0;
       return 1;
     }
-    else if (gr->pd_refcount == 0 &&
-	     RopeLink::is_empty(gr->pd_strands) &&
-	     !gr->pd_nwaiting) {
+    else if (gr->isGarbage()) {
       // garbage rope, remove it
       p = p->next;
-      gr->RopeLink::remove();
-      delete gr;
+      deleteRope(gr);
     }
     else {
       p = p->next;
@@ -189,6 +190,7 @@ restrictedGiopRope::selectRope(const giopAddressList& addrlist,
   gr = new restrictedGiopRope(addrlist, prefer_list, connection_id,
 			      max_connections, data_batch, permit_interleaved);
   gr->RopeLink::insert(restrictedGiopRope::ropes);
+  addToRopeTable(gr); // So that the scavenger finds its strands.
   gr->realIncrRefCount();
   r = (Rope*)gr; loc = 0;
   return 1;
@@ -277,9 +277,9 @@ CORBA::Any::Any(const Any& a)
     // Existing Any has data in its void* pointer. Rather than trying
     // to copy that (which would require a copy function to be
     // registered along with the marshal and destructor functions), we
-    // marshal the data into a memory buffer.
-    pd_mbuf = new cdrAnyMemoryStream;
-    a.pd_marshal(*pd_mbuf, a.pd_data);
+    // marshal the data into a memory buffer. The existing Any keeps
+    // the buffer too, so copying it again does not marshal it again.
+    pd_mbuf = new cdrAnyMemoryStream(a.PR_streamToRead());
   }
   else {
     // The Any has just a TypeCode and no data yet.
@@ -299,8 +299,7 @@ CORBA::Any::operator=(const CORBA::Any& a)
       pd_mbuf = new cdrAnyMemoryStream(*a.pd_mbuf);
     }
     else if (a.pd_marshal) {
-      pd_mbuf = new cdrAnyMemoryStream;
-      a.pd_marshal(*pd_mbuf, a.pd_data);
+      pd_mbuf = new cdrAnyMemoryStream(a.PR_streamToRead());
     }
   }
   return *this;
@@ -37,6 +37,7 @@
 #include <tcParser.h>
 #include <typecode.h>
 #include <codeSetUtil.h>
+#include <orbParameters.h>
 #include <omniORB4/valueType.h>
 
 
@@ -54,6 +55,22 @@ OMNI_NAMESPACE_BEGIN(omni)
 //  Code set conversion means that we would have to stop at any char
 //  or wchar data.
 
+// Copy an Any straight from one stream to the other, rather than
+// unpacking its value into the memory buffer of a temporary Any.
+static void copyAny(cdrStream& ibuf, cdrStream& obuf)
+{
+  CORBA::TypeCode_var tc = CORBA::TypeCode::unmarshalTypeCode(ibuf);
+
+  if (orbParameters::tcAliasExpand) {
+    CORBA::TypeCode_var etc = TypeCode_base::aliasExpand(ToTcBase(tc));
+    CORBA::TypeCode::marshalTypeCode(etc, obuf);
+  }
+  else
+    CORBA::TypeCode::marshalTypeCode(tc, obuf);
+
+  tcParser::copyStreamToStream(tc, ibuf, obuf);
+}
+
 inline void fastCopyUsingTC(TypeCode_base* tc, cdrStream& ibuf, cdrStream& obuf)
 {
   // This can only be used if both streams have the same
@@ -117,7 +134,8 @@ inline void fastCopyUsingTC(TypeCode_base* tc, cdrStream& ibuf, cdrStream& obuf)
 	  }
 
 	case CORBA::tk_any:
-	  { CORBA::Any d; d <<= ibuf; d >>= obuf; break; }
+	  copyAny(ibuf, obuf);
+	  break;
 
 	case CORBA::tk_Principal:
 	  {
@@ -317,6 +335,63 @@ inline void fastCopyUsingTC(TypeCode_base* tc, cdrStream& ibuf, cdrStream& obuf)
   }
 }
 
+// Copy <len> items of a 2, 4 or 8 byte simple type a block at a time,
+// swapping their bytes on the way if the streams' byte orders differ.
+// Returns false, having copied nothing, for any other type.
+static CORBA::Boolean
+copyArrayUsingTC(TypeCode_base* tc, CORBA::ULong len,
+		 cdrStream& ibuf, cdrStream& obuf)
+{
+  tc = TypeCode_indirect::strip(tc);
+
+  int size;
+  switch (tc->NP_kind()) {
+  case CORBA::tk_short:
+  case CORBA::tk_ushort:
+    size = 2;
+    break;
+  case CORBA::tk_long:
+  case CORBA::tk_ulong:
+  case CORBA::tk_float:
+  case CORBA::tk_enum:
+    size = 4;
+    break;
+#ifndef OMNI_MIXED_ENDIAN_DOUBLE
+  case CORBA::tk_double:
+#endif
+#ifdef HAS_LongLong
+  case CORBA::tk_longlong:
+  case CORBA::tk_ulonglong:
+#endif
+    size = 8;
+    break;
+  default:
+    return 0;
+  }
+
+  CORBA::Boolean swap = ibuf.unmarshal_byte_swap() != obuf.marshal_byte_swap();
+  omni::alignment_t align = (omni::alignment_t)size;
+
+  CORBA::Octet buf[2048];
+  CORBA::ULong chunk = sizeof(buf) / size;
+
+  while (len) {
+    CORBA::ULong n = len < chunk ? len : chunk;
+    ibuf.get_octet_array(buf, n * size, align);
+    if (swap) {
+      if (size == 2)
+	cdrStream::swapArray16(buf, n);
+      else if (size == 4)
+	cdrStream::swapArray32(buf, n);
+      else
+	cdrStream::swapArray64(buf, n);
+    }
+    obuf.put_octet_array(buf, n * size, align);
+    len -= n;
+  }
+  return 1;
+}
+
 void copyUsingTC(TypeCode_base* tc, cdrStream& ibuf, cdrStream& obuf)
 {
   tc = TypeCode_indirect::strip(tc);
@@ -364,7 +439,8 @@ void copyUsingTC(TypeCode_base* tc, cdrStream& ibuf, cdrStream& obuf)
 #endif
 
     case CORBA::tk_any:
-      { CORBA::Any d;     d <<= ibuf; d >>= obuf; return; }
+      copyAny(ibuf, obuf);
+      return;
 
     // COMPLEX TYPES
     case CORBA::tk_char:
@@ -483,6 +559,9 @@ void copyUsingTC(TypeCode_base* tc, cdrStream& ibuf, cdrStream& obuf)
 	CORBA::ULong max; max <<= ibuf; max >>= obuf;
 	TypeCode_base* tctmp = tc->NP_content_type();
 
+	if (copyArrayUsingTC(tctmp, max, ibuf, obuf))
+	  return;
+
 	for (CORBA::ULong i=0; i < max; i++)
 	  copyUsingTC(tctmp, ibuf, obuf);
 
@@ -494,6 +573,9 @@ void copyUsingTC(TypeCode_base* tc, cdrStream& ibuf, cdrStream& obuf)
 	CORBA::ULong max = tc->NP_length();
 	TypeCode_base* tctmp = tc->NP_content_type();
 
+	if (copyArrayUsingTC(tctmp, max, ibuf, obuf))
+	  return;
+
 	for (CORBA::ULong i=0; i < max; i++)
 	  copyUsingTC(tctmp, ibuf, obuf);
 
@@ -588,7 +670,11 @@ void skipUsingTC(TypeCode_base* tc, cdrStream& buf)
 	  }
 
 	case CORBA::tk_any:
-	  { CORBA::Any d; d <<= buf; break; }
+	  {
+	    CORBA::TypeCode_var d = CORBA::TypeCode::unmarshalTypeCode(buf);
+	    skipUsingTC(ToTcBase_Checked(d), buf);
+	    break;
+	  }
 
 	case CORBA::tk_Principal:
 	case CORBA::tk_string:
@@ -750,6 +836,107 @@ tcParser::copyStreamToStream(const CORBA::TypeCode_ptr tc,
     copyUsingTC(ToTcBase_Checked(tc), src, dest);
 }
 
+// The largest alignment used inside marshalled data of type <tc>.
+// Gives up and returns 8 for Anys, valuetypes and deeply nested types.
+static omni::ptr_arith_t maxAlignment(TypeCode_base* tc, int depth)
+{
+  tc = TypeCode_indirect::strip(tc);
+
+  if (depth > 4)
+    return 8;
+
+  const TypeCode_alignTable& alignTbl = tc->alignmentTable();
+  omni::ptr_arith_t result = 1;
+
+  for (unsigned i = 0; i < alignTbl.entries() && result < 8; i++) {
+    omni::ptr_arith_t a;
+
+    if (alignTbl[i].type == TypeCode_alignTable::it_simple) {
+      a = alignTbl[i].simple.alignment;
+    }
+    else {
+      TypeCode_base* ntc = alignTbl[i].nasty.tc;
+
+      switch (ntc->NP_kind()) {
+      case CORBA::tk_char:
+      case CORBA::tk_fixed:
+	a = 1;
+	break;
+
+      case CORBA::tk_wchar:
+      case CORBA::tk_string:
+      case CORBA::tk_wstring:
+      case CORBA::tk_Principal:
+      case CORBA::tk_objref:
+      case CORBA::tk_TypeCode:
+	a = 4;
+	break;
+
+      case CORBA::tk_sequence:
+	a = maxAlignment(ntc->NP_content_type(), depth + 1);
+	if (a < 4) a = 4;
+	break;
+
+      case CORBA::tk_array:
+      case CORBA::tk_alias:
+	a = maxAlignment(ntc->NP_content_type(), depth + 1);
+	break;
+
+      case CORBA::tk_union:
+	{
+	  a = maxAlignment(ntc->NP_discriminator_type(), depth + 1);
+	  CORBA::ULong n = ntc->NP_member_count();
+	  for (CORBA::ULong j = 0; j < n && a < 8; j++) {
+	    omni::ptr_arith_t ma = maxAlignment(ntc->NP_member_type(j),
+						depth + 1);
+	    if (ma > a) a = ma;
+	  }
+	  break;
+	}
+
+      default:
+	a = 8;
+      }
+    }
+    if (a > result) result = a;
+  }
+  return result;
+}
+
+void
+tcParser::copyMemStreamToStream_rdonly(const CORBA::TypeCode_ptr tc,
+				       const cdrAnyMemoryStream& src,
+				       cdrStream& dest)
+{
+  // The buffer holds exactly the marshalled value, starting at an
+  // eight byte boundary. If the destination would get the same bytes,
+  // the buffer can be copied as a block, without walking the value.
+  // Valuetypes are not stored inline in the buffer, and nested Anys
+  // would need their TypeCodes expanding, so those always take the
+  // slow way.
+  cdrAnyMemoryStream& s = OMNI_CONST_CAST(cdrAnyMemoryStream&, src);
+
+  if (!s.readOnly() && !s.hasValues() && !orbParameters::tcAliasExpand &&
+      s.marshal_byte_swap() == dest.marshal_byte_swap() &&
+      s.TCS_C() == dest.TCS_C() && s.TCS_W() == dest.TCS_W()) {
+
+    // The padding inside the value is the same if the destination is
+    // aligned to the largest alignment the value uses.
+    omni::ptr_arith_t pos = (omni::ptr_arith_t)dest.PR_get_outb_mkr();
+
+    if ((pos & 7) == 0 ||
+	(pos & (maxAlignment(ToTcBase_Checked(tc), 0) - 1)) == 0) {
+
+      CORBA::ULong size = s.bufSize();
+      if (size)
+	dest.put_octet_array((const CORBA::Octet*)s.bufPtr(), size);
+      return;
+    }
+  }
+  cdrAnyMemoryStream tmp_mbs(src, 1);
+  copyStreamToStream(tc, tmp_mbs, dest);
+}
+
 void
 tcParser::skip(const CORBA::TypeCode_ptr tc, cdrStream &s) {
   skipUsingTC(ToTcBase_Checked(tc), s);
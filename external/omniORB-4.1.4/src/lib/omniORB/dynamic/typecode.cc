@@ -1270,7 +1270,7 @@ TypeCode_base::TypeCode_base(CORBA::TCKind tck)
   : pd_complete(1), pd_mark(0), pd_ref_count(1),
     pd_loop_member(0), pd_internal_ref_count(0),
     pd_aliasExpandedTc(0), pd_compactTc(0), pd_tck(tck),
-    pd_next(0)
+    pd_hash(0), pd_next(0)
 {
   switch( tck ) {
 
@@ -1409,6 +1409,14 @@ TypeCode_base::NP_equal(const TypeCode_base* TCp,
   // Check for trivial pointer-based equality
   if (this == TCp) return 1;
 
+  // TypeCodes with different hashes cannot match. The hash covers the
+  // members too, so this is only worth checking at the top level.
+  if (!tcpl) {
+    CORBA::ULong h1 = NP_hash();
+    CORBA::ULong h2 = TCp->NP_hash();
+    if (h1 && h2 && h1 != h2) return 0;
+  }
+
   // Check the pairlist for a match, for recursive typecodes
   if( TypeCode_pairlist::contains(tcpl, this, TCp) )
     return 1;
@@ -1429,6 +1437,90 @@ TypeCode_base::NP_equal(const TypeCode_base* TCp,
 }
 
 
+static inline CORBA::ULong
+hashMix(CORBA::ULong h, CORBA::ULong v)
+{
+  return ((h << 5) ^ (h >> 27)) ^ v;
+}
+
+CORBA::ULong
+TypeCode_base::NP_hash() const
+{
+  if (pd_hash)
+    return pd_hash == 1 ? 0 : pd_hash;
+
+  // The hash must be the same for any two TypeCodes that are
+  // equivalent, so aliases are expanded and names are left out.
+  // Structs, unions and the other types with repository ids are
+  // equivalent if their ids match, regardless of their members, so
+  // for those only the id is hashed. That also means the hash never
+  // recurses into itself.
+  CORBA::ULong h;
+
+  try {
+    const TypeCode_base* tc = NP_expand(this);
+
+    if (!tc->pd_complete)
+      return 0;
+
+    h = hashMix(0, tc->NP_kind());
+
+    switch (tc->NP_kind()) {
+    case CORBA::tk_string:
+    case CORBA::tk_wstring:
+      h = hashMix(h, tc->NP_length());
+      break;
+
+    case CORBA::tk_fixed:
+      h = hashMix(h, tc->NP_fixed_digits());
+      h = hashMix(h, (CORBA::UShort)tc->NP_fixed_scale());
+      break;
+
+    case CORBA::tk_sequence:
+    case CORBA::tk_array:
+      {
+	h = hashMix(h, tc->NP_length());
+	CORBA::ULong ch = tc->NP_content_type()->NP_hash();
+	if (!ch) {
+	  OMNI_CONST_CAST(TypeCode_base*, this)->pd_hash = 1;
+	  return 0;
+	}
+	h = hashMix(h, ch);
+	break;
+      }
+
+    case CORBA::tk_struct:
+    case CORBA::tk_union:
+    case CORBA::tk_enum:
+    case CORBA::tk_except:
+    case CORBA::tk_value:
+    case CORBA::tk_value_box:
+      {
+	const char* id = tc->NP_id();
+	if (!id) {
+	  // Compared structurally against a TypeCode with an id.
+	  OMNI_CONST_CAST(TypeCode_base*, this)->pd_hash = 1;
+	  return 0;
+	}
+	while (*id) h = hashMix(h, *id++);
+	break;
+      }
+
+    default:
+      break;
+    }
+  }
+  catch (CORBA::BAD_TYPECODE&) {
+    // Unresolved recursive TypeCode. It may be completed later.
+    return 0;
+  }
+
+  if (h < 2) h += 2;
+  OMNI_CONST_CAST(TypeCode_base*, this)->pd_hash = h;
+  return h;
+}
+
+
 CORBA::Boolean
 TypeCode_base::NP_extendedEqual(const TypeCode_base* TCp,
 				CORBA::Boolean,
@@ -214,7 +214,8 @@ usage_string = """\
   -Wbdll_includes   Extra support for #included IDL in DLLs
   -Wbguard_prefix   Prefix for include guards in generated headers
   -Wbvirtual_objref Use virtual functions in object references
-  -Wbimpl_mapping   Use 'impl' mapping for object reference methods"""
+  -Wbimpl_mapping   Use 'impl' mapping for object reference methods
+  -Wbami            Generate sendc_ members for asynchronous invocation"""
 
 # Encountering an unknown AST node will cause an AttributeError exception
 # to be thrown in one of the visitors. Store a list of those not-supported
@@ -249,6 +250,8 @@ def process_args(args):
             config.state['Virtual Objref Methods'] = 1
         elif arg == "impl_mapping":
             config.state['Impl Mapping'] = 1
+        elif arg == "ami":
+            config.state['AMI']               = 1
         elif arg == "debug":
             config.state['Debug']             = 1
         elif arg[:2] == "h=":
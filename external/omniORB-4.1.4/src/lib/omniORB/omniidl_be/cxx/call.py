@@ -457,6 +457,105 @@ class CallDescriptor:
                    assign_res = string.join(assign_res,"\n"),
                    assign_context = assign_context)
 
+    def out_objrefcall_async(self,stream,operation,args,localcall_fn,
+                             ami_name,environment):
+        # Like out_objrefcall(), but the call descriptor belongs to the
+        # AMI call object, and lives until its get() member retrieves
+        # the results. Out arguments not stored in the call descriptor
+        # itself are pointed at its own storage, as in out_implcall().
+        assert isinstance(stream, output.Stream)
+
+        ctor_args = [ localcall_fn, "\"" + operation + "\"",
+                      str(len(operation) + 1) ]
+
+        assign_args = []
+        prepare_out_args = []
+
+        n = -1
+        for argument in self.__arguments:
+            n = n + 1
+            arg_n = "_call_desc.arg_" + str(n)
+            argtype = types.Type(argument.paramType())
+            ((h_is_const,h_is_ptr),(s_is_holder,s_is_var)) = \
+                         _arg_info(argtype,argument.direction())
+
+            if argument.is_in():
+                assert not argument.is_out()
+                rvalue = args[n]
+                if argtype.array():
+                    rvalue = "&" + rvalue + "[0]"
+                if argtype.value() or argtype.valuebox():
+                    star = "*"
+                else:
+                    star = ""
+                if h_is_ptr:
+                    rvalue = "&(" + argtype.base(environment) + star + "&) " \
+                             + rvalue
+                assign_args.append(arg_n + " = " + rvalue + ";")
+
+            elif not s_is_holder:
+                rvalue = arg_n + "_"
+                if s_is_var:
+                    rvalue = rvalue + ".out()"
+                if h_is_ptr:
+                    rvalue = "&" + rvalue
+                prepare_out_args.append(arg_n + " = " + rvalue + ";")
+
+        if assign_args or prepare_out_args:
+            args_stream = output.StringStream()
+            args_stream.out(template.interface_operation_async_args,
+                            call_descriptor = self.__name,
+                            assign_args = string.join(assign_args,"\n"),
+                            prepare_out_args = \
+                            string.join(prepare_out_args,"\n"))
+            assign_args = str(args_stream)
+        else:
+            assign_args = ""
+
+        stream.out(template.interface_operation_async,
+                   call_descriptor = self.__name,
+                   call_desc_args = string.join(ctor_args, ", "),
+                   ami_name = ami_name,
+                   assign_args = assign_args)
+
+    def out_ami_get(self,stream,args):
+        # Body of the get() member of an AMI call object. <args> are the
+        # names of the out arguments, indexed like the parameters.
+        assert isinstance(stream, output.Stream)
+
+        assign_res = []
+
+        n = -1
+        for argument in self.__arguments:
+            n = n + 1
+            if not argument.is_out():
+                continue
+            arg_n = "_call_desc.arg_" + str(n)
+            argtype = types.Type(argument.paramType())
+            ((h_is_const,h_is_ptr),(s_is_holder,s_is_var)) = \
+                         _arg_info(argtype,argument.direction())
+            if not s_is_holder:
+                arg_n = arg_n + "_"
+            elif s_is_var:
+                arg_n = arg_n + "._retn()"
+            assign_res.append(args[n] + " = " + arg_n + ";")
+
+        if self.__has_return_value:
+            argtype = types.Type(self.__returntype)
+            ((h_is_const,h_is_ptr),(s_is_holder,s_is_var)) = \
+                         _arg_info(argtype,3)
+            if s_is_var:
+                assign_res.append("return _call_desc.result._retn();")
+            else:
+                assign_res.append("return _call_desc.result;")
+
+        if assign_res:
+            stream.out(template.interface_ami_get,
+                       call_descriptor = self.__name,
+                       assign_res = string.join(assign_res,"\n"))
+        else:
+            stream.out(template.interface_ami_get_void)
+
     def out_implcall(self,stream,operation,localcall_fn):
         assert isinstance(stream, output.Stream)
 
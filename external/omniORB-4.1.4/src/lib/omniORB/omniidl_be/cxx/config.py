@@ -143,6 +143,9 @@ class ConfigurationState:
             # Generate local servant shortcut code?
             'Shortcut':              0,
 
+            # Generate sendc_ members for asynchronous invocation?
+            'AMI':                   0,
+
             # Extra ifdefs for stubs in dlls?
             'DLLIncludes':           0,
 
@@ -1032,13 +1032,43 @@ def visitStruct(node):
                                cxx_id = cxx_id,
                                dims = dims_string)
             
+    # Structs with no padding in their CDR encoding say whether their
+    # C++ layout is the same, so that they can be marshalled in bulk
+    cdr_layout = ""
+    layout = types.cdrLayout(node)
+    if layout is not None:
+        (size, alignment, layout_members) = layout
+        checks = [ "sizeof(" + cxx_name + ") == " + str(size) ]
+        has_double = 0
+        for (d, memberType, offset) in layout_members:
+            cxx_id = id.mapID(d.identifier())
+            checks.append("offsetof(" + cxx_name + ", " + cxx_id + ") == " +
+                          str(offset))
+            d_memberType = memberType.deref()
+            if d_memberType.struct():
+                checks.append(d_memberType.base(environment) +
+                              "::_cdrLayout()")
+            elif d_memberType.kind() == idltype.tk_double:
+                has_double = 1
+
+        if has_double:
+            layout_template = template.struct_cdr_layout_double
+        else:
+            layout_template = template.struct_cdr_layout
+
+        layout_stream = output.StringStream()
+        layout_stream.out(layout_template,
+                          checks = string.join(checks, " &&\n"))
+        cdr_layout = str(layout_stream)
+
     # Output the structure itself
     if types.variableDecl(node):
         stream.out(template.struct,
                    name = cxx_name,
                    fix_or_var = "Variable",
                    Other_IDL = Other_IDL,
-                   members = members)
+                   members = members,
+                   cdr_layout = cdr_layout)
         stream.out(template.struct_variable_out_type,
                    name = cxx_name)
     else:
@@ -1046,7 +1076,8 @@ def visitStruct(node):
                    name = cxx_name,
                    fix_or_var = "Fix",
                    Other_IDL = Other_IDL,
-                   members = members)
+                   members = members,
+                   cdr_layout = cdr_layout)
         stream.out(template.struct_fix_out_type,
                    name = cxx_name)
 
@@ -668,6 +668,18 @@ private:
 };
 """
 
+interface_ami_call = """\
+class @ami_name@ : public omniAsyncCall {
+public:
+  @get@
+
+  inline @ami_name@(omniCallDescriptor* cd, omniAsyncCallback* h)
+    : omniAsyncCall(cd, h) {}
+};
+
+typedef omniAsyncCall_var<@ami_name@> @ami_name@_var;
+"""
+
 interface_shortcut = """\
 virtual void _enableShortcut(omniServant*, const _CORBA_Boolean*);
 _impl_@name@* _shortcut;
@@ -1082,11 +1094,31 @@ struct @name@ {
 
   void operator>>= (cdrStream &) const;
   void operator<<= (cdrStream &);
-};
+@cdr_layout@};
 
 typedef @name@::_var_type @name@_var;
 """
 
+# Added to a struct whose CDR encoding has no padding. Starts at column
+# 0 so that it leaves nothing behind when it is empty.
+struct_cdr_layout = """\
+
+  // True if the CDR encoding of this struct is its memory image.
+  static inline _CORBA_Boolean _cdrLayout() {
+    return (@checks@);
+  }"""
+
+struct_cdr_layout_double = """\
+
+  // True if the CDR encoding of this struct is its memory image.
+  static inline _CORBA_Boolean _cdrLayout() {
+#ifndef OMNI_MIXED_ENDIAN_DOUBLE
+    return (@checks@);
+#else
+    return 0;
+#endif
+  }"""
+
 struct_fix_out_type = """\
 typedef @name@& @name@_out;
 """
@@ -463,6 +463,107 @@ class I(Class):
 
 
 
+# Asynchronous invocation, generated with -Wbami. Each two-way operation
+# and attribute of a non-abstract interface gets a sendc_ member in the
+# object reference, which sends the request and returns an AMI call
+# object, derived from omniAsyncCall, whose get() member returns the
+# results. Operations with contexts, inout arguments or fixed length
+# array out arguments are left out.
+def ami_supported(callable):
+  if callable.oneway() or callable.contexts():
+    return 0
+  for p in callable.parameters():
+    if p.is_in() and p.is_out():
+      return 0
+    if p.is_out():
+      pType = types.Type(p.paramType())
+      if pType.array() and not pType.variable():
+        return 0
+  return 1
+
+
+class _ami_Call:
+  """The AMI call object of a callable, and its sendc_ member"""
+  def __init__(self, callable, method):
+    self._callable = callable
+    self._method   = method
+
+    ifc = callable.interface()
+    op  = callable.operation_name()
+    if op[0] == "_":
+      op = op[1:]   # get_ and set_ of attributes
+    self._op   = op
+    self._name = ifc.name().prefix("AMI_").suffix("_" + op)
+    self._environment = ifc.environment().enter(self._name.simple())
+
+  def name(self): return self._name
+
+  def _get_args(self):
+    use_out = not config.state["Impl Mapping"]
+    names   = self._method.arg_names()
+    args    = []
+    n = -1
+    for p in self._callable.parameters():
+      n = n + 1
+      if p.is_out():
+        pType = types.Type(p.paramType())
+        args.append(pType.op(types.OUT, self._environment,
+                             use_out = use_out) + " " + names[n])
+    return string.join(args, ", ")
+
+  def _sendc_args(self):
+    arg_types = self._method.arg_types()
+    names     = self._method.arg_names()
+    args      = [ "omniAsyncCallback* ami_handler" ]
+    n = -1
+    for p in self._callable.parameters():
+      n = n + 1
+      if p.is_in():
+        args.append(arg_types[n] + " " + names[n])
+    return string.join(args, ", ")
+
+  def hh(self, stream):
+    rType = types.Type(self._callable.returnType())
+    get   = rType.op(types.RET, self._environment) + \
+            " get(" + self._get_args() + ");"
+    stream.out(omniidl_be.cxx.header.template.interface_ami_call,
+               ami_name = self._name.simple(),
+               get = get)
+
+  def hh_sendc(self):
+    return self._name.simple() + "* sendc_" + self._op + \
+           "(" + self._sendc_args() + ");"
+
+  def cc(self, stream, objref_name, call_descriptor, localcall_fn,
+         environment):
+    rType = types.Type(self._callable.returnType())
+    names = self._method.arg_names()
+
+    body = output.StringStream()
+    call_descriptor.out_ami_get(body, names)
+    stream.out("""\
+@proto@
+{
+  @body@
+}""", proto = rType.op(types.RET) + " " + self._name.fullyQualify() + \
+                   "::get(" + self._get_args() + ")",
+               body = str(body))
+
+    body = output.StringStream()
+    call_descriptor.out_objrefcall_async(body,
+                                         self._callable.operation_name(),
+                                         names, localcall_fn,
+                                         self._name.simple(), environment)
+    stream.out("""\
+@proto@
+{
+  @body@
+}""", proto = self._name.fullyQualify() + "* " + \
+                   objref_name.fullyQualify() + "::sendc_" + self._op + \
+                   "(" + self._sendc_args() + ")",
+               body = str(body))
+
+
 class _objref_I(Class):
   def __init__(self, I):
     Class.__init__(self, I)
@@ -480,6 +581,13 @@ class _objref_I(Class):
       self._methods.append(method)
       self._callables[method] = callable
 
+    self._ami = {}
+    if config.state['AMI'] and not self.interface().abstract():
+      for method in self._methods:
+        callable = self._callables[method]
+        if ami_supported(callable):
+          self._ami[method] = _ami_Call(callable, method)
+
 
   def hh(self, stream):
     # build the inheritance list
@@ -511,6 +619,11 @@ class _objref_I(Class):
       else:
         methods.append(method.hh())
 
+      if self._ami.has_key(method):
+        ami_call = self._ami[method]
+        ami_call.hh(stream)
+        methods.append(ami_call.hh_sendc())
+
     if config.state['Shortcut']:
       shortcut = output.StringStream()
       shortcut.out(omniidl_be.cxx.header.template.interface_shortcut,
@@ -705,6 +818,10 @@ class _objref_I(Class):
                                      intf_env)
       method.cc(stream, body)
 
+      if self._ami.has_key(method):
+        self._ami[method].cc(stream, self.name(), call_descriptor,
+                             localcall_fn, intf_env)
+
 
 class _nil_I(Class):
   def __init__(self, I):
@@ -504,10 +504,20 @@ def visitStruct(node):
                                   memberType, d, member_name, "_n")
         return
 
-    stream.out(template.struct,
-               name = scopedName.fullyQualify(),
-               marshall_code = marshal,
-               unmarshall_code = unmarshal)
+    layout = types.cdrLayout(node)
+    if layout is not None:
+        (size, alignment) = layout[:2]
+        stream.out(template.struct_cdr_layout,
+                   name = scopedName.fullyQualify(),
+                   size = str(size),
+                   align = "omni::ALIGN_" + str(alignment),
+                   marshall_code = marshal,
+                   unmarshall_code = unmarshal)
+    else:
+        stream.out(template.struct,
+                   name = scopedName.fullyQualify(),
+                   marshall_code = marshal,
+                   unmarshall_code = unmarshal)
 
     stream.reset_indent()
     
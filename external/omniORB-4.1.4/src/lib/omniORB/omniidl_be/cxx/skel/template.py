@@ -684,6 +684,30 @@ _invoke(_call_desc);
 @assign_res@
 """
 
+interface_operation_async = """\
+@ami_name@* _ami_call =
+  new @ami_name@(new @call_descriptor@(@call_desc_args@), ami_handler);
+@assign_args@
+_invokeAsync(_ami_call);
+return _ami_call;
+"""
+
+interface_operation_async_args = """\
+@call_descriptor@& _call_desc =
+  *(@call_descriptor@*)_ami_call->_callDescriptor();
+@assign_args@
+@prepare_out_args@\
+"""
+
+interface_ami_get = """\
+@call_descriptor@& _call_desc = *(@call_descriptor@*)_retrieve();
+@assign_res@
+"""
+
+interface_ami_get_void = """\
+_retrieve();
+"""
+
 interface_operation_shortcut = """\
 @impl_type@* _s = _shortcut;
 if (_s) {
@@ -860,6 +884,28 @@ void
 }
 """
 
+struct_cdr_layout = """\
+void
+@name@::operator>>= (cdrStream &_n) const
+{
+  if (_cdrLayout() && !_n.marshal_byte_swap()) {
+    _n.put_octet_array((const _CORBA_Octet*)this,@size@,@align@);
+    return;
+  }
+  @marshall_code@
+}
+
+void
+@name@::operator<<= (cdrStream &_n)
+{
+  if (_cdrLayout() && !_n.unmarshal_byte_swap()) {
+    _n.get_octet_array((_CORBA_Octet*)this,@size@,@align@);
+    return;
+  }
+  @unmarshall_code@
+}
+"""
+
 ##
 ## Unions
 ##
@@ -645,6 +645,9 @@ class Type:
             template["forward"] = 1
         elif typeSizeAlignMap.has_key(d_SeqType.type().kind()):
             template["fixed"] = typeSizeAlignMap[d_SeqType.type().kind()]
+        elif d_SeqType.struct() and not is_array and \
+             cdrLayout(d_SeqType.type().decl()) is not None:
+            template["layout"] = cdrLayout(d_SeqType.type().decl())[:2]
         elif d_SeqType.interface():
             scopedName = d_SeqType.type().decl().scopedName()
             is_CORBA_Object = scopedName == ["CORBA", "Object"]
@@ -710,6 +713,9 @@ class Type:
         if template.has_key("fixed"):
             name = name + "_w_FixSizeElement"
 
+        elif template.has_key("layout"):
+            name = name + "_w_FixLayoutElement"
+
         # ------------------------------------
         # build the argument list
         args = []
@@ -758,6 +764,10 @@ class Type:
             (element_size, alignment) = template["fixed"]
             args.extend([str(element_size), str(alignment)])
 
+        elif template.has_key("layout"):
+            (element_size, alignment) = template["layout"]
+            args.extend([str(element_size), str(alignment)])
+
         # -----------------------------------
         # build the template instance
         if args:
@@ -1129,3 +1139,63 @@ typeSizeAlignMap = {
     idltype.tk_longlong:  (8, 8),
     idltype.tk_ulonglong: (8, 8)
     }
+
+# Basic types whose CDR encoding is their memory image, if the byte
+# order matches. Booleans, chars and enums are left out since they must
+# be checked or converted when they are unmarshalled.
+layoutSizeAlignMap = {
+    idltype.tk_octet:     (1, 1),
+    idltype.tk_short:     (2, 2),
+    idltype.tk_ushort:    (2, 2),
+    idltype.tk_long:      (4, 4),
+    idltype.tk_ulong:     (4, 4),
+    idltype.tk_float:     (4, 4),
+    idltype.tk_double:    (8, 8),
+    idltype.tk_longlong:  (8, 8),
+    idltype.tk_ulonglong: (8, 8)
+    }
+
+def cdrLayout(decl):
+    """types.cdrLayout(idlast.Decl): (int, int, list) or None
+       If the declaration is a struct whose CDR encoding has no padding,
+       returns its (size, alignment, members), where members is a list
+       of (declarator, types.Type, offset). Such a struct can be
+       marshalled as a block of octets where its C++ layout matches."""
+    if not isinstance(decl, idlast.Struct):
+        return None
+
+    size = 0
+    alignment = 0
+    members = []
+    for m in decl.members():
+        memberType = Type(m.memberType())
+        d_memberType = memberType.deref()
+
+        if layoutSizeAlignMap.has_key(d_memberType.kind()):
+            (elmSize, elmAlignment) = layoutSizeAlignMap[d_memberType.kind()]
+        elif d_memberType.struct():
+            layout = cdrLayout(d_memberType.type().decl())
+            if layout is None:
+                return None
+            (elmSize, elmAlignment) = layout[:2]
+        else:
+            return None
+
+        for d in m.declarators():
+            dims = d.sizes() + memberType.dims()
+            n_elements = reduce(lambda x,y:x*y, dims, 1)
+
+            # The first member must have the largest alignment, so that
+            # the struct starts at the same place whatever precedes it.
+            if alignment == 0:
+                alignment = elmAlignment
+            elif elmAlignment > alignment or size % elmAlignment != 0:
+                return None
+
+            members.append((d, memberType, size))
+            size = size + elmSize * n_elements
+
+    if alignment == 0 or size % alignment != 0:
+        return None
+
+    return (size, alignment, members)
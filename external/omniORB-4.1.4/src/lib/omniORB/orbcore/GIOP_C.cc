@@ -113,7 +113,13 @@ GIOP_C::GIOP_C(giopRope* r,giopStrand* s) : giopStream(s),
 					    pd_ior(0),
 					    pd_rope(r),
 					    pd_replyStatus(GIOP::NO_EXCEPTION),
-					    pd_locateStatus(GIOP::OBJECT_HERE)
+					    pd_locateStatus(GIOP::OBJECT_HERE),
+					    pd_nextCall(0),
+					    pd_replyCond(s->mutex),
+					    pd_nextWaiter(0),
+					    pd_prevWaiter(0),
+					    pd_replyWaiting(0),
+					    pd_nextAsync(0)
 {
 }
 
@@ -150,6 +156,7 @@ GIOP_C::initialise(const omniIOR* i,
   key(k);
   keysize(ksz);
   requestId(pd_strand->newSeqNumber());
+  pd_strand->addCall(this);
   TCS_C(0);
   TCS_W(0);
 }
@@ -163,6 +170,35 @@ GIOP_C::cleanup() {
   calldescriptor(0);
 }
 
+////////////////////////////////////////////////////////////////////////
+namespace {
+  // Keeps a GIOP_C queued on its strand for as long as it is blocked,
+  // including when the wait ends with a timeout exception.
+  class replyWaiterSentry {
+  public:
+    replyWaiterSentry(giopStrand* s, GIOP_C* g) : pd_s(s), pd_g(g) {
+      pd_s->addReplyWaiter(pd_g);
+    }
+    ~replyWaiterSentry() {
+      pd_s->removeReplyWaiter(pd_g);
+    }
+  private:
+    giopStrand* pd_s;
+    GIOP_C*     pd_g;
+  };
+}
+
+void
+GIOP_C::sleepOnRdLock() {
+
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_strand->mutex,1);
+
+  if (pd_strand->rd_nwaiting < 0) {
+    replyWaiterSentry sentry(pd_strand,this);
+    giopStream::sleepOnRdLock(pd_replyCond);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////
 void
 GIOP_C::InitialiseRequest() {
@@ -172,9 +208,16 @@ GIOP_C::InitialiseRequest() {
   OMNIORB_ASSERT(pd_ior);
 
   pd_state = IOP_C::RequestInProgress;
+
+  if (calldescriptor()->is_oneway() && pd_strand->isClient()) {
+    omniObjRef* o = calldescriptor()->objref();
+    int c = o ? o->_onewayCoalescing() : -1;
+    coalesce(c < 0 ? orbParameters::onewayCoalesce : (CORBA::Boolean)c);
+  }
   impl()->outputMessageBegin(this,impl()->marshalRequestHeader);
   calldescriptor()->marshalArguments(*this);
   impl()->outputMessageEnd(this);
+  coalesce(0);
   clearValueTracker();
   pd_state = IOP_C::WaitingForReply;
   pd_strand->first_call = 0;
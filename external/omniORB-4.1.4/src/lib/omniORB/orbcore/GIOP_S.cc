@@ -207,6 +207,7 @@ GIOP_S::GIOP_S(giopStrand* g) : giopStream(g),
 				pd_state(UnUsed),
 				pd_worker(0),
 				pd_calldescriptor(0),
+				pd_targetRepoId(0),
 				pd_requestType(GIOP::MessageError),
 				pd_operation((char*)pd_op_buffer),
 				pd_principal(pd_pr_buffer),
@@ -221,6 +222,7 @@ GIOP_S::GIOP_S(const GIOP_S& src) : giopStream(src.pd_strand),
 				    pd_state(UnUsed),
 				    pd_worker(0),
 				    pd_calldescriptor(0),
+				    pd_targetRepoId(0),
 				    pd_requestType(GIOP::MessageError),
 				    pd_operation((char*)pd_op_buffer),
 				    pd_principal(pd_pr_buffer),
@@ -263,7 +265,7 @@ GIOP_S::dispatcher() {
     impl()->inputMessageBegin(this,impl()->unmarshalWildCardRequestHeader);
 
     {
-      omni_tracedmutex_lock sync(*omniTransportLock);
+      omni_tracedmutex_lock sync(*pd_strand->mutex);
       pd_state = RequestHeaderIsBeingProcessed;
       if (!pd_strand->stopIdleCounter()) {
 	// This strand has been expired by the scavenger. Don't
@@ -341,6 +343,9 @@ GIOP_S::handleRequest() {
 
   try {
 
+    pd_targetRepoId = 0;
+    pd_startTime = 0;
+
     impl()->unmarshalRequestHeader(this);
 
     pd_state = RequestIsBeingProcessed;
@@ -360,17 +365,19 @@ GIOP_S::handleRequest() {
 
     CORBA::ULong hash = omni::hash(key(), keysize());
 
-    omni::internalLock->lock();
+    // Requests to active objects are normally dispatched without
+    // taking omni::internalLock.
+    if (omniObjTable::fastDispatch(key(), keysize(), hash, call_handle))
+      return 1;
+
     omniLocalIdentity* id;
-    id = omniObjTable::locateActive(key(), keysize(), hash, 1);
+    id = omniObjTable::lockActive(key(), keysize(), hash);
 
     if( id ) {
       id->dispatch(call_handle);
       return 1;
     }
 
-    omni::internalLock->unlock();
-
     // Can we create a suitable object on demand?
 
     omniObjAdapter_var adapter(omniObjAdapter::getAdapter(key(),keysize()));
@@ -557,10 +564,8 @@ GIOP_S::handleLocateRequest() {
 
     if (keysize() > 0) {
       CORBA::ULong hash = omni::hash(key(), keysize());
-      omni_tracedmutex_lock sync(*omni::internalLock);
-      omniLocalIdentity* id;
-      id = omniObjTable::locateActive(key(), keysize(), hash, 1);
-      if( id )  status = GIOP::OBJECT_HERE;
+      if (omniObjTable::isActive(key(), keysize(), hash))
+	status = GIOP::OBJECT_HERE;
      }
     if ( status == GIOP::UNKNOWN_OBJECT && keysize() > 0 ) {
       // We attempt to find the object adapter (activate it if necassary)
@@ -653,6 +658,12 @@ GIOP_S::ReceiveRequest(omniCallDescriptor& desc) {
   pd_n_user_excns = desc.n_user_excns();
   pd_user_excns = desc.user_excns();
 
+  // Likewise the interface of the target, for the call metrics. The
+  // bootstrap agent is dispatched with a dummy local identity.
+  omniLocalIdentity* id = desc.localId();
+  if (id && id != (omniLocalIdentity*)1)
+    pd_targetRepoId = id->servant()->_mostDerivedRepoId();
+
   cdrStream& s = *this;
   desc.unmarshalArguments(s);
   pd_state = WaitingForReply;
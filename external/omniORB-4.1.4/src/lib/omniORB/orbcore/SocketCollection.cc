@@ -166,7 +166,9 @@
 
 #include <omniORB4/CORBA.h>
 #include <omniORB4/giopEndpoint.h>
+#include <orbParameters.h>
 #include <SocketCollection.h>
+#include <metrics.h>
 
 #if defined(__vxWorks__)
 #  include "pipeDrv.h"
@@ -190,6 +192,11 @@
 #  define INITIAL_POLLFD_LEN 64
 #endif
 
+#ifdef USE_EPOLL
+#  define EPOLL_EVENTS_LEN 256
+#  define EPOLL_PIPE_KEY   (~(CORBA::ULongLong)0)
+#endif
+
 
 OMNI_NAMESPACE_BEGIN(omni)
 
@@ -385,6 +392,50 @@ SocketCollection::SocketCollection()
   pd_pollsockets = new SocketHolder*[pd_pollfd_len];
 
   initPipe(pd_pipe_read, pd_pipe_write);
+
+#if defined(USE_EPOLL)
+  pd_epoll_fd          = -1;
+  pd_epoll_events      = 0;
+  pd_epoll_entries     = 0;
+  pd_epoll_entries_len = 0;
+  pd_epoll_gen         = 0;
+  pd_epoll_pending     = 0;
+  pd_epoll_pending_n   = 0;
+  pd_epoll_pending_len = 0;
+
+  if (orbParameters::connectionWatchEpoll) {
+    pd_epoll_fd = epoll_create(INITIAL_POLLFD_LEN);
+
+    if (pd_epoll_fd < 0) {
+      if (omniORB::trace(2)) {
+	omniORB::logger l;
+	l << "Unable to create epoll instance (errno = " << (int)ERRNO
+	  << "). Using poll() instead.\n";
+      }
+    }
+    else {
+      SocketSetCloseOnExec(pd_epoll_fd);
+
+      pd_epoll_events      = new struct epoll_event[EPOLL_EVENTS_LEN];
+      pd_epoll_entries_len = INITIAL_POLLFD_LEN;
+      pd_epoll_entries     = new EpollEntry[pd_epoll_entries_len];
+      pd_epoll_pending_len = INITIAL_POLLFD_LEN;
+      pd_epoll_pending     = new EpollKey[pd_epoll_pending_len];
+
+      for (unsigned i=0; i < pd_epoll_entries_len; i++) {
+	pd_epoll_entries[i].sock = 0;
+	pd_epoll_entries[i].gen  = 0;
+      }
+      if (pd_pipe_read >= 0) {
+	struct epoll_event ev;
+	ev.events   = EPOLLIN;
+	ev.data.u64 = EPOLL_PIPE_KEY;
+	epoll_ctl(pd_epoll_fd, EPOLL_CTL_ADD, pd_pipe_read, &ev);
+      }
+      omniORB::logs(25, "SocketCollection using epoll.");
+    }
+  }
+#endif
 }
 
 SocketCollection::~SocketCollection()
@@ -393,6 +444,15 @@ SocketCollection::~SocketCollection()
   delete [] pd_pollsockets;
   delete [] pd_pollfds;
   closePipe(pd_pipe_read, pd_pipe_write);
+
+#if defined(USE_EPOLL)
+  if (pd_epoll_fd >= 0) {
+    close(pd_epoll_fd);
+    delete [] pd_epoll_events;
+    delete [] pd_epoll_entries;
+    delete [] pd_epoll_pending;
+  }
+#endif
 }
 
 CORBA::Boolean
@@ -427,6 +487,11 @@ SocketCollection::growPollLists()
 CORBA::Boolean
 SocketCollection::Select() {
 
+#if defined(USE_EPOLL)
+  if (pd_epoll_fd >= 0)
+    return epollSelect();
+#endif
+
   struct timeval timeout;
   int timeout_millis;
   int count;
@@ -639,6 +704,37 @@ SocketHolder::setSelectable(int            now,
   if (now == 2 && !pd_selectable)
     return;
 
+#if defined(USE_EPOLL)
+  if (pd_belong_to->pd_epoll_fd >= 0) {
+    // With epoll, arming the socket takes effect immediately, even
+    // if the Select thread is blocked, so there is no need to defer
+    // it to the next scan or to wake the Select thread.
+    pd_selectable = 1;
+
+    if (data_in_buffer && !pd_data_in_buffer) {
+      pd_data_in_buffer = 1;
+      pd_belong_to->epollPending(this);
+
+      if (!hold_lock) {
+	// Wake up the Select thread so it dispatches the socket.
+	if (pd_belong_to->pd_pipe_write >= 0 && !pd_belong_to->pd_pipe_full) {
+	  char data = '\0';
+	  pd_belong_to->pd_pipe_full = 1;
+	  write(pd_belong_to->pd_pipe_write, &data, 1);
+	}
+      }
+    }
+    else if (!pd_data_in_buffer) {
+      pd_belong_to->epollArm(this);
+    }
+
+    // Wake up a thread waiting to peek, if there is one
+    if (pd_peek_cond)
+      pd_peek_cond->signal();
+    return;
+  }
+#endif
+
   if (now && pd_fd_index == -1) {
     // Add socket to the list of pollfds
     unsigned index = pd_belong_to->pd_pollfd_n;
@@ -693,6 +789,16 @@ SocketHolder::clearSelectable()
   omni_tracedmutex_lock l(pd_belong_to->pd_collection_lock);
   pd_selectable = 0;
 
+#if defined(USE_EPOLL)
+  if (pd_belong_to->pd_epoll_fd >= 0) {
+    // The socket is left armed. If it becomes readable before it is
+    // next made selectable, the Select thread sees that it is not
+    // selectable and ignores it, and EPOLLONESHOT disarms it. That
+    // saves a system call on every request.
+    return;
+  }
+#endif
+
   if (pd_fd_index >= 0) {
     pd_belong_to->pd_pollsockets[pd_fd_index] = 0;
     pd_fd_index = -1;
@@ -808,6 +914,19 @@ SocketHolder::Peek()
       }
 
       if (retval != -1) {
+#if defined(USE_EPOLL)
+        if (pd_belong_to->pd_epoll_fd >= 0) {
+          if (retval) {
+            pd_selectable = 0;
+          }
+          else if (pd_selectable) {
+            // The Select thread may have consumed the one-shot event
+            // while we were peeking. Make sure it is watching again.
+            pd_belong_to->epollArm(this);
+          }
+        }
+        else
+#endif
         if (retval) {
           pd_selectable = 0;
           if (pd_fd_index >= 0) {
@@ -825,6 +944,229 @@ SocketHolder::Peek()
   return (CORBA::Boolean)retval;
 }
 
+#if defined(USE_EPOLL)
+
+/////////////////////////////////////////////////////////////////////////
+// epoll() based implementation, used in place of poll() when
+// connectionWatchEpoll is set.
+
+static inline CORBA::ULongLong
+epollKey(SocketHandle_t fd, CORBA::ULong gen)
+{
+  return ((CORBA::ULongLong)gen << 32) | (CORBA::ULong)fd;
+}
+
+void
+SocketCollection::epollAdd(SocketHolder* s)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(pd_collection_lock, 1);
+
+  if (s->pd_socket < 0)
+    return;
+
+  unsigned fd = s->pd_socket;
+
+  if (fd >= pd_epoll_entries_len) {
+    unsigned new_len = pd_epoll_entries_len * 2;
+    while (fd >= new_len)
+      new_len *= 2;
+
+    EpollEntry* new_entries = new EpollEntry[new_len];
+    unsigned i;
+    for (i=0; i < pd_epoll_entries_len; i++)
+      new_entries[i] = pd_epoll_entries[i];
+
+    for (; i < new_len; i++) {
+      new_entries[i].sock = 0;
+      new_entries[i].gen  = 0;
+    }
+    delete [] pd_epoll_entries;
+    pd_epoll_entries     = new_entries;
+    pd_epoll_entries_len = new_len;
+  }
+  pd_epoll_entries[fd].sock = s;
+  pd_epoll_entries[fd].gen  = ++pd_epoll_gen;
+  s->pd_fd_index = -1;
+}
+
+void
+SocketCollection::epollRemove(SocketHolder* s)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(pd_collection_lock, 1);
+
+  if (s->pd_socket < 0)
+    return;
+
+  unsigned fd = s->pd_socket;
+
+  if (fd < pd_epoll_entries_len && pd_epoll_entries[fd].sock == s)
+    pd_epoll_entries[fd].sock = 0;
+
+  if (s->pd_fd_index >= 0) {
+    struct epoll_event ev; // Ignored, but must be non-null on old kernels
+    epoll_ctl(pd_epoll_fd, EPOLL_CTL_DEL, s->pd_socket, &ev);
+    s->pd_fd_index = -1;
+  }
+}
+
+void
+SocketCollection::epollArm(SocketHolder* s)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(pd_collection_lock, 1);
+
+  if (s->pd_fd_index == 1)
+    return;
+
+  unsigned fd = s->pd_socket;
+  if (fd >= pd_epoll_entries_len || pd_epoll_entries[fd].sock != s)
+    return;
+
+  struct epoll_event ev;
+  ev.events   = EPOLLIN | EPOLLONESHOT;
+  ev.data.u64 = epollKey(s->pd_socket, pd_epoll_entries[fd].gen);
+
+  int op = s->pd_fd_index == -1 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+
+  if (epoll_ctl(pd_epoll_fd, op, s->pd_socket, &ev) == 0) {
+    s->pd_fd_index = 1;
+  }
+  else {
+    if (omniORB::trace(20)) {
+      omniORB::logger l;
+      l << "epoll_ctl() failed for socket " << (int)s->pd_socket
+	<< ". errno = " << (int)ERRNO << "\n";
+    }
+  }
+}
+
+void
+SocketCollection::epollPending(SocketHolder* s)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(pd_collection_lock, 1);
+
+  unsigned fd = s->pd_socket;
+  if (fd >= pd_epoll_entries_len || pd_epoll_entries[fd].sock != s)
+    return;
+
+  if (pd_epoll_pending_n == pd_epoll_pending_len) {
+    EpollKey* new_pending = new EpollKey[pd_epoll_pending_len * 2];
+    for (unsigned i=0; i < pd_epoll_pending_n; i++)
+      new_pending[i] = pd_epoll_pending[i];
+
+    delete [] pd_epoll_pending;
+    pd_epoll_pending      = new_pending;
+    pd_epoll_pending_len *= 2;
+  }
+  pd_epoll_pending[pd_epoll_pending_n].fd  = s->pd_socket;
+  pd_epoll_pending[pd_epoll_pending_n].gen = pd_epoll_entries[fd].gen;
+  pd_epoll_pending_n++;
+}
+
+void
+SocketCollection::epollDispatchPending()
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(pd_collection_lock, 1);
+
+  // notifyReadable() may queue more sockets, so we must re-check
+  // pd_epoll_pending_n each time round.
+  for (unsigned i=0; i < pd_epoll_pending_n; i++) {
+    unsigned      fd  = pd_epoll_pending[i].fd;
+    CORBA::ULong  gen = pd_epoll_pending[i].gen;
+
+    if (fd >= pd_epoll_entries_len || pd_epoll_entries[fd].gen != gen)
+      continue;
+
+    SocketHolder* s = pd_epoll_entries[fd].sock;
+
+    // The data may have been consumed by Peek() in the meantime.
+    if (s && s->pd_selectable && s->pd_data_in_buffer && !s->pd_peeking) {
+      s->pd_selectable = s->pd_data_in_buffer = 0;
+      notifyReadable(s);
+    }
+  }
+  pd_epoll_pending_n = 0;
+}
+
+CORBA::Boolean
+SocketCollection::epollSelect() {
+
+  int timeout_millis;
+  {
+    omni_tracedmutex_lock sync(pd_collection_lock);
+
+    if (pd_epoll_pending_n)
+      epollDispatchPending();
+
+    if (pd_idle_count > 0 || pd_pipe_read < 0) {
+      timeout_millis = (scan_interval_sec * 1000 +
+			scan_interval_nsec / 1000000);
+    }
+    else {
+      omniORB::logs(25, "SocketCollection idle. Sleeping.");
+      timeout_millis = -1;
+    }
+  }
+
+  int count = epoll_wait(pd_epoll_fd, pd_epoll_events, EPOLL_EVENTS_LEN,
+			 timeout_millis);
+
+  if (count > 0) {
+    omni_tracedmutex_lock sync(pd_collection_lock);
+
+    pd_idle_count = idle_scans;
+
+    for (int i=0; i < count; i++) {
+      CORBA::ULongLong key = pd_epoll_events[i].data.u64;
+
+      if (key == EPOLL_PIPE_KEY) {
+	char data;
+	read(pd_pipe_read, &data, 1);
+	pd_pipe_full = 0;
+	continue;
+      }
+
+      unsigned     fd  = (CORBA::ULong)(key & 0xffffffff);
+      CORBA::ULong gen = (CORBA::ULong)(key >> 32);
+
+      if (fd >= pd_epoll_entries_len || pd_epoll_entries[fd].gen != gen)
+	continue; // Socket removed since epoll_wait() returned
+
+      SocketHolder* s = pd_epoll_entries[fd].sock;
+      if (!s)
+	continue;
+
+      // EPOLLONESHOT has disarmed the socket. Errors and hang-ups are
+      // treated as readable, so the reading thread sees them.
+      s->pd_fd_index = 0;
+
+      if (s->pd_peeking) {
+	// See the comment in the poll() implementation above.
+	s->pd_peek_go = 1;
+      }
+      else if (s->pd_selectable) {
+	s->pd_selectable = s->pd_data_in_buffer = 0;
+	notifyReadable(s);
+      }
+    }
+  }
+  else if (count == 0) {
+    // Nothing to read.
+    omni_tracedmutex_lock sync(pd_collection_lock);
+    if (pd_idle_count > 0)
+      pd_idle_count--;
+  }
+  else if (ERRNO != RC_EINTR) {
+    if (omniORB::trace(20)) {
+      omniORB::logger l;
+      l << "Error return from epoll_wait(). errno = " << (int)ERRNO << "\n";
+    }
+    return 0;
+  }
+  return 1;
+}
+
+#endif // USE_EPOLL
+
 #elif defined(__WIN32__)
 
 /////////////////////////////////////////////////////////////////////////
@@ -1585,6 +1927,53 @@ SocketHolder::~SocketHolder()
 }
 
 
+/////////////////////////////////////////////////////////////////////////
+int
+SocketHolder::waitWritable(unsigned long deadline_secs,
+			   unsigned long deadline_nanosecs)
+{
+  if (!(deadline_secs || deadline_nanosecs))
+    return 1;
+
+  int tx;
+
+  do {
+    struct timeval t;
+
+    SocketSetTimeOut(deadline_secs,deadline_nanosecs,t);
+    if (t.tv_sec == 0 && t.tv_usec == 0) {
+      // Already timeout.
+      return 0;
+    }
+#if defined(USE_POLL)
+    struct pollfd fds;
+    fds.fd = pd_socket;
+    fds.events = POLLOUT;
+    tx = poll(&fds,1,t.tv_sec*1000+(t.tv_usec/1000));
+#else
+    fd_set fds, efds;
+    FD_ZERO(&fds);
+    FD_ZERO(&efds);
+    FD_SET(pd_socket,&fds);
+    FD_SET(pd_socket,&efds);
+    tx = select(pd_socket+1,0,&fds,&efds,&t);
+#endif
+    if (tx == 0) {
+      // Time out!
+      return 0;
+    }
+    else if (tx == RC_SOCKET_ERROR) {
+      if (ERRNO == RC_EINTR)
+	continue;
+      else
+	return -1;
+    }
+    return 1;
+
+  } while(1);
+}
+
+
 /////////////////////////////////////////////////////////////////////////
 void
 SocketCollection::incrRefCount()
@@ -1617,6 +2006,7 @@ SocketCollection::addSocket(SocketHolder* s)
   pd_refcount++;
 
   s->pd_belong_to = this;
+  omniMetricsP::incr(omniMetricsP::watchedSockets);
 
   if (pd_collection)
     pd_collection->pd_prev = &s->pd_next;
@@ -1624,6 +2014,11 @@ SocketCollection::addSocket(SocketHolder* s)
   s->pd_next = pd_collection;
   s->pd_prev = &pd_collection;
   pd_collection = s;
+
+#if defined(USE_EPOLL)
+  if (pd_epoll_fd >= 0)
+    epollAdd(s);
+#endif
 }
 
 /////////////////////////////////////////////////////////////////////////
@@ -1644,7 +2039,13 @@ SocketCollection::removeSocket(SocketHolder* s)
     if (s->pd_next)
       s->pd_next->pd_prev = s->pd_prev;
 
+#if defined(USE_EPOLL)
+    if (pd_epoll_fd >= 0)
+      epollRemove(s);
+#endif
+
     s->pd_belong_to = 0;
+    omniMetricsP::decr(omniMetricsP::watchedSockets);
   }
   if (refcount == 0) delete this;
 }
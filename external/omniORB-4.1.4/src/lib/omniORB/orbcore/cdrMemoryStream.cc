@@ -89,6 +89,7 @@
 
 #include <omniORB4/CORBA.h>
 #include <orbParameters.h>
+#include <omniBufferPool.h>
 
 OMNI_USING_NAMESPACE(omni)
 
@@ -122,7 +123,7 @@ cdrMemoryStream::cdrMemoryStream(CORBA::ULong initialBufsize,
 cdrMemoryStream::~cdrMemoryStream()
 {
   if (!pd_readonly_and_external_buffer && pd_bufp != pd_inline_buffer)
-    delete [] (char*)pd_bufp;
+    omniBufferPool::release(pd_bufp);
 }
 
 void*
@@ -239,7 +240,7 @@ cdrMemoryStream::reserveOutputSpace(omni::alignment_t align,size_t required)
   void* oldbufp   = pd_bufp;
   void* oldbufp_8 = pd_bufp_8;
 
-  pd_bufp   = new char[newsize];
+  pd_bufp   = omniBufferPool::allocate(newsize);
   pd_bufp_8 = ensure_align_8(pd_bufp);
 
   if (pd_clear_memory) memset(pd_bufp,0,newsize);
@@ -259,7 +260,7 @@ cdrMemoryStream::reserveOutputSpace(omni::alignment_t align,size_t required)
 			 (omni::ptr_arith_t)oldbufp_8));
 
   if (oldbufp != pd_inline_buffer)
-    delete [] (char*) oldbufp;
+    omniBufferPool::release(oldbufp);
   return 1;
 }
 
@@ -433,7 +434,7 @@ cdrMemoryStream::operator=(const cdrMemoryStream& s)
     if (!pd_readonly_and_external_buffer) {
       pd_readonly_and_external_buffer = 1;
       if (pd_bufp != pd_inline_buffer) {
-	delete [] (char*)pd_bufp;
+	omniBufferPool::release(pd_bufp);
       }
     }
     pd_bufp     = s.pd_bufp;
@@ -535,14 +536,10 @@ cdrEncapsulationStream::getOctetStream(CORBA::Octet*& databuffer,
   
   max = ((omni::ptr_arith_t) pd_outb_end - (omni::ptr_arith_t) begin);
   len = ((omni::ptr_arith_t) pd_outb_mkr - (omni::ptr_arith_t) begin);
-  if (begin == pd_bufp && pd_bufp != pd_inline_buffer) {
-    databuffer = (CORBA::Octet*) pd_bufp;
-    pd_readonly_and_external_buffer = 1;
-  }
-  else {
-    databuffer = new CORBA::Octet[max];
-    memcpy((void*)databuffer,(void*)begin,len);
-  }
+  // The buffer comes from omniBufferPool, so it cannot be handed
+  // over to a caller that frees it with delete []. Always copy.
+  databuffer = new CORBA::Octet[max];
+  memcpy((void*)databuffer,(void*)begin,len);
 }
 
 
@@ -0,0 +1,321 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// cdrSwapKernels.cc
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//    Byte swapping of arrays unmarshalled from a stream in the other
+//    byte order.
+//
+//    On x86 with gcc or clang, SSE2 is used, and AVX2 if the processor
+//    supports it. Other platforms swap one item at a time.
+
+#include <omniORB4/CORBA.h>
+
+#if defined(__GNUC__) && defined(__SSE2__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#  define SWAP_KERNELS_SSE2 1
+#  include <emmintrin.h>
+#  if defined(__clang__) || \
+      (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#    define SWAP_KERNELS_AVX2 1
+#    include <immintrin.h>
+#  endif
+#endif
+
+
+//
+// One item at a time
+//
+
+static inline _CORBA_ULong
+swap32(_CORBA_ULong v)
+{
+#if defined(__GNUC__)
+  return __builtin_bswap32(v);
+#else
+  return (((v & 0xff000000) >> 24) | ((v & 0x00ff0000) >> 8) |
+	  ((v & 0x0000ff00) << 8)  | ((v & 0x000000ff) << 24));
+#endif
+}
+
+static inline void
+swapTail16(_CORBA_Octet* p, _CORBA_ULong i, _CORBA_ULong n)
+{
+  for (; i < n; i++) {
+    _CORBA_Octet t = p[i * 2];
+    p[i * 2]     = p[i * 2 + 1];
+    p[i * 2 + 1] = t;
+  }
+}
+
+static inline void
+swapTail32(_CORBA_Octet* p, _CORBA_ULong i, _CORBA_ULong n)
+{
+  for (; i < n; i++) {
+    _CORBA_ULong v;
+    memcpy(&v, p + i * 4, 4);
+    v = swap32(v);
+    memcpy(p + i * 4, &v, 4);
+  }
+}
+
+static inline void
+swapTail64(_CORBA_Octet* p, _CORBA_ULong i, _CORBA_ULong n)
+{
+  for (; i < n; i++) {
+    _CORBA_ULong v[2];
+    memcpy(v, p + i * 8, 8);
+    _CORBA_ULong t = swap32(v[0]);
+    v[0] = swap32(v[1]);
+    v[1] = t;
+    memcpy(p + i * 8, v, 8);
+  }
+}
+
+
+#ifdef SWAP_KERNELS_SSE2
+
+//
+// SSE2 has no byte shuffle, so bytes are swapped within 16-bit words,
+// after the words have been reversed within each item.
+//
+
+static inline __m128i
+swapBytesSSE2(__m128i v)
+{
+  return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+static inline void
+swapSSE2_16(_CORBA_Octet* p, _CORBA_ULong i, _CORBA_ULong n)
+{
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(p + i * 2));
+    _mm_storeu_si128((__m128i*)(p + i * 2), swapBytesSSE2(v));
+  }
+  swapTail16(p, i, n);
+}
+
+static inline void
+swapSSE2_32(_CORBA_Octet* p, _CORBA_ULong i, _CORBA_ULong n)
+{
+  for (; i + 4 <= n; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(p + i * 4));
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2,3,0,1));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2,3,0,1));
+    _mm_storeu_si128((__m128i*)(p + i * 4), swapBytesSSE2(v));
+  }
+  swapTail32(p, i, n);
+}
+
+static inline void
+swapSSE2_64(_CORBA_Octet* p, _CORBA_ULong i, _CORBA_ULong n)
+{
+  for (; i + 2 <= n; i += 2) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(p + i * 8));
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0,1,2,3));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0,1,2,3));
+    _mm_storeu_si128((__m128i*)(p + i * 8), swapBytesSSE2(v));
+  }
+  swapTail64(p, i, n);
+}
+
+#  ifdef SWAP_KERNELS_AVX2
+
+static void swapSSE2_16(_CORBA_Octet* p, _CORBA_ULong n)
+{
+  swapSSE2_16(p, 0, n);
+}
+
+static void swapSSE2_32(_CORBA_Octet* p, _CORBA_ULong n)
+{
+  swapSSE2_32(p, 0, n);
+}
+
+static void swapSSE2_64(_CORBA_Octet* p, _CORBA_ULong n)
+{
+  swapSSE2_64(p, 0, n);
+}
+
+
+//
+// AVX2 shuffles the bytes of 32 at a time.
+//
+
+__attribute__((target("avx2")))
+static inline void
+swapAVX2(_CORBA_Octet* p, _CORBA_ULong bytes, __m256i order)
+{
+  _CORBA_ULong i = 0;
+  for (; i + 64 <= bytes; i += 64) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(p + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(p + i + 32));
+    _mm256_storeu_si256((__m256i*)(p + i),      _mm256_shuffle_epi8(a, order));
+    _mm256_storeu_si256((__m256i*)(p + i + 32), _mm256_shuffle_epi8(b, order));
+  }
+  for (; i + 32 <= bytes; i += 32) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(p + i));
+    _mm256_storeu_si256((__m256i*)(p + i), _mm256_shuffle_epi8(a, order));
+  }
+}
+
+__attribute__((target("avx2")))
+static void
+swapAVX2_16(_CORBA_Octet* p, _CORBA_ULong n)
+{
+  const __m256i order = _mm256_setr_epi8(1,0,3,2,5,4,7,6,
+					 9,8,11,10,13,12,15,14,
+					 1,0,3,2,5,4,7,6,
+					 9,8,11,10,13,12,15,14);
+  swapAVX2(p, n * 2, order);
+  swapSSE2_16(p, n & ~15, n);
+}
+
+__attribute__((target("avx2")))
+static void
+swapAVX2_32(_CORBA_Octet* p, _CORBA_ULong n)
+{
+  const __m256i order = _mm256_setr_epi8(3,2,1,0,7,6,5,4,
+					 11,10,9,8,15,14,13,12,
+					 3,2,1,0,7,6,5,4,
+					 11,10,9,8,15,14,13,12);
+  swapAVX2(p, n * 4, order);
+  swapSSE2_32(p, n & ~7, n);
+}
+
+__attribute__((target("avx2")))
+static void
+swapAVX2_64(_CORBA_Octet* p, _CORBA_ULong n)
+{
+  const __m256i order = _mm256_setr_epi8(7,6,5,4,3,2,1,0,
+					 15,14,13,12,11,10,9,8,
+					 7,6,5,4,3,2,1,0,
+					 15,14,13,12,11,10,9,8);
+  swapAVX2(p, n * 8, order);
+  swapSSE2_64(p, n & ~3, n);
+}
+
+typedef void (*swapFn)(_CORBA_Octet*, _CORBA_ULong);
+
+static void swapSelect16(_CORBA_Octet* p, _CORBA_ULong n);
+static void swapSelect32(_CORBA_Octet* p, _CORBA_ULong n);
+static void swapSelect64(_CORBA_Octet* p, _CORBA_ULong n);
+
+static swapFn swapImpl16 = swapSelect16;
+static swapFn swapImpl32 = swapSelect32;
+static swapFn swapImpl64 = swapSelect64;
+// Set to the best versions for this processor on first use. Threads
+// racing to set them all set the same values.
+
+static void
+swapSelect()
+{
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    swapImpl16 = swapAVX2_16;
+    swapImpl32 = swapAVX2_32;
+    swapImpl64 = swapAVX2_64;
+  }
+  else {
+    swapImpl16 = swapSSE2_16;
+    swapImpl32 = swapSSE2_32;
+    swapImpl64 = swapSSE2_64;
+  }
+}
+
+static void swapSelect16(_CORBA_Octet* p, _CORBA_ULong n)
+{
+  swapSelect();
+  swapImpl16(p, n);
+}
+
+static void swapSelect32(_CORBA_Octet* p, _CORBA_ULong n)
+{
+  swapSelect();
+  swapImpl32(p, n);
+}
+
+static void swapSelect64(_CORBA_Octet* p, _CORBA_ULong n)
+{
+  swapSelect();
+  swapImpl64(p, n);
+}
+
+#  endif
+#endif
+
+// Arrays shorter than this many bytes are not worth the indirect call.
+static const _CORBA_ULong swapDispatchBytes = 64;
+
+
+//
+// cdrStream entry points
+//
+
+void
+cdrStream::swapArray16(void* a, _CORBA_ULong n)
+{
+  _CORBA_Octet* p = (_CORBA_Octet*)a;
+#if defined(SWAP_KERNELS_AVX2)
+  if (n * 2 >= swapDispatchBytes)
+    swapImpl16(p, n);
+  else
+    swapSSE2_16(p, 0, n);
+#elif defined(SWAP_KERNELS_SSE2)
+  swapSSE2_16(p, 0, n);
+#else
+  swapTail16(p, 0, n);
+#endif
+}
+
+void
+cdrStream::swapArray32(void* a, _CORBA_ULong n)
+{
+  _CORBA_Octet* p = (_CORBA_Octet*)a;
+#if defined(SWAP_KERNELS_AVX2)
+  if (n * 4 >= swapDispatchBytes)
+    swapImpl32(p, n);
+  else
+    swapSSE2_32(p, 0, n);
+#elif defined(SWAP_KERNELS_SSE2)
+  swapSSE2_32(p, 0, n);
+#else
+  swapTail32(p, 0, n);
+#endif
+}
+
+void
+cdrStream::swapArray64(void* a, _CORBA_ULong n)
+{
+  _CORBA_Octet* p = (_CORBA_Octet*)a;
+#if defined(SWAP_KERNELS_AVX2)
+  if (n * 8 >= swapDispatchBytes)
+    swapImpl64(p, n);
+  else
+    swapSSE2_64(p, 0, n);
+#elif defined(SWAP_KERNELS_SSE2)
+  swapSSE2_64(p, 0, n);
+#else
+  swapTail64(p, 0, n);
+#endif
+}
@@ -0,0 +1,302 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// codeSetKernels.cc
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//    Block conversion kernels used by the code set converters.
+//
+//    On x86 with gcc or clang, SSE2 is used for everything, and AVX2
+//    for scanning 8-bit strings if the processor supports it. Other
+//    platforms scan a machine word at a time where they can, and
+//    otherwise convert one character at a time.
+
+#include <omniORB4/CORBA.h>
+#include <codeSetUtil.h>
+
+#if defined(__GNUC__) && defined(__SSE2__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#  define CS_KERNELS_SSE2 1
+#  include <emmintrin.h>
+#  if defined(__clang__) || \
+      (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#    define CS_KERNELS_AVX2 1
+#    include <immintrin.h>
+#  endif
+#endif
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+//
+// asciiLength
+//
+
+static inline _CORBA_ULong
+asciiLengthTail(const char* s, _CORBA_ULong i, _CORBA_ULong len)
+{
+#if defined(SIZEOF_LONG) && (SIZEOF_LONG == 8)
+  // A word at a time
+  for (; i + 8 <= len; i += 8) {
+    unsigned long w;
+    memcpy(&w, s + i, 8);
+    if (w & 0x8080808080808080UL)
+      break;
+  }
+#endif
+  while (i < len && !(s[i] & 0x80))
+    i++;
+  return i;
+}
+
+#ifdef CS_KERNELS_SSE2
+
+static inline _CORBA_ULong
+asciiLengthSSE2(const char* s, _CORBA_ULong i, _CORBA_ULong len)
+{
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+    int     m = _mm_movemask_epi8(v);
+    if (m)
+      return i + __builtin_ctz(m);
+  }
+  return asciiLengthTail(s, i, len);
+}
+
+static _CORBA_ULong
+asciiLengthSSE2(const char* s, _CORBA_ULong len)
+{
+  return asciiLengthSSE2(s, 0, len);
+}
+
+#  ifdef CS_KERNELS_AVX2
+
+__attribute__((target("avx2")))
+static _CORBA_ULong
+asciiLengthAVX2(const char* s, _CORBA_ULong len)
+{
+  _CORBA_ULong i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i  v = _mm256_loadu_si256((const __m256i*)(s + i));
+    unsigned m = (unsigned)_mm256_movemask_epi8(v);
+    if (m)
+      return i + __builtin_ctz(m);
+  }
+  return asciiLengthSSE2(s, i, len);
+}
+
+typedef _CORBA_ULong (*asciiLengthFn)(const char*, _CORBA_ULong);
+
+static _CORBA_ULong asciiLengthSelect(const char* s, _CORBA_ULong len);
+
+static asciiLengthFn asciiLengthImpl = asciiLengthSelect;
+// Set to the best version for this processor on first use. Threads
+// racing to set it all set the same value.
+
+static _CORBA_ULong
+asciiLengthSelect(const char* s, _CORBA_ULong len)
+{
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    asciiLengthImpl = asciiLengthAVX2;
+  else
+    asciiLengthImpl = asciiLengthSSE2;
+
+  return asciiLengthImpl(s, len);
+}
+
+#  endif
+#endif
+
+_CORBA_ULong
+omniCodeSetUtil::asciiLength(const char* s, _CORBA_ULong len)
+{
+#if defined(CS_KERNELS_AVX2)
+  // Short strings are not worth the indirect call.
+  if (len < 32)
+    return asciiLengthSSE2(s, 0, len);
+  return asciiLengthImpl(s, len);
+#elif defined(CS_KERNELS_SSE2)
+  return asciiLengthSSE2(s, 0, len);
+#else
+  return asciiLengthTail(s, 0, len);
+#endif
+}
+
+
+//
+// widenASCII
+//
+
+_CORBA_ULong
+omniCodeSetUtil::widenASCII(const char* s, _CORBA_ULong len,
+			    omniCodeSet::UniChar* us)
+{
+  _CORBA_ULong i = 0;
+
+#ifdef CS_KERNELS_SSE2
+  __m128i zero = _mm_setzero_si128();
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+    if (_mm_movemask_epi8(v))
+      break;
+    _mm_storeu_si128((__m128i*)(us + i),     _mm_unpacklo_epi8(v, zero));
+    _mm_storeu_si128((__m128i*)(us + i + 8), _mm_unpackhi_epi8(v, zero));
+  }
+#endif
+
+  for (; i < len; i++) {
+    _CORBA_Char c = s[i];
+    if (c & 0x80)
+      break;
+    us[i] = c;
+  }
+  return i;
+}
+
+
+//
+// narrowASCII
+//
+
+_CORBA_ULong
+omniCodeSetUtil::narrowASCII(const omniCodeSet::UniChar* us,
+			     _CORBA_ULong len, char* s)
+{
+  _CORBA_ULong i = 0;
+
+#ifdef CS_KERNELS_SSE2
+  __m128i high = _mm_set1_epi16((short)0xff80);
+  __m128i zero = _mm_setzero_si128();
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(us + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(us + i + 8));
+    __m128i t = _mm_and_si128(_mm_or_si128(a, b), high);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(t, zero)) != 0xffff)
+      break;
+    _mm_storeu_si128((__m128i*)(s + i), _mm_packus_epi16(a, b));
+  }
+#endif
+
+  for (; i < len; i++) {
+    omniCodeSet::UniChar uc = us[i];
+    if (uc >= 0x80)
+      break;
+    s[i] = (char)uc;
+  }
+  return i;
+}
+
+
+//
+// swapU
+//
+
+void
+omniCodeSetUtil::swapU(omniCodeSet::UniChar* us, _CORBA_ULong len)
+{
+  _CORBA_ULong i = 0;
+
+#ifdef CS_KERNELS_SSE2
+  for (; i + 8 <= len; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(us + i));
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    _mm_storeu_si128((__m128i*)(us + i), v);
+  }
+#endif
+
+  for (; i < len; i++) {
+    omniCodeSet::UniChar uc = us[i];
+    us[i] = ((uc & 0xff00) >> 8) | ((uc & 0x00ff) << 8);
+  }
+}
+
+
+#if (SIZEOF_WCHAR == 4)
+
+//
+// narrowW
+//
+
+_CORBA_ULong
+omniCodeSetUtil::narrowW(const _CORBA_WChar* ws, _CORBA_ULong len,
+			 omniCodeSet::UniChar* us)
+{
+  _CORBA_ULong i = 0;
+
+#ifdef CS_KERNELS_SSE2
+  // SSE2 can only pack with signed saturation, so values are biased
+  // into the signed range and back.
+  __m128i zero = _mm_setzero_si128();
+  __m128i bias = _mm_set1_epi32(0x8000);
+  __m128i back = _mm_set1_epi16((short)0x8000);
+
+  for (; i + 8 <= len; i += 8) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(ws + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(ws + i + 4));
+    __m128i t = _mm_srli_epi32(_mm_or_si128(a, b), 16);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(t, zero)) != 0xffff)
+      break;
+    __m128i v = _mm_packs_epi32(_mm_sub_epi32(a, bias),
+				_mm_sub_epi32(b, bias));
+    _mm_storeu_si128((__m128i*)(us + i), _mm_xor_si128(v, back));
+  }
+#endif
+
+  for (; i < len; i++) {
+    _CORBA_ULong wc = (_CORBA_ULong)ws[i];
+    if (wc > 0xffff)
+      break;
+    us[i] = wc;
+  }
+  return i;
+}
+
+
+//
+// widenW
+//
+
+void
+omniCodeSetUtil::widenW(const omniCodeSet::UniChar* us, _CORBA_ULong len,
+			_CORBA_WChar* ws)
+{
+  _CORBA_ULong i = 0;
+
+#ifdef CS_KERNELS_SSE2
+  __m128i zero = _mm_setzero_si128();
+
+  for (; i + 8 <= len; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(us + i));
+    _mm_storeu_si128((__m128i*)(ws + i),     _mm_unpacklo_epi16(v, zero));
+    _mm_storeu_si128((__m128i*)(ws + i + 4), _mm_unpackhi_epi16(v, zero));
+  }
+#endif
+
+  for (; i < len; i++)
+    ws[i] = us[i];
+}
+
+#endif
+
+OMNI_NAMESPACE_END(omni)
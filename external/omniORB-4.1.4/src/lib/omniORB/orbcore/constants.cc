@@ -190,6 +190,7 @@ const IOP::ComponentId IOP::TAG_OMNIORB_BIDIR         	      = 0x41545401;
 const IOP::ComponentId IOP::TAG_OMNIORB_UNIX_TRANS    	      = 0x41545402;
 const IOP::ComponentId IOP::TAG_OMNIORB_PERSISTENT_ID 	      = 0x41545403;
 const IOP::ComponentId IOP::TAG_OMNIORB_RESTRICTED_CONNECTION = 0x41545404;
+const IOP::ComponentId IOP::TAG_OMNIORB_SHM_TRANS             = 0x41545405;
 
 
 static struct {
@@ -229,6 +230,7 @@ static struct {
   { IOP::TAG_OMNIORB_UNIX_TRANS, "TAG_OMNIORB_UNIX_TRANS" },
   { IOP::TAG_OMNIORB_PERSISTENT_ID, "TAG_OMNIORB_PERSISTENT_ID" },
   { IOP::TAG_OMNIORB_RESTRICTED_CONNECTION, "TAG_OMNIORB_RESTRICTED_CONNECTION" },
+  { IOP::TAG_OMNIORB_SHM_TRANS, "TAG_OMNIORB_SHM_TRANS" },
   { 0, 0 }
 };
 
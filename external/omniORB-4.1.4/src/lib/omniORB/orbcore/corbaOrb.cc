@@ -434,6 +434,7 @@ extern omniInitialiser& omni_giopRope_initialiser_;
 extern omniInitialiser& omni_giopserver_initialiser_;
 extern omniInitialiser& omni_giopbidir_initialiser_;
 extern omniInitialiser& omni_omniTransport_initialiser_;
+extern omniInitialiser& omni_bufferPool_initialiser_;
 extern omniInitialiser& omni_omniCurrent_initialiser_;
 extern omniInitialiser& omni_dynamiclib_initialiser_;
 extern omniInitialiser& omni_objadpt_initialiser_;
@@ -444,6 +445,9 @@ extern omniInitialiser& omni_orbOptions_initialiser_;
 extern omniInitialiser& omni_poa_initialiser_;
 extern omniInitialiser& omni_uri_initialiser_;
 extern omniInitialiser& omni_invoker_initialiser_;
+extern omniInitialiser& omni_logAsync_initialiser_;
+extern omniInitialiser& omni_metrics_initialiser_;
+extern omniInitialiser& omni_timerWheel_initialiser_;
 
 OMNI_NAMESPACE_END(omni)
 
@@ -649,6 +653,8 @@ CORBA::ORB_init(int& argc, char** argv, const char* orb_identifier,
     omni_codeSet_initialiser_.attach();
     omni_cdrStream_initialiser_.attach();
     omni_omniTransport_initialiser_.attach();
+    omni_bufferPool_initialiser_.attach();
+    omni_timerWheel_initialiser_.attach();
     omni_giopRope_initialiser_.attach();
     omni_giopserver_initialiser_.attach();
     omni_giopbidir_initialiser_.attach();
@@ -661,6 +667,8 @@ CORBA::ORB_init(int& argc, char** argv, const char* orb_identifier,
     omni_poa_initialiser_.attach();
     omni_uri_initialiser_.attach();
     omni_invoker_initialiser_.attach();
+    omni_logAsync_initialiser_.attach();
+    omni_metrics_initialiser_.attach();
     omni_hooked_initialiser_.attach();
 
     if (orbParameters::lcdMode) {
@@ -901,6 +909,8 @@ omniOrbORB::destroy()
 
     // Call detach method of the initialisers in reverse order.
     omni_hooked_initialiser_.detach();
+    omni_metrics_initialiser_.detach();
+    omni_logAsync_initialiser_.detach();
     omni_invoker_initialiser_.detach();
     omni_uri_initialiser_.detach();
     omni_poa_initialiser_.detach();
@@ -913,6 +923,8 @@ omniOrbORB::destroy()
     omni_giopbidir_initialiser_.detach();
     omni_giopserver_initialiser_.detach();
     omni_giopRope_initialiser_.detach();
+    omni_timerWheel_initialiser_.detach();
+    omni_bufferPool_initialiser_.detach();
     omni_omniTransport_initialiser_.detach();
     omni_cdrStream_initialiser_.detach();
     omni_codeSet_initialiser_.detach();
@@ -362,6 +362,23 @@ omniCodeSet::TCS_C_8bit::fastMarshalString(cdrStream&          stream,
     }
     return 1;
   }
+  else if (ncs->id() == omniCodeSet::ID_UTF_8 && pd_ascii) {
+    // A UTF-8 string that is all ASCII is sent as it is.
+    if (len == 0)
+      len = strlen(s);
+
+    if (omniCodeSetUtil::asciiLength(s, len) != len)
+      return 0;
+
+    if (bound && len > bound)
+      OMNIORB_THROW(MARSHAL, MARSHAL_StringIsTooLong, 
+		    (CORBA::CompletionStatus)stream.completion());
+    len++;
+    stream.declareArrayLength(omni::ALIGN_4, len + 4);
+    len >>= stream;
+    stream.put_octet_array((const _CORBA_Octet*)s, len);
+    return 1;
+  }
   return 0;
 }
 
@@ -384,7 +401,9 @@ omniCodeSet::TCS_C_8bit::fastUnmarshalString(cdrStream&          stream,
 					     _CORBA_ULong&       len,
 					     char*&              s)
 {
-  if (ncs->id() == id()) { // Null transformation
+  _CORBA_Boolean toUTF8 = (ncs->id() == omniCodeSet::ID_UTF_8 && pd_ascii);
+
+  if (ncs->id() == id() || toUTF8) { // Null transformation, or to UTF-8
     _CORBA_ULong mlen; mlen <<= stream;
 
     if (mlen == 0) {
@@ -418,6 +437,39 @@ omniCodeSet::TCS_C_8bit::fastUnmarshalString(cdrStream&          stream,
       OMNIORB_THROW(MARSHAL, MARSHAL_StringNotEndWithNull, 
 		    (CORBA::CompletionStatus)stream.completion());
 
+    _CORBA_ULong n;
+    if (toUTF8 && (n = omniCodeSetUtil::asciiLength(s, mlen)) != mlen) {
+      // Convert what follows the leading run of ASCII to UTF-8.
+      omniCodeSetUtil::BufferC b(mlen + (mlen - n) * 2);
+      memcpy(b.room(n), s, n);
+      b.advance(n);
+
+      for (const char* p = s + n; *p; p++) {
+	_CORBA_Char c  = *p;
+	UniChar     uc = pd_toU[c];
+
+	if (uc < 0x0080) {
+	  if (!uc)
+	    OMNIORB_THROW(DATA_CONVERSION, 
+			  DATA_CONVERSION_CannotMapChar,
+			  (CORBA::CompletionStatus)stream.completion());
+	  b.insert(uc);
+	}
+	else if (uc < 0x0800) {
+	  b.insert(0xc0 | ((uc & 0x07c0) >>  6));
+	  b.insert(0x80 | ((uc & 0x003f)      ));
+	}
+	else {
+	  b.insert(0xe0 | ((uc & 0xf000) >> 12));
+	  b.insert(0x80 | ((uc & 0x0fc0) >>  6));
+	  b.insert(0x80 | ((uc & 0x003f)      ));
+	}
+      }
+      b.insert(0);
+      len = b.length() - 1;
+      s   = b.extract();
+      return 1;
+    }
 
     h.drop();
     len = mlen - 1; // Return length without terminating null
@@ -214,16 +214,11 @@ NCS_W_UTF_16::marshalWString(cdrStream&          stream,
 #else
   omniCodeSet::UniChar*    us = omniCodeSetUtil::allocU(len+1);
   omniCodeSetUtil::HolderU uh(us);
-  _CORBA_WChar             wc;
 
-  for (_CORBA_ULong i=0; i<=len; i++) {
-    wc = ws[i];
-    if (wc > 0xffff)
-      OMNIORB_THROW(BAD_PARAM, BAD_PARAM_WCharOutOfRange, 
-		    (CORBA::CompletionStatus)stream.completion());
+  if (omniCodeSetUtil::narrowW(ws, len+1, us) != len+1)
+    OMNIORB_THROW(BAD_PARAM, BAD_PARAM_WCharOutOfRange, 
+		  (CORBA::CompletionStatus)stream.completion());
 
-    us[i] = wc;
-  }
   tcs->marshalWString(stream, bound, len, us);
 #endif
 }
@@ -262,12 +257,7 @@ NCS_W_UTF_16::unmarshalWString(cdrStream& stream,
   omniCodeSetUtil::HolderU uh(us);
 
   ws = omniCodeSetUtil::allocW(len+1);
-  omniCodeSetUtil::HolderW wh(ws);
-
-  for (_CORBA_ULong i=0; i<=len; i++)
-    ws[i] = us[i];
-
-  wh.drop();
+  omniCodeSetUtil::widenW(us, len+1, ws);
   return len;
 #endif
 }
@@ -430,12 +420,8 @@ TCS_W_UTF_16::unmarshalWString(cdrStream& stream,
 
     stream.get_octet_array((_CORBA_Octet*)us, len*2, omni::ALIGN_2);
 
-    if (!stream.unmarshal_byte_swap()) {
-      for (_CORBA_ULong i=0; i < len; i++) {
-	uc    = us[i];
-	us[i] = ((uc & 0xff00) >> 8) | ((uc & 0x00ff) << 8);
-      }
-    }
+    if (!stream.unmarshal_byte_swap())
+      omniCodeSetUtil::swapU(us, len);
   }
   else {
     // No BOM at all, so big endian
@@ -461,10 +447,7 @@ TCS_W_UTF_16::unmarshalWString(cdrStream& stream,
 
     if (omni::myByteOrder) {
       // We are little endian, so byteswap the string
-      for (_CORBA_ULong i=0; i < len; i++) {
-	uc    = us[i];
-	us[i] = ((uc & 0xff00) >> 8) | ((uc & 0x00ff) << 8);
-      }
+      omniCodeSetUtil::swapU(us, len);
     }
   }
   us[len] = 0;
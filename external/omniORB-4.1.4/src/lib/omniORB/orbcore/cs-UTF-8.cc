@@ -163,7 +163,8 @@ public:
 				     _CORBA_ULong&       length,
 				     char*&              s);
 
-  void validateString(const char* s, CORBA::CompletionStatus completion);
+  void validateString(const char* s, _CORBA_ULong len,
+		      CORBA::CompletionStatus completion);
 
   TCS_C_UTF_8(GIOP::Version v)
     : omniCodeSet::TCS_C(omniCodeSet::ID_UTF_8, "UTF-8",
@@ -268,6 +269,124 @@ validateExt(_CORBA_Char c, CORBA::CompletionStatus completion)
 }
 
 
+// Convert UTF-8 s[0..len), which must be followed by a null, to
+// UTF-16 in ub. Runs of ASCII are copied a block at a time.
+
+static void
+utf8ToUTF16(const char* s, _CORBA_ULong len,
+	    omniCodeSetUtil::BufferU& ub, CORBA::CompletionStatus completion)
+{
+  const char*  end = s + len;
+  CORBA::ULong lc;
+  _CORBA_Char  c;
+  int          bytes;
+
+  while (s < end) {
+    _CORBA_ULong n = omniCodeSetUtil::widenASCII(s, end - s,
+						 ub.room(end - s));
+    ub.advance(n);
+    s += n;
+    if (s == end)
+      break;
+
+    c     = *s++;
+    bytes = utf8Count[c];
+    lc    = c & utf8Mask[c];
+
+    switch (bytes) {
+    case 6: OMNIORB_THROW(DATA_CONVERSION, 
+			  DATA_CONVERSION_BadInput,
+			  completion);
+    case 5:
+    case 4: OMNIORB_THROW(DATA_CONVERSION, 
+			  DATA_CONVERSION_CannotMapChar,
+			  completion);
+    case 3: c = *s++; lc = (lc << 6) | (c & 0x3f); validateExt(c, completion);
+    case 2: c = *s++; lc = (lc << 6) | (c & 0x3f); validateExt(c, completion);
+    case 1: c = *s++; lc = (lc << 6) | (c & 0x3f); validateExt(c, completion);
+    }
+    if (lc <= 0xffff) {
+      // Single unicode char
+      ub.insert(lc);
+    }
+    else {
+      // Surrogate pair
+      lc -= 0x10000;
+      ub.insert((lc >> 10)    + 0xd800);
+      ub.insert((lc &  0x3ff) + 0xdc00);
+    }
+  }
+}
+
+
+// Convert UTF-16 us[0..len) to UTF-8 in b. Runs of ASCII are copied a
+// block at a time.
+
+static void
+utf16ToUTF8(const omniCodeSet::UniChar* us, _CORBA_ULong len,
+	    omniCodeSetUtil::BufferC& b, CORBA::CompletionStatus completion)
+{
+  omniCodeSet::UniChar uc;
+  _CORBA_ULong         i = 0;
+
+  while (i < len) {
+    _CORBA_ULong n = omniCodeSetUtil::narrowASCII(us + i, len - i,
+						  b.room(len - i));
+    b.advance(n);
+    i += n;
+    if (i == len)
+      break;
+
+    uc = us[i];
+
+    if (uc < 0x0800) {
+      b.insert(0xc0 | ((uc & 0x07c0) >>  6));
+      b.insert(0x80 | ((uc & 0x003f)      ));
+    }
+    else if (uc < 0xd800) {
+      b.insert(0xe0 | ((uc & 0xf000) >> 12));
+      b.insert(0x80 | ((uc & 0x0fc0) >>  6));
+      b.insert(0x80 | ((uc & 0x003f)      ));
+    }
+    else if (uc < 0xdc00) {
+      // Surrogate pair
+      _CORBA_ULong lc = (uc - 0xd800) << 10;
+      if (++i == len) {
+	// No second half to surrogate pair
+	OMNIORB_THROW(DATA_CONVERSION, 
+		      DATA_CONVERSION_BadInput,
+		      completion);
+      }
+      uc = us[i];
+      if (uc < 0xdc00 || uc > 0xdfff) {
+	// Value is not a valid second half to a surrogate pair
+	OMNIORB_THROW(DATA_CONVERSION, 
+		      DATA_CONVERSION_BadInput,
+		      completion);
+      }
+      lc = lc + uc - 0xdc00 + 0x10000;
+
+      b.insert(0xf0 | ((lc & 0x001c0000) >> 18));
+      b.insert(0x80 | ((lc & 0x0003f000) >> 12));
+      b.insert(0x80 | ((lc & 0x00000fc0) >>  6));
+      b.insert(0x80 | ((lc & 0x0000003f)      ));
+    }
+    else if (uc < 0xe000) {
+      // Second half of surrogate pair not allowed on its own
+      OMNIORB_THROW(DATA_CONVERSION,
+		    DATA_CONVERSION_BadInput,
+		    completion);
+    }
+    else {
+      b.insert(0xe0 | ((uc & 0xf000) >> 12));
+      b.insert(0x80 | ((uc & 0x0fc0) >>  6));
+      b.insert(0x80 | ((uc & 0x003f)      ));
+    }
+    i++;
+  }
+}
+
+
 
 
 //
@@ -303,40 +422,12 @@ NCS_C_UTF_8::marshalString(cdrStream& stream, omniCodeSet::TCS_C* tcs,
 
   if (tcs->fastMarshalString(stream, this, bound, len, s)) return;
 
-  CORBA::CompletionStatus completion =
-    (CORBA::CompletionStatus)stream.completion();
+  if (len == 0)
+    len = strlen(s);
 
-  omniCodeSetUtil::BufferU ub;
-  CORBA::ULong        	   lc;
-  _CORBA_Char         	   c;
-  int                  	   bytes;
+  omniCodeSetUtil::BufferU ub(len + 1);
+  utf8ToUTF16(s, len, ub, (CORBA::CompletionStatus)stream.completion());
 
-  while (*s) {
-    c     = *s++;
-    bytes = utf8Count[c];
-    lc    = c & utf8Mask[c];
-
-    switch (bytes) {
-    case 6:
-    case 5:
-    case 4: OMNIORB_THROW(DATA_CONVERSION, 
-			  DATA_CONVERSION_CannotMapChar,
-			  completion);
-    case 3: c = *s++; lc = (lc << 6) | (c & 0x3f); validateExt(c, completion);
-    case 2: c = *s++; lc = (lc << 6) | (c & 0x3f); validateExt(c, completion);
-    case 1: c = *s++; lc = (lc << 6) | (c & 0x3f); validateExt(c, completion);
-    }
-    if (lc <= 0xffff) {
-      // Single unicode char
-      ub.insert(lc);
-    }
-    else {
-      // Surrogate pair
-      lc -= 0x10000;
-      ub.insert((lc >> 10)    + 0xd800);
-      ub.insert((lc &  0x3ff) + 0xdc00);
-    }
-  }
   // Null terminator
   len = ub.length();
   ub.insert(0);
@@ -382,60 +473,11 @@ NCS_C_UTF_8::unmarshalString(cdrStream& stream, omniCodeSet::TCS_C* tcs,
   OMNIORB_ASSERT(us);
 
   omniCodeSetUtil::HolderU uh(us);
-  omniCodeSetUtil::BufferC b;
-  omniCodeSet::UniChar     uc;
+  OMNIORB_ASSERT(us[len] == 0); // Last char must be zero
 
-  for (_CORBA_ULong i=0; i<=len; i++) {
-    uc = us[i];
-
-    if      (uc < 0x0080) {
-      b.insert(uc);
-    }
-    else if (uc < 0x0800) {
-      b.insert(0xc0 | ((uc & 0x07c0) >>  6));
-      b.insert(0x80 | ((uc & 0x003f)      ));
-    }
-    else if (uc < 0xd800) {
-      b.insert(0xe0 | ((uc & 0xf000) >> 12));
-      b.insert(0x80 | ((uc & 0x0fc0) >>  6));
-      b.insert(0x80 | ((uc & 0x003f)      ));
-    }
-    else if (uc < 0xdc00) {
-      // Surrogate pair
-      _CORBA_ULong lc = (uc - 0xd800) << 10;
-      if (++i == len) {
-	// No second half to surrogate pair
-	OMNIORB_THROW(DATA_CONVERSION, 
-		      DATA_CONVERSION_BadInput,
-		      (CORBA::CompletionStatus)stream.completion());
-      }
-      uc = us[i];
-      if (uc < 0xdc00 || uc > 0xdfff) {
-	// Value is not a valid second half to a surrogate pair
-	OMNIORB_THROW(DATA_CONVERSION, 
-		      DATA_CONVERSION_BadInput,
-		      (CORBA::CompletionStatus)stream.completion());
-      }
-      lc = lc + uc - 0xdc00 + 0x10000;
-
-      b.insert(0xf0 | ((lc & 0x001c0000) >> 18));
-      b.insert(0x80 | ((lc & 0x0003f000) >> 12));
-      b.insert(0x80 | ((lc & 0x00000fc0) >>  6));
-      b.insert(0x80 | ((lc & 0x000000ef)      ));
-    }
-    else if (uc < 0xe000) {
-      // Second half of surrogate pair not allowed on its own
-      OMNIORB_THROW(DATA_CONVERSION,
-		    DATA_CONVERSION_BadInput,
-		    (CORBA::CompletionStatus)stream.completion());
-    }
-    else {
-      b.insert(0xe0 | ((uc & 0xf000) >> 12));
-      b.insert(0x80 | ((uc & 0x0fc0) >>  6));
-      b.insert(0x80 | ((uc & 0x003f)      ));
-    }
-  }
-  OMNIORB_ASSERT(uc == 0); // Last char must be zero
+  omniCodeSetUtil::BufferC b(len + 1);
+  utf16ToUTF8(us, len, b, (CORBA::CompletionStatus)stream.completion());
+  b.insert(0);
 
   s = b.extract();
   return b.length() - 1;
@@ -465,59 +507,10 @@ TCS_C_UTF_8::marshalString(cdrStream& stream,
 			   _CORBA_ULong len,
 			   const omniCodeSet::UniChar* us)
 {
-  omniCodeSetUtil::BufferC b;
-  omniCodeSet::UniChar     uc;
-
-  for (_CORBA_ULong i=0; i<=len; i++) {
-    uc = us[i];
+  omniCodeSetUtil::BufferC b(len + 1);
+  utf16ToUTF8(us, len, b, (CORBA::CompletionStatus)stream.completion());
+  b.insert(0);
 
-    if      (uc < 0x0080) {
-      b.insert(uc);
-    }
-    else if (uc < 0x0800) {
-      b.insert(0xc0 | ((uc & 0x07c0) >>  6));
-      b.insert(0x80 | ((uc & 0x003f)      ));
-    }
-    else if (uc < 0xd800) {
-      b.insert(0xe0 | ((uc & 0xf000) >> 12));
-      b.insert(0x80 | ((uc & 0x0fc0) >>  6));
-      b.insert(0x80 | ((uc & 0x003f)      ));
-    }
-    else if (uc < 0xdc00) {
-      // Surrogate pair
-      _CORBA_ULong lc = (uc - 0xd800) << 10;
-      if (++i == len) {
-	// No second half to surrogate pair
-	OMNIORB_THROW(DATA_CONVERSION, 
-		      DATA_CONVERSION_BadInput,
-		      (CORBA::CompletionStatus)stream.completion());
-      }
-      uc = us[i];
-      if (uc < 0xdc00 || uc > 0xdfff) {
-	// Value is not a valid second half to a surrogate pair
-	OMNIORB_THROW(DATA_CONVERSION, 
-		      DATA_CONVERSION_BadInput,
-		      (CORBA::CompletionStatus)stream.completion());
-      }
-      lc = lc + uc - 0xdc00 + 0x10000;
-
-      b.insert(0xf0 | ((lc & 0x001c0000) >> 18));
-      b.insert(0x80 | ((lc & 0x0003f000) >> 12));
-      b.insert(0x80 | ((lc & 0x00000fc0) >>  6));
-      b.insert(0x80 | ((lc & 0x000000ef)      ));
-    }
-    else if (uc < 0xe000) {
-      // Second half of surrogate pair not allowed on its own
-      OMNIORB_THROW(DATA_CONVERSION, 
-		    DATA_CONVERSION_BadInput,
-		    (CORBA::CompletionStatus)stream.completion());
-    }
-    else {
-      b.insert(0xe0 | ((uc & 0xf000) >> 12));
-      b.insert(0x80 | ((uc & 0x0fc0) >>  6));
-      b.insert(0x80 | ((uc & 0x003f)      ));
-    }
-  }
   _CORBA_ULong mlen = b.length();
 
   if (bound && mlen-1 > bound)
@@ -576,48 +569,17 @@ TCS_C_UTF_8::unmarshalString(cdrStream& stream,
     OMNIORB_THROW(MARSHAL, MARSHAL_PassEndOfMessage, completion);
 
 
-  omniCodeSetUtil::BufferU ub;
-  CORBA::ULong         	   lc;
-  _CORBA_Char          	   c;
-  int                  	   bytes;
+  char* buf = omniCodeSetUtil::allocC(len);
+  omniCodeSetUtil::HolderC h(buf);
 
-  for (_CORBA_ULong i=0; i < len; i++) {
-    c     = stream.unmarshalOctet();
-    bytes = utf8Count[c];
-    lc    = c & utf8Mask[c];
-
-    switch (bytes) {
-    case 6: OMNIORB_THROW(DATA_CONVERSION, 
-			  DATA_CONVERSION_BadInput,
-			  completion);
-    case 5:
-    case 4: OMNIORB_THROW(DATA_CONVERSION, 
-			  DATA_CONVERSION_CannotMapChar,
-			  completion);
-    case 3:
-      c = stream.unmarshalOctet(); i++;
-      lc = (lc << 6) | (c & 0x3f); validateExt(c, completion);
-    case 2:
-      c = stream.unmarshalOctet(); i++;
-      lc = (lc << 6) | (c & 0x3f); validateExt(c, completion);
-    case 1:
-      c = stream.unmarshalOctet(); i++;
-      lc = (lc << 6) | (c & 0x3f); validateExt(c, completion);
-    }
-    if (lc <= 0xffff) {
-      // Single unicode char
-      ub.insert(lc);
-    }
-    else {
-      // Surrogate pair
-      lc -= 0x10000;
-      ub.insert((lc >> 10)    + 0xd800);
-      ub.insert((lc &  0x3ff) + 0xdc00);
-    }
-  }
-  if (lc != 0) // Check for null-terminator
+  stream.get_octet_array((_CORBA_Octet*)buf, len);
+  if (buf[len-1] != '\0') // Check for null-terminator
     OMNIORB_THROW(MARSHAL, MARSHAL_StringNotEndWithNull, completion);
 
+  omniCodeSetUtil::BufferU ub(len);
+  utf8ToUTF16(buf, len - 1, ub, completion);
+  ub.insert(0);
+
   us = ub.extract();
   return ub.length() - 1;
 }
@@ -644,7 +606,8 @@ TCS_C_UTF_8::fastMarshalString(cdrStream&          stream,
 {
   if (ncs->id() == id()) { // Null transformation
     if (validateUTF8)
-      validateString(s, (CORBA::CompletionStatus)stream.completion());
+      validateString(s, len ? len : strlen(s),
+		     (CORBA::CompletionStatus)stream.completion());
 
     if (len == 0) {
       len = stream.marshalRawString(s);
@@ -666,11 +629,37 @@ TCS_C_UTF_8::fastMarshalString(cdrStream&          stream,
   }
   else if (ncs->kind() == omniCodeSet::CS_8bit) { // Simple 8 bit code set
 
-    const omniCodeSet::UniChar* toU = ((omniCodeSet::NCS_C_8bit*)ncs)->toU();
+    omniCodeSet::NCS_C_8bit*    ncs8 = (omniCodeSet::NCS_C_8bit*)ncs;
+    const omniCodeSet::UniChar* toU  = ncs8->toU();
+
+    if (len == 0)
+      len = strlen(s);
 
-    omniCodeSetUtil::BufferC b;
+    // If the code set agrees with ASCII, a leading run of ASCII needs
+    // no conversion, and an all-ASCII string can be sent as it is.
+    _CORBA_ULong n = 0;
+    if (ncs8->asciiCompatible()) {
+      n = omniCodeSetUtil::asciiLength(s, len);
+
+      if (n == len) {
+	if (bound && len > bound)
+	  OMNIORB_THROW(MARSHAL, MARSHAL_StringIsTooLong, 
+			(CORBA::CompletionStatus)stream.completion());
+
+	_CORBA_ULong mlen = len + 1;
+	mlen >>= stream;
+	stream.put_octet_array((const _CORBA_Octet*)s, mlen);
+	return 1;
+      }
+    }
+
+    omniCodeSetUtil::BufferC b(len + len / 2 + 1);
     omniCodeSet::UniChar     uc;
 
+    memcpy(b.room(n), s, n);
+    b.advance(n);
+    s += n;
+
     while (*s) {
       uc = toU[(_CORBA_Char)*s++];
 
@@ -766,7 +755,7 @@ TCS_C_UTF_8::fastUnmarshalString(cdrStream&          stream,
 		    (CORBA::CompletionStatus)stream.completion());
 
     if (validateUTF8)
-      validateString(s, (CORBA::CompletionStatus)stream.completion());
+      validateString(s, mlen - 1, (CORBA::CompletionStatus)stream.completion());
 
     h.drop();
     len = mlen - 1;
@@ -777,7 +766,8 @@ TCS_C_UTF_8::fastUnmarshalString(cdrStream&          stream,
     CORBA::CompletionStatus completion =
       (CORBA::CompletionStatus)stream.completion();
 
-    const _CORBA_Char** fromU = ((omniCodeSet::NCS_C_8bit*)ncs)->fromU();
+    omniCodeSet::NCS_C_8bit* ncs8  = (omniCodeSet::NCS_C_8bit*)ncs;
+    const _CORBA_Char**      fromU = ncs8->fromU();
 
     _CORBA_ULong mlen; mlen <<= stream;
 
@@ -801,13 +791,30 @@ TCS_C_UTF_8::fastUnmarshalString(cdrStream&          stream,
     if (!stream.checkInputOverrun(1, mlen))
       OMNIORB_THROW(MARSHAL, MARSHAL_PassEndOfMessage, completion);
 
-    omniCodeSetUtil::BufferC        b; // *** Could initialise to mlen here
-    omniCodeSet::UniChar 	    uc;
-    _CORBA_Char          	    c;
-    int                  	    bytes;
+    // The string is read in one go and converted in place, since the
+    // 8 bit form is never longer than the UTF-8 one.
+    s = omniCodeSetUtil::allocC(mlen);
+    omniCodeSetUtil::HolderC h(s);
+
+    stream.get_octet_array((_CORBA_Octet*)s, mlen);
+    if (s[mlen-1] != '\0') // Check for null-terminator
+      OMNIORB_THROW(MARSHAL, MARSHAL_StringNotEndWithNull, completion);
 
-    for (_CORBA_ULong i=0; i < mlen; i++) {
-      c     = stream.unmarshalOctet();
+    // If the code set agrees with ASCII, there is nothing to do for a
+    // leading run of ASCII.
+    _CORBA_ULong n = 0;
+    if (ncs8->asciiCompatible())
+      n = omniCodeSetUtil::asciiLength(s, mlen);
+
+    const char*          in  = s + n;
+    const char*          end = s + mlen;
+    char*                out = s + n;
+    omniCodeSet::UniChar uc;
+    _CORBA_Char          c;
+    int                  bytes;
+
+    while (in < end) {
+      c     = *in++;
       bytes = utf8Count[c];
       uc    = c & utf8Mask[c];
 
@@ -821,10 +828,10 @@ TCS_C_UTF_8::fastUnmarshalString(cdrStream&          stream,
 			    DATA_CONVERSION_CannotMapChar,
 			    completion);
       case 2:
-	c = stream.unmarshalOctet(); i++;
+	c = *in++;
 	uc = (uc << 6) | (c & 0x3f); validateExt(c, completion);
       case 1:
-	c = stream.unmarshalOctet(); i++;
+	c = *in++;
 	uc = (uc << 6) | (c & 0x3f); validateExt(c, completion);
       }
       c = fromU[(uc & 0xff00) >> 8][uc & 0x00ff];
@@ -832,13 +839,11 @@ TCS_C_UTF_8::fastUnmarshalString(cdrStream&          stream,
 				  DATA_CONVERSION_CannotMapChar,
 				  completion);
 
-      b.insert(c);
+      *out++ = c;
     }
-    if (uc != 0) // Check for null-terminator
-      OMNIORB_THROW(MARSHAL, MARSHAL_StringNotEndWithNull, completion);
 
-    s   = b.extract();
-    len = b.length() - 1;
+    h.drop();
+    len = (out - s) - 1;
     return 1;
   }
   return 0;
@@ -846,14 +851,21 @@ TCS_C_UTF_8::fastUnmarshalString(cdrStream&          stream,
 
 
 void
-TCS_C_UTF_8::validateString(const char* s, CORBA::CompletionStatus completion)
+TCS_C_UTF_8::validateString(const char* s, _CORBA_ULong len,
+			    CORBA::CompletionStatus completion)
 {
-  // Check that string is valid UTF-8 data.
+  // Check that string is valid UTF-8 data. The string is followed by
+  // a null, which stops a truncated sequence running off the end.
+
+  const char* end = s + len;
+  int         bytes;
 
-  int bytes;
+  while (s < end) {
+    s += omniCodeSetUtil::asciiLength(s, end - s);
+    if (s == end)
+      break;
 
-  while (*s) {
-    bytes = utf8Count[*s++];
+    bytes = utf8Count[(_CORBA_Char)*s++];
 
     switch (bytes) {
     case 6:
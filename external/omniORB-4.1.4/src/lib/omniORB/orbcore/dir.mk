@@ -3,6 +3,7 @@
 GIOP_SRCS = \
             omniTransport.cc \
 	    cdrStream.cc \
+	    cdrSwapKernels.cc \
             cdrStreamAdapter.cc \
 	    cdrMemoryStream.cc \
 	    cdrValueChunkStream.cc \
@@ -21,6 +22,10 @@ GIOP_SRCS = \
             giopImpl12.cc \
             giopBiDir.cc \
             giopMonitor.cc \
+            omniBufferPool.cc \
+            metrics.cc \
+            logAsync.cc \
+            timerWheel.cc \
             SocketCollection.cc
 
 TRANSPORT_SRCS = \
@@ -37,8 +42,16 @@ UNIXSOCK_SRCS = \
             unixAddress.cc \
             unixActive.cc
 
+SHM_SRCS = \
+            shmTransportImpl.cc \
+            shmConnection.cc \
+            shmEndpoint.cc \
+            shmAddress.cc \
+            shmActive.cc
+
 CODESET_SRCS = \
 	    codeSets.cc \
+	    codeSetKernels.cc \
 	    cs-8bit.cc \
 	    cs-16bit.cc \
 	    cs-8859-1.cc \
@@ -85,6 +98,7 @@ ORB_SRCS =  \
 	    objectAdapter.cc \
 	    omniInternal.cc \
 	    omniIOR.cc \
+	    omniAsyncCall.cc \
 	    omniObjRef.cc \
 	    omniORB.cc \
 	    omniServant.cc \
@@ -129,6 +143,12 @@ ifdef UnixPlatform
   CXXVPATH += $(VPATH:%=%/unix)
 endif
 
+# Build the shared memory transport on Linux
+ifdef Linux
+  ORB_SRCS += $(SHM_SRCS)
+  CXXVPATH += $(VPATH:%=%/shm)
+endif
+
 ##########################################################################
 ifdef OMNIORB_CONFIG_DEFAULT_LOCATION
   CONFIG_DEFAULT_LOCATION = $(OMNIORB_CONFIG_DEFAULT_LOCATION)
@@ -131,6 +131,7 @@
 #include <omniORB4/omniObjRef.h>
 #include <exceptiondefs.h>
 #include <omniORB4/minorCode.h>
+#include <timerWheel.h>
 
 OMNI_USING_NAMESPACE(omni)
 
@@ -174,9 +175,11 @@ omni_defaultTransientExcHandler(void*,
       log << "Invocation on a location forwarded object has failed. "
 	  << n_retries << " retries.\n";
     }
-    unsigned long secs;
+    // Back off before retrying. The sleep is cut short if the ORB is
+    // shut down meanwhile.
+    CORBA::ULong secs;
     secs = ((n_retries < 30) ? n_retries : 30);
-    if (secs) omni_thread::sleep(secs,0);
+    if (secs) omniTimerWheel::sleep(secs * 1000);
     return 1;
   }
   return 0;
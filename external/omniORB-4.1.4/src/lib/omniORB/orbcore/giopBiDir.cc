@@ -135,6 +135,7 @@
 #include <orbOptions.h>
 #include <orbParameters.h>
 #include <transportRules.h>
+#include <metrics.h>
 
 OMNI_USING_NAMESPACE(omni)
 
@@ -260,7 +261,7 @@ RopeLink BiDirServerRope::ropes;
 
 ////////////////////////////////////////////////////////////////////////
 BiDirServerRope::BiDirServerRope(giopStrand* strand, giopAddress* addr) : 
-  giopRope(addr,0), 
+  giopRope(addr,0,1), 
   pd_sendfrom((const char*)strand->connection->peeraddress()) 
 {
   pd_maxStrands = 1;
@@ -522,7 +523,7 @@ BiDirServerRope::realIncrRefCount() {
 ////////////////////////////////////////////////////////////////////////
 BiDirClientRope::BiDirClientRope(const giopAddressList& addrlist,
 				 const omnivector<CORBA::ULong>& preferred) :
-  giopRope(addrlist,preferred)
+  giopRope(addrlist,preferred,1)
 {
   pd_maxStrands = 1;
   pd_oneCallPerConnection = 0;
@@ -548,7 +549,7 @@ BiDirClientRope::acquireClient(const omniIOR* ior,
     return giop_c;
   }
 
-  omni_tracedmutex_lock sync(pd_lock);
+  omni_tracedmutex_lock sync(pd_connectLock);
   giopStrand& s = (giopStrand&)((giopStream&)(*giop_c));
   if (s.connection == 0 && s.state() != giopStrand::DYING) {
     if (omniORB::trace(20)) {
@@ -585,7 +586,10 @@ BiDirClientRope::acquireClient(const omniIOR* ior,
     giopActiveConnection* c = s.address->Connect(deadline_secs,
 						 deadline_nanosecs,
 						 s.flags);
-    if (c) s.connection = &(c->getConnection());
+    if (c) {
+      s.connection = &(c->getConnection());
+      omniMetricsP::add(omniMetricsP::connectionsOpened,1);
+    }
     if (!s.connection) {
       s.state(giopStrand::DYING);
     }
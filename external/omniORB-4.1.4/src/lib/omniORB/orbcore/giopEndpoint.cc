@@ -265,29 +265,56 @@ giopTransportImpl::str2Transport(const char* endpoint) {
   return matchType(endpoint,param,1);
 }
 
+////////////////////////////////////////////////////////////////////////
+// The connection reference count is changed with different locks held
+// on different paths, so it is updated atomically.
+#if defined(__GNUC__)
+#  define CONN_REFCOUNT_ADD(p,v) __sync_add_and_fetch(p,v)
+#else
+static omni_tracedmutex refcountLock;
+
+static inline int
+connRefcountAdd(volatile int* p, int v)
+{
+  omni_tracedmutex_lock sync(refcountLock);
+  return *p += v;
+}
+#  define CONN_REFCOUNT_ADD(p,v) connRefcountAdd(p,v)
+#endif
+
 ////////////////////////////////////////////////////////////////////////
 void
 giopConnection::incrRefCount() {
 
   ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
-  OMNIORB_ASSERT(pd_refcount >= 0);
-  pd_refcount++;
+  int rc = CONN_REFCOUNT_ADD(&pd_refcount, 1);
+  OMNIORB_ASSERT(rc > 1);
 }
 
 ////////////////////////////////////////////////////////////////////////
 int
 giopConnection::decrRefCount(CORBA::Boolean forced) {
 
-  if (!forced) {
-    ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
-  }
-  int rc = --pd_refcount;
+  int rc = CONN_REFCOUNT_ADD(&pd_refcount, -1);
   OMNIORB_ASSERT(rc >= 0);
   if (rc == 0)
     delete this;
   return rc;
 }
 
+////////////////////////////////////////////////////////////////////////
+int
+giopConnection::Sendv(const SendBuffer* bufs, int count,
+		      unsigned long deadline_secs,
+		      unsigned long deadline_nanosecs) {
+
+  for (int i=0; i < count; i++) {
+    if (bufs[i].sz)
+      return Send(bufs[i].buf,bufs[i].sz,deadline_secs,deadline_nanosecs);
+  }
+  return 0;
+}
+
 ////////////////////////////////////////////////////////////////////////
 const char*
 giopConnection::peeridentity() {
@@ -336,6 +363,14 @@ CORBA::UShort   orbParameters::unixTransportPermission = 0777;
 //
 //  Valid values = unix permission mode bits in octal radix (e.g. 0755)
 
+CORBA::ULong    orbParameters::shmTransportBufferSize = 262144;
+//  Applies to the server side. The size in bytes of each of the two
+//  shared memory ring buffers, one per direction, that connections
+//  to a giop:shm endpoint use. Messages larger than the buffer are
+//  streamed through it.
+//
+//  Valid values = a power of 2, (n >= 8192)
+
 
 /////////////////////////////////////////////////////////////////////////////
 //            Handlers for Configuration Options                           //
@@ -415,6 +450,35 @@ public:
 
 static unixTransportPermissionHandler unixTransportPermissionHandler_;
 
+/////////////////////////////////////////////////////////////////////////////
+class shmTransportBufferSizeHandler : public orbOptions::Handler {
+public:
+
+  shmTransportBufferSizeHandler() :
+    orbOptions::Handler("shmTransportBufferSize",
+			"shmTransportBufferSize = n >= 8192, a power of 2",
+			1,
+			"-ORBshmTransportBufferSize < n >= 8192, a power of 2 >") {}
+
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::ULong v;
+    if (!orbOptions::getULong(value,v) || v < 8192 || (v & (v - 1))) {
+      throw orbOptions::BadParam(key(),value,
+				 "Invalid value, expect a power of 2 >= 8192");
+    }
+    orbParameters::shmTransportBufferSize = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVULong(key(),orbParameters::shmTransportBufferSize,
+			   result);
+  }
+};
+
+static shmTransportBufferSizeHandler shmTransportBufferSizeHandler_;
+
 
 /////////////////////////////////////////////////////////////////////////////
 //            Module initialiser                                           //
@@ -425,6 +489,7 @@ public:
   omni_giopEndpoint_initialiser() {
     orbOptions::singleton().registerHandler(unixTransportDirectoryHandler_);
     orbOptions::singleton().registerHandler(unixTransportPermissionHandler_);
+    orbOptions::singleton().registerHandler(shmTransportBufferSizeHandler_);
   }
 
   void attach() {
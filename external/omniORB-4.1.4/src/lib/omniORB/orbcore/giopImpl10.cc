@@ -225,7 +225,7 @@ giopImpl10::inputMessageBegin(giopStream* g,
 
  again:
   {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
 
     while (!(g->inputFullyBuffered() || g->pd_rdlocked)) {
       if (!g->rdLockNonBlocking()) {
@@ -364,7 +364,7 @@ giopImpl10::inputReplyBegin(giopStream* g,
   }
   else {
 
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     giopStreamList* gp = g->pd_strand->clients.next;
     for (; gp != &g->pd_strand->clients; gp = gp->next) {
 
@@ -453,7 +453,7 @@ giopImpl10::inputMessageEnd(giopStream* g,CORBA::Boolean disgard) {
     }
   }
   if (g->pd_rdlocked) {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->rdUnLock();
   }
 }
@@ -953,7 +953,7 @@ void
 giopImpl10::outputNewMessage(giopStream* g) {
 
   if (!g->pd_wrlocked) {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->wrLock();
   }
 
@@ -1015,7 +1015,7 @@ giopImpl10::outputMessageEnd(giopStream* g) {
   }
 
   {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->wrUnLock();
   }
 }
@@ -1027,7 +1027,7 @@ giopImpl10::sendMsgErrorMessage(giopStream* g,
 				const CORBA::SystemException* ex) {
 
   if (!g->pd_wrlocked) {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->wrLock();
   }
 
@@ -1071,7 +1071,7 @@ giopImpl10::sendMsgErrorMessage(giopStream* g,
   g->pd_strand->state(giopStrand::DYING);
 
   {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->wrUnLock();
   }
 }
@@ -1653,7 +1653,7 @@ giopImpl10::outputSetMessageSize(giopStream* g,CORBA::ULong msz) {
 	// safely relinquish this giopStream so that another request
 	// can proceed. There is no need to close the connection.
 	((GIOP_C*)g)->state(IOP_C::Idle);
-	omni_tracedmutex_lock sync(*omniTransportLock);
+	omni_tracedmutex_lock sync(*g->pd_strand->mutex);
 	g->wrUnLock();
 	OMNIORB_THROW(MARSHAL,MARSHAL_MessageSizeExceedLimitOnClient,
 		      (CORBA::CompletionStatus)g->completion());
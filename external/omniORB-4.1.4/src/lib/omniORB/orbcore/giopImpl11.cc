@@ -203,7 +203,8 @@ public:
 
   static void outputNewMessage(giopStream* g);
 
-  static void outputFlush(giopStream* g,CORBA::Boolean knownFragmentSize=0);
+  static void outputFlush(giopStream* g,CORBA::Boolean knownFragmentSize=0,
+			  void* data=0,CORBA::ULong datasz=0);
 
   static void outputSetFragmentSize(giopStream*,CORBA::ULong);
 
@@ -223,7 +224,7 @@ giopImpl11::inputMessageBegin(giopStream* g,
 
  again:
   {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
 
     while (!(g->inputFullyBuffered() || g->pd_rdlocked)) {
       if (!g->rdLockNonBlocking()) {
@@ -371,7 +372,7 @@ giopImpl11::inputReplyBegin(giopStream* g,
   }
   else {
 
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     giopStreamList* gp = g->pd_strand->clients.next;
     for (; gp != &g->pd_strand->clients; gp = gp->next) {
 
@@ -491,7 +492,7 @@ giopImpl11::inputMessageEnd(giopStream* g,CORBA::Boolean disgard) {
   }
 
   if (g->pd_rdlocked) {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->rdUnLock();
   }
 }
@@ -1097,7 +1098,7 @@ void
 giopImpl11::outputNewMessage(giopStream* g) {
 
   if (!g->pd_wrlocked) {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->wrLock();
   }
 
@@ -1158,7 +1159,7 @@ giopImpl11::outputMessageEnd(giopStream* g) {
   }
 
   {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->wrUnLock();
   }
 }
@@ -1169,7 +1170,7 @@ giopImpl11::sendMsgErrorMessage(giopStream* g,
 				const CORBA::SystemException* ex) {
 
   if (!g->pd_wrlocked) {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->wrLock();
   }
 
@@ -1213,7 +1214,7 @@ giopImpl11::sendMsgErrorMessage(giopStream* g,
   g->pd_strand->state(giopStrand::DYING);
 
   {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->wrUnLock();
   }
 }
@@ -1583,7 +1584,8 @@ giopImpl11::outputRemaining(const giopStream* g) {
 
 ////////////////////////////////////////////////////////////////////////
 void
-giopImpl11::outputFlush(giopStream* g,CORBA::Boolean knownFragmentSize) {
+giopImpl11::outputFlush(giopStream* g,CORBA::Boolean knownFragmentSize,
+			void* data,CORBA::ULong datasz) {
 
   // Note: g->outputFragmentSize() == 0 implies that the full message
   //       size has been pre-calculated and no GIOP Fragment should be
@@ -1625,7 +1627,7 @@ giopImpl11::outputFlush(giopStream* g,CORBA::Boolean knownFragmentSize) {
   }
 
   g->pd_currentOutputBuffer->last = g->pd_currentOutputBuffer->start + fsz;
-  g->sendChunk(g->pd_currentOutputBuffer);
+  g->sendChunk(g->pd_currentOutputBuffer,data,datasz);
 
   if (outbuf_begin & 0x7) {
     // start has previously been changed to non 8-bytes aligned
@@ -1741,9 +1743,9 @@ giopImpl11::copyOutputData(giopStream* g,void* b, size_t sz,
       *((CORBA::ULong*)((omni::ptr_arith_t)outbuf_begin + 8)) = fsz;
     }
 
-    outputFlush(g,1);
-
-    g->sendCopyChunk(b,sz);
+    // Send the fragment so far and the application's data together,
+    // straight from where they are.
+    outputFlush(g,1,b,sz);
 
     if (g->outputFragmentSize()) {
       size_t leftover = (newmkr + sz) % 0x7;
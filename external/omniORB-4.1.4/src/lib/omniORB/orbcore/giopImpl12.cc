@@ -211,7 +211,8 @@ public:
 
   static void inputNewServerMessage(giopStream* g);
 
-  static void inputQueueMessage(giopStream*,giopStream_Buffer*);
+  static void inputQueueMessage(giopStream*,giopStream_Buffer*,
+				CORBA::Boolean handOff=0);
 
   static void inputReplyBegin(giopStream*, 
 			      void (*unmarshalHeader)(giopStream*));
@@ -230,7 +231,8 @@ public:
 
   static void outputNewMessage(giopStream* g);
 
-  static void outputFlush(giopStream* g,CORBA::Boolean knownFragmentSize=0);
+  static void outputFlush(giopStream* g,CORBA::Boolean knownFragmentSize=0,
+			  void* data=0,CORBA::ULong datasz=0);
 
   static void outputSetFragmentSize(giopStream*,CORBA::ULong);
 
@@ -253,10 +255,17 @@ giopImpl12::outputHasReachedLimit(giopStream* g) {
 
 ////////////////////////////////////////////////////////////////////////
 void
-giopImpl12::inputQueueMessage(giopStream* g,giopStream_Buffer* b) {
+giopImpl12::inputQueueMessage(giopStream* g,giopStream_Buffer* b,
+			      CORBA::Boolean handOff) {
 
   // On entry, this function owns the giopStream_Buffer. On exit, the
   // buffer has either been assigned to another owner or deleted.
+  //
+  // If <handOff> is true, the caller is waiting for a reply of its own
+  // and has not started reading it. If the message is a large reply for
+  // another caller, the read lock may then be passed to that caller so
+  // that it reads the rest of its reply itself. The caller must check
+  // g->pd_rdlocked on return.
 
   unsigned char* hdr = (unsigned char*)b + b->start;
   GIOP::MsgType mtype = (GIOP::MsgType)hdr[7];
@@ -329,14 +338,14 @@ giopImpl12::inputQueueMessage(giopStream* g,giopStream_Buffer* b) {
   giopStream*    matched_target = 0;
   CORBA::Boolean matched_target_is_client = 0;
 
-  omniTransportLock->lock();
+  g->pd_strand->mutex->lock();
 
   // Look at clients
   switch (mtype) {
   case GIOP::Reply:
   case GIOP::LocateReply:
     if (!(g->pd_strand->isClient() || g->pd_strand->biDir)) {
-      omniTransportLock->unlock();
+      g->pd_strand->mutex->unlock();
       giopStream_Buffer::deleteBuffer(b);
       inputTerminalProtocolError(g, __FILE__, __LINE__,
 				 "Server received an invalid reply message");
@@ -345,54 +354,47 @@ giopImpl12::inputQueueMessage(giopStream* g,giopStream_Buffer* b) {
     // falls through
   case GIOP::Fragment:
     {
-      // search for a matching id in clients.
+      // look up the call waiting for this request id.
 
-      giopStreamList* gp = g->pd_strand->clients.next;
-      for (; gp != &g->pd_strand->clients; gp = gp->next) {
+      GIOP_C* target = g->pd_strand->findCall(reqid);
+      if (target) {
 
-	GIOP_C* target = (GIOP_C*)gp;
-
-	if (target->state() != IOP_C::UnUsed && 
-	    target->requestId() == reqid) {
+	// sanity check
+	if (target->inputFullyBuffered()) {
+	  // a reply has already been received!
+	  g->pd_strand->mutex->unlock();
+	  giopStream_Buffer::deleteBuffer(b);
+	  inputTerminalProtocolError(g, __FILE__, __LINE__,
+				     "Message claims to belong to a "
+				     "completed reply");
+	  // never reach here
+	}
 
-	  // sanity check
-	  if (target->inputFullyBuffered()) {
-	    // a reply has already been received!
-	    omniTransportLock->unlock();
+	if (target->inputMatchedId()) {
+	  if (mtype != GIOP::Fragment) {
+	    // already got the header
+	    g->pd_strand->mutex->unlock();
 	    giopStream_Buffer::deleteBuffer(b);
 	    inputTerminalProtocolError(g, __FILE__, __LINE__,
-				       "Message claims to belong to a "
-				       "completed reply");
+				       "Reply header has already been "
+				       "received");
 	    // never reach here
 	  }
-
-	  if (target->inputMatchedId()) {
-	    if (mtype != GIOP::Fragment) {
-	      // already got the header
-	      omniTransportLock->unlock();
-	      giopStream_Buffer::deleteBuffer(b);
-	      inputTerminalProtocolError(g, __FILE__, __LINE__,
-					 "Reply header has already been "
-					 "received");
-	      // never reach here
-	    }
-	  }
-	  else if (mtype == GIOP::Fragment) {
-	    // receive body before the header
-	    omniTransportLock->unlock();
-	    giopStream_Buffer::deleteBuffer(b);
-	    inputTerminalProtocolError(g, __FILE__, __LINE__,
-				       "Reply header not seen for message "
-				       "fragment");
-	    // never reach here
-	  }
-	  else {
-	    target->inputMatchedId(1);
-	  }
-	  matched_target = (giopStream*)target;
-	  matched_target_is_client = 1;
-	  break;
 	}
+	else if (mtype == GIOP::Fragment) {
+	  // receive body before the header
+	  g->pd_strand->mutex->unlock();
+	  giopStream_Buffer::deleteBuffer(b);
+	  inputTerminalProtocolError(g, __FILE__, __LINE__,
+				     "Reply header not seen for message "
+				     "fragment");
+	  // never reach here
+	}
+	else {
+	  target->inputMatchedId(1);
+	}
+	matched_target = (giopStream*)target;
+	matched_target_is_client = 1;
       }
     }
   default:
@@ -407,7 +409,7 @@ giopImpl12::inputQueueMessage(giopStream* g,giopStream_Buffer* b) {
     case GIOP::LocateRequest:
       {
 	if (g->pd_strand->isClient() && !g->pd_strand->biDir) {
-	  omniTransportLock->unlock();
+	  g->pd_strand->mutex->unlock();
 	  giopStream_Buffer::deleteBuffer(b);
 	  inputTerminalProtocolError(g, __FILE__, __LINE__,
 				     "Request message received by client");
@@ -424,7 +426,7 @@ giopImpl12::inputQueueMessage(giopStream* g,giopStream_Buffer* b) {
 	  }
 	  else if (target->requestId() == reqid) {
 	    // already have a request with the same id.
-	    omniTransportLock->unlock();
+	    g->pd_strand->mutex->unlock();
 	    giopStream_Buffer::deleteBuffer(b);
 	    inputTerminalProtocolError(g, __FILE__, __LINE__,
 				       "Duplicate request id");
@@ -443,7 +445,7 @@ giopImpl12::inputQueueMessage(giopStream* g,giopStream_Buffer* b) {
       // falls through
     case GIOP::CancelRequest:
       if (g->pd_strand->isClient() && !g->pd_strand->biDir) {
-	omniTransportLock->unlock();
+	g->pd_strand->mutex->unlock();
 	giopStream_Buffer::deleteBuffer(b);
 	inputTerminalProtocolError(g, __FILE__, __LINE__,
 				   "Client received a CancelRequest message");
@@ -465,7 +467,7 @@ giopImpl12::inputQueueMessage(giopStream* g,giopStream_Buffer* b) {
 	    // sanity check
 	    if (target->inputFullyBuffered()) {
 	      // a reply has already been received!
-	      omniTransportLock->unlock();
+	      g->pd_strand->mutex->unlock();
 	      giopStream_Buffer::deleteBuffer(b);
 	      inputTerminalProtocolError(g, __FILE__, __LINE__,
 					 "Message claims to belong to a "
@@ -482,7 +484,7 @@ giopImpl12::inputQueueMessage(giopStream* g,giopStream_Buffer* b) {
       break;
     }
   }
-  omniTransportLock->unlock();
+  g->pd_strand->mutex->unlock();
 
   if (matched_target) {
 
@@ -497,13 +499,47 @@ giopImpl12::inputQueueMessage(giopStream* g,giopStream_Buffer* b) {
     }
 
     OMNIORB_ASSERT(matched_target->pd_currentInputBuffer == 0);
+
+    CORBA::ULong fetchsz = b->size - (b->last - b->start);
+
+    if (handOff && matched_target_is_client && mtype == GIOP::Reply &&
+	fetchsz >= giopStream::handOffReadCutOff) {
+
+      // Rather than staging the rest of the reply in buffers and having
+      // the caller copy it out again, hand the read lock over to the
+      // caller. It unmarshals the reply as if it had read the header
+      // itself, so a large octet sequence is received straight into
+      // the sequence's own storage. This is only done if the caller is
+      // blocked waiting for its reply; a caller that has given up (or
+      // not yet sent its whole request) must not end up owning a
+      // partly read message.
+      omni_tracedmutex_lock sync(*g->pd_strand->mutex);
+
+      GIOP_C* target = (GIOP_C*)matched_target;
+      if (target->state() == IOP_C::WaitingForReply &&
+	  g->pd_strand->isReplyWaiter(target)) {
+
+	OMNIORB_ASSERT(matched_target->pd_input == 0);
+	OMNIORB_ASSERT(g->pd_rdlocked && !matched_target->pd_rdlocked);
+	matched_target->pd_input = b;
+	matched_target->pd_rdlocked = 1;
+	g->pd_rdlocked = 0;
+	g->pd_strand->wakeUpReplyWaiter(target);
+
+	if (omniORB::trace(25)) {
+	  omniORB::logger log;
+	  log << "Pass read lock to the caller of request id " << reqid
+	      << " to receive the remaining " << fetchsz << " bytes.\n";
+	}
+	return;
+      }
+    }
+
     giopStream_Buffer** pp = &matched_target->pd_input;
     while (*pp) {
       pp = &((*pp)->next);
     }
     *pp = b;
-
-    CORBA::ULong fetchsz = b->size - (b->last - b->start);
     while (fetchsz) {
       // fetch the rest of the message;
       giopStream_Buffer* p = g->inputChunk(fetchsz);
@@ -520,13 +556,19 @@ giopImpl12::inputQueueMessage(giopStream* g,giopStream_Buffer* b) {
     }
     else if (isfull) {
       {
-	omni_tracedmutex_lock sync(*omniTransportLock);
+	omni_tracedmutex_lock sync(*g->pd_strand->mutex);
 	matched_target->inputFullyBuffered(isfull);
 
 	if (!matched_target_is_client)
 	  ((GIOP_S*)matched_target)->state(IOP_S::InputFullyBuffered);
 
-	giopStream::wakeUpRdLock(g->pd_strand);
+	if (matched_target_is_client && !g->pd_strand->biDir) {
+	  // Only the caller waiting for this reply needs to run.
+	  g->pd_strand->wakeUpReplyWaiter((GIOP_C*)matched_target);
+	}
+	else {
+	  giopStream::wakeUpRdLock(g->pd_strand);
+	}
       }
       if (!matched_target_is_client) {
 	omniORB::logs(25, "Changed GIOP_S to InputFullyBuffered");
@@ -665,8 +707,9 @@ void
 giopImpl12::inputReplyBegin(giopStream* g, 
 			    void (*unmarshalHeader)(giopStream*)) {
 
+ wait_for_reply:
   {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
 
     if (!g->pd_strand->biDir) {
 
@@ -714,7 +757,11 @@ giopImpl12::inputReplyBegin(giopStream* g,
   again:
     if (!g->pd_input) {
       giopStream_Buffer* p = g->inputMessage();
-      inputQueueMessage(g,p);
+      inputQueueMessage(g,p,!g->pd_strand->biDir);
+      if (!g->pd_rdlocked && !g->pd_input) {
+	// The read lock has been passed to another caller.
+	goto wait_for_reply;
+      }
       goto again;
     }
     else {
@@ -741,6 +788,16 @@ giopImpl12::inputReplyBegin(giopStream* g,
 			 (g->pd_currentInputBuffer->last -
 			  g->pd_currentInputBuffer->start));
 
+  if (g->pd_rdlocked &&
+      !(g->inputExpectAnotherFragment() || g->inputFragmentToCome())) {
+    // The whole reply is already in our buffer. If other callers are
+    // waiting for replies on this strand, give up the read lock now so
+    // that one of them can carry on reading while we unmarshal.
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
+    if (g->pd_strand->rd_nwaiting < -1)
+      g->rdUnLock();
+  }
+
   unmarshalHeader(g);
 
   if (g->inputMessageSize() > orbParameters::giopMaxMsgSize) {
@@ -761,7 +818,7 @@ giopImpl12::inputMessageBegin(giopStream* g,
   }
 
   {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
 
     if (!(g->inputFullyBuffered() || g->pd_rdlocked)) {
       g->rdLock();
@@ -901,7 +958,7 @@ giopImpl12::inputMessageEnd(giopStream* g,CORBA::Boolean disgard) {
   }
 
   if (g->pd_rdlocked) {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->rdUnLock();
   }
 }
@@ -1386,7 +1443,7 @@ void
 giopImpl12::outputNewMessage(giopStream* g) {
 
   if (!g->pd_wrlocked) {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->wrLock();
   }
 
@@ -1465,7 +1522,7 @@ giopImpl12::outputMessageEnd(giopStream* g) {
   }
 
   {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->wrUnLock();
   }
 
@@ -1477,7 +1534,7 @@ giopImpl12::sendMsgErrorMessage(giopStream* g,
 				const CORBA::SystemException* ex) {
 
   if (!g->pd_wrlocked) {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->wrLock();
   }
 
@@ -1522,7 +1579,7 @@ giopImpl12::sendMsgErrorMessage(giopStream* g,
   g->pd_strand->state(giopStrand::DYING);
 
   {
-    omni_tracedmutex_lock sync(*omniTransportLock);
+    omni_tracedmutex_lock sync(*g->pd_strand->mutex);
     g->wrUnLock();
   }
 }
@@ -1995,7 +2052,8 @@ giopImpl12::outputRemaining(const giopStream* g) {
 
 ////////////////////////////////////////////////////////////////////////
 void
-giopImpl12::outputFlush(giopStream* g,CORBA::Boolean knownFragmentSize) {
+giopImpl12::outputFlush(giopStream* g,CORBA::Boolean knownFragmentSize,
+			void* data,CORBA::ULong datasz) {
 
   // Note: g->outputFragmentSize() != 0 implies that the full message
   //       size has been pre-calculated and no GIOP Fragment should be
@@ -2045,7 +2103,7 @@ giopImpl12::outputFlush(giopStream* g,CORBA::Boolean knownFragmentSize) {
   }
 
   g->pd_currentOutputBuffer->last = g->pd_currentOutputBuffer->start + fsz;
-  g->sendChunk(g->pd_currentOutputBuffer);
+  g->sendChunk(g->pd_currentOutputBuffer,data,datasz);
 
   if (outbuf_begin & 0x7) {
     // start has previously been changed to non 8-bytes aligned
@@ -2166,9 +2224,9 @@ giopImpl12::copyOutputData(giopStream* g,void* b, size_t sz,
       *((CORBA::ULong*)((omni::ptr_arith_t)outbuf_begin + 8)) = fsz;
     }
 
-    outputFlush(g,1);
-
-    g->sendCopyChunk(b,sz - leftover);
+    // Send the fragment so far and the application's data together,
+    // straight from where they are.
+    outputFlush(g,1,b,sz - leftover);
 
     if (leftover) {
       if (outputHasReachedLimit(g)) {
@@ -51,12 +51,14 @@
 #include <invoker.h>
 #include <giopServer.h>
 #include <giopMonitor.h>
+#include <metrics.h>
 
 OMNI_NAMESPACE_BEGIN(omni)
 
 void
 giopMonitor::notifyReadable(void* this_,giopConnection* conn) {
   giopMonitor* m = (giopMonitor*)this_;
+  omniMetricsP::add(omniMetricsP::connectionsReadable,1);
   m->pd_server->notifyRzReadable(conn);
 }
 
@@ -155,6 +155,7 @@
 #include <orbOptions.h>
 #include <orbParameters.h>
 #include <transportRules.h>
+#include <metrics.h>
 #include <omniORB4/callDescriptor.h>
 
 #include <stdlib.h>
@@ -169,6 +170,16 @@ CORBA::Boolean orbParameters::oneCallPerConnection = 1;
 //
 //  Valid values = 0 or 1
 
+CORBA::Boolean orbParameters::multiplexGIOP12Calls = 1;
+//  1 means that when oneCallPerConnection is 1 and all
+//  maxGIOPConnectionPerServer connections to a server are busy, a
+//  GIOP 1.2 call is multiplexed onto the least busy connection
+//  rather than waiting for one to become free. 0 means such calls
+//  block. Has no effect if oneCallPerConnection is 0, or for
+//  GIOP 1.0 and 1.1 calls, which always wait.
+//
+//  Valid values = 0 or 1
+
 CORBA::ULong orbParameters::maxGIOPConnectionPerServer = 5;
 //  The ORB could open more than one connections to a server
 //  depending on the number of concurrent invocations to the same
@@ -182,18 +193,43 @@ CORBA::ULong orbParameters::maxGIOPConnectionPerServer = 5;
 
 
 ///////////////////////////////////////////////////////////////////////
-RopeLink giopRope::ropes;
+giopRope**   giopRope::ropeTable       = 0;
+CORBA::ULong giopRope::ropeTableSize   = 0;
+int          giopRope::ropeTableSizeI  = -1;
+CORBA::ULong giopRope::numRopesInTable = 0;
+CORBA::ULong giopRope::maxNumRopes     = 0;
+
+// Sizes of the rope table. As with the object table, the table is
+// grown when it becomes 2/3 full.
+static int ropeTblSizes[] = {
+  128 + 3,              // 2^7
+  1024 + 9,             // 2^10
+  8192 + 27,            // 2^13
+  32768 + 3,            // 2^15
+  65536 + 45,           // 2^16
+  131072 + 9,
+  262144 + 39,
+  524288 + 39,
+  1048576 + 9,          // 2^20
+  -1                    // Sentinel to detect the end.
+};
 
 ////////////////////////////////////////////////////////////////////////
 giopRope::giopRope(const giopAddressList& addrlist,
-		   const omnivector<CORBA::ULong>& preferred) :
+		   const omnivector<CORBA::ULong>& preferred,
+		   CORBA::Boolean sharedLock) :
+  pd_lock(sharedLock ? omniTransportLock : &pd_ownLock),
   pd_refcount(0),
+  pd_nstrands(0),
   pd_address_in_use(0),
   pd_maxStrands(orbParameters::maxGIOPConnectionPerServer),
   pd_oneCallPerConnection(orbParameters::oneCallPerConnection),
   pd_nwaiting(0),
-  pd_cond(omniTransportLock),
-  pd_offerBiDir(orbParameters::offerBiDirectionalGIOP)
+  pd_cond(pd_lock),
+  pd_offerBiDir(orbParameters::offerBiDirectionalGIOP),
+  pd_hashValue(0),
+  pd_nextInRopeTable(0),
+  pd_inRopeTable(0)
 {
   {
     giopAddressList::const_iterator i, last;
@@ -213,25 +249,38 @@ giopRope::giopRope(const giopAddressList& addrlist,
       pd_addresses_order.push_back(*i);
     }
   }
+  pd_hashValue = hashAddresses(pd_addresses);
+  omniMetricsP::incr(omniMetricsP::ropes);
 }
 
 
 ////////////////////////////////////////////////////////////////////////
-giopRope::giopRope(giopAddress* addr,int initialRefCount) :
+giopRope::giopRope(giopAddress* addr,int initialRefCount,
+		   CORBA::Boolean sharedLock) :
+  pd_lock(sharedLock ? omniTransportLock : &pd_ownLock),
   pd_refcount(initialRefCount),
+  pd_nstrands(0),
   pd_address_in_use(0),
   pd_maxStrands(orbParameters::maxGIOPConnectionPerServer),
   pd_oneCallPerConnection(orbParameters::oneCallPerConnection),
   pd_nwaiting(0),
-  pd_cond(omniTransportLock)
+  pd_cond(pd_lock),
+  pd_hashValue(0),
+  pd_nextInRopeTable(0),
+  pd_inRopeTable(0)
 {
   pd_addresses.push_back(addr);
   pd_addresses_order.push_back(0);
+  pd_hashValue = hashAddresses(pd_addresses);
+  omniMetricsP::incr(omniMetricsP::ropes);
 }
 
 ////////////////////////////////////////////////////////////////////////
 giopRope::~giopRope() {
   OMNIORB_ASSERT(pd_nwaiting == 0);
+  OMNIORB_ASSERT(pd_nstrands == 0);
+  OMNIORB_ASSERT(!pd_inRopeTable);
+  omniMetricsP::decr(omniMetricsP::ropes);
   giopAddressList::iterator i, last;
   i    = pd_addresses.begin();
   last = pd_addresses.end();
@@ -254,9 +303,9 @@ giopRope::acquireClient(const omniIOR* ior,
     v = impl->version();
   }
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,0);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_lock,0);
 
-  omni_tracedmutex_lock sync(*omniTransportLock);
+  omni_tracedmutex_lock sync(*pd_lock);
 
  again:
 
@@ -285,9 +334,7 @@ giopRope::acquireClient(const omniIOR* ior,
       }
     case giopStrand::TIMEDOUT:
       {
-	s->StrandList::remove();
 	s->state(giopStrand::ACTIVE);
-	s->StrandList::insert(giopStrand::active);
 	// falls through
       }
     case giopStrand::ACTIVE:
@@ -303,13 +350,13 @@ giopRope::acquireClient(const omniIOR* ior,
 	else {
 	  GIOP_C* g;
 	  if (!giopStreamList::is_empty(s->clients)) {
-	    giopStreamList* gp = s->clients.next;
-	    for (; gp != &s->clients; gp = gp->next) {
-	      g = (GIOP_C*)gp;
-	      if (g->state() == IOP_C::UnUsed) {
-		g->initialise(ior,key,keysize,calldesc);
-		return g;
-	      }
+	    // releaseClient() only keeps an idle GIOP_C when it is the
+	    // last one on the strand, so if there is one it is at the
+	    // head of the list. No need to walk past busy calls.
+	    g = (GIOP_C*)s->clients.next;
+	    if (g->state() == IOP_C::UnUsed) {
+	      g->initialise(ior,key,keysize,calldesc);
+	      return g;
 	    }
 	    nbusy++;
 	  }
@@ -345,20 +392,29 @@ giopRope::acquireClient(const omniIOR* ior,
       OMNIORB_THROW(TRANSIENT,TRANSIENT_NoUsableProfile,CORBA::COMPLETED_NO);
     }
 
-    giopStrand* s = new giopStrand(pd_addresses[pd_addresses_order[pd_address_in_use]]);
+    giopStrand* s = new giopStrand(pd_addresses[pd_addresses_order[pd_address_in_use]],
+				   this);
     s->state(giopStrand::ACTIVE);
     s->RopeLink::insert(pd_strands);
-    s->StrandList::insert(giopStrand::active);
     s->version = v;
     s->giopImpl = impl;
   }
-  else if (pd_oneCallPerConnection || ndying >= max) {
-    // Wait for a strand to be unused.
+  else if ((pd_oneCallPerConnection &&
+	    !((calldesc->asyncCall() || orbParameters::multiplexGIOP12Calls) &&
+	      (v.major > 1 || v.minor >= 2))) ||
+	   ndying >= max) {
+    // Wait for a strand to be unused. Once the rope has all the
+    // strands it may open, GIOP 1.2 calls are multiplexed onto a busy
+    // one even if the rope is limited to one call per connection,
+    // unless multiplexGIOP12Calls is false. An asynchronous call is
+    // always multiplexed, since otherwise each call in flight would
+    // need a connection of its own.
     pd_nwaiting++;
     unsigned long deadline_secs,deadline_nanosecs;
     calldesc->getDeadline(deadline_secs,deadline_nanosecs);
     if (deadline_secs || deadline_nanosecs) {
-      if (pd_cond.timedwait(deadline_secs,deadline_nanosecs) == 0) {
+      if (omniTimerWheel::timedwait(pd_cond,*pd_lock,
+				    deadline_secs,deadline_nanosecs) == 0) {
 	pd_nwaiting--;
 	OMNIORB_THROW(TRANSIENT,TRANSIENT_CallTimedout,CORBA::COMPLETED_NO);
       }
@@ -369,29 +425,23 @@ giopRope::acquireClient(const omniIOR* ior,
     pd_nwaiting--;
   }
   else {
-    // Pick a random non-dying strand.
+    // Multiplex the call onto the non-dying strand with the fewest
+    // calls outstanding. From GIOP 1.2 onwards the request is sent
+    // straight away and the reply is matched up by its request id, so
+    // the call does not have to wait for the others to complete.
     OMNIORB_ASSERT(nbusy);  // There must be a non-dying strand that can
                             // serve this GIOP version
-    int n = rand() % nbusy;
-    // Pick a random and non-dying strand
-    RopeLink* p = pd_strands.next;
-    giopStrand* q = 0;
     giopStrand* s = 0;
-    while (n >=0 && p != &pd_strands) {
-      s = (giopStrand*)p;
-      if (s->state() == giopStrand::ACTIVE &&
-	  s->version.major == v.major &&
-	  s->version.minor == v.minor)
-	{
-	  n--;
-	  if (!q) q = s;
-	}
-      else {
-	s = 0;
+    RopeLink* p = pd_strands.next;
+    for (; p != &pd_strands; p = p->next) {
+      giopStrand* q = (giopStrand*)p;
+      if (q->state() == giopStrand::ACTIVE &&
+	  q->version.major == v.major &&
+	  q->version.minor == v.minor &&
+	  (!s || q->outstandingCalls() < s->outstandingCalls())) {
+	s = q;
       }
-      p = p->next;
     }
-    s = (s) ? s : q;
     // By the time we look for busy strands, it's possible that they
     // are all dying, in which case we have to start again.
     if (s) {
@@ -409,9 +459,9 @@ giopRope::acquireClient(const omniIOR* ior,
 void
 giopRope::releaseClient(IOP_C* iop_c) {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,0);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_lock,0);
 
-  omni_tracedmutex_lock sync(*omniTransportLock);
+  omni_tracedmutex_lock sync(*pd_lock);
 
   GIOP_C* giop_c = (GIOP_C*) iop_c;
 
@@ -436,6 +486,7 @@ giopRope::releaseClient(IOP_C* iop_c) {
 
   giopStrand* s = &((giopStrand&)(*(giopStream*)giop_c));
   giop_c->giopStreamList::remove();
+  s->removeCall(giop_c);
 
   CORBA::Boolean remove = 0;
   CORBA::Boolean avail = 1;
@@ -504,18 +555,18 @@ giopRope::realIncrRefCount() {
 
   OMNIORB_ASSERT(pd_refcount >= 0);
 
-  if (pd_refcount == 0 && !RopeLink::is_empty(pd_strands)) {
-    // This Rope still has some strands in the giopStrand::active_timedout list
-    // put there by decrRefCount() when the reference count goes to 0
-    // previously. We move these stands back to the giopStrand::active list so
-    // that they can be used straight away.
+  if (pd_refcount == 0) {
+    // This Rope may still have some strands marked TIMEDOUT by
+    // decrRefCount() when the reference count went to 0 previously. We
+    // mark them ACTIVE again so that they can be used straight away.
+    CORBA::Boolean shared = (pd_lock == omniTransportLock);
+    omni_optional_lock sync(*pd_lock,shared,shared);
+
     RopeLink* p = pd_strands.next;
     for (; p != &pd_strands; p = p->next) {
       giopStrand* g = (giopStrand*)p;
       if (g->state() != giopStrand::DYING) {
-	g->StrandList::remove();
 	g->state(giopStrand::ACTIVE);
-	g->StrandList::insert(giopStrand::active);
       }
     }
   }
@@ -545,29 +596,75 @@ giopRope::decrRefCount() {
 
   // This Rope is not used by any object reference.
   // If this rope has no strand, we can remove this instance straight away.
-  // Otherwise, we move all the strands from the giopStrand::active list to
-  // the giopStrand::active_timedout list. Eventually when all the strands are
-  // retired by time out, this instance will also be deleted.
-
-  if (RopeLink::is_empty(pd_strands) && !pd_nwaiting) {
-    RopeLink::remove();
-    delete this;
+  // Otherwise, we mark all the strands as TIMEDOUT. Eventually when all
+  // the strands are retired by time out, the scavenger deletes this
+  // instance.
+  if (isGarbage()) {
+    deleteRope(this);
+    return;
   }
-  else {
-    RopeLink* p = pd_strands.next;
-    for (; p != &pd_strands; p = p->next) {
-      giopStrand* g = (giopStrand*)p;
-      if (g->state() != giopStrand::DYING) {
-	g->state(giopStrand::TIMEDOUT);
-	// The strand may already be on the active_timedout list. However
-	// it is OK to remove and reinsert again.
-	g->StrandList::remove();
-	g->StrandList::insert(giopStrand::active_timedout);
-      }
+
+  CORBA::Boolean shared = (pd_lock == omniTransportLock);
+  omni_optional_lock rsync(*pd_lock,shared,shared);
+
+  RopeLink* p = pd_strands.next;
+  for (; p != &pd_strands; p = p->next) {
+    giopStrand* g = (giopStrand*)p;
+    if (g->state() != giopStrand::DYING) {
+      g->state(giopStrand::TIMEDOUT);
     }
   }
 }
 
+////////////////////////////////////////////////////////////////////////
+// Strands are deleted with different locks held on different paths,
+// and the scavenger deletes them with none, so the count of strands is
+// updated atomically.
+#if defined(__GNUC__)
+#  define ROPE_NSTRANDS_ADD(p,v) __sync_add_and_fetch(p,v)
+#else
+static omni_tracedmutex nstrandsLock;
+
+static inline int
+ropeNstrandsAdd(volatile int* p, int v)
+{
+  omni_tracedmutex_lock sync(nstrandsLock);
+  return *p += v;
+}
+#  define ROPE_NSTRANDS_ADD(p,v) ropeNstrandsAdd(p,v)
+#endif
+
+////////////////////////////////////////////////////////////////////////
+void
+giopRope::strandCreated() {
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_lock,1);
+
+  ROPE_NSTRANDS_ADD(&pd_nstrands, 1);
+}
+
+////////////////////////////////////////////////////////////////////////
+void
+giopRope::strandDeleted() {
+  int n = ROPE_NSTRANDS_ADD(&pd_nstrands, -1);
+  OMNIORB_ASSERT(n >= 0);
+}
+
+////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+giopRope::isGarbage() {
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+
+  if (pd_refcount)
+    return 0;
+
+  CORBA::Boolean shared = (pd_lock == omniTransportLock);
+  omni_optional_lock rsync(*pd_lock,shared,shared);
+
+  return (RopeLink::is_empty(pd_strands) &&
+	  !pd_nwaiting &&
+	  ROPE_NSTRANDS_ADD(&pd_nstrands, 0) == 0);
+}
+
 
 ////////////////////////////////////////////////////////////////////////
 CORBA::Boolean
@@ -588,11 +685,11 @@ giopRope::notifyCommFailure(const giopAddress* addr,
 			    CORBA::Boolean heldlock) {
 
   if (heldlock) {
-    ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+    ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_lock,1);
   }
   else {
-    ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,0);
-    omniTransportLock->lock();
+    ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_lock,0);
+    pd_lock->lock();
   }
 
   const giopAddress* addr_in_use;
@@ -611,7 +708,7 @@ giopRope::notifyCommFailure(const giopAddress* addr,
   }
 
   if (!heldlock) {
-    omniTransportLock->unlock();
+    pd_lock->unlock();
   }
   return addr_in_use;
 }
@@ -645,24 +742,22 @@ giopRope::selectRope(const giopAddressList& addrlist,
   giopRope* gr;
 
   // Check if there already exists a rope that goes to the same addresses
-  RopeLink* p = giopRope::ropes.next;
-  while ( p != &giopRope::ropes ) {
-    gr = (giopRope*)p;
-    if (gr->match(addrlist)) {
-      gr->realIncrRefCount();
-      r = (Rope*)gr; loc = 0;
-      return 1;
-    }
-    else if (gr->pd_refcount == 0 &&
-	     RopeLink::is_empty(gr->pd_strands) &&
-	     !gr->pd_nwaiting) {
-      // garbage rope, remove it
-      p = p->next;
-      gr->RopeLink::remove();
-      delete gr;
-    }
-    else {
-      p = p->next;
+  CORBA::ULong hashv = hashAddresses(addrlist);
+
+  if (ropeTableSize) {
+    gr = ropeTable[hashv % ropeTableSize];
+    while (gr) {
+      if (gr->pd_hashValue == hashv && gr->match(addrlist)) {
+	gr->realIncrRefCount();
+	r = (Rope*)gr; loc = 0;
+	return 1;
+      }
+      giopRope* next = gr->pd_nextInRopeTable;
+      if (gr->isGarbage()) {
+	// garbage rope, remove it
+	deleteRope(gr);
+      }
+      gr = next;
     }
   }
 
@@ -688,13 +783,104 @@ giopRope::selectRope(const giopAddressList& addrlist,
       gr = new giopRope(addrlist,prefer_list);
     }
   }
-  gr->RopeLink::insert(giopRope::ropes);
+  addToRopeTable(gr);
   gr->realIncrRefCount();
   r = (Rope*)gr; loc = 0;
   return 1;
 }
 
 
+////////////////////////////////////////////////////////////////////////
+void
+giopRope::addToRopeTable(giopRope* gr)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  OMNIORB_ASSERT(!gr->pd_inRopeTable);
+
+  if (numRopesInTable >= maxNumRopes) {
+    int newsizei = ropeTblSizes[ropeTableSizeI + 1];
+
+    if (newsizei == -1) {
+      // Keep the largest table and let the chains grow.
+      maxNumRopes = 0xffffffff;
+    }
+    else {
+      CORBA::ULong newsize = newsizei;
+
+      if (omniORB::trace(15)) {
+	omniORB::logger l;
+	l << "Rope table resizing from " << ropeTableSize
+	  << " to " << newsize << "\n";
+      }
+
+      giopRope** newtable = new giopRope* [newsize];
+      CORBA::ULong i;
+      for (i = 0; i < newsize; i++) newtable[i] = 0;
+
+      for (i = 0; i < ropeTableSize; i++) {
+	giopRope* r = ropeTable[i];
+	while (r) {
+	  giopRope* next = r->pd_nextInRopeTable;
+	  CORBA::ULong j = r->pd_hashValue % newsize;
+	  r->pd_nextInRopeTable = newtable[j];
+	  newtable[j] = r;
+	  r = next;
+	}
+      }
+      delete [] ropeTable;
+      ropeTable      = newtable;
+      ropeTableSize  = newsize;
+      ropeTableSizeI++;
+      maxNumRopes    = ropeTableSize * 2 / 3;
+    }
+  }
+
+  giopRope** head = ropeTable + gr->pd_hashValue % ropeTableSize;
+  gr->pd_nextInRopeTable = *head;
+  *head = gr;
+  gr->pd_inRopeTable = 1;
+  numRopesInTable++;
+}
+
+////////////////////////////////////////////////////////////////////////
+void
+giopRope::deleteRope(giopRope* gr)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  OMNIORB_ASSERT(gr->isGarbage());
+
+  if (gr->pd_inRopeTable) {
+    giopRope** p = ropeTable + gr->pd_hashValue % ropeTableSize;
+    while (*p != gr) {
+      OMNIORB_ASSERT(*p);
+      p = &((*p)->pd_nextInRopeTable);
+    }
+    *p = gr->pd_nextInRopeTable;
+    gr->pd_nextInRopeTable = 0;
+    gr->pd_inRopeTable = 0;
+    numRopesInTable--;
+  }
+  gr->RopeLink::remove();
+  delete gr;
+}
+
+////////////////////////////////////////////////////////////////////////
+CORBA::ULong
+giopRope::hashAddresses(const giopAddressList& addrlist)
+{
+  CORBA::ULong n = 0;
+
+  giopAddressList::const_iterator i, last;
+  i    = addrlist.begin();
+  last = addrlist.end();
+  for (; i != last; i++) {
+    const char* a = (*i)->address();
+    n = ((n << 5) ^ (n >> 27)) ^
+        omni::hash((const CORBA::Octet*)a, strlen(a));
+  }
+  return n;
+}
+
 ////////////////////////////////////////////////////////////////////////
 CORBA::Boolean
 giopRope::match(const giopAddressList& addrlist) const
@@ -836,6 +1022,35 @@ public:
 
 static oneCallPerConnectionHandler oneCallPerConnectionHandler_;
 
+/////////////////////////////////////////////////////////////////////////////
+class multiplexGIOP12CallsHandler : public orbOptions::Handler {
+public:
+
+  multiplexGIOP12CallsHandler() : 
+    orbOptions::Handler("multiplexGIOP12Calls",
+			"multiplexGIOP12Calls = 0 or 1",
+			1,
+			"-ORBmultiplexGIOP12Calls < 0 | 1 >") {}
+
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::Boolean v;
+    if (!orbOptions::getBoolean(value,v)) {
+      throw orbOptions::BadParam(key(),value,
+				 orbOptions::expect_boolean_msg);
+    }
+    orbParameters::multiplexGIOP12Calls = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVBoolean(key(),orbParameters::multiplexGIOP12Calls,
+			     result);
+  }
+};
+
+static multiplexGIOP12CallsHandler multiplexGIOP12CallsHandler_;
+
 /////////////////////////////////////////////////////////////////////////////
 class maxGIOPConnectionPerServerHandler : public orbOptions::Handler {
 public:
@@ -875,6 +1090,7 @@ public:
 
   omni_giopRope_initialiser() {
     orbOptions::singleton().registerHandler(oneCallPerConnectionHandler_);
+    orbOptions::singleton().registerHandler(multiplexGIOP12CallsHandler_);
     orbOptions::singleton().registerHandler(maxGIOPConnectionPerServerHandler_);
   }
 
@@ -884,20 +1100,21 @@ public:
     // Get rid of any remaining ropes. By now they should all be strand-less.
     omni_tracedmutex_lock sync(*omniTransportLock);
 
-    RopeLink* p = giopRope::ropes.next;
-    giopRope* gr;
     int i=0;
 
-    while (p != &giopRope::ropes) {
-      gr = (giopRope*)p;
-      OMNIORB_ASSERT(gr->pd_refcount == 0 &&
-		     RopeLink::is_empty(gr->pd_strands) &&
-		     !gr->pd_nwaiting);
-      p = p->next;
-      gr->RopeLink::remove();
-      delete gr;
-      ++i;
+    for (CORBA::ULong b = 0; b < giopRope::ropeTableSize; b++) {
+      while (giopRope::ropeTable[b]) {
+	giopRope::deleteRope(giopRope::ropeTable[b]);
+	++i;
+      }
     }
+    delete [] giopRope::ropeTable;
+    giopRope::ropeTable       = 0;
+    giopRope::ropeTableSize   = 0;
+    giopRope::ropeTableSizeI  = -1;
+    giopRope::numRopesInTable = 0;
+    giopRope::maxNumRopes     = 0;
+
     if (omniORB::trace(15)) {
       omniORB::logger l;
       l << i << " remaining rope" << (i == 1 ? "" : "s") << " deleted.\n";
@@ -1257,8 +1257,11 @@ giopServer::notifyWkDone(giopWorker* w, CORBA::Boolean exit_on_error)
     // This connection is managed with the thread-pool policy.
 
     OMNIORB_ASSERT(w->singleshot() == 1); // Never called by a dedicated thread
-    CORBA::Boolean select_and_return = 0;
-    {
+
+    // This part is only a hint, so look at the counts without holding
+    // pd_lock. The workers limit flag is tested again under the lock
+    // below, so if we miss it here the request is still picked up.
+    if (conn->pd_has_hit_n_workers_limit) {
       omni_tracedmutex_lock sync(pd_lock);
 
       if (conn->pd_has_hit_n_workers_limit) {
@@ -1268,17 +1271,23 @@ giopServer::notifyWkDone(giopWorker* w, CORBA::Boolean exit_on_error)
 	conn->pd_has_hit_n_workers_limit = 0;
 	return 1;
       }
-
-      // If there are other workers for this connection, or there are
-      // too many temporary workers, let this worker finish.
-
-      if (conn->pd_n_workers > orbParameters::threadPoolWatchConnection ||
-	  pd_n_temporary_workers > orbParameters::maxServerThreadPoolSize) {
-
-	select_and_return = 1;
-      }
     }
 
+    // If there are other workers for this connection, or there are
+    // too many temporary workers, let this worker finish.
+    //
+    // The counts are read without pd_lock, so they may be stale. That
+    // is harmless: they only decide whether this worker watches the
+    // connection with Peek() before finishing, or finishes straight
+    // away. Either way, the workers limit and the dying flag are
+    // checked again under pd_lock before the worker is removed, and a
+    // request that arrives later is noticed by the select loop once
+    // the connection is selectable again.
+    CORBA::Boolean select_and_return =
+      ((CORBA::ULong)conn->pd_n_workers >
+         orbParameters::threadPoolWatchConnection ||
+       pd_n_temporary_workers > orbParameters::maxServerThreadPoolSize);
+
     if (!select_and_return) {
       // Call Peek(). This thread will be used for a short time to
       // monitor the connection. We can probably afford to call Peek()
@@ -148,6 +148,8 @@
 #include <invoker.h>
 #include <orbOptions.h>
 #include <orbParameters.h>
+#include <remoteIdentity.h>
+#include <metrics.h>
 
 OMNI_NAMESPACE_BEGIN(omni)
 
@@ -155,31 +157,50 @@ OMNI_NAMESPACE_BEGIN(omni)
 //             Configuration options                                      //
 ////////////////////////////////////////////////////////////////////////////
 CORBA::ULong orbParameters::scanGranularity = 5;
-//  The granularity at which the ORB scan for idle connections.
-//  This value determines the minimum value that inConScanPeriod or
-//  outConScanPeriod can be implemented.
+//  Idle connections are closed when their idle timers expire, with
+//  millisecond resolution, so the value no longer matters other than
+//  to switch that off. Kept for compatibility.
 //
 //  Valid values = (n >= 0 in seconds) 
-//                  0 --> do not scan for idle connections.
+//                  0 --> do not close idle connections.
 
 CORBA::ULong orbParameters::outConScanPeriod = 120;
-//  Idle connections shutdown. The ORB periodically scans all the
-//  outgoing connections to detect if they are idle.
-//  If no operation has passed through a connection for a scan period,
-//  the ORB would treat this connection idle and shut it down.
+//  Idle connections shutdown. If no operation has passed through an
+//  outgoing connection for this period, the ORB treats the connection
+//  as idle and shuts it down.
 //
 //  Valid values = (n >= 0 in seconds) 
 //                  0 --> do not close idle connections.
 
 CORBA::ULong orbParameters::inConScanPeriod = 180;
-//  Idle connections shutdown. The ORB periodically scans all the
-//  incoming connections to detect if they are idle.
-//  If no operation has passed through a connection for a scan period,
-//  the ORB would treat this connection idle and shut it down.
+//  Idle connections shutdown. If no operation has passed through an
+//  incoming connection for this period, the ORB treats the connection
+//  as idle and shuts it down.
 //
 //   Valid values = (n >= 0 in seconds) 
 //                   0 --> do not close idle connections.
 
+CORBA::Boolean orbParameters::onewayCoalesce = 0;
+//  1 means oneway requests are held back for up to onewayCoalesceWindow
+//  and written to the connection together with the requests that
+//  follow them. Can be overridden per object reference with
+//  omniORB::setClientOnewayCoalescing().
+//
+//  Valid values = 0 or 1
+
+CORBA::ULong orbParameters::onewayCoalesceSize = 8192;
+//  Coalesced oneway requests are written as soon as they add up to
+//  this many bytes.
+//
+//  Valid values = (n >= 1 in bytes)
+
+CORBA::ULong orbParameters::onewayCoalesceWindow = 100;
+//  Coalesced oneway requests are written no later than this long after
+//  the first of them, if no other message has been sent on the
+//  connection by then.
+//
+//  Valid values = (n >= 1 in microseconds)
+
 ////////////////////////////////////////////////////////////////////////
 class Scavenger : public omniTask {
 public:
@@ -190,6 +211,12 @@ public:
 
   static void notify();
 
+  static CORBA::Boolean expired(giopStrand*);
+  // Take the strand, whose idle timer has expired, off its rope or
+  // the passive list and queue it to be closed. Returns false, having
+  // done nothing, if <mutex> is held by another thread.
+  // Caller must hold the strand's mutex.
+
   static void terminate();
 
   static void initialise();
@@ -199,8 +226,46 @@ private:
   static omni_tracedmutex*       mutex;
   static omni_tracedcondition*	 cond;
   static Scavenger*              theTask;
+  static StrandList              clientList;
+  // Client strands queued to be closed. Protected by <mutex>.
+  static StrandList              serverList;
+  // Server strands queued to be closed. Protected by omniTransportLock,
+  // since a server or worker may delete one of them at any time.
+  static CORBA::Boolean          serverQueued;
+  // Set when a strand is added to <serverList>. Protected by <mutex>.
+
+  static void removeGarbageRopes();
+};
+
+////////////////////////////////////////////////////////////////////////
+class OnewayFlusher : public omniTask {
+public:
+  OnewayFlusher() : omniTask(omniTask::AnyTime) {}
+  ~OnewayFlusher() {}
 
-  void removeIdle(StrandList& src,StrandList& dest, CORBA::Boolean skip_bidir);
+  void execute();
+
+  static CORBA::Boolean schedule(giopStrand*);
+  // Queue the strand to be flushed when its coalescing window expires.
+  // Return false if the flusher has been shut down.
+  // Caller must hold the strand's mutex.
+
+  static void terminate();
+  // Flush every queued strand, and wait for the task to finish.
+
+  static void initialise();
+
+private:
+  static CORBA::Boolean          shutdown;
+  static omni_tracedmutex*       mutex;
+  static omni_tracedcondition*	 cond;
+  static OnewayFlusher*          theTask;
+  static giopStrand*             head;
+  static giopStrand*             tail;
+  // The queued strands. All have the same window, so they are in the
+  // order of their deadlines.
+
+  static void flush(giopStrand*);
 };
 
 ////////////////////////////////////////////////////////////////////////
@@ -228,18 +293,25 @@ sendCloseConnection(giopStrand* s)
 
 
 ////////////////////////////////////////////////////////////////////////
-giopStrand::giopStrand(const giopAddress* addr) :
-  pd_safelyDeleted(0),
-  idlebeats(-1),
+giopStrand::giopStrand(const giopAddress* addr, giopRope* r) :
+  pd_safelyDeleted(0), pd_rope(r),
+  idlebeats(-1), idleTimer(this),
   address(addr), connection(0), server(0), flags(0),
   biDir(0), gatekeeper_checked(0), first_use(1), first_call(1),
   orderly_closed(0), biDir_initiated(0), biDir_has_callbacks(0),
   tcs_selected(0), tcs_c(0), tcs_w(0), giopImpl(0),
-  rdcond(omniTransportLock), rd_nwaiting(0), rd_n_justwaiting(0),
-  wrcond(omniTransportLock), wr_nwaiting(0),
-  seqNumber(0), head(0), spare(0), pd_state(ACTIVE)
+  mutex(r->pd_lock),
+  rdcond(r->pd_lock), rd_nwaiting(0), rd_n_justwaiting(0),
+  wrcond(r->pd_lock), wr_nwaiting(0),
+  seqNumber(0), pd_callTable(0), pd_callTableSize(0), pd_ncalls(0),
+  pd_replyWaiters(0), pd_replyWaitersTail(0),
+  pd_asyncHead(0), pd_asyncTail(0), pd_asyncReading(0), head(0), spare(0),
+  coalesced(0), coalescedSize(0), coalesceScheduled(0),
+  pd_flushNext(0), pd_flushSecs(0), pd_flushNanosecs(0), pd_state(ACTIVE)
 {
   version.major = version.minor = 0;
+  pd_rope->strandCreated();
+  omniMetricsP::incr(omniMetricsP::strands);
   Scavenger::notify();
   // Call scavenger::notify() to cause the scavenger thread to be
   // created if it hasn't been created already.
@@ -247,17 +319,23 @@ giopStrand::giopStrand(const giopAddress* addr) :
 
 ////////////////////////////////////////////////////////////////////////
 giopStrand::giopStrand(giopConnection* conn, giopServer* serv) :
-  pd_safelyDeleted(0),
-  idlebeats(-1),
+  pd_safelyDeleted(0), pd_rope(0),
+  idlebeats(-1), idleTimer(this),
   address(0), connection(conn), server(serv), flags(0),
   biDir(0), gatekeeper_checked(0), first_use(0), first_call(0),
   orderly_closed(0), biDir_initiated(0), biDir_has_callbacks(0),
   tcs_selected(0), tcs_c(0), tcs_w(0), giopImpl(0),
+  mutex(omniTransportLock),
   rdcond(omniTransportLock), rd_nwaiting(0), rd_n_justwaiting(0),
   wrcond(omniTransportLock), wr_nwaiting(0),
-  seqNumber(1), head(0), spare(0), pd_state(ACTIVE)
+  seqNumber(1), pd_callTable(0), pd_callTableSize(0), pd_ncalls(0),
+  pd_replyWaiters(0), pd_replyWaitersTail(0),
+  pd_asyncHead(0), pd_asyncTail(0), pd_asyncReading(0), head(0), spare(0),
+  coalesced(0), coalescedSize(0), coalesceScheduled(0),
+  pd_flushNext(0), pd_flushSecs(0), pd_flushNanosecs(0), pd_state(ACTIVE)
 {
   version.major = version.minor = 0;
+  omniMetricsP::incr(omniMetricsP::strands);
   Scavenger::notify();
   // Call scavenger::notify() to cause the scavenger thread to be
   // created if it hasn't been created already.
@@ -266,12 +344,15 @@ giopStrand::giopStrand(giopConnection* conn, giopServer* serv) :
     omniORB::logger log;
     log << "Server accepted connection from " << conn->peeraddress() << "\n";
   }
+  omniMetricsP::add(omniMetricsP::connectionsAccepted,1);
 }
 
 ////////////////////////////////////////////////////////////////////////
 giopStrand::~giopStrand()
 {
   OMNIORB_ASSERT(pd_state == DYING);
+  omniTimerWheel::cancel(&idleTimer);
+  omniMetricsP::decr(omniMetricsP::strands);
 
   if (!giopStreamList::is_empty(servers)) {
     giopStreamList* gp = servers.next;
@@ -295,6 +376,13 @@ giopStrand::~giopStrand()
     }
   }
 
+  OMNIORB_ASSERT(pd_ncalls == 0 && pd_replyWaiters == 0);
+  OMNIORB_ASSERT(pd_asyncHead == 0);
+  if (pd_callTable) delete [] pd_callTable;
+
+  OMNIORB_ASSERT(!coalesceScheduled);
+  if (coalesced) delete [] coalesced;
+
   giopStream_Buffer* p = head;
   while (p) {
     giopStream_Buffer* q = p->next;
@@ -318,17 +406,19 @@ giopStrand::safeDelete(CORBA::Boolean forced)
   CORBA::Boolean deleted = 1;
 
   if (!forced) {
-    ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+    ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,1);
 
     deleted = pd_safelyDeleted = 1;
 
     if (giopStreamList::is_empty(clients) &&
 	giopStreamList::is_empty(servers) &&
-	giopStream::noLockWaiting(this)) {
+	giopStream::noLockWaiting(this) &&
+	!coalesceScheduled) {
 
       // No other threads should be waiting for a read or write lock
       // on the strand. Otherwise, the GIOP_C or GIOP_S lists would not
-      // be empty.
+      // be empty. If the strand is queued for the oneway flusher, the
+      // flusher deletes it once it is done with it.
       StrandList::remove();
       RopeLink::remove();
       deleteStrandAndConnection();
@@ -390,15 +480,24 @@ giopStrand::deleteStrandAndConnection(CORBA::Boolean forced)
 	<< (isClient() ? " to " : " from ")
 	<< (const char*)peeraddr << "\n";
   }
+  if (connection)
+    omniMetricsP::add(isClient() ? omniMetricsP::clientConnectionsClosed
+		                 : omniMetricsP::serverConnectionsClosed, 1);
   pd_state = DYING;     // satisfy the invariant in the dtor.
+
+  // The rope may be deleted as soon as the strand is no longer counted
+  // in it, so only do that once the strand has gone.
+  giopRope* rope = pd_rope;
   delete this;
+  if (rope)
+    rope->strandDeleted();
 }
 
 ////////////////////////////////////////////////////////////////////////
 CORBA::Boolean
 giopStrand::deletePending()
 {
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,1);
   return pd_safelyDeleted;
 }
 
@@ -443,9 +542,9 @@ giopStrand::acquireServer(giopWorker* w)
   // no need for a Read lock.
 
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,0);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,0);
 
-  omni_tracedmutex_lock sync(*omniTransportLock);
+  omni_tracedmutex_lock sync(*mutex);
 
   if (deletePending()) {
     // Check if safeDelete() has been called on the strand and has returned
@@ -546,7 +645,7 @@ giopStrand::acquireServer(giopWorker* w)
 void
 giopStrand::releaseServer(IOP_S* iop_s)
 {
-  omni_tracedmutex_lock sync(*omniTransportLock);
+  omni_tracedmutex_lock sync(*mutex);
 
   GIOP_S* giop_s = (GIOP_S*) iop_s;
 
@@ -627,34 +726,251 @@ giopStrand::releaseServer(IOP_S* iop_s)
 CORBA::ULong
 giopStrand::newSeqNumber() {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,1);
   seqNumber += 2;
   return seqNumber;
 }
 
 ////////////////////////////////////////////////////////////////////////
-StrandList giopStrand::active;
-StrandList giopStrand::active_timedout;
+// Request ids handed out by newSeqNumber() step by 2, so the low bit
+// carries no information.
+#define CALL_HASH(reqid, size) (((reqid) >> 1) & ((size) - 1))
+
+void
+giopStrand::addCall(GIOP_C* g) {
+
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,1);
+
+  if (pd_ncalls >= pd_callTableSize) {
+    CORBA::ULong newsize = pd_callTableSize ? pd_callTableSize * 2 : 8;
+    GIOP_C** newtable = new GIOP_C*[newsize];
+    CORBA::ULong i;
+    for (i=0; i < newsize; i++) newtable[i] = 0;
+
+    for (i=0; i < pd_callTableSize; i++) {
+      GIOP_C* c = pd_callTable[i];
+      while (c) {
+	GIOP_C* next = c->pd_nextCall;
+	CORBA::ULong h = CALL_HASH(c->requestId(), newsize);
+	c->pd_nextCall = newtable[h];
+	newtable[h] = c;
+	c = next;
+      }
+    }
+    if (pd_callTable) delete [] pd_callTable;
+    pd_callTable     = newtable;
+    pd_callTableSize = newsize;
+  }
+
+  CORBA::ULong h = CALL_HASH(g->requestId(), pd_callTableSize);
+  g->pd_nextCall = pd_callTable[h];
+  pd_callTable[h] = g;
+  pd_ncalls++;
+}
+
+////////////////////////////////////////////////////////////////////////
+void
+giopStrand::removeCall(GIOP_C* g) {
+
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,1);
+
+  if (!pd_ncalls) return;
+
+  GIOP_C** pp = &pd_callTable[CALL_HASH(g->requestId(), pd_callTableSize)];
+  for (; *pp; pp = &(*pp)->pd_nextCall) {
+    if (*pp == g) {
+      *pp = g->pd_nextCall;
+      g->pd_nextCall = 0;
+      pd_ncalls--;
+      return;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+GIOP_C*
+giopStrand::findCall(CORBA::ULong reqid) {
+
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,1);
+
+  if (!pd_ncalls) return 0;
+
+  GIOP_C* g = pd_callTable[CALL_HASH(reqid, pd_callTableSize)];
+  while (g && g->requestId() != reqid)
+    g = g->pd_nextCall;
+  return g;
+}
+
+#undef CALL_HASH
+
+////////////////////////////////////////////////////////////////////////
+void
+giopStrand::addReplyWaiter(GIOP_C* g) {
+
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,1);
+  OMNIORB_ASSERT(!g->pd_replyWaiting);
+
+  g->pd_nextWaiter = 0;
+  g->pd_prevWaiter = pd_replyWaitersTail;
+  if (pd_replyWaitersTail)
+    pd_replyWaitersTail->pd_nextWaiter = g;
+  else
+    pd_replyWaiters = g;
+  pd_replyWaitersTail = g;
+  g->pd_replyWaiting = 1;
+}
+
+////////////////////////////////////////////////////////////////////////
+void
+giopStrand::removeReplyWaiter(GIOP_C* g) {
+
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,1);
+
+  if (!g->pd_replyWaiting) return;
+
+  if (g->pd_prevWaiter)
+    g->pd_prevWaiter->pd_nextWaiter = g->pd_nextWaiter;
+  else
+    pd_replyWaiters = g->pd_nextWaiter;
+
+  if (g->pd_nextWaiter)
+    g->pd_nextWaiter->pd_prevWaiter = g->pd_prevWaiter;
+  else
+    pd_replyWaitersTail = g->pd_prevWaiter;
+
+  g->pd_nextWaiter = g->pd_prevWaiter = 0;
+  g->pd_replyWaiting = 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+giopStrand::isReplyWaiter(GIOP_C* g) {
+
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,1);
+
+  return g->pd_replyWaiting;
+}
+
+////////////////////////////////////////////////////////////////////////
+void
+giopStrand::wakeUpReplyWaiter(GIOP_C* g) {
+
+  if (g->pd_replyWaiting) {
+    removeReplyWaiter(g);
+    g->pd_replyCond.signal();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+void
+giopStrand::wakeUpReplyWaiter() {
+
+  if (pd_replyWaiters)
+    wakeUpReplyWaiter(pd_replyWaiters);
+}
+
+////////////////////////////////////////////////////////////////////////
+void
+giopStrand::wakeUpReplyWaiters() {
+
+  while (pd_replyWaiters)
+    wakeUpReplyWaiter(pd_replyWaiters);
+}
+
+////////////////////////////////////////////////////////////////////////
+class AsyncReplyReader : public omniTask {
+public:
+  AsyncReplyReader(giopStrand* s) : omniTask(omniTask::AnyTime),
+				    pd_strand(s) {}
+  ~AsyncReplyReader() {}
+
+  void execute();
+
+private:
+  giopStrand* pd_strand;
+  // The strand is kept alive by the calls queued on it. Once the last
+  // of them has been completed, the task must not touch it again.
+};
+
+void
+AsyncReplyReader::execute()
+{
+  CORBA::Boolean last = 0;
+  while (!last) {
+    GIOP_C* g;
+    {
+      omni_tracedmutex_lock sync(*pd_strand->mutex);
+      g = pd_strand->removeAsyncCall(last);
+    }
+    omniRemoteIdentity::receiveAsyncReply(g);
+  }
+  delete this;
+}
+
+////////////////////////////////////////////////////////////////////////
+void
+giopStrand::addAsyncCall(GIOP_C* g) {
+
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,0);
+
+  AsyncReplyReader* task = 0;
+  {
+    omni_tracedmutex_lock sync(*mutex);
+
+    g->pd_nextAsync = 0;
+    if (pd_asyncTail)
+      pd_asyncTail->pd_nextAsync = g;
+    else
+      pd_asyncHead = g;
+    pd_asyncTail = g;
+
+    if (!pd_asyncReading) {
+      pd_asyncReading = 1;
+      task = new AsyncReplyReader(this);
+    }
+  }
+  if (task && !orbAsyncInvoker->insert(task)) {
+    // No thread is available to receive the replies, so do it here.
+    omniORB::logs(20, "Unable to start a task to receive asynchronous "
+		  "replies. Receiving them in the calling thread.");
+    task->execute();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+GIOP_C*
+giopStrand::removeAsyncCall(CORBA::Boolean& last) {
+
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,1);
+  OMNIORB_ASSERT(pd_asyncHead && pd_asyncReading);
+
+  GIOP_C* g = pd_asyncHead;
+  pd_asyncHead = g->pd_nextAsync;
+  g->pd_nextAsync = 0;
+
+  if (!pd_asyncHead) {
+    pd_asyncTail    = 0;
+    pd_asyncReading = 0;
+    last = 1;
+  }
+  else {
+    last = 0;
+  }
+  return g;
+}
+
+////////////////////////////////////////////////////////////////////////
 StrandList giopStrand::passive;
-// Throughout the lifetime of a strand, it is a member of one and only one
-// of the lists:
-//   active           - the ORB uses this connection in the role of a client
-//                      it is 'active' in the sense that the connection was
-//                      initiated by this ORB
-//   active_timedout  - the connection was previously active and has been
-//                      idled for some time. It will be deleted soon.
-//   passive          - the ORB uses this connection in the role of a server
-//                      it is 'passive' because the connection was initiated
-//                      by the remote party.
-//
+// All passive strands are members of this list. Active strands are only
+// linked to their ropes.
 
-CORBA::ULong giopStrand::idleIncomingBeats = 36;
-CORBA::ULong giopStrand::idleOutgoingBeats = 24;
+CORBA::ULong giopStrand::idleIncomingPeriod = 180000;
+CORBA::ULong giopStrand::idleOutgoingPeriod = 120000;
 
 ////////////////////////////////////////////////////////////////////////
 CORBA::Boolean
 giopStrand::startIdleCounter() {
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,1);
 
   if (idlebeats >= 0) {
     // The idle counter is already active or has already expired.
@@ -665,55 +981,151 @@ giopStrand::startIdleCounter() {
     idlebeats = -1;
     return 1;
   }
-  if (isClient()) {
-    idlebeats = (idleOutgoingBeats) ? (CORBA::Long)idleOutgoingBeats : -1;
-  }
-  else {
-    idlebeats = (idleIncomingBeats) ? (CORBA::Long)idleIncomingBeats : -1;
+  CORBA::ULong period = isClient() ? idleOutgoingPeriod : idleIncomingPeriod;
+  if (!period) {
+    idlebeats = -1;
+    return 1;
   }
+  idleTimer.pd_since = omniTimerWheel::now();
+  if (!idleTimer.pd_armed)
+    idleTimer.pd_armed = omniTimerWheel::schedule(&idleTimer,period);
+
+  idlebeats = idleTimer.pd_armed ? 1 : -1;
   return 1;
 }
 
 ////////////////////////////////////////////////////////////////////////
 CORBA::Boolean
 giopStrand::stopIdleCounter() {
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*mutex,1);
 
   if (idlebeats == 0) {
     // The idle counter has already expired.
     return 0;
   }
+  // The timer is left to lapse when it goes off.
   idlebeats = -1;
   return 1;
 }
 
+////////////////////////////////////////////////////////////////////////
+void
+giopStrand::IdleTimer::expire()
+{
+  // Called by the timer wheel, which must not be kept waiting for the
+  // strand's lock. If another thread has it, try again shortly.
+  giopStrand* s = pd_strand;
+
+  if (!s->mutex->trylock()) {
+    omniTimerWheel::reschedule(this,1);
+    return;
+  }
+
+  CORBA::ULong period = (s->isClient() ? idleOutgoingPeriod :
+			                 idleIncomingPeriod);
+  CORBA::ULongLong now  = omniTimerWheel::now();
+  CORBA::ULongLong idle = now > pd_since ? now - pd_since : 0;
+
+  if (s->idlebeats < 0) {
+    // In use, or held open.
+    pd_armed = 0;
+  }
+  else if (idle < period) {
+    // Used again since the timer was scheduled.
+    omniTimerWheel::reschedule(this,(CORBA::ULong)(period - idle));
+  }
+  else if (s->coalesceScheduled) {
+    // Leave the strand until the oneway flusher has written its
+    // requests.
+    omniTimerWheel::reschedule(this,1);
+  }
+  else if (Scavenger::expired(s)) {
+    pd_armed = 0;
+  }
+  else {
+    omniTimerWheel::reschedule(this,1);
+  }
+  s->mutex->unlock();
+}
 
 ////////////////////////////////////////////////////////////////////////
 void
-Scavenger::removeIdle(StrandList& src,StrandList& dest,
-		      CORBA::Boolean skip_bidir)
+giopStrand::IdleTimer::stopped()
 {
-  StrandList* p = src.next;
-  while (p != &src) {
-    giopStrand* s = (giopStrand*)p;
+  // The timer wheel has stopped. The strand is closed with the others
+  // when the ORB shuts down.
+  if (!pd_strand->mutex->trylock()) {
+    omniTimerWheel::reschedule(this,1);
+    return;
+  }
+  pd_armed = 0;
+  pd_strand->mutex->unlock();
+}
 
-    if ( s->idlebeats >= 0 ) {
 
-      if (omniORB::trace(30)) {
-	omniORB::logger log;
-	log << "Scavenger reduce idle count for strand "
-	    << (void*)s << " to " << (s->idlebeats - 1) << "\n";
-      }
-      if (--(s->idlebeats) <= 0) {
-	p = p->next;
-	s->StrandList::remove();
-	s->RopeLink::remove();
-	s->StrandList::insert(dest);
-	continue;
-      }
-    }
+////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+Scavenger::expired(giopStrand* s)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*s->mutex,1);
 
-    p = p->next;
+  // Called from an idle timer, which must not wait for the lock.
+  if (!mutex->trylock())
+    return 0;
+
+  if (shutdown) {
+    // The strand is closed with the others when the ORB is shut down.
+    mutex->unlock();
+    return 1;
+  }
+
+  if (omniORB::trace(30)) {
+    omniORB::logger log;
+    log << "Idle counter for strand " << (void*)s << " expired.\n";
+  }
+  s->idlebeats = 0;
+  s->RopeLink::remove();
+  if (s->isClient()) {
+    s->StrandList::insert(clientList);
+  }
+  else {
+    // The strand's mutex is omniTransportLock, which protects
+    // <serverList>.
+    s->StrandList::remove();
+    s->StrandList::insert(serverList);
+    serverQueued = 1;
+  }
+  cond->signal();
+  mutex->unlock();
+  return 1;
+}
+
+////////////////////////////////////////////////////////////////////////
+void
+Scavenger::removeGarbageRopes()
+{
+  // Ropes whose last strands were closed and that are not used by
+  // any object reference. The table is visited one bucket at a time,
+  // and omniTransportLock is released between buckets.
+  omniTransportLock->lock();
+  CORBA::ULong tablesize = giopRope::ropeTableSize;
+  omniTransportLock->unlock();
+
+  for (CORBA::ULong i = 0; i < tablesize; i++) {
+    omni_tracedmutex_lock sync(*omniTransportLock);
+
+    if (giopRope::ropeTableSize != tablesize) {
+      // The table has been resized. The remaining ropes are looked
+      // at next time.
+      break;
+    }
+    giopRope* r = giopRope::ropeTable[i];
+    while (r) {
+      giopRope* next = r->pd_nextInRopeTable;
+      if (r->isGarbage())
+	giopRope::deleteRope(r);
+      r = next;
+    }
   }
 }
 
@@ -723,43 +1135,35 @@ Scavenger::execute()
 {
   omniORB::logs(25, "Scavenger task execute.");
 
-  unsigned long abs_sec,abs_nsec;
-  omni_thread::get_time(&abs_sec,&abs_nsec);
-
   while (1) {
+    // Strands are handed over by their idle timers. Take the client
+    // strands queued so far, and close them without holding any lock.
+    // Server strands stay queued until omniTransportLock is held.
+    StrandList client_shutdown_list;
+    CORBA::Boolean dying;
+    CORBA::Boolean close_servers;
     {
       omni_tracedmutex_lock sync(*mutex);
-      if ( shutdown || !orbParameters::scanGranularity ) {
-	goto died;
+      while (!shutdown &&
+	     StrandList::is_empty(clientList) &&
+	     !serverQueued) {
+	cond->wait();
+      }
+      dying = shutdown;
+      close_servers = serverQueued;
+      serverQueued = 0;
+
+      StrandList* p = clientList.next;
+      while (p != &clientList) {
+	StrandList* next = p->next;
+	p->remove();
+	p->insert(client_shutdown_list);
+	p = next;
       }
-      omni_thread::get_time(&abs_sec,&abs_nsec,orbParameters::scanGranularity);
-      cond->timedwait(abs_sec,abs_nsec);
-    }
-
-    if (omniORB::trace(30)) {
-      omniORB::logger log;
-      log << "Scan for idle connections ("
-	  << abs_sec << "," << abs_nsec << ")\n";
-    }
-
-    StrandList client_shutdown_list;
-    StrandList server_shutdown_list;
-    {
-      // Collect all the strands that should be removed
-      // We want to minimise the time we hold the omniTransportLock.
-      // Therefore we remove the strands and keep it in the private
-      // list for the time being.
-
-      omni_tracedmutex_lock sync(*omniTransportLock);
-
-      // Notice that only those strands that have no other threads touching
-      // them will be scanned and may be removed.
-      removeIdle(giopStrand::active_timedout,client_shutdown_list,0);
-      removeIdle(giopStrand::active,client_shutdown_list,1);
-      removeIdle(giopStrand::passive,server_shutdown_list,0);
     }
 
     // Now go through the list to delete them all
+    CORBA::Boolean closed_clients = 0;
     {
       StrandList* p = client_shutdown_list.next;
       while ( p != &client_shutdown_list ) {
@@ -779,16 +1183,18 @@ Scavenger::execute()
           sendCloseConnection(s);
         }
 	s->safeDelete(1);
+	closed_clients = 1;
       }
     }
 
-    {
+    if (close_servers || dying) {
       // We have to hold <omniTransportLock> while disposing of the
       // server strands, since other threads may be dealing with them.
+      // A strand deleted since it was queued has left <serverList>.
       omni_tracedmutex_lock sync(*omniTransportLock);
 
-      StrandList* p = server_shutdown_list.next;
-      while ( p != &server_shutdown_list ) {
+      StrandList* p = serverList.next;
+      while ( p != &serverList ) {
 	giopStrand* s = (giopStrand*)p;
 	p = p->next;
 	s->StrandList::remove();
@@ -803,27 +1209,19 @@ Scavenger::execute()
       }
     }
 
-    if (omniORB::trace(30)) {
-      omniORB::logger log;
-      log << "Scan for idle connections done ("
-	  << abs_sec << "," << abs_nsec << ").\n";
-    }
+    if (closed_clients)
+      removeGarbageRopes();
+
+    if (dying)
+      break;
   }
 
- died:
   {
-    mutex->lock();
+    omni_tracedmutex_lock sync(*mutex);
     theTask = 0;
-    if (shutdown) {
-      mutex->unlock();
-      delete cond;
-      delete mutex;
-    }
-    else {
-      mutex->unlock();
-    }
-    delete this;
+    cond->broadcast();
   }
+  delete this;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -833,7 +1231,10 @@ Scavenger::notify()
   omni_tracedmutex_lock sync(*mutex);
   if ( !shutdown && orbParameters::scanGranularity &&!theTask ) {
     theTask = new Scavenger();
-    orbAsyncInvoker->insert(theTask);
+    if (!orbAsyncInvoker->insert(theTask)) {
+      delete theTask;
+      theTask = 0;
+    }
   }
 }
 
@@ -841,25 +1242,27 @@ Scavenger::notify()
 void
 Scavenger::terminate()
 {
-  mutex->lock();
-  if (theTask) {
-    shutdown = 1;
-    cond->signal();
-    mutex->unlock();
-  }
-  else {
-    mutex->unlock();
-    delete cond; cond = 0;
-    delete mutex; mutex = 0;
-  }
+  // The task closes the strands already queued before it finishes.
+  // Wait for it, since the strands still use the locks of their ropes,
+  // which are deleted once the strands are gone. The mutex and
+  // condition are kept, since idle timers can still expire until the
+  // timer wheel is stopped.
+  omni_tracedmutex_lock sync(*mutex);
+  shutdown = 1;
+  cond->broadcast();
+  while (theTask)
+    cond->wait();
 }
 
 void
 Scavenger::initialise()
 {
+  if (!Scavenger::mutex) {
+    Scavenger::mutex = new omni_tracedmutex();
+    Scavenger::cond  = new omni_tracedcondition(Scavenger::mutex);
+  }
+  omni_tracedmutex_lock sync(*mutex);
   Scavenger::shutdown = 0;
-  Scavenger::mutex = new omni_tracedmutex();
-  Scavenger::cond  = new omni_tracedcondition(Scavenger::mutex);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -867,6 +1270,183 @@ CORBA::Boolean        Scavenger::shutdown = 0;
 omni_tracedmutex*     Scavenger::mutex = 0;
 omni_tracedcondition* Scavenger::cond = 0;
 Scavenger*            Scavenger::theTask = 0;
+StrandList            Scavenger::clientList;
+StrandList            Scavenger::serverList;
+CORBA::Boolean        Scavenger::serverQueued = 0;
+
+
+////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+giopStrand::scheduleFlush()
+{
+  omni_tracedmutex_lock sync(*mutex);
+
+  if (coalesceScheduled)
+    return 1;
+
+  if (!OnewayFlusher::schedule(this))
+    return 0;
+
+  coalesceScheduled = 1;
+  return 1;
+}
+
+////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+OnewayFlusher::schedule(giopStrand* s)
+{
+  omni_tracedmutex_lock sync(*mutex);
+
+  if (shutdown)
+    return 0;
+
+  omni_thread::get_time(&s->pd_flushSecs,&s->pd_flushNanosecs,
+			orbParameters::onewayCoalesceWindow / 1000000,
+			(orbParameters::onewayCoalesceWindow % 1000000) * 1000);
+  s->pd_flushNext = 0;
+  if (tail)
+    tail->pd_flushNext = s;
+  else
+    head = s;
+  tail = s;
+
+  if (!theTask) {
+    theTask = new OnewayFlusher();
+    if (!orbAsyncInvoker->insert(theTask)) {
+      delete theTask;
+      theTask = 0;
+      head = tail = 0;
+      return 0;
+    }
+  }
+  else if (s == head) {
+    cond->signal();
+  }
+  return 1;
+}
+
+////////////////////////////////////////////////////////////////////////
+void
+OnewayFlusher::flush(giopStrand* s)
+{
+  // The strand cannot be deleted while it is marked as scheduled, so
+  // it is safe to use it without holding any lock.
+
+  omni_tracedmutex_lock sync(*s->mutex);
+
+  giopStream g(s);
+  g.wrLock();
+  s->mutex->unlock();
+
+  if (s->state() == giopStrand::DYING) {
+    // The requests would not have got through if they had been sent
+    // straight away either.
+    s->coalescedSize = 0;
+  }
+  else {
+    try {
+      g.flushCoalesced();
+    }
+    catch (const giopStream::CommFailure&) {
+      // The strand is now DYING. Whoever uses it next finds out.
+    }
+  }
+
+  s->mutex->lock();
+
+  // Requests added from now on queue the strand again. Until the
+  // write lock is released, nothing can be added.
+  s->coalesceScheduled = 0;
+  g.wrUnLock();
+
+  if (s->state() == giopStrand::DYING && s->deletePending()) {
+    // The last GIOP_C was released while the strand was queued.
+    s->safeDelete();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+void
+OnewayFlusher::execute()
+{
+  omniORB::logs(25, "Oneway flusher task execute.");
+
+  {
+    omni_tracedmutex_lock sync(*mutex);
+
+    while (1) {
+      if (!head) {
+	if (shutdown)
+	  break;
+
+	// Stay around for a while, so that a steady stream of oneways
+	// does not start a new task every window.
+	unsigned long abs_sec,abs_nsec;
+	omni_thread::get_time(&abs_sec,&abs_nsec,1);
+	cond->timedwait(abs_sec,abs_nsec);
+	if (!head && !shutdown)
+	  break;
+	continue;
+      }
+
+      giopStrand* s = head;
+
+      if (!shutdown) {
+	unsigned long now_sec,now_nsec;
+	omni_thread::get_time(&now_sec,&now_nsec);
+	if (now_sec < s->pd_flushSecs ||
+	    (now_sec == s->pd_flushSecs && now_nsec < s->pd_flushNanosecs)) {
+	  cond->timedwait(s->pd_flushSecs,s->pd_flushNanosecs);
+	  continue;
+	}
+      }
+
+      head = s->pd_flushNext;
+      if (!head) tail = 0;
+      s->pd_flushNext = 0;
+
+      mutex->unlock();
+      flush(s);
+      mutex->lock();
+    }
+
+    omniORB::logs(25, "Oneway flusher task finish.");
+    theTask = 0;
+    cond->broadcast();
+  }
+  delete this;
+}
+
+////////////////////////////////////////////////////////////////////////
+void
+OnewayFlusher::terminate()
+{
+  omni_tracedmutex_lock sync(*mutex);
+  shutdown = 1;
+  if (theTask) {
+    cond->broadcast();
+    while (theTask)
+      cond->wait();
+  }
+}
+
+void
+OnewayFlusher::initialise()
+{
+  if (!mutex) {
+    mutex = new omni_tracedmutex();
+    cond  = new omni_tracedcondition(mutex);
+  }
+  shutdown = 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+CORBA::Boolean        OnewayFlusher::shutdown = 0;
+omni_tracedmutex*     OnewayFlusher::mutex = 0;
+omni_tracedcondition* OnewayFlusher::cond = 0;
+OnewayFlusher*        OnewayFlusher::theTask = 0;
+giopStrand*           OnewayFlusher::head = 0;
+giopStrand*           OnewayFlusher::tail = 0;
 
 /////////////////////////////////////////////////////////////////////////////
 //            Handlers for Configuration Options                           //
@@ -956,52 +1536,133 @@ public:
 
 static inConScanPeriodHandler inConScanPeriodHandler_;
 
+/////////////////////////////////////////////////////////////////////////////
+class onewayCoalesceHandler : public orbOptions::Handler {
+public:
+
+  onewayCoalesceHandler() : 
+    orbOptions::Handler("onewayCoalesce",
+			"onewayCoalesce = 0 or 1",
+			1,
+			"-ORBonewayCoalesce < 0 | 1 >") {}
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::Boolean v;
+    if (!orbOptions::getBoolean(value,v)) {
+      throw orbOptions::BadParam(key(),value,
+				 orbOptions::expect_boolean_msg);
+    }
+    orbParameters::onewayCoalesce = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVBoolean(key(),orbParameters::onewayCoalesce,
+			     result);
+  }
+};
+
+static onewayCoalesceHandler onewayCoalesceHandler_;
+
+/////////////////////////////////////////////////////////////////////////////
+class onewayCoalesceSizeHandler : public orbOptions::Handler {
+public:
+
+  onewayCoalesceSizeHandler() : 
+    orbOptions::Handler("onewayCoalesceSize",
+			"onewayCoalesceSize = n >= 1 bytes",
+			1,
+			"-ORBonewayCoalesceSize < n >= 1 bytes >") {}
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::ULong v;
+    if (!orbOptions::getULong(value,v) || v < 1) {
+      throw orbOptions::BadParam(key(),value,
+				 orbOptions::expect_greater_than_zero_ulong_msg);
+    }
+    orbParameters::onewayCoalesceSize = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVULong(key(),orbParameters::onewayCoalesceSize,
+			   result);
+  }
+};
+
+static onewayCoalesceSizeHandler onewayCoalesceSizeHandler_;
+
+/////////////////////////////////////////////////////////////////////////////
+class onewayCoalesceWindowHandler : public orbOptions::Handler {
+public:
+
+  onewayCoalesceWindowHandler() : 
+    orbOptions::Handler("onewayCoalesceWindow",
+			"onewayCoalesceWindow = n >= 1 usec",
+			1,
+			"-ORBonewayCoalesceWindow < n >= 1 usec >") {}
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::ULong v;
+    if (!orbOptions::getULong(value,v) || v < 1) {
+      throw orbOptions::BadParam(key(),value,
+				 orbOptions::expect_greater_than_zero_ulong_msg);
+    }
+    orbParameters::onewayCoalesceWindow = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVULong(key(),orbParameters::onewayCoalesceWindow,
+			   result);
+  }
+};
+
+static onewayCoalesceWindowHandler onewayCoalesceWindowHandler_;
+
 ////////////////////////////////////////////////////////////////////////
 // Module initialiser
 ////////////////////////////////////////////////////////////////////////
 
+static CORBA::ULong
+msecs(CORBA::ULong secs)
+{
+  return secs < 0xffffffff / 1000 ? secs * 1000 : 0xffffffff;
+}
+
 class omni_giopStrand_initialiser : public omniInitialiser {
 public:
   omni_giopStrand_initialiser() {
     orbOptions::singleton().registerHandler(scanGranularityHandler_);
     orbOptions::singleton().registerHandler(outConScanPeriodHandler_);
     orbOptions::singleton().registerHandler(inConScanPeriodHandler_);
+    orbOptions::singleton().registerHandler(onewayCoalesceHandler_);
+    orbOptions::singleton().registerHandler(onewayCoalesceSizeHandler_);
+    orbOptions::singleton().registerHandler(onewayCoalesceWindowHandler_);
   }
 
   void attach() {
 
-    if (orbParameters::outConScanPeriod && orbParameters::scanGranularity) {
-      if (orbParameters::outConScanPeriod <= orbParameters::scanGranularity) {
-	giopStrand::idleOutgoingBeats = 1;
-	omniORB::logs(2, "Warning: outConScanPeriod <= scanGranularity means "
-		      "connections can be closed while still in use.");
-      }
-      else {
-	giopStrand::idleOutgoingBeats = orbParameters::outConScanPeriod /
-      	                                orbParameters::scanGranularity;
-      }
-    }
-    else {
-      giopStrand::idleOutgoingBeats = 0;
-    }
-    if (orbParameters::inConScanPeriod && orbParameters::scanGranularity) {
-      if (orbParameters::inConScanPeriod <= orbParameters::scanGranularity) {
-	giopStrand::idleIncomingBeats = 1;
-	omniORB::logs(2, "Warning: inConScanPeriod <= scanGranularity means "
-		      "connections can be closed while still in use.");
-      }
-      else {
-	giopStrand::idleIncomingBeats = orbParameters::inConScanPeriod /
-      	                                orbParameters::scanGranularity;
-      }
+    // Idle connections are closed by their timers on the timer wheel,
+    // to the millisecond. scanGranularity only switches that off.
+    if (orbParameters::scanGranularity) {
+      giopStrand::idleOutgoingPeriod = msecs(orbParameters::outConScanPeriod);
+      giopStrand::idleIncomingPeriod = msecs(orbParameters::inConScanPeriod);
     }
     else {
-      giopStrand::idleIncomingBeats = 0;
+      giopStrand::idleOutgoingPeriod = 0;
+      giopStrand::idleIncomingPeriod = 0;
     }
 
     Scavenger::initialise();
+    OnewayFlusher::initialise();
   }
   void detach() {
+    // Coalesced oneway requests are written before the connections are
+    // closed below.
+    omniORB::logs(25, "Terminate oneway flusher.");
+    OnewayFlusher::terminate();
+
     omniORB::logs(25, "Terminate strand scavenger.");
     Scavenger::terminate();
 
@@ -1010,48 +1671,32 @@ public:
     omniORB::logs(25, "Close remaining strands.");
 
     // Close client strands
-    {
-      StrandList* p = giopStrand::active_timedout.next;
-      while ( p != &giopStrand::active_timedout ) {
-	giopStrand* s = (giopStrand*)p;
-	p = p->next;
-	s->StrandList::remove();
-	s->RopeLink::remove();
-	s->state(giopStrand::DYING);
-	if (omniORB::trace(25)) {
-	  omniORB::logger log;
-	  log << "Shutdown close "
-              << (s->connection ? "connection" : "unconnected strand")
-              << " to "
-	      << s->address->address() << "\n";
-	}
-        if ( s->version.minor >= 2 && s->connection ) {
-          // GIOP 1.2 or above requires the client send a closeconnection
-          // message.
-          sendCloseConnection(s);
-        }
-	s->safeDelete(1);
-      }
-    }
-    {
-      StrandList* p = giopStrand::active.next;
-      while ( p != &giopStrand::active ) {
-	giopStrand* s = (giopStrand*)p;
-	p = p->next;
-	s->StrandList::remove();
-	s->RopeLink::remove();
-	s->state(giopStrand::DYING);
-	if (omniORB::trace(25)) {
-	  omniORB::logger log;
-	  log << "Shutdown close connection to "
-	      << s->address->address() << "\n";
-	}
-	if ( s->version.minor >= 2 ) {
-	  // GIOP 1.2 or above requires the client send a closeconnection
-	  // message.
-	  sendCloseConnection(s);
+    for (CORBA::ULong i = 0; i < giopRope::ropeTableSize; i++) {
+      giopRope* r = giopRope::ropeTable[i];
+      for (; r; r = r->pd_nextInRopeTable) {
+	CORBA::Boolean shared = (r->pd_lock == omniTransportLock);
+	omni_optional_lock rsync(*r->pd_lock,shared,shared);
+
+	RopeLink* p = r->pd_strands.next;
+	while ( p != &r->pd_strands ) {
+	  giopStrand* s = (giopStrand*)p;
+	  p = p->next;
+	  s->RopeLink::remove();
+	  s->state(giopStrand::DYING);
+	  if (omniORB::trace(25)) {
+	    omniORB::logger log;
+	    log << "Shutdown close "
+		<< (s->connection ? "connection" : "unconnected strand")
+		<< " to "
+		<< s->address->address() << "\n";
+	  }
+	  if ( s->version.minor >= 2 && s->connection ) {
+	    // GIOP 1.2 or above requires the client send a closeconnection
+	    // message.
+	    sendCloseConnection(s);
+	  }
+	  s->safeDelete(1);
 	}
-	s->safeDelete(1);
       }
     }
     // Close server strands
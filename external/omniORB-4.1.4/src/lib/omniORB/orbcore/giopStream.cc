@@ -145,6 +145,8 @@
 #include <giopStrand.h>
 #include <giopStreamImpl.h>
 #include <omniORB4/minorCode.h>
+#include <omniBufferPool.h>
+#include <metrics.h>
 #include <orbParameters.h>
 #include <stdio.h>
 
@@ -153,6 +155,7 @@ OMNI_NAMESPACE_BEGIN(omni)
 ////////////////////////////////////////////////////////////////////////
 CORBA::ULong giopStream::directSendCutOff = 16384;
 CORBA::ULong giopStream::directReceiveCutOff = 1024;
+CORBA::ULong giopStream::handOffReadCutOff = 65536;
 CORBA::ULong giopStream::bufferSize = 8192;
 
 ////////////////////////////////////////////////////////////////////////
@@ -163,6 +166,8 @@ giopStream::giopStream(giopStrand* strand) :
   pd_impl(0),
   pd_deadline_secs(0),
   pd_deadline_nanosecs(0),
+  pd_coalesce(0),
+  pd_startTime(0),
   pd_currentInputBuffer(0),
   pd_input(0),
   pd_inputFullyBuffered(0),
@@ -224,6 +229,7 @@ giopStream::reset() {
   inputFullyBuffered(0);
   inputMatchedId(0);
   setDeadline(0,0);
+  pd_coalesce = 0;
 }
 
 
@@ -237,7 +243,7 @@ giopStream::version() {
 void
 giopStream::rdLock() {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_strand->mutex,1);
 
   OMNIORB_ASSERT(!pd_rdlocked);
 
@@ -250,8 +256,10 @@ giopStream::rdLock() {
     if (!(pd_deadline_secs || pd_deadline_nanosecs))
       pd_strand->rdcond.wait();
     else {
-      hastimeout = !(pd_strand->rdcond.timedwait(pd_deadline_secs,
-						 pd_deadline_nanosecs));
+      hastimeout = !(omniTimerWheel::timedwait(pd_strand->rdcond,
+					       *pd_strand->mutex,
+					       pd_deadline_secs,
+					       pd_deadline_nanosecs));
     }
 
     if (pd_strand->rd_nwaiting >= 0)
@@ -275,13 +283,16 @@ giopStream::rdLock() {
 void
 giopStream::rdUnLock() {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_strand->mutex,1);
 
   if (!pd_rdlocked) return;
 
   OMNIORB_ASSERT(pd_strand->rd_nwaiting < 0);
   pd_strand->rd_nwaiting = -pd_strand->rd_nwaiting - 1;
   if (pd_strand->rd_nwaiting > 0) {
+    // Pass the read lock on to one of the callers waiting for a reply.
+    pd_strand->wakeUpReplyWaiter();
+
     if (pd_strand->rd_n_justwaiting == 0) {
       pd_strand->rdcond.signal();
     }
@@ -303,7 +314,7 @@ giopStream::rdUnLock() {
 void
 giopStream::wrLock() {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_strand->mutex,1);
 
   OMNIORB_ASSERT(!pd_wrlocked); 
 
@@ -316,8 +327,10 @@ giopStream::wrLock() {
     if (!(pd_deadline_secs || pd_deadline_nanosecs))
       pd_strand->wrcond.wait();
     else {
-      hastimeout = !(pd_strand->wrcond.timedwait(pd_deadline_secs,
-						 pd_deadline_nanosecs));
+      hastimeout = !(omniTimerWheel::timedwait(pd_strand->wrcond,
+					       *pd_strand->mutex,
+					       pd_deadline_secs,
+					       pd_deadline_nanosecs));
     }
 
     if (pd_strand->wr_nwaiting >= 0)
@@ -341,7 +354,7 @@ giopStream::wrLock() {
 void
 giopStream::wrUnLock() {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_strand->mutex,1);
 
   if (!pd_wrlocked) return;
 
@@ -365,7 +378,7 @@ giopStream::wrUnLock() {
 CORBA::Boolean
 giopStream::rdLockNonBlocking() {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_strand->mutex,1);
 
   OMNIORB_ASSERT(!pd_rdlocked);
 
@@ -382,7 +395,7 @@ giopStream::rdLockNonBlocking() {
 CORBA::Boolean
 giopStream::rdLockNonBlocking(giopStrand* strand) {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*strand->mutex,1);
 
   if (strand->rd_nwaiting < 0)
     return 0;
@@ -395,8 +408,14 @@ giopStream::rdLockNonBlocking(giopStrand* strand) {
 ////////////////////////////////////////////////////////////////////////
 void
 giopStream::sleepOnRdLock() {
+  sleepOnRdLock(pd_strand->rdcond);
+}
+
+////////////////////////////////////////////////////////////////////////
+void
+giopStream::sleepOnRdLock(omni_tracedcondition& cond) {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_strand->mutex,1);
 
   if (pd_strand->rd_nwaiting < 0) {
     pd_strand->rd_nwaiting--;
@@ -405,10 +424,11 @@ giopStream::sleepOnRdLock() {
 
     // Now blocks.
     if (!(pd_deadline_secs || pd_deadline_nanosecs))
-      pd_strand->rdcond.wait();
+      cond.wait();
     else {
-      hastimeout = !(pd_strand->rdcond.timedwait(pd_deadline_secs,
-						 pd_deadline_nanosecs));
+      hastimeout = !(omniTimerWheel::timedwait(cond,*pd_strand->mutex,
+					       pd_deadline_secs,
+					       pd_deadline_nanosecs));
     }
 
     if (pd_strand->rd_nwaiting >= 0)
@@ -416,8 +436,9 @@ giopStream::sleepOnRdLock() {
     else
       pd_strand->rd_nwaiting++;
 
-    if (hastimeout) {
-      // Timeout. 
+    if (hastimeout && !pd_rdlocked) {
+      // Timeout. If the read lock was handed to us as the wait expired,
+      // the message we were waiting for is partly read, so carry on.
       errorOnReceive(0,__FILE__,__LINE__,0,1,
 		     "Timed out sleeping on read lock");
     }
@@ -428,7 +449,7 @@ giopStream::sleepOnRdLock() {
 void
 giopStream::sleepOnRdLock(giopStrand* strand) {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*strand->mutex,1);
 
   if (strand->rd_nwaiting < 0) {
     strand->rd_nwaiting--;
@@ -444,7 +465,7 @@ giopStream::sleepOnRdLock(giopStrand* strand) {
 void
 giopStream::sleepOnRdLockAlways() {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_strand->mutex,1);
 
   if (pd_strand->rd_nwaiting < 0)
     pd_strand->rd_nwaiting--;
@@ -459,8 +480,10 @@ giopStream::sleepOnRdLockAlways() {
   if (!(pd_deadline_secs || pd_deadline_nanosecs))
     pd_strand->rdcond.wait();
   else {
-      hastimeout = !(pd_strand->rdcond.timedwait(pd_deadline_secs,
-						 pd_deadline_nanosecs));
+      hastimeout = !(omniTimerWheel::timedwait(pd_strand->rdcond,
+					       *pd_strand->mutex,
+					       pd_deadline_secs,
+					       pd_deadline_nanosecs));
   }
 
   pd_strand->rd_n_justwaiting--;
@@ -482,7 +505,9 @@ giopStream::sleepOnRdLockAlways() {
 void
 giopStream::wakeUpRdLock(giopStrand* strand) {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*strand->mutex,1);
+
+  strand->wakeUpReplyWaiters();
 
 #if 1
   strand->rdcond.broadcast();
@@ -501,7 +526,7 @@ giopStream::wakeUpRdLock(giopStrand* strand) {
 CORBA::Boolean
 giopStream::noLockWaiting(giopStrand* strand) {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*strand->mutex,1);
 
   return ((strand->rd_nwaiting == 0) && (strand->wr_nwaiting == 0));
 }
@@ -510,7 +535,7 @@ giopStream::noLockWaiting(giopStrand* strand) {
 void
 giopStream::markRdLock() {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_strand->mutex,1);
 
   OMNIORB_ASSERT(pd_rdlocked == 0);
   pd_rdlocked = 1;
@@ -520,7 +545,7 @@ giopStream::markRdLock() {
 CORBA::Boolean
 giopStream::RdLockIsHeld(giopStrand* strand) {
 
-  ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,1);
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*strand->mutex,1);
 
   return ((strand->rd_nwaiting != 0));
 }
@@ -713,7 +738,7 @@ giopStream_Buffer::newBuffer(CORBA::ULong sz) {
 
   //  giopStream_Buffer* b = (giopStream_Buffer*)
   //                         (new char[sz + sizeof(giopStream_Buffer) + 8]);
-  char* p = new char[sz + sizeof(giopStream_Buffer) + 8];
+  void* p = omniBufferPool::allocate(sz + sizeof(giopStream_Buffer) + 8);
   giopStream_Buffer* b = (giopStream_Buffer*)p;
   b->alignStart(omni::ALIGN_8);
   b->end = b->start + sz;
@@ -726,8 +751,7 @@ giopStream_Buffer::newBuffer(CORBA::ULong sz) {
 ////////////////////////////////////////////////////////////////////////
 void 
 giopStream_Buffer::deleteBuffer(giopStream_Buffer* b) {
-  char* p = (char*)b;
-  delete [] p;
+  omniBufferPool::release(b);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -745,8 +769,7 @@ void
 giopStream::releaseInputBuffer(giopStream_Buffer* p) {
 
   if (!pd_rdlocked || pd_strand->spare || (p->end - p->start) < giopStream::bufferSize ) {
-    char* c = (char*)p;
-    delete [] c;
+    giopStream_Buffer::deleteBuffer(p);
     return;
   }
   p->next = pd_strand->spare;
@@ -872,6 +895,7 @@ giopStream::inputMessage() {
 					  pd_deadline_secs,
 					  pd_deadline_nanosecs);
     if (rsz > 0) {
+      omniMetricsP::add(omniMetricsP::bytesReceived,rsz);
       buf->last += rsz;
     }
     else {
@@ -908,6 +932,7 @@ giopStream::inputMessage() {
 					    pd_deadline_secs,
 					    pd_deadline_nanosecs);
       if (rsz > 0) {
+	omniMetricsP::add(omniMetricsP::bytesReceived,rsz);
 	if (omniORB::trace(25)) {
 	  omniORB::logger log;
 	  log << "inputMessage: (body) from " 
@@ -1036,6 +1061,7 @@ giopStream::inputChunk(CORBA::ULong maxsize) {
 					  pd_deadline_secs,
 					  pd_deadline_nanosecs);
     if (rsz > 0) {
+      omniMetricsP::add(omniMetricsP::bytesReceived,rsz);
       buf->last += rsz;
       maxsize -= rsz;
     }
@@ -1092,6 +1118,7 @@ giopStream::inputCopyChunk(void* dest, CORBA::ULong size) {
 					  pd_deadline_secs,
 					  pd_deadline_nanosecs);
     if (rsz > 0) {
+      omniMetricsP::add(omniMetricsP::bytesReceived,rsz);
       if (omniORB::trace(30)) {
 	dumpbuf((unsigned char*)p,rsz);
       }
@@ -1109,7 +1136,7 @@ giopStream::inputCopyChunk(void* dest, CORBA::ULong size) {
 
 ////////////////////////////////////////////////////////////////////////
 void
-giopStream::sendChunk(giopStream_Buffer* buf) {
+giopStream::sendChunk(giopStream_Buffer* buf, void* data, CORBA::ULong size) {
 
   if (!pd_strand->connection) {
     OMNIORB_ASSERT(pd_strand->address);
@@ -1146,7 +1173,10 @@ giopStream::sendChunk(giopStream_Buffer* buf) {
       giopActiveConnection* c = pd_strand->address->Connect(deadline_secs,
 							    deadline_nanosecs,
 							    pd_strand->flags);
-      if (c) pd_strand->connection = &(c->getConnection());
+      if (c) {
+	pd_strand->connection = &(c->getConnection());
+	omniMetricsP::add(omniMetricsP::connectionsOpened,1);
+      }
     }
     if (!pd_strand->connection) {
       errorOnSend(TRANSIENT_ConnectFailed,__FILE__,__LINE__,0,
@@ -1162,17 +1192,104 @@ giopStream::sendChunk(giopStream_Buffer* buf) {
   CORBA::ULong first = buf->start;
   size_t total;
 
+  if (pd_coalesce && !data &&
+      pd_strand->coalescedSize + (buf->last - first) <=
+      orbParameters::onewayCoalesceSize) {
+
+    // Hold the request back, to be written with whatever follows it.
+    CORBA::ULong sz = buf->last - first;
+
+    if (omniORB::trace(25)) {
+      omniORB::logger log;
+      log << "sendChunk: to " 
+	  << pd_strand->connection->peeraddress() << " "
+	  << sz << " bytes (coalesced)\n";
+    }
+    if (omniORB::trace(30)) {
+      dumpbuf((unsigned char*)buf+first,sz);
+    }
+
+    if (!pd_strand->coalesced)
+      pd_strand->coalesced =
+	new CORBA::Octet[orbParameters::onewayCoalesceSize];
+
+    memcpy(pd_strand->coalesced + pd_strand->coalescedSize,
+	   (void*)((omni::ptr_arith_t)buf+first), sz);
+
+    if (pd_strand->coalescedSize) {
+      pd_strand->coalescedSize += sz;
+      return;
+    }
+    pd_strand->coalescedSize = sz;
+    if (!pd_strand->scheduleFlush()) {
+      // The flusher has been shut down.
+      flushCoalesced();
+    }
+    return;
+  }
+
+  giopConnection::SendBuffer bufs[3];
+  int nbufs = 0;
+
+  CORBA::ULong held = pd_strand->coalescedSize;
+  if (held) {
+    bufs[nbufs].buf = pd_strand->coalesced;
+    bufs[nbufs].sz  = held;
+    nbufs++;
+    pd_strand->coalescedSize = 0;
+  }
+  bufs[nbufs].buf = (void*)((omni::ptr_arith_t)buf+first);
+  bufs[nbufs].sz  = buf->last - first;
+  nbufs++;
+  if (data) {
+    bufs[nbufs].buf = data;
+    bufs[nbufs].sz  = size;
+    nbufs++;
+  }
+
   if (omniORB::trace(25)) {
     omniORB::logger log;
     log << "sendChunk: to " 
-	<< pd_strand->connection->peeraddress() << " "
-	<< buf->last - buf->start << " bytes\n";
+	<< pd_strand->connection->peeraddress() << " ";
+    if (held)
+      log << held << " bytes (coalesced) + ";
+    log << buf->last - buf->start << " bytes";
+    if (data)
+      log << " + " << size << " bytes (gathered)";
+    log << "\n";
   }
 
   if (omniORB::trace(30)) {
     dumpbuf((unsigned char*)buf+buf->start,buf->last-buf->start);
   }
 
+  if (nbufs > 1) {
+    size_t remaining = held + (buf->last - first) + (data ? size : 0);
+
+    while (remaining) {
+      int ssz = pd_strand->connection->Sendv(bufs,nbufs,
+					     pd_deadline_secs,
+					     pd_deadline_nanosecs);
+      if (ssz > 0) {
+	omniMetricsP::add(omniMetricsP::bytesSent,ssz);
+	size_t done = ssz;
+	remaining -= done;
+	for (int i=0; i < nbufs; i++) {
+	  size_t n = (done < bufs[i].sz) ? done : bufs[i].sz;
+	  bufs[i].buf = (void*)((omni::ptr_arith_t)bufs[i].buf + n);
+	  bufs[i].sz -= n;
+	  done -= n;
+	}
+      }
+      else {
+	errorOnSend(ssz,__FILE__,__LINE__,0,
+		    "Error in network send (gathered data)");
+	// never reaches here.
+      }
+    }
+    return;
+  }
+
   while ((total = buf->last - first)) {
     int ssz = pd_strand->connection->Send((void*)
 					  ((omni::ptr_arith_t)buf+first),
@@ -1180,6 +1297,7 @@ giopStream::sendChunk(giopStream_Buffer* buf) {
 					  pd_deadline_secs,
 					  pd_deadline_nanosecs);
     if (ssz > 0) {
+      omniMetricsP::add(omniMetricsP::bytesSent,ssz);
       first += ssz;
     }
     else {
@@ -1227,7 +1345,10 @@ giopStream::sendCopyChunk(void* buf,CORBA::ULong size) {
       }
       giopActiveConnection* c = pd_strand->address->Connect(deadline_secs,
 							    deadline_nanosecs);
-      if (c) pd_strand->connection = &(c->getConnection());
+      if (c) {
+	pd_strand->connection = &(c->getConnection());
+	omniMetricsP::add(omniMetricsP::connectionsOpened,1);
+      }
     }
     if (!pd_strand->connection) {
       errorOnSend(TRANSIENT_ConnectFailed,__FILE__,__LINE__,0,
@@ -1240,6 +1361,8 @@ giopStream::sendCopyChunk(void* buf,CORBA::ULong size) {
     }
   }
 
+  flushCoalesced();
+
   if (omniORB::trace(25)) {
     omniORB::logger log;
     log << "sendCopyChunk: to " 
@@ -1257,6 +1380,7 @@ giopStream::sendCopyChunk(void* buf,CORBA::ULong size) {
 					  pd_deadline_secs,
 					  pd_deadline_nanosecs);
     if (ssz > 0) {
+      omniMetricsP::add(omniMetricsP::bytesSent,ssz);
       size -= ssz;
       buf = (void*)((omni::ptr_arith_t)buf + ssz);
     }
@@ -1269,6 +1393,41 @@ giopStream::sendCopyChunk(void* buf,CORBA::ULong size) {
 
 }
 
+////////////////////////////////////////////////////////////////////////
+void
+giopStream::flushCoalesced() {
+
+  CORBA::ULong size = pd_strand->coalescedSize;
+  if (!size) return;
+
+  pd_strand->coalescedSize = 0;
+
+  if (omniORB::trace(25)) {
+    omniORB::logger log;
+    log << "flushCoalesced: to "
+	<< pd_strand->connection->peeraddress() << " "
+	<< size << " bytes\n";
+  }
+
+  CORBA::Octet* p = pd_strand->coalesced;
+  while (size) {
+    int ssz = pd_strand->connection->Send(p,
+					  size,
+					  pd_deadline_secs,
+					  pd_deadline_nanosecs);
+    if (ssz > 0) {
+      omniMetricsP::add(omniMetricsP::bytesSent,ssz);
+      size -= ssz;
+      p += ssz;
+    }
+    else {
+      errorOnSend(ssz,__FILE__,__LINE__,0,
+		  "Error in network send (coalesced oneway requests)");
+      // never reaches here.
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////
 void
 giopStream::errorOnSend(int rc, const char* filename, CORBA::ULong lineno,
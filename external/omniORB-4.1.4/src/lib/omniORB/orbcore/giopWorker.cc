@@ -179,8 +179,8 @@ giopWorker::real_execute()
 	log << "\n";
       }
       {
-	ASSERT_OMNI_TRACEDMUTEX_HELD(*omniTransportLock,0);
-	omni_tracedmutex_lock sync(*omniTransportLock);
+	ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_strand->mutex,0);
+	omni_tracedmutex_lock sync(*pd_strand->mutex);
 	pd_strand->safeDelete();
       }
       pd_server->notifyWkDone(this,1);
@@ -143,9 +143,8 @@ omniInProcessIdentity::dispatch(omniCallDescriptor& call_desc)
 
     CORBA::ULong hash = omni::hash(key(), keysize());
 
-    omni::internalLock->lock();
     omniLocalIdentity* id;
-    id = omniObjTable::locateActive(key(), keysize(), hash, 1);
+    id = omniObjTable::lockActive(key(), keysize(), hash);
 
     if (id) {
       // Found an entry in the object table. Either the servant has
@@ -175,8 +174,6 @@ omniInProcessIdentity::dispatch(omniCallDescriptor& call_desc)
       return;
     }
 
-    omni::internalLock->unlock();
-
     // Can we create a suitable object on demand?
 
     omniObjAdapter_var adapter(omniObjAdapter::getAdapter(key(),keysize()));
@@ -114,6 +114,123 @@ OMNI_USING_NAMESPACE(omni)
 
 unsigned int omniAsyncInvoker::idle_timeout = 10;
 
+// Upper limit on the number of Anytime task queues.
+#define INVOKER_MAX_QUEUES 64
+
+#if defined(__GNUC__)
+#  define INVOKER_CAS(p,o,n) __sync_bool_compare_and_swap(p,o,n)
+#  define INVOKER_SWAP(p,v)  __sync_lock_test_and_set(p,v)
+#  define INVOKER_ADD(p,v)   __sync_fetch_and_add(p,v)
+#  define INVOKER_FENCE()    __sync_synchronize()
+#else
+static omni_mutex invokerAtomicLock;
+
+template <class T>
+static inline CORBA::Boolean invokerCAS(T volatile* p, T o, T n)
+{
+  omni_mutex_lock sync(invokerAtomicLock);
+  if (*p != o) return 0;
+  *p = n;
+  return 1;
+}
+template <class T>
+static inline T invokerSwap(T volatile* p, T v)
+{
+  omni_mutex_lock sync(invokerAtomicLock);
+  T o = *p;
+  *p = v;
+  return o;
+}
+template <class T>
+static inline T invokerAdd(T volatile* p, T v)
+{
+  omni_mutex_lock sync(invokerAtomicLock);
+  T o = *p;
+  *p = o + v;
+  return o;
+}
+#  define INVOKER_CAS(p,o,n) invokerCAS(p,o,n)
+#  define INVOKER_SWAP(p,v)  invokerSwap(p,v)
+#  define INVOKER_ADD(p,v)   invokerAdd(p,v)
+#  define INVOKER_FENCE()    do { omni_mutex_lock s(invokerAtomicLock); } while(0)
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// A queue of Anytime tasks. Tasks are pushed on to inbox with a
+// compare and swap, so inserting never blocks. Everything else
+// happens with the queue's lock held: the inbox is moved to the tasks
+// list in FIFO order, and tasks are taken from the front of the list,
+// both by the queue's own worker and by threads stealing work.
+
+struct omniAsyncInvoker::TaskQueue {
+
+  omni_tracedmutex   lock;
+  omniTaskLink       tasks;  // Protected by lock.
+  omniTask* volatile inbox;  // Tasks not yet in the list, newest first,
+			     // linked through next.
+  volatile int       count;  // No. of tasks in inbox and tasks.
+  char               pad[64];
+
+  TaskQueue() : inbox(0), count(0) {}
+
+  void push(omniTask* t) {
+    omniTask* head;
+    do {
+      head = inbox;
+      t->next = head;
+    } while (!INVOKER_CAS(&inbox, head, t));
+    INVOKER_ADD(&count, 1);
+  }
+
+  omniTask* pop() {
+    if (!count) return 0;
+
+    omni_tracedmutex_lock sync(lock);
+    drain();
+    if (omniTaskLink::is_empty(tasks))
+      return 0;
+
+    omniTask* t = (omniTask*)tasks.next;
+    t->deq();
+    INVOKER_ADD(&count, -1);
+    return t;
+  }
+
+  CORBA::Boolean remove(omniTask* t) {
+    omni_tracedmutex_lock sync(lock);
+    drain();
+    for (omniTaskLink* l = tasks.next; l != &tasks; l = l->next) {
+      if (l == t) {
+	l->deq();
+	INVOKER_ADD(&count, -1);
+	return 1;
+      }
+    }
+    return 0;
+  }
+
+private:
+  void drain() {
+    // Caller holds lock.
+    omniTaskLink* l = INVOKER_SWAP(&inbox, (omniTask*)0);
+    omniTaskLink* rev = 0;
+    while (l) {
+      omniTaskLink* n = l->next;
+      l->next = rev;
+      rev = l;
+      l = n;
+    }
+    while (rev) {
+      omniTaskLink* n = rev->next;
+      rev->enq(tasks);
+      rev = n;
+    }
+  }
+};
+
+
 class omniAsyncWorker;
 
 class omniAsyncWorkerInfo
@@ -136,6 +253,7 @@ public:
   omniAsyncWorker(omniAsyncInvoker* pool, omniTask* task) :
     pd_pool(pool), pd_task(task), pd_next(0), pd_id(id()), pd_in_idle_queue(0)
   {
+    pd_home = INVOKER_ADD(&pool->pd_next_queue, 1) % pool->pd_nqueues;
     pd_cond = new omni_tracedcondition(pool->pd_lock);
     start();
   }
@@ -174,63 +292,23 @@ public:
 	<< " has started. Total threads = " << pd_pool->pd_totalthreads
 	<< "\n";
     }
-    pd_pool->pd_lock->lock();
 
-    while (pd_task || pd_pool->pd_keep_working) {
+    while (1) {
 
       if (!pd_task) {
-	if ( !omniTaskLink::is_empty(pd_pool->pd_anytime_tq) ) {
-	  pd_task = (omniTask*)pd_pool->pd_anytime_tq.next;
-	  pd_task->deq();
-	}
-	else {
-	  // Add to the idle queue
-	  OMNIORB_ASSERT(!pd_in_idle_queue);
-	  pd_next = pd_pool->pd_idle_threads;
-	  pd_pool->pd_idle_threads = this;
-	  pd_in_idle_queue = 1;
-
-	  unsigned long abs_sec,abs_nanosec;
-	  omni_thread::get_time(&abs_sec,&abs_nanosec,
-				omniAsyncInvoker::idle_timeout);
-
-	  int signalled = pd_cond->timedwait(abs_sec,abs_nanosec);
-
-	  if (pd_in_idle_queue) {
-	    // Remove from the idle queue
-	    omniAsyncWorker** pp = &pd_pool->pd_idle_threads;
-	    while (*pp && *pp != this) {
-	      pp = &((*pp)->pd_next);
-	    }
-	    if (*pp) {
-	      *pp = pd_next;
-	    }
-	    else {
-	      if (omniORB::trace(1)) {
-		omniORB::logger l;
-		l << "AsyncInvoker: Warning: thread " << pd_id
-		  << " thought it was in the idle queue but it was not.\n";
-	      }
-	    }
-	    pd_next = 0;
-	    pd_in_idle_queue = 0;
-	  }
-	  if (!signalled && !pd_task) {
-	    // We have timed out and have not been assigned a task.
-	    // Break out from the while loop and exit.
-	    break;
-	  }
-	  // If signalled, we have been dequeued by the
-	  // omniAsyncInvoker, and will have a task to process next
-	  // time around the while loop.
+	if (pd_pool->pd_keep_working)
+	  pd_task = pd_pool->findTask(pd_home);
+
+	if (!pd_task) {
+	  if (!waitForTask())
+	    return;
+	  // If we have not been given a task, look in the queues again.
 	  continue;
 	}
       }
 
       unsigned int immediate = (pd_task->category() ==
 				omniTask::ImmediateDispatch);
-
-      pd_pool->pd_lock->unlock();
       try {
 	pd_task->pd_selfThread = self_thread;
 	pd_task->execute();
@@ -240,20 +318,87 @@ public:
 		      "caught while executing a task.");
       }
       pd_task = 0;
-      pd_pool->pd_lock->lock();
 
-      if (immediate) {
-	pd_pool->pd_nthreads++;
+      if (immediate || pd_pool->pd_nthreads > pd_pool->pd_maxthreads) {
+	omni_tracedmutex_lock sync(*pd_pool->pd_lock);
+	if (immediate) {
+	  pd_pool->pd_nthreads++;
+	}
+	if (pd_pool->pd_nthreads > pd_pool->pd_maxthreads) {
+	  // No need to keep this thread
+	  pd_pool->pd_nthreads--;
+	  return;
+	}
       }
+    }
+  }
+
+  CORBA::Boolean waitForTask() {
+    // Wait in the idle queue until we are woken or time out. Returns
+    // false if the thread should exit, in which case it has been
+    // removed from the thread count.
+
+    omni_tracedmutex_lock sync(*pd_pool->pd_lock);
 
-      if (pd_pool->pd_nthreads > pd_pool->pd_maxthreads) {
-	// No need to keep this thread
-	break;
+    if (!pd_pool->pd_keep_working) {
+      pd_pool->pd_nthreads--;
+      return 0;
+    }
+
+    // Add to the idle queue, then look for work once more, in case a
+    // task was queued while we were not counted as idle. Whoever
+    // queues a task checks pd_nidle after queuing it.
+    OMNIORB_ASSERT(!pd_in_idle_queue);
+    pd_next = pd_pool->pd_idle_threads;
+    pd_pool->pd_idle_threads = this;
+    pd_pool->pd_nidle++;
+    pd_in_idle_queue = 1;
+    INVOKER_FENCE();
+
+    int signalled = 1;
+    pd_task = pd_pool->findTask(pd_home);
+
+    if (!pd_task) {
+      unsigned long abs_sec,abs_nanosec;
+      omni_thread::get_time(&abs_sec,&abs_nanosec,
+			    omniAsyncInvoker::idle_timeout);
+
+      signalled = pd_cond->timedwait(abs_sec,abs_nanosec);
+    }
+
+    if (pd_in_idle_queue) {
+      // Remove from the idle queue
+      omniAsyncWorker** pp = &pd_pool->pd_idle_threads;
+      while (*pp && *pp != this) {
+	pp = &((*pp)->pd_next);
+      }
+      if (*pp) {
+	*pp = pd_next;
+	pd_pool->pd_nidle--;
       }
+      else {
+	if (omniORB::trace(1)) {
+	  omniORB::logger l;
+	  l << "AsyncInvoker: Warning: thread " << pd_id
+	    << " thought it was in the idle queue but it was not.\n";
+	}
+      }
+      pd_next = 0;
+      pd_in_idle_queue = 0;
     }
 
-    pd_pool->pd_nthreads--;
-    pd_pool->pd_lock->unlock();
+    if (!signalled && !pd_task) {
+      // We have timed out and have not been assigned a task. Exit
+      // unless something was queued at the last moment.
+      if (pd_pool->pd_keep_working)
+	pd_task = pd_pool->findTask(pd_home);
+
+      if (!pd_task) {
+	pd_pool->pd_nthreads--;
+	return 0;
+      }
+    }
+    return 1;
   }
 
   friend class omniAsyncInvoker;
@@ -264,6 +409,7 @@ private:
   omni_tracedcondition* pd_cond;
   omniAsyncWorker*      pd_next;
   int                   pd_id;
+  unsigned int          pd_home;  // Index of this thread's task queue
   CORBA::Boolean        pd_in_idle_queue;
 
   omniAsyncWorker();
@@ -291,7 +437,12 @@ omniAsyncInvoker::omniAsyncInvoker(unsigned int max) {
   pd_keep_working = 1;
   pd_lock  = new omni_tracedmutex();
   pd_cond  = new omni_tracedcondition(pd_lock);
+  pd_nqueues = max < INVOKER_MAX_QUEUES ? max : INVOKER_MAX_QUEUES;
+  if (!pd_nqueues) pd_nqueues = 1;
+  pd_queues = new TaskQueue[pd_nqueues];
+  pd_next_queue = 0;
   pd_idle_threads = 0;
+  pd_nidle = 0;
   pd_nthreads = 0;
   pd_maxthreads = max;
   pd_totalthreads = 0;
@@ -315,6 +466,7 @@ omniAsyncInvoker::~omniAsyncInvoker() {
     t->pd_in_idle_queue = 0;
     t->pd_cond->signal();
   }
+  pd_nidle = 0;
 
   // Wait for threads to exit
   if (pd_totalthreads) {
@@ -323,7 +475,7 @@ omniAsyncInvoker::~omniAsyncInvoker() {
       timeout = orbParameters::scanGranularity;
     else
       timeout = 5;
-    
+
     omni_thread::get_time(&s, &ns, timeout);
 
     if (omniORB::trace(25)) {
@@ -346,11 +498,69 @@ omniAsyncInvoker::~omniAsyncInvoker() {
   }
   pd_lock->unlock();
 
+  delete [] pd_queues;
   delete pd_cond;
   delete pd_lock;
   omniORB::logs(10, "AsyncInvoker: deleted.");
 }
 
+///////////////////////////////////////////////////////////////////////////
+omniTask*
+omniAsyncInvoker::findTask(unsigned int home) {
+
+  omniTask* t = pd_queues[home].pop();
+  if (t) return t;
+
+  for (unsigned int i=1; i < pd_nqueues; i++) {
+    unsigned int q = home + i;
+    if (q >= pd_nqueues) q -= pd_nqueues;
+
+    if (pd_queues[q].count && (t = pd_queues[q].pop()))
+      return t;
+  }
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////
+void
+omniAsyncInvoker::wakeIdleThread() {
+
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*pd_lock, 1);
+
+  if (pd_idle_threads) {
+    omniAsyncWorker* w = pd_idle_threads;
+    pd_idle_threads = w->pd_next;
+    w->pd_next = 0;
+    w->pd_in_idle_queue = 0;
+    pd_nidle--;
+    w->pd_cond->signal();
+    return;
+  }
+
+  // The idle thread we expected has gone. Start another one if the
+  // work has not already been picked up.
+  if (pd_nthreads >= pd_maxthreads)
+    return;
+
+  unsigned int i;
+  for (i=0; i < pd_nqueues && !pd_queues[i].count; i++);
+  if (i == pd_nqueues)
+    return;
+
+  try {
+    pd_nthreads++;
+    pd_totalthreads++;
+    omniAsyncWorker* w = new omniAsyncWorker(this,0);
+    OMNIORB_ASSERT(w);
+  }
+  catch (...) {
+    pd_nthreads--;
+    pd_totalthreads--;
+    omniORB::logs(2, "Exception trying to start new thread. "
+		  "Task left queued.");
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////
 int
 omniAsyncInvoker::insert(omniTask* t) {
@@ -358,24 +568,28 @@ omniAsyncInvoker::insert(omniTask* t) {
   switch (t->category()) {
   case omniTask::AnyTime:
     {
-      omni_tracedmutex_lock sync(*pd_lock);
-
-      if (pd_idle_threads) {
-	omniAsyncWorker* w = pd_idle_threads;
-	pd_idle_threads = w->pd_next;
-	w->pd_next = 0;
-	OMNIORB_ASSERT(w->pd_task == 0);
-	w->pd_task = t;
-	w->pd_in_idle_queue = 0;
-	w->pd_cond->signal();
-      }
-      else {
+      if (!pd_nidle && pd_nthreads < pd_maxthreads) {
+	// There is room for another thread. Start one to run the task.
+	omni_tracedmutex_lock sync(*pd_lock);
+
+	if (pd_idle_threads) {
+	  omniAsyncWorker* w = pd_idle_threads;
+	  pd_idle_threads = w->pd_next;
+	  w->pd_next = 0;
+	  OMNIORB_ASSERT(w->pd_task == 0);
+	  w->pd_task = t;
+	  w->pd_in_idle_queue = 0;
+	  pd_nidle--;
+	  w->pd_cond->signal();
+	  break;
+	}
 	if (pd_nthreads < pd_maxthreads) {
 	  try {
 	    pd_nthreads++;
 	    pd_totalthreads++;
 	    omniAsyncWorker* w = new omniAsyncWorker(this,t);
 	    OMNIORB_ASSERT(w);
+	    break;
 	  }
 	  catch (const omni_thread_fatal &ex) {
 	    // Cannot start a new thread.
@@ -386,7 +600,6 @@ omniAsyncInvoker::insert(omniTask* t) {
 	      log << "Exception trying to start new thread ("
 		  << ex.error << "). Task queued.\n";
 	    }
-	    t->enq(pd_anytime_tq);
 	  }
 	  catch (...) {
 	    // Cannot start a new thread.
@@ -394,12 +607,25 @@ omniAsyncInvoker::insert(omniTask* t) {
 	    pd_totalthreads--;
 	    omniORB::logs(2, "Exception trying to start new thread. "
 			  "Task queued.");
-	    t->enq(pd_anytime_tq);
 	  }
 	}
-	else {
-	  t->enq(pd_anytime_tq);
-	}
+      }
+
+      // Queue the task. One of our own threads queues to itself, so
+      // the task is likely to run on the same CPU; anyone else spreads
+      // tasks over all the queues.
+      unsigned int q;
+      omniAsyncWorker* self = dynamic_cast<omniAsyncWorker*>(omni_thread::self());
+      if (self && self->pd_pool == this)
+	q = self->pd_home;
+      else
+	q = INVOKER_ADD(&pd_next_queue, 1) % pd_nqueues;
+
+      pd_queues[q].push(t);
+
+      if (pd_nidle) {
+	omni_tracedmutex_lock sync(*pd_lock);
+	wakeIdleThread();
       }
       break;
     }
@@ -414,6 +640,7 @@ omniAsyncInvoker::insert(omniTask* t) {
 	OMNIORB_ASSERT(w->pd_task == 0);
 	w->pd_task = t;
 	w->pd_in_idle_queue = 0;
+	pd_nidle--;
 	w->pd_cond->signal();
 	pd_nthreads--;
       }
@@ -454,14 +681,9 @@ int
 omniAsyncInvoker::cancel(omniTask* t) {
 
   if (t->category() == omniTask::AnyTime) {
-    omni_tracedmutex_lock sync(*pd_lock);
-    omniTaskLink* l;
-
-    for (l = pd_anytime_tq.next; l != &pd_anytime_tq; l =l->next) {
-      if ((omniTask*)l == t) {
-	l->deq();
+    for (unsigned int i=0; i < pd_nqueues; i++) {
+      if (pd_queues[i].remove(t))
 	return 1;
-      }
     }
   }
   else if (t->category() == omniTask::DedicatedThread) {
@@ -471,6 +693,19 @@ omniAsyncInvoker::cancel(omniTask* t) {
 }
 
 ///////////////////////////////////////////////////////////////////////////
+void
+omniAsyncInvoker::stats(unsigned int& threads, unsigned int& idle,
+			unsigned int& queued) {
+
+  threads = pd_nthreads;
+  idle    = pd_nidle;
+  queued  = 0;
+  for (unsigned int i=0; i < pd_nqueues; i++) {
+    int n = pd_queues[i].count;
+    if (n > 0) queued += n;
+  }
+}
+
 //
 // Default do-nothing implementations of dedicated thread functions
 
@@ -1020,6 +1020,65 @@ omniIOR::dump_TAG_OMNIORB_UNIX_TRANS(const IOP::TaggedComponent& c) {
 
 }
 
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+void
+omniIOR::unmarshal_TAG_OMNIORB_SHM_TRANS(const IOP::TaggedComponent& c,
+					 omniIOR& ior) {
+  
+  OMNIORB_ASSERT(c.tag == IOP::TAG_OMNIORB_SHM_TRANS);
+  OMNIORB_ASSERT(ior.pd_iorInfo);
+
+  cdrEncapsulationStream e(c.component_data.get_buffer(),
+			   c.component_data.length(),1);
+
+  CORBA::String_var host;
+  host = e.unmarshalRawString();
+  CORBA::String_var filename;
+  filename = e.unmarshalRawString();
+
+  // Shared memory can only be used if we are on the same host.
+  char self[OMNIORB_HOSTNAME_MAX];
+  if (gethostname(&self[0],OMNIORB_HOSTNAME_MAX) == RC_SOCKET_ERROR) {
+    self[0] = '\0';
+    omniORB::logs(1, "Cannot get the name of this host.");
+  }
+  if (strcmp(self,host) != 0) return;
+
+  const char* format = "giop:shm:%s";
+
+  CORBA::ULong len = strlen(filename);
+  if (len == 0) return;
+  len += strlen(format);
+  CORBA::String_var addrstr(CORBA::string_alloc(len));
+  sprintf(addrstr,format,(const char*)filename);
+  
+  giopAddress* address = giopAddress::str2Address(addrstr);
+  // If we do not have shm transport linked the return value will be 0
+  if (address == 0) return;
+  ior.getIORInfo()->addresses().push_back(address);
+}
+
+char*
+omniIOR::dump_TAG_OMNIORB_SHM_TRANS(const IOP::TaggedComponent& c) {
+
+  OMNIORB_ASSERT(c.tag == IOP::TAG_OMNIORB_SHM_TRANS);
+  cdrEncapsulationStream e(c.component_data.get_buffer(),
+			   c.component_data.length(),1);
+
+  CORBA::String_var host;
+  host = e.unmarshalRawString();
+  CORBA::String_var filename;
+  filename = e.unmarshalRawString();
+
+  const char* format = "TAG_OMNIORB_SHM_TRANS %s %s";
+  CORBA::String_var outstr;
+  CORBA::ULong len = strlen(format) + strlen(host) + strlen(filename);
+  outstr = CORBA::string_alloc(len);
+  sprintf(outstr,format,(const char*)host,(const char*)filename);
+  return outstr._retn();
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 void
@@ -1206,6 +1265,10 @@ static struct {
     omniIOR::unmarshal_TAG_OMNIORB_PERSISTENT_ID,
     omniIOR::dump_TAG_OMNIORB_PERSISTENT_ID },
 
+  { IOP::TAG_OMNIORB_SHM_TRANS,
+    omniIOR::unmarshal_TAG_OMNIORB_SHM_TRANS,
+    omniIOR::dump_TAG_OMNIORB_SHM_TRANS },
+
   { 0xffffffff, 0, 0 }
 };
 
@@ -1297,6 +1360,7 @@ static _CORBA_Unbounded_Sequence_Octet my_orb_type;
 static _CORBA_Unbounded_Sequence<_CORBA_Unbounded_Sequence_Octet> my_alternative_addr;
 static _CORBA_Unbounded_Sequence<_CORBA_Unbounded_Sequence_Octet> my_ssl_addr;
 static _CORBA_Unbounded_Sequence<_CORBA_Unbounded_Sequence_Octet> my_unix_addr;
+static _CORBA_Unbounded_Sequence<_CORBA_Unbounded_Sequence_Octet> my_shm_addr;
 
 static _CORBA_Unbounded_Sequence_Octet my_csi_component;
 static _CORBA_Unbounded_Sequence<IIOP::Address> my_tls_addr_list;
@@ -1498,6 +1562,35 @@ omniIOR::add_TAG_OMNIORB_UNIX_TRANS(const char* filename) {
   my_unix_addr[index].replace(max,len,p,1);
 }
 
+/////////////////////////////////////////////////////////////////////////////
+void
+omniIOR::add_TAG_OMNIORB_SHM_TRANS(const char* filename) {
+
+  OMNIORB_ASSERT(filename && strlen(filename) != 0);
+
+  char self[OMNIORB_HOSTNAME_MAX];
+  if (gethostname(&self[0],OMNIORB_HOSTNAME_MAX) == RC_SOCKET_ERROR) {
+    omniORB::logs(1, "Cannot get the name of this host.");
+    self[0] = '\0';
+  }
+
+  if (strlen(my_address.host) == 0) {
+    my_address.host = (const char*) self;
+  }
+
+  cdrEncapsulationStream s(CORBA::ULong(0),CORBA::Boolean(1));
+
+  s.marshalRawString(self);
+  s.marshalRawString(filename);
+
+  CORBA::ULong index = my_shm_addr.length();
+  my_shm_addr.length(index+1);
+
+  CORBA::Octet* p; CORBA::ULong max,len; s.getOctetStream(p,max,len);
+
+  my_shm_addr[index].replace(max,len,p,1);
+}
+
 
 OMNI_NAMESPACE_BEGIN(omni)
 
@@ -1596,6 +1689,19 @@ CORBA::Boolean insertSupportedComponents(omniInterceptors::encodeIOR_T::info_T&
       c.component_data.replace(max,len,
 			       my_unix_addr[index].get_buffer(),0);
     }
+
+    // and the shared memory transport
+    for (CORBA::ULong index = 0;
+	 index < my_shm_addr.length(); index++) {
+
+      IOP::TaggedComponent& c = omniIOR::newIIOPtaggedComponent(cs);
+      c.tag = IOP::TAG_OMNIORB_SHM_TRANS;
+      CORBA::ULong max, len;
+      max = my_shm_addr[index].maximum();
+      len = my_shm_addr[index].length();
+      c.component_data.replace(max,len,
+			       my_shm_addr[index].get_buffer(),0);
+    }
   }
 
   if (v.major > 1 || v.minor >= 1) {
@@ -1691,6 +1797,7 @@ public:
     my_alternative_addr.length(0);
     my_ssl_addr.length(0);
     my_unix_addr.length(0);
+    my_shm_addr.length(0);
     my_csi_component.length(0);
     my_tls_addr_list.length(0);
     my_csi_enabled = 0;
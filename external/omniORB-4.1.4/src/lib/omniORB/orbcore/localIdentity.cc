@@ -98,6 +98,7 @@
 #endif
 
 #include <localIdentity.h>
+#include <objectTable.h>
 #include <omniORB4/callDescriptor.h>
 #include <omniORB4/callHandle.h>
 #include <objectAdapter.h>
@@ -113,14 +114,14 @@ class omniLocalIdentity_RefHolder {
 public:
   inline omniLocalIdentity_RefHolder(omniLocalIdentity* id) : pd_id(id) {
     ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 1);
-    pd_id->pd_nInvocations++;
+    LOCALID_ADD(&pd_id->pd_nInvocations, 1);
   }
 
   inline ~omniLocalIdentity_RefHolder() {
     omni::internalLock->lock();
-    pd_id->pd_nInvocations--;
+    int n = LOCALID_ADD(&pd_id->pd_nInvocations, -1);
     pd_id->pd_adapter->leaveAdapter();
-    if (pd_id->pd_nInvocations > 0) {
+    if (n > 0) {
       omni::internalLock->unlock();
       return;
     }
@@ -136,6 +137,72 @@ private:
   omniLocalIdentity* pd_id;
 };
 
+
+class omniLocalIdentity_FastHolder {
+public:
+  inline omniLocalIdentity_FastHolder(omniObjTableEntry* entry,
+				      _CORBA_Boolean entered = 0)
+    : pd_id(entry)
+  {
+    // If <entered> is true, the caller has already entered the entry
+    // with fastEnter(), and the holder leaves it.
+    if (!entered && !pd_id->fastEnter())
+      pd_id = 0;
+  }
+
+  inline ~omniLocalIdentity_FastHolder() {
+    if (pd_id) pd_id->fastLeave();
+  }
+
+  inline _CORBA_Boolean entered() const { return pd_id != 0; }
+
+private:
+  omniObjTableEntry* pd_id;
+};
+
+
+// Passes a local call to the object adapter, without holding
+// <omni::internalLock> if <fast> is true.
+static _CORBA_Boolean
+adapterDispatch(omniObjAdapter* adapter, omniCallDescriptor& call_desc,
+		omniLocalIdentity* id, _CORBA_Boolean fast)
+{
+#ifndef HAS_Cplusplus_catch_exception_by_base
+  // The compiler cannot catch exceptions by base class, hence
+  // we cannot trap invalid exceptions going through here.
+  if (fast) return adapter->fastDispatch(call_desc, id);
+  adapter->dispatch(call_desc, id);
+  return 1;
+
+#else
+  try {
+    if (fast) return adapter->fastDispatch(call_desc, id);
+    adapter->dispatch(call_desc, id);
+    return 1;
+  }
+  catch (CORBA::SystemException& ex) {
+    throw;
+  }
+  catch (CORBA::UserException& ex) {
+    call_desc.validateUserException(ex);
+    throw;
+  }
+  catch (omniORB::LOCATION_FORWARD&) {
+    throw;
+  }
+
+  catch (...) {
+    if( omniORB::trace(2) ) {
+      omniORB::logger l;
+      l << "WARNING -- method \'" << call_desc.op() << "\' raised an unknown\n"
+	" exception (not a legal CORBA exception).\n";
+    }
+    OMNIORB_THROW(UNKNOWN,UNKNOWN_UserException, CORBA::COMPLETED_MAYBE);
+  }
+  return 0; // Not reached.
+#endif
+}
+
 OMNI_NAMESPACE_END(omni)
 
 
@@ -186,37 +253,90 @@ omniLocalIdentity::dispatch(omniCallDescriptor& call_desc)
 
   call_desc.localId(this);
 
+  if (pd_adapter->fastCalls())
+    call_desc.objref()->_enableFastCalls(this);
+
   omniLocalIdentity_RefHolder rh(this);
 
-  omni::localInvocationCount++;
+  // Fast calls update the count without the lock.
+  LOCALID_ADD(&omni::localInvocationCount, 1);
 
-#ifndef HAS_Cplusplus_catch_exception_by_base
-  // The compiler cannot catch exceptions by base class, hence
-  // we cannot trap invalid exceptions going through here.
-  pd_adapter->dispatch(call_desc, this);
+  adapterDispatch(pd_adapter, call_desc, this, 0);
+}
 
-#else
-  try { pd_adapter->dispatch(call_desc, this); }
 
-  catch (CORBA::SystemException& ex) {
-    throw;
-  }
-  catch (CORBA::UserException& ex) {
-    call_desc.validateUserException(ex);
-    throw;
-  }
-  catch (omniORB::LOCATION_FORWARD&) {
-    throw;
+_CORBA_Boolean
+omniObjTableEntry::fastEnter()
+{
+#ifdef LOCALID_HAVE_ATOMICS
+  // Once the count of invocations is zero, the object has been
+  // deactivated and is being etherealised, so it must not be entered
+  // again.
+  int n;
+  do {
+    n = pd_nInvocations;
+    if (n == 0)
+      return 0;
+  } while (!LOCALID_CAS(&pd_nInvocations, n, n + 1));
+
+  // Deactivation changes the state before it decrements the count,
+  // so if the state is still active, the thread deactivating the
+  // object will see this call in the count.
+  if (state() != ACTIVE) {
+    fastLeave();
+    return 0;
   }
+  return 1;
+#else
+  return 0;
+#endif
+}
 
-  catch (...) {
-    if( omniORB::trace(2) ) {
-      omniORB::logger l;
-      l << "WARNING -- method \'" << call_desc.op() << "\' raised an unknown\n"
-	" exception (not a legal CORBA exception).\n";
+
+void
+omniObjTableEntry::fastLeave()
+{
+  // Only the final decrement to zero needs the lock, so that it is
+  // seen atomically by a thread deactivating the object.
+  int n;
+  do {
+    n = pd_nInvocations;
+    if (n == 1) {
+      omni::internalLock->lock();
+      if (LOCALID_ADD(&pd_nInvocations, -1) > 0) {
+	omni::internalLock->unlock();
+	return;
+      }
+      adapter()->lastInvocationHasCompleted(this);
+
+      // lastInvocationHasCompleted() has released <omni::internalLock>.
+      return;
     }
-    OMNIORB_THROW(UNKNOWN,UNKNOWN_UserException, CORBA::COMPLETED_MAYBE);
-  }
+  } while (!LOCALID_CAS(&pd_nInvocations, n, n - 1));
+}
+
+
+_CORBA_Boolean
+omniObjTableEntry::fastDispatch(omniCallDescriptor& call_desc)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 0);
+
+#ifdef LOCALID_HAVE_ATOMICS
+  if (!call_desc.haslocalCallFn() ||
+      (call_desc.containsValues() && orbParameters::copyValuesInLocalCalls))
+    return 0;
+
+  omniLocalIdentity_FastHolder fh(this);
+  if (!fh.entered())
+    return 0;
+
+  call_desc.localId(this);
+
+  LOCALID_ADD(&omni::localInvocationCount, 1);
+
+  return adapterDispatch(pd_adapter, call_desc, this, 1);
+#else
+  return 0;
 #endif
 }
 
@@ -231,12 +351,27 @@ omniLocalIdentity::dispatch(omniCallHandle& handle)
 
   omniLocalIdentity_RefHolder rh(this);
 
-  omni::remoteInvocationCount++;
+  LOCALID_ADD(&omni::remoteInvocationCount, 1);
 
   pd_adapter->dispatch(handle, this);
 }
 
 
+_CORBA_Boolean
+omniObjTableEntry::fastDispatch(omniCallHandle& handle)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 0);
+
+  omniLocalIdentity_FastHolder fh(this, 1);
+
+  handle.localId(this);
+
+  LOCALID_ADD(&omni::remoteInvocationCount, 1);
+
+  return pd_adapter->fastDispatch(handle, this);
+}
+
+
 void
 omniLocalIdentity::gainRef(omniObjRef*)
 {
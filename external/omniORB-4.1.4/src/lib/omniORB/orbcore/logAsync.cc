@@ -0,0 +1,646 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// logAsync.cc                Created on: 2026/10/17
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//    Asynchronous log output.
+//
+//    With the traceAsync option, omniORB::logger and omniORB::logs()
+//    copy each formatted message into a ring buffer belonging to the
+//    calling thread, and a flusher task writes the buffers out every
+//    few milliseconds. Each ring has a single producer, its thread,
+//    and a single consumer, the flusher, so neither takes a lock; a
+//    message that does not fit is dropped and counted rather than
+//    making the thread wait. Threads not created by omnithread share
+//    one ring, protected by a mutex.
+//
+//    A ring holds records of a ringRecord header followed by the
+//    message, each aligned to RECORD_ALIGN bytes. A record never wraps
+//    around the end of the ring; if there is not room for it there, a
+//    pad record fills the rest and the record starts at the beginning.
+//    When a thread exits, its ring is left for the flusher to empty
+//    and delete.
+//
+//    With traceAsyncBinary, the messages are written to the log file
+//    as omniAsyncLog::binaryRecord records carrying the time and
+//    thread of each, to be decoded by the decodetrace utility.
+//
+
+#include <omniORB4/CORBA.h>
+#include <initialiser.h>
+#include <orbOptions.h>
+#include <orbParameters.h>
+#include <invoker.h>
+#include <metrics.h>
+#include <logAsync.h>
+
+#include <time.h>
+
+OMNI_USING_NAMESPACE(omni)
+
+////////////////////////////////////////////////////////////////////////////
+//             Configuration options                                      //
+////////////////////////////////////////////////////////////////////////////
+CORBA::Boolean orbParameters::traceAsync = 0;
+//   1 means log messages are queued in per-thread buffers and written
+//   by a background task, rather than by the thread that logs them.
+//
+//   Valid values = 0 or 1
+
+size_t orbParameters::traceAsyncBufferSize = 262144;
+//   Size in bytes of each thread's log buffer, rounded up to a power
+//   of two. Messages logged while the buffer is full are dropped.
+//
+//   Valid values = (n >= 4096)
+
+CORBA::Boolean orbParameters::traceAsyncBinary = 0;
+//   1 means asynchronous log messages are written to the log file as
+//   binary records, to be decoded with the decodetrace utility.
+//
+//   Valid values = 0 or 1
+
+
+#if defined(__GNUC__)
+#  define LOG_FENCE() __sync_synchronize()
+#else
+#  define LOG_FENCE()
+#endif
+
+enum {
+  RECORD_ALIGN       = 16,
+  PAD_RECORD         = 0xffffffff,
+  NO_THREAD          = 0xffffffff,
+  FLUSH_INTERVAL_NS  = 10000000      // 10 ms
+};
+
+volatile CORBA::Boolean omniAsyncLog::active = 0;
+
+
+////////////////////////////////////////////////////////////////////////////
+static inline CORBA::ULongLong
+now()
+{
+  // Wall clock time in nanoseconds.
+#if defined(CLOCK_REALTIME)
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (CORBA::ULongLong)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+  unsigned long s, ns;
+  omni_thread::get_time(&s, &ns);
+  return (CORBA::ULongLong)s * 1000000000 + ns;
+#endif
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//             Ring buffers                                               //
+////////////////////////////////////////////////////////////////////////////
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+struct ringRecord {
+  CORBA::ULong     length;     // Message length, or PAD_RECORD.
+  CORBA::ULong     reserved;
+  CORBA::ULongLong time;       // Set only for binary output.
+};
+
+class logRing {
+public:
+  logRing(size_t size, CORBA::ULong thread);
+  ~logRing();
+
+  void put(const char* msg, size_t len, CORBA::ULongLong time);
+  // Called by the owning thread only.
+
+  char*                   pd_buf;
+  size_t                  pd_size;      // A power of two.
+  volatile size_t         pd_head;      // Total bytes written. Set by
+					// the producer.
+  volatile size_t         pd_tail;      // Total bytes consumed. Set by
+					// the flusher.
+  volatile CORBA::ULong   pd_dropped;   // Set by the producer.
+  CORBA::ULong            pd_reported;  // Drops the flusher has logged.
+  CORBA::ULong            pd_thread;
+  volatile CORBA::Boolean pd_orphan;    // The owning thread has exited.
+  logRing*                pd_next;      // Protected by ringsLock.
+};
+
+static inline size_t
+recordSize(size_t len)
+{
+  return (sizeof(ringRecord) + len + RECORD_ALIGN - 1) &
+         ~(size_t)(RECORD_ALIGN - 1);
+}
+
+logRing::logRing(size_t size, CORBA::ULong thread)
+  : pd_size(size), pd_head(0), pd_tail(0), pd_dropped(0), pd_reported(0),
+    pd_thread(thread), pd_orphan(0), pd_next(0)
+{
+  pd_buf = (char*)new CORBA::ULongLong[size / sizeof(CORBA::ULongLong)];
+}
+
+logRing::~logRing()
+{
+  delete [] (CORBA::ULongLong*)pd_buf;
+}
+
+void
+logRing::put(const char* msg, size_t len, CORBA::ULongLong time)
+{
+  // Very long messages, such as message dumps at high trace levels,
+  // are cut short so that they can always fit.
+  CORBA::Boolean truncated = 0;
+  size_t max = pd_size / 2 - sizeof(ringRecord);
+  if (len > max) {
+    len = max;
+    truncated = 1;
+  }
+  size_t need = recordSize(len);
+
+  size_t head = pd_head;
+  size_t tail = pd_tail;
+  LOG_FENCE();
+
+  size_t off  = head & (pd_size - 1);
+  size_t room = pd_size - off;
+  size_t want = room < need ? room + need : need;
+
+  if (pd_size - (head - tail) < want) {
+    pd_dropped = pd_dropped + 1;
+    omniMetricsP::add(omniMetricsP::logMessagesDropped, 1);
+    return;
+  }
+  if (room < need) {
+    ((ringRecord*)(pd_buf + off))->length = PAD_RECORD;
+    head += room;
+    off   = 0;
+  }
+  ringRecord* r = (ringRecord*)(pd_buf + off);
+  r->length = (CORBA::ULong)len;
+  r->time   = time;
+
+  char* text = (char*)(r + 1);
+  memcpy(text, msg, len);
+  if (truncated)
+    text[len - 1] = '\n';
+
+  // The record must be complete before the flusher can see it.
+  LOG_FENCE();
+  pd_head = head + need;
+}
+
+
+class logRingHolder : public omni_thread::value_t {
+public:
+  logRingHolder(logRing* r) : pd_ring(r) {}
+  ~logRingHolder() {
+    // The thread is exiting. The flusher deletes the ring once it is
+    // empty.
+    LOG_FENCE();
+    pd_ring->pd_orphan = 1;
+  }
+  logRing* pd_ring;
+};
+
+
+static CORBA::Boolean     initialised = 0;
+static omni_thread::key_t ringKey     = 0;
+static size_t             ringSize    = 0;
+static omni_tracedmutex*  ringsLock   = 0;
+static logRing*           rings       = 0;
+static omni_tracedmutex*  sharedLock  = 0;
+static logRing*           sharedRing  = 0;
+
+
+static logRing*
+threadRing()
+{
+#if defined(__GNUC__)
+  omni_thread* self = omni_thread::self();
+  if (!self)
+    return 0;
+
+  logRingHolder* h = (logRingHolder*)self->get_value(ringKey);
+  if (!h) {
+    logRing* r = new logRing(ringSize, self->id());
+    {
+      omni_tracedmutex_lock sync(*ringsLock);
+      r->pd_next = rings;
+      rings = r;
+    }
+    h = new logRingHolder(r);
+    self->set_value(ringKey, h);
+  }
+  return h->pd_ring;
+#else
+  // Without memory barriers, all threads use the shared ring.
+  return 0;
+#endif
+}
+
+OMNI_NAMESPACE_END(omni)
+
+
+CORBA::Boolean
+omniAsyncLog::put(const char* msg, size_t len)
+{
+  CORBA::ULongLong time = orbParameters::traceAsyncBinary ? now() : 0;
+
+  logRing* r = threadRing();
+  if (r) {
+    r->put(msg, len, time);
+  }
+  else {
+    omni_tracedmutex_lock sync(*sharedLock);
+    sharedRing->put(msg, len, time);
+  }
+  return 1;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//             Output                                                     //
+////////////////////////////////////////////////////////////////////////////
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+static char*  scratch     = 0;
+static size_t scratchSize = 0;
+// For adding a terminating null to messages given to a log function.
+// Only used with ringsLock held.
+
+static void
+writeText(FILE* f, const char* text, size_t len)
+{
+  if (f) {
+    fwrite(text, 1, len, f);
+    return;
+  }
+  if (len >= scratchSize) {
+    delete [] scratch;
+    scratchSize = len + 256;
+    scratch     = new char[scratchSize];
+  }
+  memcpy(scratch, text, len);
+  scratch[len] = '\0';
+  omniLogOutput(scratch);
+}
+
+static void
+writeBinary(FILE* f, CORBA::ULong thread, CORBA::ULong dropped,
+	    CORBA::ULongLong time, const char* text, size_t len)
+{
+  omniAsyncLog::binaryRecord r;
+  r.magic   = omniAsyncLog::BINARY_MAGIC;
+  r.length  = (CORBA::ULong)len;
+  r.thread  = thread;
+  r.dropped = dropped;
+  r.time    = time;
+  fwrite(&r, sizeof(r), 1, f);
+  if (len)
+    fwrite(text, 1, len, f);
+}
+
+static void
+drain(logRing* r, FILE* f, CORBA::Boolean binary)
+{
+  // Caller holds ringsLock.
+  omni_tracedmutex* lock = (r == sharedRing) ? sharedLock : 0;
+
+  size_t head;
+  if (lock) {
+    omni_tracedmutex_lock sync(*lock);
+    head = r->pd_head;
+  }
+  else {
+    head = r->pd_head;
+    LOG_FENCE();
+  }
+
+  size_t tail = r->pd_tail;
+  while (tail != head) {
+    size_t      off = tail & (r->pd_size - 1);
+    ringRecord* rec = (ringRecord*)(r->pd_buf + off);
+
+    if (rec->length == PAD_RECORD) {
+      tail += r->pd_size - off;
+      continue;
+    }
+    const char* text = (const char*)(rec + 1);
+    if (binary)
+      writeBinary(f, r->pd_thread, 0, rec->time, text, rec->length);
+    else
+      writeText(f, text, rec->length);
+
+    tail += recordSize(rec->length);
+  }
+
+  if (lock) {
+    omni_tracedmutex_lock sync(*lock);
+    r->pd_tail = tail;
+  }
+  else {
+    // Finish reading the records before the producer can reuse them.
+    LOG_FENCE();
+    r->pd_tail = tail;
+  }
+
+  CORBA::ULong dropped = r->pd_dropped;
+  if (dropped != r->pd_reported) {
+    CORBA::ULong n = dropped - r->pd_reported;
+    r->pd_reported = dropped;
+
+    if (binary) {
+      writeBinary(f, r->pd_thread, n, now(), 0, 0);
+    }
+    else {
+      char buf[100];
+      if (r->pd_thread == NO_THREAD)
+	sprintf(buf, "omniORB: %lu log messages dropped by non-omni "
+		"threads.\n", (unsigned long)n);
+      else
+	sprintf(buf, "omniORB: %lu log messages dropped by thread %lu.\n",
+		(unsigned long)n, (unsigned long)r->pd_thread);
+      writeText(f, buf, strlen(buf));
+    }
+  }
+}
+
+static void
+drainAll()
+{
+  omni_tracedmutex_lock sync(*ringsLock);
+
+  FILE*          f      = omniLogFile();
+  CORBA::Boolean binary = orbParameters::traceAsyncBinary && f;
+
+  logRing** link = &rings;
+  while (*link) {
+    logRing* r = *link;
+    drain(r, f, binary);
+
+    if (r->pd_orphan) {
+      // Nothing more is written once the ring is orphaned.
+      LOG_FENCE();
+      if (r->pd_head == r->pd_tail) {
+	*link = r->pd_next;
+	delete r;
+	continue;
+      }
+    }
+    link = &r->pd_next;
+  }
+  if (f)
+    fflush(f);
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//             Flusher task                                               //
+////////////////////////////////////////////////////////////////////////////
+
+class logFlusher : public omniTask {
+public:
+  logFlusher() : omniTask(omniTask::AnyTime) {}
+  ~logFlusher() {}
+
+  void execute();
+
+  static void start();
+  // Start the task and make logging asynchronous.
+
+  static void terminate();
+  // Make logging synchronous again, stop the task and write out
+  // everything it had not.
+
+private:
+  static CORBA::Boolean          shutdown;
+  static omni_tracedmutex*       mutex;
+  static omni_tracedcondition*   cond;
+  static logFlusher*             theTask;
+};
+
+void
+logFlusher::execute()
+{
+  omniORB::logs(25, "Log flusher task execute.");
+
+  {
+    omni_tracedmutex_lock sync(*mutex);
+
+    while (!shutdown) {
+      unsigned long abs_sec,abs_nsec;
+      omni_thread::get_time(&abs_sec,&abs_nsec,0,FLUSH_INTERVAL_NS);
+      cond->timedwait(abs_sec,abs_nsec);
+
+      mutex->unlock();
+      drainAll();
+      mutex->lock();
+    }
+    theTask = 0;
+    cond->broadcast();
+  }
+  delete this;
+}
+
+void
+logFlusher::start()
+{
+  if (!mutex) {
+    mutex = new omni_tracedmutex();
+    cond  = new omni_tracedcondition(mutex);
+  }
+  omni_tracedmutex_lock sync(*mutex);
+  shutdown = 0;
+  if (!theTask) {
+    theTask = new logFlusher();
+    if (!orbAsyncInvoker->insert(theTask)) {
+      delete theTask;
+      theTask = 0;
+      omniORB::logs(2, "Unable to start the log flusher task. "
+		    "Log messages are written synchronously.");
+      return;
+    }
+  }
+  omniAsyncLog::active = 1;
+}
+
+void
+logFlusher::terminate()
+{
+  if (!mutex)
+    return;
+
+  omniAsyncLog::active = 0;
+  {
+    omni_tracedmutex_lock sync(*mutex);
+    shutdown = 1;
+    if (theTask) {
+      cond->broadcast();
+      while (theTask)
+	cond->wait();
+    }
+  }
+  drainAll();
+}
+
+CORBA::Boolean        logFlusher::shutdown = 0;
+omni_tracedmutex*     logFlusher::mutex = 0;
+omni_tracedcondition* logFlusher::cond = 0;
+logFlusher*           logFlusher::theTask = 0;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//            Handlers for Configuration Options                           //
+/////////////////////////////////////////////////////////////////////////////
+
+class traceAsyncHandler : public orbOptions::Handler {
+public:
+
+  traceAsyncHandler() :
+    orbOptions::Handler("traceAsync",
+			"traceAsync = 0 or 1",
+			1,
+			"-ORBtraceAsync < 0 | 1 >") {}
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::Boolean v;
+    if (!orbOptions::getBoolean(value,v)) {
+      throw orbOptions::BadParam(key(),value,
+				 orbOptions::expect_boolean_msg);
+    }
+    orbParameters::traceAsync = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVBoolean(key(),orbParameters::traceAsync,
+			     result);
+  }
+};
+
+static traceAsyncHandler traceAsyncHandler_;
+
+/////////////////////////////////////////////////////////////////////////////
+class traceAsyncBufferSizeHandler : public orbOptions::Handler {
+public:
+
+  traceAsyncBufferSizeHandler() :
+    orbOptions::Handler("traceAsyncBufferSize",
+			"traceAsyncBufferSize = n >= 4096",
+			1,
+			"-ORBtraceAsyncBufferSize < n >= 4096 >") {}
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::ULong v;
+    if (!orbOptions::getULong(value,v) || v < 4096) {
+      throw orbOptions::BadParam(key(),value,
+				 "Invalid value, expect n >= 4096");
+    }
+    orbParameters::traceAsyncBufferSize = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVULong(key(),orbParameters::traceAsyncBufferSize,
+			   result);
+  }
+};
+
+static traceAsyncBufferSizeHandler traceAsyncBufferSizeHandler_;
+
+/////////////////////////////////////////////////////////////////////////////
+class traceAsyncBinaryHandler : public orbOptions::Handler {
+public:
+
+  traceAsyncBinaryHandler() :
+    orbOptions::Handler("traceAsyncBinary",
+			"traceAsyncBinary = 0 or 1",
+			1,
+			"-ORBtraceAsyncBinary < 0 | 1 >") {}
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::Boolean v;
+    if (!orbOptions::getBoolean(value,v)) {
+      throw orbOptions::BadParam(key(),value,
+				 orbOptions::expect_boolean_msg);
+    }
+    orbParameters::traceAsyncBinary = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVBoolean(key(),orbParameters::traceAsyncBinary,
+			     result);
+  }
+};
+
+static traceAsyncBinaryHandler traceAsyncBinaryHandler_;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//            Module initialiser                                           //
+/////////////////////////////////////////////////////////////////////////////
+
+class omni_logAsync_initialiser : public omniInitialiser {
+public:
+
+  omni_logAsync_initialiser() {
+    orbOptions::singleton().registerHandler(traceAsyncHandler_);
+    orbOptions::singleton().registerHandler(traceAsyncBufferSizeHandler_);
+    orbOptions::singleton().registerHandler(traceAsyncBinaryHandler_);
+  }
+
+  void attach() {
+    if (!orbParameters::traceAsync)
+      return;
+
+    if (!initialised) {
+      // The rings of threads that outlive the ORB are kept, so they
+      // can be used again if it is restarted.
+      ringsLock   = new omni_tracedmutex;
+      sharedLock  = new omni_tracedmutex;
+      ringKey     = omni_thread::allocate_key();
+
+      ringSize = 4096;
+      while (ringSize < orbParameters::traceAsyncBufferSize)
+	ringSize *= 2;
+
+      sharedRing  = new logRing(ringSize, NO_THREAD);
+      rings       = sharedRing;
+      initialised = 1;
+    }
+    logFlusher::start();
+  }
+
+  void detach() {
+    logFlusher::terminate();
+  }
+};
+
+static omni_logAsync_initialiser initialiser;
+
+omniInitialiser& omni_logAsync_initialiser_ = initialiser;
+
+OMNI_NAMESPACE_END(omni)
@@ -135,6 +135,7 @@
 #include <objectTable.h>
 #include <remoteIdentity.h>
 #include <inProcessIdentity.h>
+#include <logAsync.h>
 #include <stdio.h>
 #include <ctype.h>
 #include <time.h>
@@ -200,6 +201,25 @@ omniORB::getLogFilename()
 {
   return (const char*)logfilename;
 }
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+void
+omniLogOutput(const char* msg)
+{
+  if (logfunc())
+    logfunc()(msg);
+  else
+    fputs(msg, logfile);
+}
+
+FILE*
+omniLogFile()
+{
+  return logfunc() ? 0 : logfile;
+}
+
+OMNI_NAMESPACE_END(omni)
   
 
 omniORB::logger::logger(const char* prefix)
@@ -237,7 +257,9 @@ omniORB::logger::logger(const char* prefix)
 omniORB::logger::~logger()
 {
   if( (size_t)(pd_p - pd_buf) != strlen(pd_prefix) ) {
-    if (logfunc())
+    if (omniAsyncLog::queue(pd_buf, pd_p - pd_buf))
+      ;
+    else if (logfunc())
       logfunc()(pd_buf);
     else {
       fputs(pd_buf, logfile);
@@ -442,7 +464,9 @@ void
 omniORB::logger::flush()
 {
   if( (size_t)(pd_p - pd_buf) != strlen(pd_prefix) ) {
-    if (logfunc())
+    if (omniAsyncLog::queue(pd_buf, pd_p - pd_buf))
+      ;
+    else if (logfunc())
       logfunc()(pd_buf);
     else
       fprintf(logfile, "%s", pd_buf);
@@ -516,9 +540,11 @@ omniORB::do_logs(const char* mesg)
   }
 #endif
 
-  sprintf(cbuf, "%s\n", mesg);
+  cbuf += sprintf(cbuf, "%s\n", mesg);
 
-  if (logfunc())
+  if (omniAsyncLog::queue(buf, cbuf - buf))
+    ;
+  else if (logfunc())
     logfunc()(buf);
   else
     fputs(buf, logfile);
@@ -0,0 +1,851 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// metrics.cc                 Created on: 2026/10/17
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//    Per-operation latency histograms and runtime counters.
+//
+//    Calls are timed by interceptors. The client side stamps the
+//    GIOP_C when the request is sent and records the call when the
+//    reply arrives; the server side stamps the GIOP_S when the request
+//    header has been read and records the call when the reply or
+//    exception is sent.
+//
+//    Each (side, interface, operation) has a record in a hash table.
+//    Records are only ever added, never removed or moved, so lookups
+//    take no lock; inserts are serialised by a mutex. The histogram
+//    buckets and totals are updated with atomic adds, so recording a
+//    call takes no lock either once its record exists.
+//
+
+#include <omniORB4/CORBA.h>
+#include <omniORB4/omniInterceptors.h>
+#include <omniORB4/omniMetrics.h>
+#include <initialiser.h>
+#include <orbOptions.h>
+#include <orbParameters.h>
+#include <interceptors.h>
+#include <invoker.h>
+#include <giopRope.h>
+#include <giopStrand.h>
+#include <giopStream.h>
+#include <GIOP_C.h>
+#include <GIOP_S.h>
+#include <metrics.h>
+
+#include <stdio.h>
+#include <time.h>
+
+OMNI_USING_NAMESPACE(omni)
+
+////////////////////////////////////////////////////////////////////////////
+//             Configuration options                                      //
+////////////////////////////////////////////////////////////////////////////
+CORBA::Boolean orbParameters::metrics = 1;
+//   1 means the ORB keeps a latency histogram for each operation it
+//   calls or dispatches. The other runtime counters are always kept.
+//
+//   Valid values = 0 or 1
+
+CORBA::String_var orbParameters::metricsDumpFile((const char*)"");
+//   If not empty, the name of a file the metrics are written to, as a
+//   JSON document, every metricsDumpPeriod seconds and when the ORB
+//   is shut down.
+//
+//   Valid values = a pathname, or the empty string
+
+CORBA::ULong orbParameters::metricsDumpPeriod = 60;
+//   Seconds between writes of metricsDumpFile. 0 means the file is only
+//   written when the ORB is shut down.
+//
+//   Valid values = (n >= 0 in seconds)
+
+
+////////////////////////////////////////////////////////////////////////////
+volatile CORBA::ULongLong omniMetricsP::bytesSent               = 0;
+volatile CORBA::ULongLong omniMetricsP::bytesReceived           = 0;
+volatile CORBA::ULongLong omniMetricsP::connectionsOpened       = 0;
+volatile CORBA::ULongLong omniMetricsP::connectionsAccepted     = 0;
+volatile CORBA::ULongLong omniMetricsP::clientConnectionsClosed = 0;
+volatile CORBA::ULongLong omniMetricsP::serverConnectionsClosed = 0;
+volatile CORBA::ULongLong omniMetricsP::connectionsReadable     = 0;
+volatile CORBA::ULongLong omniMetricsP::logMessagesDropped      = 0;
+volatile CORBA::ULong     omniMetricsP::ropes                   = 0;
+volatile CORBA::ULong     omniMetricsP::strands                 = 0;
+volatile CORBA::ULong     omniMetricsP::watchedSockets          = 0;
+volatile CORBA::ULong     omniMetricsP::upcallThreads           = 0;
+
+
+#if defined(__GNUC__)
+#  define METRICS_ADD(p,n)    __sync_fetch_and_add(&(p),(n))
+#  define METRICS_CAS(p,o,n)  __sync_bool_compare_and_swap(&(p),(o),(n))
+#  define METRICS_FENCE()     __sync_synchronize()
+#else
+// Updates from concurrent calls may be lost, so the histograms are
+// only approximate.
+#  define METRICS_ADD(p,n)    ((p) += (n))
+#  define METRICS_CAS(p,o,n)  ((p) == (o) ? ((p) = (n), 1) : 0)
+#  define METRICS_FENCE()
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////
+static inline CORBA::ULongLong
+now()
+{
+  // Monotonic time in nanoseconds.
+#if defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (CORBA::ULongLong)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+  unsigned long s, ns;
+  omni_thread::get_time(&s, &ns);
+  return (CORBA::ULongLong)s * 1000000000 + ns;
+#endif
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//             Histogram                                                  //
+////////////////////////////////////////////////////////////////////////////
+
+CORBA::ULong
+omniMetrics::Histogram::bucketIndex(CORBA::ULongLong ns)
+{
+  const int sub = SUB_BUCKET_BITS;
+
+  if (ns < (1 << (sub + 1)))
+    return (CORBA::ULong)ns;
+
+  int msb = 0;
+  for (CORBA::ULongLong v = ns; v >>= 1; ) msb++;
+
+  if (msb >= MAX_BITS)
+    return BUCKETS - 1;
+
+  return ((msb - sub + 1) << sub) +
+         (CORBA::ULong)((ns >> (msb - sub)) & ((1 << sub) - 1));
+}
+
+CORBA::ULongLong
+omniMetrics::Histogram::bucketLimit(CORBA::ULong index)
+{
+  const int sub = SUB_BUCKET_BITS;
+
+  if (index < (2 << sub))
+    return index;
+
+  int msb = (index >> sub) + sub - 1;
+
+  CORBA::ULongLong low = ((CORBA::ULongLong)((1 << sub) +
+					     (index & ((1 << sub) - 1)))
+			  << (msb - sub));
+  return low + ((CORBA::ULongLong)1 << (msb - sub)) - 1;
+}
+
+CORBA::ULongLong
+omniMetrics::Histogram::mean() const
+{
+  return count ? total / count : 0;
+}
+
+CORBA::ULongLong
+omniMetrics::Histogram::percentile(double p) const
+{
+  if (!count)
+    return 0;
+
+  CORBA::ULongLong target = (CORBA::ULongLong)(count * p / 100.0 + 0.999999);
+  if (target < 1)     target = 1;
+  if (target > count) target = count;
+
+  CORBA::ULongLong seen = 0;
+  for (CORBA::ULong i = 0; i < BUCKETS; i++) {
+    seen += buckets[i];
+    if (seen >= target) {
+      CORBA::ULongLong limit = bucketLimit(i);
+      return limit < max ? limit : max;
+    }
+  }
+  return max;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//             Operation records                                          //
+////////////////////////////////////////////////////////////////////////////
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+struct opRecord {
+  opRecord*                 next;
+  CORBA::ULong              hash;
+  CORBA::Boolean            server;
+  char*                     interfaceId;
+  char*                     name;
+  volatile CORBA::ULongLong exceptions;
+  volatile CORBA::ULongLong total;
+  volatile CORBA::ULongLong max;
+  volatile CORBA::ULongLong buckets[omniMetrics::Histogram::BUCKETS];
+};
+
+enum { OP_TABLE_SIZE = 256 };
+
+// Records are never freed, and operation names and client side
+// interface ids come from other processes, so the number of records
+// is limited. Once there are OP_TABLE_MAX, calls to any other
+// operation are counted in one OP_OVERFLOW_NAME record for each side.
+enum { OP_TABLE_MAX = 1024 };
+#define OP_OVERFLOW_NAME "other"
+
+static opRecord* volatile opTable[OP_TABLE_SIZE];
+static CORBA::ULong       opCount = 0;
+static opRecord* volatile opOverflow[2];
+static omni_tracedmutex   opTableLock;
+
+static CORBA::ULong
+hashOp(CORBA::Boolean server, const char* interfaceId, const char* name)
+{
+  CORBA::ULong h = server ? 1 : 0;
+  const char* p;
+  for (p = interfaceId; *p; p++) h = h * 33 + (unsigned char)*p;
+  for (p = name;        *p; p++) h = h * 33 + (unsigned char)*p;
+  return h;
+}
+
+static inline CORBA::Boolean
+matches(const opRecord* r, CORBA::ULong hash, CORBA::Boolean server,
+	const char* interfaceId, const char* name)
+{
+  return (r->hash == hash && r->server == server &&
+	  !strcmp(r->name, name) && !strcmp(r->interfaceId, interfaceId));
+}
+
+static opRecord*
+insertOp(CORBA::Boolean server, const char* interfaceId, const char* name)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(opTableLock, 1);
+
+  CORBA::ULong hash = hashOp(server, interfaceId, name);
+  CORBA::ULong b    = hash % OP_TABLE_SIZE;
+
+  // Another thread may have added the record in the meantime.
+  opRecord* r;
+  for (r = opTable[b]; r; r = r->next) {
+    if (matches(r, hash, server, interfaceId, name))
+      return r;
+  }
+
+  r = new opRecord;
+  memset((void*)r, 0, sizeof(*r));
+  r->next        = opTable[b];
+  r->hash        = hash;
+  r->server      = server;
+  r->interfaceId = CORBA::string_dup(interfaceId);
+  r->name        = CORBA::string_dup(name);
+
+  // The record must be complete before readers can see it.
+  METRICS_FENCE();
+  opTable[b] = r;
+  opCount++;
+  return r;
+}
+
+static opRecord*
+findOp(CORBA::Boolean server, const char* interfaceId, const char* name)
+{
+  CORBA::ULong hash = hashOp(server, interfaceId, name);
+  CORBA::ULong b    = hash % OP_TABLE_SIZE;
+
+  opRecord* r;
+  for (r = opTable[b]; r; r = r->next) {
+    if (matches(r, hash, server, interfaceId, name))
+      return r;
+  }
+
+  // Once the table is full, it stays full, so its overflow record can
+  // be used without the lock.
+  r = opOverflow[server ? 1 : 0];
+  if (r)
+    return r;
+
+  omni_tracedmutex_lock sync(opTableLock);
+
+  if (opCount < OP_TABLE_MAX)
+    return insertOp(server, interfaceId, name);
+
+  r = insertOp(server, "", OP_OVERFLOW_NAME);
+  opOverflow[server ? 1 : 0] = r;
+  return r;
+}
+
+static void
+recordCall(CORBA::Boolean server, const char* interfaceId, const char* name,
+	   CORBA::ULongLong start, CORBA::Boolean exception)
+{
+  if (!start)
+    return;
+
+  CORBA::ULongLong t = now() - start;
+  opRecord* r = findOp(server, interfaceId ? interfaceId : "", name);
+
+  METRICS_ADD(r->buckets[omniMetrics::Histogram::bucketIndex(t)], 1);
+  METRICS_ADD(r->total, t);
+  if (exception)
+    METRICS_ADD(r->exceptions, 1);
+
+  CORBA::ULongLong m = r->max;
+  while (t > m && !METRICS_CAS(r->max, m, t))
+    m = r->max;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//             Interceptors                                               //
+////////////////////////////////////////////////////////////////////////////
+
+static CORBA::Boolean
+clientSendRequest(omniInterceptors::clientSendRequest_T::info_T& info)
+{
+  info.giop_c.startTime(now());
+  return 1;
+}
+
+static CORBA::Boolean
+clientReceiveReply(omniInterceptors::clientReceiveReply_T::info_T& info)
+{
+  GIOP_C& giop_c = info.giop_c;
+  CORBA::Boolean exception;
+
+  switch (giop_c.replyStatus()) {
+  case GIOP::NO_EXCEPTION:
+    exception = 0;
+    break;
+  case GIOP::USER_EXCEPTION:
+  case GIOP::SYSTEM_EXCEPTION:
+    exception = 1;
+    break;
+  default:
+    // Forwarded; the call is timed again when it is retried.
+    return 1;
+  }
+  omniCallDescriptor* cd = giop_c.calldescriptor();
+  omniObjRef* objref = cd->objref();
+  recordCall(0, objref ? objref->_mostDerivedRepoId() : "", cd->op(),
+	     giop_c.startTime(), exception);
+  return 1;
+}
+
+static CORBA::Boolean
+serverReceiveRequest(omniInterceptors::serverReceiveRequest_T::info_T& info)
+{
+  info.giop_s.startTime(now());
+  return 1;
+}
+
+static CORBA::Boolean
+serverSendReply(omniInterceptors::serverSendReply_T::info_T& info)
+{
+  GIOP_S& giop_s = info.giop_s;
+
+  // Requests that found no object are not recorded, so that clients
+  // cannot create records by sending arbitrary operation names.
+  if (giop_s.targetRepoId())
+    recordCall(1, giop_s.targetRepoId(), giop_s.operation_name(),
+	       giop_s.startTime(), 0);
+  return 1;
+}
+
+static CORBA::Boolean
+serverSendException(omniInterceptors::serverSendException_T::info_T& info)
+{
+  GIOP_S& giop_s = info.giop_s;
+  if (giop_s.targetRepoId())
+    recordCall(1, giop_s.targetRepoId(), giop_s.operation_name(),
+	       giop_s.startTime(), 1);
+  return 1;
+}
+
+static void
+countUpcallThread(omniInterceptors::assignUpcallThread_T::info_T& info)
+{
+  omniMetricsP::incr(omniMetricsP::upcallThreads);
+  try {
+    info.run();
+  }
+  catch (...) {
+    omniMetricsP::decr(omniMetricsP::upcallThreads);
+    throw;
+  }
+  omniMetricsP::decr(omniMetricsP::upcallThreads);
+}
+
+OMNI_NAMESPACE_END(omni)
+
+
+////////////////////////////////////////////////////////////////////////////
+//             Snapshots                                                  //
+////////////////////////////////////////////////////////////////////////////
+
+omniMetrics::Snapshot::Snapshot() : pd_operations(0), pd_count(0)
+{
+  {
+    omni_tracedmutex_lock sync(opTableLock);
+
+    if (opCount)
+      pd_operations = new Operation[opCount];
+
+    for (CORBA::ULong b = 0; b < OP_TABLE_SIZE; b++) {
+      for (opRecord* r = opTable[b]; r; r = r->next) {
+	Operation& op = pd_operations[pd_count++];
+	op.interfaceId = r->interfaceId;
+	op.name        = r->name;
+	op.server      = r->server;
+	op.exceptions  = r->exceptions;
+
+	Histogram& h = op.latency;
+	h.count = 0;
+	for (CORBA::ULong i = 0; i < Histogram::BUCKETS; i++) {
+	  h.buckets[i] = r->buckets[i];
+	  h.count     += h.buckets[i];
+	}
+	h.total = r->total;
+	h.max   = r->max;
+      }
+    }
+  }
+
+  Counters& c = pd_counters;
+  c.bytesSent               = omniMetricsP::bytesSent;
+  c.bytesReceived           = omniMetricsP::bytesReceived;
+  c.connectionsOpened       = omniMetricsP::connectionsOpened;
+  c.connectionsAccepted     = omniMetricsP::connectionsAccepted;
+  c.clientConnectionsClosed = omniMetricsP::clientConnectionsClosed;
+  c.serverConnectionsClosed = omniMetricsP::serverConnectionsClosed;
+  c.connectionsReadable     = omniMetricsP::connectionsReadable;
+  c.logMessagesDropped      = omniMetricsP::logMessagesDropped;
+  c.ropes                   = omniMetricsP::ropes;
+  c.strands                 = omniMetricsP::strands;
+  c.watchedSockets          = omniMetricsP::watchedSockets;
+  c.upcallThreads           = omniMetricsP::upcallThreads;
+
+  unsigned int threads = 0, idle = 0, queued = 0;
+  if (orbAsyncInvoker)
+    orbAsyncInvoker->stats(threads, idle, queued);
+  c.invokerThreads     = threads;
+  c.invokerIdleThreads = idle;
+  c.invokerQueuedTasks = queued;
+}
+
+omniMetrics::Snapshot::~Snapshot()
+{
+  delete [] pd_operations;
+}
+
+void
+omniMetrics::reset()
+{
+  {
+    omni_tracedmutex_lock sync(opTableLock);
+
+    for (CORBA::ULong b = 0; b < OP_TABLE_SIZE; b++) {
+      for (opRecord* r = opTable[b]; r; r = r->next) {
+	for (CORBA::ULong i = 0; i < Histogram::BUCKETS; i++)
+	  r->buckets[i] = 0;
+	r->exceptions = 0;
+	r->total      = 0;
+	r->max        = 0;
+      }
+    }
+  }
+  omniMetricsP::bytesSent               = 0;
+  omniMetricsP::bytesReceived           = 0;
+  omniMetricsP::connectionsOpened       = 0;
+  omniMetricsP::connectionsAccepted     = 0;
+  omniMetricsP::clientConnectionsClosed = 0;
+  omniMetricsP::serverConnectionsClosed = 0;
+  omniMetricsP::connectionsReadable     = 0;
+  omniMetricsP::logMessagesDropped      = 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//             JSON dump                                                  //
+////////////////////////////////////////////////////////////////////////////
+
+static void
+writeULL(FILE* f, CORBA::ULongLong v)
+{
+  char buf[24];
+  char* p = buf + sizeof(buf);
+  *--p = '\0';
+  do {
+    *--p = '0' + (char)(v % 10);
+    v /= 10;
+  } while (v);
+  fputs(p, f);
+}
+
+static void
+writeString(FILE* f, const char* s)
+{
+  fputc('"', f);
+  for (; *s; s++) {
+    unsigned char c = *s;
+    if (c == '"' || c == '\\')
+      fprintf(f, "\\%c", c);
+    else if (c < 0x20)
+      fprintf(f, "\\u%04x", c);
+    else
+      fputc(c, f);
+  }
+  fputc('"', f);
+}
+
+static void
+writeField(FILE* f, const char* name, CORBA::ULongLong v,
+	   const char* sep = ", ")
+{
+  fprintf(f, "\"%s\": ", name);
+  writeULL(f, v);
+  fputs(sep, f);
+}
+
+CORBA::Boolean
+omniMetrics::dump(const char* filename)
+{
+  Snapshot snap;
+
+  CORBA::String_var tmp = CORBA::string_alloc(strlen(filename) + 4);
+  sprintf(tmp, "%s.tmp", filename);
+
+  FILE* f = fopen(tmp, "w");
+  if (!f) {
+    if (omniORB::trace(2)) {
+      omniORB::logger log;
+      log << "Unable to write metrics to '" << (const char*)tmp << "'.\n";
+    }
+    return 0;
+  }
+
+  unsigned long secs, nsecs;
+  omni_thread::get_time(&secs, &nsecs);
+
+  fputs("{\n  ", f);
+  writeField(f, "time", secs, ",\n");
+
+  const Counters& c = snap.counters();
+  const char* sep = ",\n    ";
+  fputs("  \"counters\": {\n    ", f);
+  writeField(f, "bytes_sent",                 c.bytesSent, sep);
+  writeField(f, "bytes_received",             c.bytesReceived, sep);
+  writeField(f, "connections_opened",         c.connectionsOpened, sep);
+  writeField(f, "connections_accepted",       c.connectionsAccepted, sep);
+  writeField(f, "client_connections_closed",  c.clientConnectionsClosed, sep);
+  writeField(f, "server_connections_closed",  c.serverConnectionsClosed, sep);
+  writeField(f, "connections_readable",       c.connectionsReadable, sep);
+  writeField(f, "log_messages_dropped",       c.logMessagesDropped, sep);
+  writeField(f, "ropes",                      c.ropes, sep);
+  writeField(f, "strands",                    c.strands, sep);
+  writeField(f, "watched_sockets",            c.watchedSockets, sep);
+  writeField(f, "upcall_threads",             c.upcallThreads, sep);
+  writeField(f, "invoker_threads",            c.invokerThreads, sep);
+  writeField(f, "invoker_idle_threads",       c.invokerIdleThreads, sep);
+  writeField(f, "invoker_queued_tasks",       c.invokerQueuedTasks, "\n");
+  fputs("  },\n  \"operations\": [", f);
+
+  for (CORBA::ULong i = 0; i < snap.operationCount(); i++) {
+    const Operation& op = snap.operation(i);
+    const Histogram& h  = op.latency;
+
+    fputs(i ? ",\n    {" : "\n    {", f);
+    fputs("\"interface\": ", f);
+    writeString(f, op.interfaceId);
+    fputs(", \"operation\": ", f);
+    writeString(f, op.name);
+    fputs(op.server ? ", \"side\": \"server\", " : ", \"side\": \"client\", ",
+	  f);
+    writeField(f, "count",      h.count);
+    writeField(f, "exceptions", op.exceptions);
+    writeField(f, "mean_ns",    h.mean());
+    writeField(f, "p50_ns",     h.percentile(50));
+    writeField(f, "p90_ns",     h.percentile(90));
+    writeField(f, "p99_ns",     h.percentile(99));
+    writeField(f, "p999_ns",    h.percentile(99.9));
+    writeField(f, "max_ns",     h.max, "}");
+  }
+  fputs(snap.operationCount() ? "\n  ]\n}\n" : "]\n}\n", f);
+
+  CORBA::Boolean ok = !ferror(f);
+  if (fclose(f) != 0)
+    ok = 0;
+
+  if (ok && rename(tmp, filename) != 0)
+    ok = 0;
+
+  if (!ok) {
+    remove(tmp);
+    if (omniORB::trace(2)) {
+      omniORB::logger log;
+      log << "Unable to write metrics to '" << filename << "'.\n";
+    }
+  }
+  return ok;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//             Periodic dump task                                         //
+////////////////////////////////////////////////////////////////////////////
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+class MetricsDumper : public omniTask {
+public:
+  MetricsDumper() : omniTask(omniTask::AnyTime) {}
+  ~MetricsDumper() {}
+
+  void execute();
+
+  static void start();
+  // Start the task, if it is not already running.
+
+  static void terminate();
+  // Wait for the task to finish.
+
+private:
+  static CORBA::Boolean          shutdown;
+  static omni_tracedmutex*       mutex;
+  static omni_tracedcondition*   cond;
+  static MetricsDumper*          theTask;
+};
+
+void
+MetricsDumper::execute()
+{
+  omniORB::logs(25, "Metrics dumper task execute.");
+
+  {
+    omni_tracedmutex_lock sync(*mutex);
+
+    while (!shutdown) {
+      unsigned long abs_sec,abs_nsec;
+      omni_thread::get_time(&abs_sec,&abs_nsec,
+			    orbParameters::metricsDumpPeriod);
+
+      // timedwait() returns 0 once the time has passed.
+      while (!shutdown && cond->timedwait(abs_sec,abs_nsec)) ;
+
+      if (shutdown)
+	break;
+
+      mutex->unlock();
+      omniMetrics::dump(orbParameters::metricsDumpFile);
+      mutex->lock();
+    }
+
+    omniORB::logs(25, "Metrics dumper task finish.");
+    theTask = 0;
+    cond->broadcast();
+  }
+  delete this;
+}
+
+void
+MetricsDumper::start()
+{
+  if (!mutex) {
+    mutex = new omni_tracedmutex();
+    cond  = new omni_tracedcondition(mutex);
+  }
+  omni_tracedmutex_lock sync(*mutex);
+  shutdown = 0;
+  if (!theTask) {
+    theTask = new MetricsDumper();
+    if (!orbAsyncInvoker->insert(theTask)) {
+      // Cannot start a thread; the file is still written at shutdown.
+      delete theTask;
+      theTask = 0;
+    }
+  }
+}
+
+void
+MetricsDumper::terminate()
+{
+  if (!mutex)
+    return;
+
+  omni_tracedmutex_lock sync(*mutex);
+  shutdown = 1;
+  if (theTask) {
+    cond->broadcast();
+    while (theTask)
+      cond->wait();
+  }
+}
+
+CORBA::Boolean        MetricsDumper::shutdown = 0;
+omni_tracedmutex*     MetricsDumper::mutex = 0;
+omni_tracedcondition* MetricsDumper::cond = 0;
+MetricsDumper*        MetricsDumper::theTask = 0;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//            Handlers for Configuration Options                           //
+/////////////////////////////////////////////////////////////////////////////
+
+class metricsHandler : public orbOptions::Handler {
+public:
+
+  metricsHandler() :
+    orbOptions::Handler("metrics",
+			"metrics = 0 or 1",
+			1,
+			"-ORBmetrics < 0 | 1 >") {}
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::Boolean v;
+    if (!orbOptions::getBoolean(value,v)) {
+      throw orbOptions::BadParam(key(),value,
+				 orbOptions::expect_boolean_msg);
+    }
+    orbParameters::metrics = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVBoolean(key(),orbParameters::metrics,
+			     result);
+  }
+};
+
+static metricsHandler metricsHandler_;
+
+/////////////////////////////////////////////////////////////////////////////
+class metricsDumpFileHandler : public orbOptions::Handler {
+public:
+
+  metricsDumpFileHandler() :
+    orbOptions::Handler("metricsDumpFile",
+			"metricsDumpFile = <file name>",
+			1,
+			"-ORBmetricsDumpFile <file name>") {}
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+    orbParameters::metricsDumpFile = value;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+
+    CORBA::String_var kv;
+    CORBA::ULong l;
+
+    const char* format = "metricsDumpFile = %s";
+
+    l = strlen(format) + strlen(orbParameters::metricsDumpFile);
+    kv = CORBA::string_alloc(l);
+    sprintf(kv,format,(const char*)orbParameters::metricsDumpFile);
+
+    l = result.length();
+    result.length(l+1);
+    result[l] = kv._retn();
+  }
+};
+
+static metricsDumpFileHandler metricsDumpFileHandler_;
+
+/////////////////////////////////////////////////////////////////////////////
+class metricsDumpPeriodHandler : public orbOptions::Handler {
+public:
+
+  metricsDumpPeriodHandler() :
+    orbOptions::Handler("metricsDumpPeriod",
+			"metricsDumpPeriod = n >= 0 sec",
+			1,
+			"-ORBmetricsDumpPeriod < n >= 0 sec >") {}
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::ULong v;
+    if (!orbOptions::getULong(value,v)) {
+      throw orbOptions::BadParam(key(),value,
+				 orbOptions::expect_ulong_msg);
+    }
+    orbParameters::metricsDumpPeriod = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVULong(key(),orbParameters::metricsDumpPeriod,
+			   result);
+  }
+};
+
+static metricsDumpPeriodHandler metricsDumpPeriodHandler_;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//            Module initialiser                                           //
+/////////////////////////////////////////////////////////////////////////////
+
+class omni_metrics_initialiser : public omniInitialiser {
+public:
+
+  omni_metrics_initialiser() {
+    orbOptions::singleton().registerHandler(metricsHandler_);
+    orbOptions::singleton().registerHandler(metricsDumpFileHandler_);
+    orbOptions::singleton().registerHandler(metricsDumpPeriodHandler_);
+  }
+
+  void attach() {
+    omniInterceptors* interceptors = omniORB::getInterceptors();
+
+    // The interceptor lists are emptied when the ORB is destroyed.
+    interceptors->assignUpcallThread.add(countUpcallThread);
+
+    if (orbParameters::metrics) {
+      interceptors->clientSendRequest.add(clientSendRequest);
+      interceptors->clientReceiveReply.add(clientReceiveReply);
+      interceptors->serverReceiveRequest.add(serverReceiveRequest);
+      interceptors->serverSendReply.add(serverSendReply);
+      interceptors->serverSendException.add(serverSendException);
+    }
+
+    if (*orbParameters::metricsDumpFile && orbParameters::metricsDumpPeriod)
+      MetricsDumper::start();
+  }
+
+  void detach() {
+    MetricsDumper::terminate();
+
+    if (*orbParameters::metricsDumpFile)
+      omniMetrics::dump(orbParameters::metricsDumpFile);
+  }
+};
+
+static omni_metrics_initialiser initialiser;
+
+omniInitialiser& omni_metrics_initialiser_ = initialiser;
+
+OMNI_NAMESPACE_END(omni)
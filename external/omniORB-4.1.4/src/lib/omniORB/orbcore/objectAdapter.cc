@@ -593,7 +593,8 @@ omniObjAdapter::waitForActiveRequestsToComplete(int locked)
   OMNIORB_ASSERT(pd_nReqActive >= 0);
 
   pd_signalOnZeroInvocations++;
-  while( pd_nReqActive )  pd_signal->wait();
+  LOCALID_FENCE();
+  while( pd_nReqActive || pd_nReqFast )  pd_signal->wait();
   pd_signalOnZeroInvocations--;
 
   if( !locked )  omni::internalLock->unlock();
@@ -611,13 +612,56 @@ omniObjAdapter::waitForAllRequestsToComplete(int locked)
   OMNIORB_ASSERT(pd_nReqInThis >= 0);
 
   pd_signalOnZeroInvocations++;
-  while( pd_nReqInThis )  pd_signal->wait();
+  LOCALID_FENCE();
+  while( pd_nReqInThis || pd_nReqFast )  pd_signal->wait();
   pd_signalOnZeroInvocations--;
 
   if( !locked )  omni::internalLock->unlock();
 }
 
 
+//////////////////////////////////////////////////////////////////////
+_CORBA_Boolean
+omniObjAdapter::fastDispatch(omniCallDescriptor&, omniLocalIdentity*)
+{
+  return 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+_CORBA_Boolean
+omniObjAdapter::fastDispatch(omniCallHandle&, omniLocalIdentity*)
+{
+  return 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void
+omniObjAdapter::enterFast()
+{
+  LOCALID_ADD(&pd_nReqFast, 1);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+void
+omniObjAdapter::leaveFast(int locked)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, locked);
+
+  // A waiter increments <pd_signalOnZeroInvocations> before it looks
+  // at <pd_nReqFast>, and we look at it after our decrement, so one
+  // of us sees the other. The broadcast is made with the lock held,
+  // so it cannot come between a waiter's test and its wait().
+  if( LOCALID_ADD(&pd_nReqFast, -1) == 0 && pd_signalOnZeroInvocations ) {
+    if( !locked )  omni::internalLock->lock();
+    pd_signal->broadcast();
+    if( !locked )  omni::internalLock->unlock();
+  }
+}
+
+
 //////////////////////////////////////////////////////////////////////
 void
 omniObjAdapter::met_detached_object()
@@ -691,6 +735,8 @@ omniObjAdapter::omniObjAdapter(int nil)
   : pd_nReqInThis(0),
     pd_nReqActive(0),
     pd_signalOnZeroInvocations(0),
+    pd_nReqFast(0),
+    pd_fastCalls(0),
     pd_signal(0),
     pd_nDetachedObjects(0),
     pd_signalOnZeroDetachedObjects(0),
@@ -744,6 +790,7 @@ public:
 "          <endpoint uri> = \"giop:tcp:<host>:<port>\" |\n"
 "                          *\"giop:ssl:<host>:<port>\" |\n"
 "                          *\"giop:unix:<filename>\"   |\n"
+"                          *\"giop:shm:<filename>\"    |\n"
 "                          *\"giop:fd:<no.>\"          |\n"
 "                          *\"<other protocol>:<network protocol>:<options>\"\n"
 "                          * may not be supported on the platform.\n") {}
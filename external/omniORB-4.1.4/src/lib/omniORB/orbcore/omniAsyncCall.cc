@@ -0,0 +1,182 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// omniAsyncCall.cc
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//    Futures for calls made with the sendc_ stubs.
+//
+
+#include <omniORB4/CORBA.h>
+#include <omniORB4/callDescriptor.h>
+#include <exceptiondefs.h>
+
+OMNI_USING_NAMESPACE(omni)
+
+static omni_tracedmutex asyncCallLock;
+// Protects the state of every omniAsyncCall. It is only held briefly,
+// and never while a handler runs.
+
+
+omniAsyncCallback::~omniAsyncCallback() {}
+
+
+omniAsyncCall::omniAsyncCall(omniCallDescriptor* cd,
+			     omniAsyncCallback* handler)
+  : pd_cd(cd), pd_handler(handler), pd_objref(0), pd_identity(0),
+    pd_exception(0), pd_cond(0), pd_refCount(1),
+    pd_sent(0), pd_completed(0), pd_retrieved(0)
+{
+  cd->asyncCall(this);
+}
+
+
+omniAsyncCall::~omniAsyncCall()
+{
+  OMNIORB_ASSERT(!pd_objref && !pd_identity);
+  delete pd_cd;
+  delete pd_exception;
+  delete pd_cond;
+}
+
+
+void
+omniAsyncCall::_add_ref()
+{
+  omni_tracedmutex_lock sync(asyncCallLock);
+  pd_refCount++;
+}
+
+
+void
+omniAsyncCall::_remove_ref()
+{
+  {
+    omni_tracedmutex_lock sync(asyncCallLock);
+    OMNIORB_ASSERT(pd_refCount > 0);
+    if (--pd_refCount > 0) return;
+  }
+  delete this;
+}
+
+
+CORBA::Boolean
+omniAsyncCall::poll()
+{
+  omni_tracedmutex_lock sync(asyncCallLock);
+  return pd_completed;
+}
+
+
+void
+omniAsyncCall::wait()
+{
+  omni_tracedmutex_lock sync(asyncCallLock);
+
+  if (!pd_completed && !pd_cond)
+    pd_cond = new omni_tracedcondition(&asyncCallLock);
+
+  while (!pd_completed)
+    pd_cond->wait();
+}
+
+
+CORBA::Boolean
+omniAsyncCall::wait(CORBA::ULong millisecs)
+{
+  unsigned long s, ns;
+  omni_thread::get_time(&s, &ns, millisecs / 1000,
+			(millisecs % 1000) * 1000000);
+
+  omni_tracedmutex_lock sync(asyncCallLock);
+
+  if (!pd_completed && !pd_cond)
+    pd_cond = new omni_tracedcondition(&asyncCallLock);
+
+  while (!pd_completed) {
+    if (!pd_cond->timedwait(s, ns))
+      break;
+  }
+  return pd_completed;
+}
+
+
+omniCallDescriptor*
+omniAsyncCall::_retrieve()
+{
+  wait();
+  {
+    omni_tracedmutex_lock sync(asyncCallLock);
+
+    if (pd_retrieved)
+      OMNIORB_THROW(BAD_INV_ORDER, BAD_INV_ORDER_ResultAlreadyReceived,
+		    CORBA::COMPLETED_NO);
+    pd_retrieved = 1;
+  }
+  // The exception does not change once the call has completed.
+  if (pd_exception)
+    pd_exception->_raise();
+
+  return pd_cd;
+}
+
+
+void
+omniAsyncCall::complete(CORBA::Exception* ex)
+{
+  omniObjRef* objref;
+  {
+    omni_tracedmutex_lock sync(asyncCallLock);
+    OMNIORB_ASSERT(!pd_completed);
+
+    pd_exception = ex;
+    pd_completed = 1;
+    objref       = pd_objref;
+    pd_objref    = 0;
+
+    if (pd_cond)
+      pd_cond->broadcast();
+  }
+
+  if (omniORB::traceInvocationReturns) {
+    omniORB::logger l;
+    l << "Complete asynchronous '" << pd_cd->op() << "'";
+    if (ex)
+      l << " (" << ex->_name() << ")";
+    l << '\n';
+  }
+
+  if (pd_handler) {
+    try {
+      pd_handler->completed(this);
+    }
+    catch (...) {
+      omniORB::logs(1, "Warning: an asynchronous call handler raised an "
+		    "exception, which has been ignored.");
+    }
+  }
+
+  if (objref)
+    omni::releaseObjRef(objref);
+
+  _remove_ref();
+}
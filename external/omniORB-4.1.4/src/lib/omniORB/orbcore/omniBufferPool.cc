@@ -0,0 +1,488 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// omniBufferPool.cc          Created on: 2026/10/17
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//    Size-class pool for GIOP message buffers and cdrMemoryStream storage.
+//
+//    Every block carries an 8 byte header recording its size class, so
+//    release() needs no size argument. Class n holds blocks of
+//    (256 << n) + 64 bytes; the slack lets the ORB's standard 8KB GIOP
+//    buffer, plus its giopStream_Buffer header, fit in the 8KB class
+//    rather than wasting half of a 16KB block. Requests above the
+//    largest class are passed straight to the heap.
+//
+//    Each omni_thread has a cache of free lists, one per class, limited
+//    to orbParameters::bufferPoolThreadCache bytes. Behind the caches
+//    is a shared depot, limited to orbParameters::bufferPoolMaxRetained
+//    bytes. Blocks move between a cache and the depot in batches, so
+//    the depot lock is taken at most once every POOL_BATCH operations
+//    of a thread that allocates in one thread and releases in another.
+//    Threads not created by omnithread have no cache and use the depot
+//    directly.
+//
+
+#include <omniORB4/CORBA.h>
+#include <initialiser.h>
+#include <orbOptions.h>
+#include <orbParameters.h>
+#include <omniBufferPool.h>
+
+OMNI_USING_NAMESPACE(omni)
+
+////////////////////////////////////////////////////////////////////////////
+//             Configuration options                                      //
+////////////////////////////////////////////////////////////////////////////
+size_t orbParameters::bufferPoolThreadCache = 262144;
+//   Maximum number of bytes of free GIOP and cdrMemoryStream buffers
+//   each thread keeps for its own reuse. 0 disables the per-thread
+//   caches.
+//
+//   Valid values = (n >= 0)
+
+size_t orbParameters::bufferPoolMaxRetained = 4194304;
+//   Maximum number of bytes of free buffers held in the pool shared by
+//   all threads. Blocks released by threads whose cache is full go
+//   here; beyond this limit they are returned to the heap. 0 disables
+//   the shared pool.
+//
+//   Valid values = (n >= 0)
+
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+#define POOL_MIN_SHIFT 8
+#define POOL_CLASSES   9
+#define POOL_SLACK     64
+#define POOL_BATCH     8
+#define POOL_NO_CLASS  (-1)
+
+static inline size_t
+classSize(int c)
+{
+  return ((size_t)1 << (c + POOL_MIN_SHIFT)) + POOL_SLACK;
+}
+
+static inline int
+sizeClass(size_t size)
+{
+  if (size > classSize(POOL_CLASSES - 1))
+    return POOL_NO_CLASS;
+
+  int c = 0;
+  while (classSize(c) < size)
+    ++c;
+  return c;
+}
+
+union poolHeader {
+  CORBA::Long sizeClass;
+  double      align;     // Keep the block data 8 byte aligned
+};
+
+static inline poolHeader*
+headerOf(void* block)
+{
+  return (poolHeader*)block - 1;
+}
+
+static inline void*&
+nextOf(void* block)
+{
+  // A free block's first word links it into its free list.
+  return *(void**)block;
+}
+
+static void*
+heapAllocate(size_t size, int c)
+{
+  if (c != POOL_NO_CLASS)
+    size = classSize(c);
+
+  poolHeader* h = (poolHeader*)new char[sizeof(poolHeader) + size];
+  h->sizeClass  = c;
+  return h + 1;
+}
+
+static inline void
+heapDelete(void* block)
+{
+  delete [] (char*)headerOf(block);
+}
+
+
+//
+// The shared depot. Everything here is protected by depotLock, except
+// that depotCount may be peeked at without it as a hint.
+
+static omni_tracedmutex* depotLock = 0;
+static void*             depotList[POOL_CLASSES];
+static CORBA::ULong      depotCount[POOL_CLASSES];
+static size_t            depotBytes  = 0;
+static unsigned long     depotHits   = 0;
+static unsigned long     depotMisses = 0;
+
+static CORBA::Boolean     poolInitialised = 0;
+static omni_thread::key_t cacheKey        = 0;
+
+
+//
+// Per-thread cache.
+
+class omniBufferPoolCache : public omni_thread::value_t {
+public:
+  omniBufferPoolCache();
+  ~omniBufferPoolCache();
+
+  void*          pd_list[POOL_CLASSES];
+  CORBA::ULong   pd_count[POOL_CLASSES];
+  size_t         pd_bytes;
+  unsigned long  pd_hits;
+  unsigned long  pd_misses;
+
+  omniBufferPoolCache* pd_next;
+  omniBufferPoolCache* pd_prev;
+  // All caches are linked together so stats() can find them.
+  // Protected by depotLock.
+};
+
+static omniBufferPoolCache* caches = 0;
+
+
+static void
+depotPush(void* block, int c)
+{
+  // Caller must hold depotLock.
+  if (depotBytes + classSize(c) > orbParameters::bufferPoolMaxRetained) {
+    heapDelete(block);
+    return;
+  }
+  nextOf(block)  = depotList[c];
+  depotList[c]   = block;
+  depotCount[c] += 1;
+  depotBytes    += classSize(c);
+}
+
+static void*
+depotPop(int c)
+{
+  // Caller must hold depotLock.
+  void* block = depotList[c];
+  if (block) {
+    depotList[c]   = nextOf(block);
+    depotCount[c] -= 1;
+    depotBytes    -= classSize(c);
+  }
+  return block;
+}
+
+
+omniBufferPoolCache::omniBufferPoolCache()
+  : pd_bytes(0), pd_hits(0), pd_misses(0), pd_prev(0)
+{
+  for (int c = 0; c < POOL_CLASSES; c++) {
+    pd_list[c]  = 0;
+    pd_count[c] = 0;
+  }
+  omni_tracedmutex_lock sync(*depotLock);
+  pd_next = caches;
+  if (caches) caches->pd_prev = this;
+  caches = this;
+}
+
+omniBufferPoolCache::~omniBufferPoolCache()
+{
+  // The thread is exiting. Hand its free blocks and counts to the depot.
+  omni_tracedmutex_lock sync(*depotLock);
+
+  for (int c = 0; c < POOL_CLASSES; c++) {
+    while (pd_list[c]) {
+      void* block = pd_list[c];
+      pd_list[c] = nextOf(block);
+      depotPush(block, c);
+    }
+  }
+  depotHits   += pd_hits;
+  depotMisses += pd_misses;
+
+  if (pd_prev)
+    pd_prev->pd_next = pd_next;
+  else
+    caches = pd_next;
+  if (pd_next)
+    pd_next->pd_prev = pd_prev;
+}
+
+
+static inline omniBufferPoolCache*
+threadCache()
+{
+  if (!orbParameters::bufferPoolThreadCache)
+    return 0;
+
+  omni_thread* self = omni_thread::self();
+  if (!self)
+    return 0;
+
+  omniBufferPoolCache* cache =
+    (omniBufferPoolCache*)self->get_value(cacheKey);
+
+  if (!cache) {
+    cache = new omniBufferPoolCache();
+    self->set_value(cacheKey, cache);
+  }
+  return cache;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+void*
+omniBufferPool::allocate(size_t size)
+{
+  int c = sizeClass(size);
+
+  if (c == POOL_NO_CLASS || !poolInitialised)
+    return heapAllocate(size, c);
+
+  omniBufferPoolCache* cache = threadCache();
+
+  if (cache) {
+    void* block = cache->pd_list[c];
+    if (block) {
+      cache->pd_list[c]   = nextOf(block);
+      cache->pd_count[c] -= 1;
+      cache->pd_bytes    -= classSize(c);
+      cache->pd_hits++;
+      return block;
+    }
+    if (depotCount[c]) {
+      // Refill from the depot: return one block and keep up to
+      // POOL_BATCH-1 more, as far as the cache limit allows.
+      omni_tracedmutex_lock sync(*depotLock);
+      block = depotPop(c);
+      if (block) {
+	for (int i = 1; i < POOL_BATCH && depotList[c]; i++) {
+	  if (cache->pd_bytes + classSize(c) >
+	      orbParameters::bufferPoolThreadCache)
+	    break;
+
+	  void* extra = depotPop(c);
+	  nextOf(extra)       = cache->pd_list[c];
+	  cache->pd_list[c]   = extra;
+	  cache->pd_count[c] += 1;
+	  cache->pd_bytes    += classSize(c);
+	}
+	cache->pd_hits++;
+	return block;
+      }
+    }
+    cache->pd_misses++;
+    return heapAllocate(size, c);
+  }
+  else {
+    omni_tracedmutex_lock sync(*depotLock);
+    void* block = depotPop(c);
+    if (block) {
+      depotHits++;
+      return block;
+    }
+    depotMisses++;
+  }
+  return heapAllocate(size, c);
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+void
+omniBufferPool::release(void* block)
+{
+  if (!block) return;
+
+  int c = headerOf(block)->sizeClass;
+
+  // Before ORB_init, depotLock and cacheKey do not exist yet, so
+  // blocks go straight back to the heap.
+  if (c == POOL_NO_CLASS || !poolInitialised) {
+    heapDelete(block);
+    return;
+  }
+
+  omniBufferPoolCache* cache = threadCache();
+
+  if (cache) {
+    if (cache->pd_bytes + classSize(c) <=
+	orbParameters::bufferPoolThreadCache) {
+
+      nextOf(block)       = cache->pd_list[c];
+      cache->pd_list[c]   = block;
+      cache->pd_count[c] += 1;
+      cache->pd_bytes    += classSize(c);
+      return;
+    }
+
+    // The cache is full. Pass this block and a batch of its siblings
+    // on to the depot, so the next few releases of this class stay
+    // in the thread.
+    omni_tracedmutex_lock sync(*depotLock);
+    depotPush(block, c);
+
+    for (int i = 1; i < POOL_BATCH && cache->pd_list[c]; i++) {
+      void* extra = cache->pd_list[c];
+      cache->pd_list[c]   = nextOf(extra);
+      cache->pd_count[c] -= 1;
+      cache->pd_bytes    -= classSize(c);
+      depotPush(extra, c);
+    }
+  }
+  else {
+    omni_tracedmutex_lock sync(*depotLock);
+    depotPush(block, c);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+void
+omniBufferPool::stats(unsigned long& hits, unsigned long& misses,
+		      unsigned long& bytesRetained)
+{
+  hits = misses = bytesRetained = 0;
+
+  if (!poolInitialised)
+    return;
+
+  omni_tracedmutex_lock sync(*depotLock);
+
+  hits          = depotHits;
+  misses        = depotMisses;
+  bytesRetained = depotBytes;
+
+  for (omniBufferPoolCache* cache = caches; cache; cache = cache->pd_next) {
+    hits          += cache->pd_hits;
+    misses        += cache->pd_misses;
+    bytesRetained += cache->pd_bytes;
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//            Handlers for Configuration Options                           //
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+class bufferPoolThreadCacheHandler : public orbOptions::Handler {
+public:
+
+  bufferPoolThreadCacheHandler() :
+    orbOptions::Handler("bufferPoolThreadCache",
+			"bufferPoolThreadCache = n >= 0",
+			1,
+			"-ORBbufferPoolThreadCache < n >= 0 >") {}
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::ULong v;
+    if (!orbOptions::getULong(value,v)) {
+      throw orbOptions::BadParam(key(),value,
+				 orbOptions::expect_ulong_msg);
+    }
+    orbParameters::bufferPoolThreadCache = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVULong(key(),orbParameters::bufferPoolThreadCache,
+			   result);
+  }
+
+};
+
+static bufferPoolThreadCacheHandler bufferPoolThreadCacheHandler_;
+
+
+/////////////////////////////////////////////////////////////////////////////
+class bufferPoolMaxRetainedHandler : public orbOptions::Handler {
+public:
+
+  bufferPoolMaxRetainedHandler() :
+    orbOptions::Handler("bufferPoolMaxRetained",
+			"bufferPoolMaxRetained = n >= 0",
+			1,
+			"-ORBbufferPoolMaxRetained < n >= 0 >") {}
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::ULong v;
+    if (!orbOptions::getULong(value,v)) {
+      throw orbOptions::BadParam(key(),value,
+				 orbOptions::expect_ulong_msg);
+    }
+    orbParameters::bufferPoolMaxRetained = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVULong(key(),orbParameters::bufferPoolMaxRetained,
+			   result);
+  }
+
+};
+
+static bufferPoolMaxRetainedHandler bufferPoolMaxRetainedHandler_;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//            Module initialiser                                           //
+/////////////////////////////////////////////////////////////////////////////
+
+class omni_bufferPool_initialiser : public omniInitialiser {
+public:
+  omni_bufferPool_initialiser() {
+    orbOptions::singleton().registerHandler(bufferPoolThreadCacheHandler_);
+    orbOptions::singleton().registerHandler(bufferPoolMaxRetainedHandler_);
+  }
+
+  void attach() {
+    if (!poolInitialised) {
+      depotLock       = new omni_tracedmutex;
+      cacheKey        = omni_thread::allocate_key();
+      poolInitialised = 1;
+    }
+  }
+
+  void detach() {
+    // Free the depot. Thread caches are emptied as their threads
+    // exit. depotLock and cacheKey are kept, since blocks may still
+    // be in use by application-owned streams.
+    omni_tracedmutex_lock sync(*depotLock);
+    for (int c = 0; c < POOL_CLASSES; c++) {
+      void* block;
+      while ((block = depotPop(c)))
+	heapDelete(block);
+    }
+  }
+};
+
+static omni_bufferPool_initialiser initialiser;
+
+omniInitialiser& omni_bufferPool_initialiser_ = initialiser;
+
+OMNI_NAMESPACE_END(omni)
@@ -374,13 +374,196 @@ OMNI_NAMESPACE_BEGIN(omni)
 
 // The local object table.  This is a dynamically resized
 // open hash table.
-static omniObjTableEntry**       objectTable = 0;
-static _CORBA_ULong              objectTableSize = 0;
+//
+// All changes to the table are made holding <omni::internalLock>, as
+// the object table entry state machine requires, but lockActive()
+// searches it without the lock:
+//
+//  - Every change makes <tableSeq> odd before it touches the chains
+//    and even again afterwards, so a search that overlaps a change
+//    notices and starts again.
+//
+//  - Entries and bucket arrays removed from the table are not freed
+//    until no search can still be looking at them.  Searches count
+//    themselves in and out of the current epoch.  A removed item is
+//    retired with the epoch at its removal, and freed once the epoch
+//    has advanced twice.  The epoch only advances when nobody is left
+//    in the previous one, and changes to the table just try to advance
+//    it, so they never wait for searches.
+//
+// When the table is resized, the entries are not all rehashed at
+// once, which with millions of objects would hold up every other
+// thread.  Instead, each later change to the table moves a few
+// buckets of the old array across, and entries are looked for in both
+// arrays until the old one is empty.
+
+#if defined(__GNUC__)
+#  define OBJTABLE_LOCKFREE 1
+#  define OBJTABLE_ADD(p,v)  __sync_fetch_and_add(p,v)
+#  define OBJTABLE_FENCE()   __sync_synchronize()
+#else
+#  define OBJTABLE_FENCE()
+#endif
+
+// Number of old buckets moved by each change to the table.
+#define OBJTABLE_MOVE_STEP 16
+
+struct objTableArray {
+  _CORBA_ULong        size;
+  omniObjTableEntry** buckets;
+
+  objTableArray(_CORBA_ULong n) : size(n) {
+    buckets = new omniObjTableEntry* [n];
+    for (_CORBA_ULong i = 0; i < n; i++) buckets[i] = 0;
+  }
+  ~objTableArray() { delete [] buckets; }
+};
+
+static objTableArray* volatile   objectTable = 0;
+static objTableArray* volatile   oldObjectTable = 0;
+static _CORBA_ULong              oldObjectTableNext = 0;
 static int                       objectTableSizeI = 0;
 static _CORBA_ULong              numObjectsInTable = 0;
 static _CORBA_ULong              maxNumObjects = 0;
 static _CORBA_ULong              minNumObjects = 0;
 
+static volatile _CORBA_ULong     tableSeq = 0;
+
+static inline void beginTableChange()
+{
+  ++tableSeq;
+  OBJTABLE_FENCE();
+}
+
+static inline void endTableChange()
+{
+  OBJTABLE_FENCE();
+  ++tableSeq;
+}
+
+// Items waiting to be freed, oldest first.
+struct objTableRetired {
+  objTableRetired*   next;
+  _CORBA_ULong       epoch;
+  omniObjTableEntry* entry;
+  objTableArray*     array;
+};
+
+static objTableRetired*          retiredHead = 0;
+static objTableRetired*          retiredTail = 0;
+
+#ifdef OBJTABLE_LOCKFREE
+
+// Searches count themselves in one of several counters, chosen by
+// thread id so that threads mostly use different cache lines, in one
+// of two sets selected by the epoch's parity.
+#define OBJTABLE_READER_SLOTS 16
+
+static inline unsigned int readerSlot()
+{
+  omni_thread* self = omni_thread::self();
+  if (self)
+    return (unsigned int)self->id() & (OBJTABLE_READER_SLOTS - 1);
+
+  // Not an omni_thread. Thread stacks are usually a large power of two
+  // apart, so mix the bits of a stack address before picking a slot.
+  unsigned long addr = (unsigned long)&self >> 12;
+  return (unsigned int)((addr * 2654435761UL) >> 16) &
+         (OBJTABLE_READER_SLOTS - 1);
+}
+
+struct objTableReaderCount {
+  volatile int n;
+  char         pad[64 - sizeof(int)];
+};
+
+static objTableReaderCount       tableReaders[2][OBJTABLE_READER_SLOTS];
+static volatile _CORBA_ULong     tableEpoch = 0;
+
+class objTableReader {
+public:
+  inline objTableReader() {
+    unsigned int slot = readerSlot();
+    for (;;) {
+      _CORBA_ULong e = tableEpoch;
+      pd_count = &tableReaders[e & 1][slot].n;
+      OBJTABLE_ADD(pd_count, 1);
+      if (e == tableEpoch) return;
+      OBJTABLE_ADD(pd_count, -1);
+    }
+  }
+  inline ~objTableReader() { OBJTABLE_ADD(pd_count, -1); }
+
+private:
+  volatile int* pd_count;
+};
+
+static void advanceEpoch()
+{
+  // Readers of the previous epoch count in the set that readers of
+  // the next epoch will use, so it must be empty before advancing.
+  _CORBA_ULong e = tableEpoch;
+  objTableReaderCount* counts = tableReaders[(e + 1) & 1];
+
+  for (int i = 0; i < OBJTABLE_READER_SLOTS; i++)
+    if (counts[i].n) return;
+
+  OBJTABLE_FENCE();
+  tableEpoch = e + 1;
+  OBJTABLE_FENCE();
+}
+
+static inline _CORBA_ULong currentEpoch() { return tableEpoch; }
+
+#else
+
+static inline void advanceEpoch() {}
+static inline _CORBA_ULong currentEpoch() { return 0; }
+
+#endif
+
+static void freeRetired(objTableRetired* r)
+{
+  if (r->entry) delete r->entry;
+  if (r->array) delete r->array;
+  delete r;
+}
+
+static void reclaimRetired()
+{
+  if (!retiredHead) return;
+
+  advanceEpoch();
+  _CORBA_ULong epoch = currentEpoch();
+
+  while (retiredHead) {
+#ifdef OBJTABLE_LOCKFREE
+    if (epoch - retiredHead->epoch < 2) break;
+#endif
+    objTableRetired* r = retiredHead;
+    retiredHead = r->next;
+    if (!retiredHead) retiredTail = 0;
+    freeRetired(r);
+  }
+}
+
+static void retireItem(omniObjTableEntry* entry, objTableArray* array)
+{
+  objTableRetired* r = new objTableRetired;
+  r->next  = 0;
+  r->epoch = currentEpoch();
+  r->entry = entry;
+  r->array = array;
+
+  if (retiredTail)
+    retiredTail->next = r;
+  else
+    retiredHead = r;
+  retiredTail = r;
+
+  reclaimRetired();
+}
+
 // Some sort of magic numbers that are supposed
 // to be good for hash tables...
 static int objTblSizes[] = {
@@ -443,41 +626,56 @@ omniObjTable::resize()
   }
   CORBA::ULong newsize = newsizei;
 
+  // Finish moving the entries out of any previous old array.
+  if (oldObjectTable)
+    moveBuckets(oldObjectTable->size);
+
   if (omniORB::trace(15)) {
     omniORB::logger l;
-    l << "Object table resizing from " << objectTableSize
+    l << "Object table resizing from " << objectTable->size
       << " to " << newsize << "\n";
   }
 
-  // Create and initialise new object table.
-  omniObjTableEntry** newtable = new omniObjTableEntry* [newsize];
-  CORBA::ULong i;
-  for( i = 0; i < newsize; i++ )  newtable[i] = 0;
+  // The new array is filled incrementally by moveBuckets().
+  oldObjectTable = objectTable;
+  oldObjectTableNext = 0;
+  objectTable = new objTableArray(newsize);
 
-  // Move the objects across...
-  for( i = 0; i < objectTableSize; i++ ) {
-    omniObjTableEntry* id = objectTable[i];
+  maxNumObjects = newsize * 2 / 3;
+  minNumObjects =
+    objectTableSizeI ? (objTblSizes[objectTableSizeI - 1] / 3) : 0;
+}
+
+
+void
+omniObjTable::moveBuckets(_CORBA_ULong n)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 1);
 
-    while( id ) {
-      omniObjTableEntry* next = id->nextInObjectTable();
+  while (oldObjectTable && n--) {
+    omniObjTableEntry** head = oldObjectTable->buckets + oldObjectTableNext;
 
-      _CORBA_ULong j = omni::hash(id->key(), id->keysize()) % newsize;
-      *(id->addrOfNextInObjectTable()) = newtable[j];
-      newtable[j] = id;
+    while (*head) {
+      omniObjTableEntry* id = *head;
+      *head = id->pd_nextInObjectTable;
 
-      id = next;
+      _CORBA_ULong j = omni::hash(id->key(), id->keysize()) % objectTable->size;
+      id->pd_nextInObjectTable = objectTable->buckets[j];
+      objectTable->buckets[j] = id;
     }
-  }
 
-  // Replace the old table.
-  delete[] objectTable;
-  objectTable = newtable;
-  objectTableSize = newsize;
-  maxNumObjects = objectTableSize * 2 / 3;
-  minNumObjects =
-    objectTableSizeI ? (objTblSizes[objectTableSizeI - 1] / 3) : 0;
+    if (++oldObjectTableNext == oldObjectTable->size) {
+      if (omniORB::trace(15)) {
+	omniORB::logger l;
+	l << "Object table resized to " << objectTable->size << "\n";
+      }
+      retireItem(0, oldObjectTable);
+      oldObjectTable = 0;
+    }
+  }
 }
 
+
 //////////////////////////////////////////////////////////////////////
 //////////////////////////////// omni ////////////////////////////////
 //////////////////////////////////////////////////////////////////////
@@ -532,6 +730,14 @@ omni::releaseObjRef(omniObjRef* objref)
   {
     omni_tracedmutex_lock sync(*internalLock);
     objref->_setIdentity(0);
+    if (objref->pd_fastId) {
+      objref->pd_fastId->loseRef();
+      objref->pd_fastId = 0;
+    }
+    if (objref->pd_fastRetired) {
+      objref->pd_fastRetired->loseRef();
+      objref->pd_fastRetired = 0;
+    }
   }
 
   if( omniORB::trace(15) ) {
@@ -545,21 +751,206 @@ omni::releaseObjRef(omniObjRef* objref)
 
 
 omniObjTableEntry*
-omniObjTable::locateActive(const _CORBA_Octet* key, int keysize,
-			   _CORBA_ULong hashv, _CORBA_Boolean wait)
+omniObjTable::find(const _CORBA_Octet* key, int keysize, _CORBA_ULong hashv)
 {
   ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 1);
 
+  omniObjTableEntry* entry = objectTable->buckets[hashv % objectTable->size];
+
+  for (; entry; entry = entry->pd_nextInObjectTable)
+    if (entry->is_equal(key, keysize)) return entry;
+
+  if (oldObjectTable) {
+    entry = oldObjectTable->buckets[hashv % oldObjectTable->size];
+
+    for (; entry; entry = entry->pd_nextInObjectTable)
+      if (entry->is_equal(key, keysize)) return entry;
+  }
+  return 0;
+}
+
+
+#ifdef OBJTABLE_LOCKFREE
+
+omniObjTableEntry*
+omniObjTable::findUnlocked(const _CORBA_Octet* key, int keysize,
+			   _CORBA_ULong hashv)
+{
+  // Must be inside an objTableReader.  The chains may be changed while
+  // we walk them, so <tableSeq> is checked at every step; it also
+  // stops us going round in circles if entries we have already passed
+  // are moved ahead of us.
+
  again:
-  omniObjTableEntry** head  = objectTable + hashv % objectTableSize;
-  omniObjTableEntry*  entry = *head;
+  _CORBA_ULong seq = tableSeq;
+  if (seq & 1) {
+    omni_thread::yield();
+    goto again;
+  }
+  OBJTABLE_FENCE();
+
+  objTableArray*     tables[2] = { objectTable, oldObjectTable };
+  omniObjTableEntry* found     = 0;
 
-  while (entry) {
-    if (entry->is_equal(key, keysize)) break;
+  for (int t = 0; t < 2 && !found && tables[t]; t++) {
+    omniObjTableEntry* entry =
+      *(omniObjTableEntry* volatile*)
+        (tables[t]->buckets + hashv % tables[t]->size);
 
-    entry = entry->nextInObjectTable();
+    while (entry) {
+      if (tableSeq != seq) goto again;
+      if (entry->is_equal(key, keysize)) {
+	found = entry;
+	break;
+      }
+      entry = *(omniObjTableEntry* volatile*)&entry->pd_nextInObjectTable;
+    }
   }
 
+  OBJTABLE_FENCE();
+  if (tableSeq != seq) goto again;
+  return found;
+}
+
+#endif
+
+
+omniObjTableEntry*
+omniObjTable::lockActive(const _CORBA_Octet* key, int keysize,
+			 _CORBA_ULong hashv)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 0);
+
+#ifdef OBJTABLE_LOCKFREE
+  {
+    objTableReader reader;
+
+    omniObjTableEntry* entry = findUnlocked(key, keysize, hashv);
+    if (!entry) return 0;
+
+    omni::internalLock->lock();
+
+    // The reader keeps the entry from being freed until we have
+    // checked its state under the lock. It cannot be active unless it
+    // is still in the table.
+    if (entry->pd_state & (omniObjTableEntry::ACTIVE |
+			   omniObjTableEntry::DEACTIVATING))
+      return entry;
+  }
+#else
+  omni::internalLock->lock();
+#endif
+
+  // Activating, or gone. Look again, waiting if need be.
+  omniObjTableEntry* entry = locateActive(key, keysize, hashv, 1);
+  if (!entry) omni::internalLock->unlock();
+  return entry;
+}
+
+
+_CORBA_Boolean
+omniObjTable::fastDispatch(const _CORBA_Octet* key, int keysize,
+			   _CORBA_ULong hashv, omniCallHandle& handle)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 0);
+
+#ifdef OBJTABLE_LOCKFREE
+  omniObjTableEntry* entry;
+  {
+    objTableReader reader;
+
+    entry = findUnlocked(key, keysize, hashv);
+
+    // The reader keeps the entry from being freed until it has been
+    // entered. After that, the call in its invocation count keeps it
+    // from being etherealised and removed.
+    if (!entry || !entry->fastEnter())
+      return 0;
+  }
+  return entry->fastDispatch(handle);
+#else
+  return 0;
+#endif
+}
+
+
+_CORBA_Boolean
+omniObjTable::isActive(const _CORBA_Octet* key, int keysize,
+		       _CORBA_ULong hashv)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 0);
+
+#ifdef OBJTABLE_LOCKFREE
+  objTableReader reader;
+
+  omniObjTableEntry* entry = findUnlocked(key, keysize, hashv);
+  return entry && (entry->pd_state & (omniObjTableEntry::ACTIVE |
+				      omniObjTableEntry::DEACTIVATING));
+#else
+  omniObjTableEntry* entry = lockActive(key, keysize, hashv);
+  if (entry) omni::internalLock->unlock();
+  return entry != 0;
+#endif
+}
+
+
+void
+omniObjTable::remove(omniObjTableEntry* entry)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 1);
+
+  _CORBA_ULong hashv = omni::hash(entry->key(), entry->keysize());
+
+  beginTableChange();
+
+  omniObjTableEntry** pid =
+    objectTable->buckets + hashv % objectTable->size;
+
+  while (*pid && *pid != entry)
+    pid = &(*pid)->pd_nextInObjectTable;
+
+  if (!*pid && oldObjectTable) {
+    pid = oldObjectTable->buckets + hashv % oldObjectTable->size;
+
+    while (*pid && *pid != entry)
+      pid = &(*pid)->pd_nextInObjectTable;
+  }
+  OMNIORB_ASSERT(*pid);
+
+  // Searches may be looking at the entry, so its own link is left
+  // alone.
+  *pid = entry->pd_nextInObjectTable;
+
+  moveBuckets(OBJTABLE_MOVE_STEP);
+
+  if( --numObjectsInTable < minNumObjects )
+    omniObjTable::resize();
+
+  endTableChange();
+}
+
+
+void
+omniObjTable::retire(omniObjTableEntry* entry)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 1);
+#ifdef OBJTABLE_LOCKFREE
+  retireItem(entry, 0);
+#else
+  delete entry;
+#endif
+}
+
+
+omniObjTableEntry*
+omniObjTable::locateActive(const _CORBA_Octet* key, int keysize,
+			   _CORBA_ULong hashv, _CORBA_Boolean wait)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 1);
+
+ again:
+  omniObjTableEntry* entry = find(key, keysize, hashv);
+
   omniObjTableEntry::State state;
 
   if (entry) {
@@ -592,14 +983,7 @@ omniObjTable::locate(const _CORBA_Octet* key, int keysize,
   ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 1);
 
  again:
-  omniObjTableEntry** head  = objectTable + hashv % objectTableSize;
-  omniObjTableEntry*  entry = *head;
-
-  while (entry) {
-    if (entry->is_equal(key, keysize)) break;
-
-    entry = entry->nextInObjectTable();
-  }
+  omniObjTableEntry* entry = find(key, keysize, hashv);
 
   if (entry) {
     while (!(entry->state() & set)) {
@@ -630,24 +1014,25 @@ omniObjTable::newEntry(omniObjKey& key, _CORBA_ULong hashv)
 {
   ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 1);
 
-  omniObjTableEntry** head  = objectTable + hashv % objectTableSize;
-  omniObjTableEntry*  entry = *head;
+  if (find(key.key(), key.size(), hashv)) return 0;
 
-  while (entry) {
-    if (entry->is_equal(key.key(), key.size())) return 0;
-    entry = entry->nextInObjectTable();
-  }
+  omniObjTableEntry* entry = new omniObjTableEntry(key);
+
+  beginTableChange();
 
-  if( ++numObjectsInTable > maxNumObjects ) {
+  moveBuckets(OBJTABLE_MOVE_STEP);
+
+  if( ++numObjectsInTable > maxNumObjects )
     omniObjTable::resize();
-    head = objectTable + hashv % objectTableSize;
-  }
 
-  entry = new omniObjTableEntry(key);
-  
-  *(entry->addrOfNextInObjectTable()) = *head;
+  omniObjTableEntry** head = objectTable->buckets + hashv % objectTable->size;
+  entry->pd_nextInObjectTable = *head;
   *head = entry;
 
+  endTableChange();
+
+  reclaimRetired();
+
   if (omniORB::trace(10)) {
     omniORB::logger l;
     l << "Adding " << entry << " to object table.\n";
@@ -699,7 +1084,7 @@ omniObjTableEntry::setDeactivating()
   }
 
   pd_state = DEACTIVATING;
-  --pd_nInvocations;
+  LOCALID_ADD(&pd_nInvocations, -1);
 
   if (pd_waiters)
     pd_cond->broadcast();
@@ -717,12 +1102,19 @@ omniObjTableEntry::setDeactivatingOA()
     l << "State " << this << " -> deactivating (OA destruction)\n";
   }
 
-  if (pd_nInvocations == 1)
-    pd_state = DEACTIVATING_OA;
-  else
-    pd_state = DEACTIVATING;
+  // Fast local calls may be entering or leaving, so the test for
+  // outstanding invocations must be made by the decrement itself. The
+  // state must change first, so fast calls entering after the
+  // decrement see that the object is no longer active.
+  pd_state = DEACTIVATING;
+
+  int n;
+  do {
+    n = pd_nInvocations;
+  } while (!LOCALID_CAS(&pd_nInvocations, n, n - 1));
 
-  --pd_nInvocations;
+  if (n == 1)
+    pd_state = DEACTIVATING_OA;
 
   if (pd_waiters)
     pd_cond->broadcast();
@@ -753,23 +1145,11 @@ omniObjTableEntry::setDead()
 {
   ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 1);
 
-  omniObjTableEntry** pid =
-    objectTable + omni::hash(key(), keysize()) % objectTableSize;
-
-  while (*pid) {
-    if (*pid == this) break;
-    pid = (*pid)->addrOfNextInObjectTable();
-  }
-  OMNIORB_ASSERT(*pid);
-
   if( omniORB::trace(10) ) {
     omniORB::logger l;
     l << "Removing " << this << " from object table\n";
   }
-  *pid = nextInObjectTable();
-
-  if( --numObjectsInTable < minNumObjects )
-    omniObjTable::resize();
+  omniObjTable::remove(this);
 
   if (pd_state != ETHEREALISING && pd_servant) {
     pd_servant->_removeActivation(this);
@@ -855,7 +1235,8 @@ omniObjTableEntry::loseRef(omniObjRef* objref)
   // If this fails, an object reference released its reference to us
   // without passing the objref pointer.
 
-  delete this;
+  // Searches of the object table may still be looking at us.
+  omniObjTable::retire(this);
 }
 
 
@@ -1647,18 +2028,19 @@ public:
     numObjectsInTable = 0;
     minNumObjects = 0;
 
+    CORBA::ULong size;
     if( orbParameters::objectTableSize ) {
-      objectTableSize = orbParameters::objectTableSize;
+      size = orbParameters::objectTableSize;
       maxNumObjects = 1ul << 31;
     }
     else {
       objectTableSizeI = 0;
-      objectTableSize = objTblSizes[objectTableSizeI];
-      maxNumObjects = objectTableSize * 2 / 3;
+      size = objTblSizes[objectTableSizeI];
+      maxNumObjects = size * 2 / 3;
     }
 
-    objectTable = new omniObjTableEntry* [objectTableSize];
-    for( CORBA::ULong i = 0; i < objectTableSize; i++ )  objectTable[i] = 0;
+    objectTable = new objTableArray(size);
+    oldObjectTable = 0;
 
 #ifdef WIN32_EXCEPTION_HANDLING
     if (abortOnNativeException) {
@@ -1677,8 +2059,20 @@ public:
 	<< " at ORB shutdown time.";
     }
     OMNIORB_ASSERT(numObjectsInTable == 0);
-    delete [] objectTable;
+    delete objectTable;
     objectTable = 0;
+    if (oldObjectTable) {
+      delete oldObjectTable;
+      oldObjectTable = 0;
+    }
+
+    // Nothing can be searching the table any more.
+    while (retiredHead) {
+      objTableRetired* r = retiredHead;
+      retiredHead = r->next;
+      freeRetired(r);
+    }
+    retiredTail = 0;
   }
 };
 
@@ -109,6 +109,7 @@
 #include <omniORB4/CORBA.h>
 #include <orbParameters.h>
 #include <omniCurrent.h>
+#include <omniBufferPool.h>
 
 #ifdef HAS_pch
 #pragma hdrstop
@@ -207,6 +208,17 @@ omniORB::setClientConnectTimeout(CORBA::ULong v)
   orbParameters::clientConnectTimeOutPeriod.nanosecs = (v % 1000) * 1000000;
 }
 
+void
+omniORB::setClientOnewayCoalescing(CORBA::Object_ptr obj, CORBA::Boolean yes)
+{
+  omniObjRef* oo = obj->_PR_getobj();
+  if (!oo)
+    OMNIORB_THROW(INV_OBJREF, INV_OBJREF_InvokeOnNilObjRef,
+		  CORBA::COMPLETED_NO);
+
+  oo->_setOnewayCoalescing(yes ? 1 : 0);
+}
+
 
 //////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
@@ -215,6 +227,13 @@ omniORB::giopMaxMsgSize() {
   return orbParameters::giopMaxMsgSize;
 }
 
+//////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////
+void
+omniORB::getBufferPoolStats(bufferPoolStats& stats) {
+  omniBufferPool::stats(stats.hits, stats.misses, stats.bytesRetained);
+}
+
 
 #if defined(__DMC__) && defined(_WINDLL)
 BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
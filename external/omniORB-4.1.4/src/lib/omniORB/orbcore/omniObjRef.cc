@@ -227,12 +227,212 @@ CORBA::Boolean orbParameters::copyValuesInLocalCalls = 1;
 //
 //  Valid values = 0 or 1
 
+CORBA::Boolean orbParameters::fastLocalCalls = 0;
+//  If the value of this variable is TRUE, calls to active objects
+//  in the same process, in POAs with the ORB_CTRL_MODEL threading
+//  policy, are dispatched without taking the ORB's internal lock,
+//  once the first call through an object reference has found the
+//  object.
+//
+//  Valid values = 0 or 1
+
 CORBA::Boolean orbParameters::resetTimeOutOnRetries = 0;
 // If the value of this variable is TRUE, the call timeout is reset
 // when an exception handler causes a call to be retried. If it is
 // FALSE, the timeout is not reset, and therefore applies to the call
 // as a whole, rather than each individual call attempt.
 
+CORBA::ULong orbParameters::trustIsACache = 0;
+// Answers to _is_a() are remembered per pair of (most derived
+// repository id, queried repository id). This variable says which of
+// them are believed for other objects with the same most derived id,
+// rather than asking each object.
+//
+//   0 -- always ask the object.
+//   1 -- believe answers of TRUE.
+//   2 -- believe answers of TRUE and FALSE.
+//
+// Objects of different types may be advertised with the same id, so
+// only set this if the ids in references are known to be the objects'
+// most derived types.
+
+
+////////////////////////////////////////////////////////////////////////////
+//             _is_a() answer cache                                       //
+////////////////////////////////////////////////////////////////////////////
+//
+// The repository id in an IOR is only a hint of the object's type, so
+// when no stub says whether that type derives from the one asked for,
+// _narrow() and _is_a() ask the object. Many objects usually share
+// the same most derived type, so the answers are kept here, keyed by
+// the pair of ids, and reused according to trustIsACache.
+//
+// The repository ids come from references received from other
+// processes, so the cache holds at most isACacheMaxEntries pairs. Once
+// it is full, the oldest pair is forgotten to make room for a new one.
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+struct isACacheEntry {
+  isACacheEntry*  next;
+  isACacheEntry*  newer;
+  CORBA::ULong    hash;
+  char*           mostDerived;
+  char*           repoId;
+  CORBA::Boolean  answer;
+};
+
+static const CORBA::ULong isACacheSize       = 131;
+static const CORBA::ULong isACacheMaxEntries = 1024;
+
+static omni_tracedmutex isACacheLock;
+static isACacheEntry*   isACache[isACacheSize];
+static isACacheEntry*   isACacheOldest  = 0;
+static isACacheEntry*   isACacheNewest  = 0;
+static CORBA::ULong     isACacheEntries = 0;
+// Protected by <isACacheLock>. Entries are chained from their bucket
+// through <next>, and from the oldest to the newest through <newer>.
+
+static inline CORBA::Boolean
+isACacheable(const char* mostDerived)
+{
+  // References made from corbaloc URIs and the like have no useful
+  // most derived id.
+  return (mostDerived && *mostDerived &&
+	  !omni::strMatch(mostDerived, CORBA::Object::_PD_repoId));
+}
+
+static inline CORBA::ULong
+isACacheHash(const char* mostDerived, const char* repoId)
+{
+  CORBA::ULong h1 = omni::hash((const CORBA::Octet*)mostDerived,
+			       strlen(mostDerived));
+  CORBA::ULong h2 = omni::hash((const CORBA::Octet*)repoId,
+			       strlen(repoId));
+  return h1 ^ (h2 * 31);
+}
+
+static isACacheEntry*
+isACacheFind(CORBA::ULong h, const char* mostDerived, const char* repoId)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(isACacheLock, 1);
+
+  for (isACacheEntry* e = isACache[h % isACacheSize]; e; e = e->next) {
+    if (e->hash == h &&
+	omni::strMatch(e->mostDerived, mostDerived) &&
+	omni::strMatch(e->repoId, repoId))
+      return e;
+  }
+  return 0;
+}
+
+//
+// Returns 1 or 0 for an answer that may be believed, or -1 if the
+// object must be asked.
+
+static int
+isACacheLookup(const char* mostDerived, const char* repoId)
+{
+  if (!orbParameters::trustIsACache || !isACacheable(mostDerived))
+    return -1;
+
+  // If the stub for the most derived type is linked in, it knows the
+  // answer if it is TRUE.
+  proxyObjectFactory* pof = proxyObjectFactory::lookup(mostDerived);
+  if (pof && pof->is_a(repoId))
+    return 1;
+
+  CORBA::ULong h = isACacheHash(mostDerived, repoId);
+  int result = -1;
+  {
+    omni_tracedmutex_lock sync(isACacheLock);
+    isACacheEntry* e = isACacheFind(h, mostDerived, repoId);
+    if (e && (e->answer || orbParameters::trustIsACache > 1))
+      result = e->answer ? 1 : 0;
+  }
+  if (result >= 0 && omniORB::trace(25)) {
+    omniORB::logger log;
+    log << "_is_a(\"" << repoId << "\") on object of type "
+	<< mostDerived << " answered from cache: "
+	<< (result ? "true" : "false") << "\n";
+  }
+  return result;
+}
+
+static void
+isACacheInsert(const char* mostDerived, const char* repoId,
+	       CORBA::Boolean answer)
+{
+  if (!orbParameters::trustIsACache || !isACacheable(mostDerived))
+    return;
+
+  CORBA::ULong h = isACacheHash(mostDerived, repoId);
+
+  omni_tracedmutex_lock sync(isACacheLock);
+
+  isACacheEntry* e = isACacheFind(h, mostDerived, repoId);
+  if (e) {
+    // The latest answer wins, in case an object has been replaced by
+    // one of a different type.
+    e->answer = answer;
+    return;
+  }
+  if (isACacheEntries >= isACacheMaxEntries) {
+    // Forget the oldest entry.
+    isACacheEntry* old = isACacheOldest;
+    isACacheOldest = old->newer;
+    if (!isACacheOldest) isACacheNewest = 0;
+
+    isACacheEntry** p = &isACache[old->hash % isACacheSize];
+    while (*p != old) p = &(*p)->next;
+    *p = old->next;
+
+    CORBA::string_free(old->mostDerived);
+    CORBA::string_free(old->repoId);
+    delete old;
+    isACacheEntries--;
+  }
+
+  e = new isACacheEntry;
+  e->hash        = h;
+  e->mostDerived = CORBA::string_dup(mostDerived);
+  e->repoId      = CORBA::string_dup(repoId);
+  e->answer      = answer;
+  e->next        = isACache[h % isACacheSize];
+  e->newer       = 0;
+  isACache[h % isACacheSize] = e;
+
+  if (isACacheNewest)
+    isACacheNewest->newer = e;
+  else
+    isACacheOldest = e;
+  isACacheNewest = e;
+  isACacheEntries++;
+}
+
+static void
+isACacheClear()
+{
+  omni_tracedmutex_lock sync(isACacheLock);
+
+  for (CORBA::ULong i = 0; i < isACacheSize; i++) {
+    isACacheEntry* e = isACache[i];
+    while (e) {
+      isACacheEntry* next = e->next;
+      CORBA::string_free(e->mostDerived);
+      CORBA::string_free(e->repoId);
+      delete e;
+      e = next;
+    }
+    isACache[i] = 0;
+  }
+  isACacheOldest  = 0;
+  isACacheNewest  = 0;
+  isACacheEntries = 0;
+}
+
+OMNI_NAMESPACE_END(omni)
+
 
 ////////////////////////////////////////////////////////////////////////////
 const char*
@@ -252,8 +452,11 @@ omniObjRef::_real_is_a(const char* repoId)
 
   // Reach here because pd_flags.type_verified == 0, and we could not
   // verify the inheritance relationship using compile-time information.
-  // Thus we ask our implementation if it is an instance of the given
-  // type.
+  // Unless another object of the same type has answered already, we
+  // ask our implementation if it is an instance of the given type.
+
+  int cached = isACacheLookup(pd_mostDerivedRepoId, repoId);
+  if( cached >= 0 )  return cached;
 
   return _remote_is_a(repoId);
 }
@@ -486,6 +689,7 @@ omniObjRef::_remote_is_a(const char* a_repoId)
   omni_is_a_CallDesc call_desc("_is_a", sizeof("_is_a"), a_repoId);
 
   _invoke(call_desc, 0);
+  isACacheInsert(pd_mostDerivedRepoId, a_repoId, call_desc.result);
   return call_desc.result;
 }
 
@@ -633,8 +837,14 @@ omniObjRef::omniObjRef()
     pd_intfRepoId(0),
     pd_ior(0),
     pd_id(0),
+    pd_fastId(0),
+    pd_fastRetired(0),
+    pd_fastCalls(0),
     pd_next(0),
-    pd_prev(0)
+    pd_prev(0),
+    pd_timeout_secs(0),
+    pd_timeout_nanosecs(0),
+    pd_onewayCoalescing(-1)
 {
   // Nil objref.
   pd_flags.orb_shutdown = 0;
@@ -646,8 +856,12 @@ omniObjRef::omniObjRef(const char* intfRepoId, omniIOR* ior,
   : pd_refCount(1),
     pd_ior(ior),
     pd_id(id),
+    pd_fastId(0),
+    pd_fastRetired(0),
+    pd_fastCalls(0),
     pd_timeout_secs(0),
-    pd_timeout_nanosecs(0)
+    pd_timeout_nanosecs(0),
+    pd_onewayCoalescing(-1)
 {
   OMNIORB_ASSERT(intfRepoId);
   OMNIORB_ASSERT(ior);
@@ -705,6 +919,24 @@ omniObjRef::_shutdown()
   }
 }
 
+OMNI_NAMESPACE_BEGIN(omni)
+
+// Counts a thread in an object reference's <pd_fastCalls> while it
+// uses the reference's <pd_fastId>.
+class omniObjRef_FastCallHolder {
+public:
+  inline omniObjRef_FastCallHolder(volatile int* count) : pd_count(count) {
+    LOCALID_ADD(pd_count, 1);
+  }
+  inline ~omniObjRef_FastCallHolder() {
+    LOCALID_ADD(pd_count, -1);
+  }
+private:
+  volatile int* pd_count;
+};
+
+OMNI_NAMESPACE_END(omni)
+
 void
 omniObjRef::_disable()
 {
@@ -740,6 +972,15 @@ omniObjRef::_invoke(omniCallDescriptor& call_desc, CORBA::Boolean do_assert)
 
   call_desc.objref(this);
 
+#ifdef LOCALID_HAVE_ATOMICS
+  if (pd_fastId) {
+    omniObjRef_FastCallHolder fh(&pd_fastCalls);
+    omniObjTableEntry* fast = pd_fastId;
+    if (fast && pd_id == fast && fast->fastDispatch(call_desc))
+      return;
+  }
+#endif
+
   omniCurrent* current;
   unsigned long abs_secs = 0, abs_nanosecs = 0;
 
@@ -858,6 +1099,32 @@ omniObjRef::_invoke(omniCallDescriptor& call_desc, CORBA::Boolean do_assert)
 }
 
 
+void
+omniObjRef::_invokeAsync(omniAsyncCall* call)
+{
+  // The ORB holds a reference to the call, and one to this object
+  // reference, until the call completes.
+  call->_add_ref();
+  if (!_is_nil()) {
+    omni::duplicateObjRef(this);
+    call->pd_objref = this;
+  }
+
+  try {
+    _invoke(*call->pd_cd);
+  }
+  catch (CORBA::Exception& ex) {
+    call->complete(CORBA::Exception::_duplicate(&ex));
+    return;
+  }
+
+  // A call that was not sent to a remote object, one to a colocated
+  // object for example, has been made already.
+  if (!call->pd_sent)
+    call->complete(0);
+}
+
+
 omniIOR* 
 omniObjRef::_getIOR()
 {
@@ -1199,6 +1466,46 @@ omniObjRef::_enableShortcut(omniServant*, const _CORBA_Boolean*)
   // Default does nothing
 }
 
+void
+omniObjRef::_enableFastCalls(omniLocalIdentity* id)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 1);
+
+  // Identities that are not in the object table, such as those made
+  // for calls to default servants, only last for one call.
+  omniObjTableEntry* entry = omniObjTableEntry::downcast(id);
+  if (!entry || entry != pd_id || entry == pd_fastId) return;
+
+  if (pd_fastRetired) {
+    // The entry replaced last time may still be in use by a call that
+    // read it before it was replaced.
+    LOCALID_FENCE();
+    if (pd_fastCalls) return;
+    pd_fastRetired->loseRef();
+    pd_fastRetired = 0;
+  }
+
+  if (omniORB::trace(25)) {
+    omniORB::logger l;
+    l << "Enable fast local calls to " << entry << "\n";
+  }
+  entry->gainRef();
+
+  omniObjTableEntry* old = pd_fastId;
+  pd_fastId = entry;
+
+  if (old) {
+    // The object has been reactivated. A call that counted itself in
+    // <pd_fastCalls> before the count is read here may still be using
+    // the old entry, so it is kept until the next time.
+    LOCALID_FENCE();
+    if (pd_fastCalls)
+      pd_fastRetired = old;
+    else
+      old->loseRef();
+  }
+}
+
 OMNI_NAMESPACE_BEGIN(omni)
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1265,6 +1572,36 @@ public:
 static copyValuesInLocalCallsHandler copyValuesInLocalCallsHandler_;
 
 
+/////////////////////////////////////////////////////////////////////////////
+class fastLocalCallsHandler : public orbOptions::Handler {
+public:
+
+  fastLocalCallsHandler() : 
+    orbOptions::Handler("fastLocalCalls",
+			"fastLocalCalls = 0 or 1",
+			1,
+			"-ORBfastLocalCalls < 0 | 1 >") {}
+
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::Boolean v;
+    if (!orbOptions::getBoolean(value,v)) {
+      throw orbOptions::BadParam(key(),value,
+				 orbOptions::expect_boolean_msg);
+    }
+    orbParameters::fastLocalCalls = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVBoolean(key(),orbParameters::fastLocalCalls,
+			     result);
+  }
+};
+
+static fastLocalCallsHandler fastLocalCallsHandler_;
+
+
 /////////////////////////////////////////////////////////////////////////////
 class resetTimeOutOnRetriesHandler : public orbOptions::Handler {
 public:
@@ -1295,6 +1632,36 @@ public:
 static resetTimeOutOnRetriesHandler resetTimeOutOnRetriesHandler_;
 
 
+/////////////////////////////////////////////////////////////////////////////
+class trustIsACacheHandler : public orbOptions::Handler {
+public:
+
+  trustIsACacheHandler() : 
+    orbOptions::Handler("trustIsACache",
+			"trustIsACache = 0,1,2",
+			1,
+			"-ORBtrustIsACache < 0 | 1 | 2 >") {}
+
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::ULong v;
+    if (!orbOptions::getULong(value,v) || v > 2) {
+      throw orbOptions::BadParam(key(),value,
+				 "Invalid value, expect 0, 1 or 2");
+    }
+    orbParameters::trustIsACache = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVULong(key(),orbParameters::trustIsACache,
+			   result);
+  }
+};
+
+static trustIsACacheHandler trustIsACacheHandler_;
+
+
 /////////////////////////////////////////////////////////////////////////////
 //            Module initialiser                                           //
 /////////////////////////////////////////////////////////////////////////////
@@ -1304,11 +1671,13 @@ public:
   omni_ObjRef_initialiser() {
     orbOptions::singleton().registerHandler(verifyObjectExistsAndTypeHandler_);
     orbOptions::singleton().registerHandler(copyValuesInLocalCallsHandler_);
+    orbOptions::singleton().registerHandler(fastLocalCallsHandler_);
     orbOptions::singleton().registerHandler(resetTimeOutOnRetriesHandler_);
+    orbOptions::singleton().registerHandler(trustIsACacheHandler_);
   }
 
   void attach() { }
-  void detach() { }
+  void detach() { isACacheClear(); }
 };
 
 
@@ -102,6 +102,8 @@ size_t orbParameters::maxSocketRecv    = 0x7fffffff;
 int    orbParameters::socketSendBuffer = -1;
 #endif
 
+CORBA::Boolean orbParameters::connectionWatchEpoll = 0;
+
 
 ////////////////////////////////////////////////////////////////////////////
 IOP_C_Holder::IOP_C_Holder(const omniIOR* ior,
@@ -116,7 +118,7 @@ IOP_C_Holder::IOP_C_Holder(const omniIOR* ior,
 
 ////////////////////////////////////////////////////////////////////////////
 IOP_C_Holder::~IOP_C_Holder() {
-  pd_rope->releaseClient(pd_iop_c);
+  if (pd_iop_c) pd_rope->releaseClient(pd_iop_c);
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -302,6 +304,36 @@ public:
 static connectionWatchPeriodHandler connectionWatchPeriodHandler_;
 
 
+/////////////////////////////////////////////////////////////////////////////
+class connectionWatchEpollHandler : public orbOptions::Handler {
+public:
+
+  connectionWatchEpollHandler() : 
+    orbOptions::Handler("connectionWatchEpoll",
+			"connectionWatchEpoll = 0 or 1",
+			1,
+			"-ORBconnectionWatchEpoll < 0 | 1 >") {}
+
+  void visit(const char* value,orbOptions::Source) throw (orbOptions::BadParam) {
+
+    CORBA::Boolean v;
+    if (!orbOptions::getBoolean(value,v)) {
+      throw orbOptions::BadParam(key(),value,
+				 orbOptions::expect_boolean_msg);
+    }
+    orbParameters::connectionWatchEpoll = v;
+  }
+
+  void dump(orbOptions::sequenceString& result) {
+    orbOptions::addKVBoolean(key(),orbParameters::connectionWatchEpoll,
+			     result);
+  }
+
+};
+
+static connectionWatchEpollHandler connectionWatchEpollHandler_;
+
+
 /////////////////////////////////////////////////////////////////////////////
 //            Module initialiser                                           //
 /////////////////////////////////////////////////////////////////////////////
@@ -313,6 +345,7 @@ public:
     orbOptions::singleton().registerHandler(maxSocketRecvHandler_);
     orbOptions::singleton().registerHandler(socketSendBufferHandler_);
     orbOptions::singleton().registerHandler(connectionWatchPeriodHandler_);
+    orbOptions::singleton().registerHandler(connectionWatchEpollHandler_);
   }
 
   void attach() {
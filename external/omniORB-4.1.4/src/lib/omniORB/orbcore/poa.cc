@@ -1908,6 +1908,51 @@ omniOrbPOA::dispatch(omniCallHandle& handle, omniLocalIdentity* id)
       handle.mainThread(pd_main_thread_sync.mu, pd_main_thread_sync.cond);
   }
 
+  upcall(handle, id);
+}
+
+
+_CORBA_Boolean
+omniOrbPOA::fastDispatch(omniCallHandle& handle, omniLocalIdentity* id)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 0);
+  OMNIORB_ASSERT(id);  OMNIORB_ASSERT(id->servant());
+  OMNIORB_ASSERT(id->adapter() == this);
+
+  // Only the ORB controlled threading model leaves the upcall free of
+  // any further synchronisation.
+  if( pd_policy.threading != TP_ORB_CTRL )
+    return 0;
+
+  // The request has been counted in <pd_nReqFast>, so if the state is
+  // seen to be active, a thread changing it will wait for the request
+  // to complete.
+  enterFast();
+
+  if( pd_rq_state != (int) PortableServer::POAManager::ACTIVE ) {
+    leaveFast(0);
+    return 0;
+  }
+
+  handle.poa(this);
+
+  try {
+    upcall(handle, id);
+  }
+  catch (...) {
+    leaveFast(0);
+    throw;
+  }
+  leaveFast(0);
+  return 1;
+}
+
+
+void
+omniOrbPOA::upcall(omniCallHandle& handle, omniLocalIdentity* id)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 0);
+
   if( omniORB::traceInvocations ) {
     omniORB::logger l;
     l << "Dispatching "
@@ -2082,6 +2127,49 @@ omniOrbPOA::dispatch(omniCallDescriptor& call_desc, omniLocalIdentity* id)
 }
 
 
+_CORBA_Boolean
+omniOrbPOA::fastDispatch(omniCallDescriptor& call_desc, omniLocalIdentity* id)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*omni::internalLock, 0);
+  OMNIORB_ASSERT(id);  OMNIORB_ASSERT(id->servant());
+  OMNIORB_ASSERT(id->adapter() == this);
+
+  // The call has been counted in <pd_nReqFast>, so if the state is
+  // seen to be active, a thread changing it will wait for the call
+  // to complete.
+  enterFast();
+
+  if( pd_rq_state != (int) PortableServer::POAManager::ACTIVE ) {
+    leaveFast(0);
+    return 0;
+  }
+
+  if( omniORB::traceInvocations ) {
+    omniORB::logger l;
+    l << "Dispatching fast local call \'" << call_desc.op() << "\' to "
+      << id << '\n';
+  }
+
+  try {
+    call_desc.poa(this);
+    _OMNI_NS(poaCurrentStackInsert) insert(&call_desc);
+    call_desc.doLocalCall(id->servant());
+  }
+  catch (...) {
+    leaveFast(0);
+    throw;
+  }
+  leaveFast(0);
+
+  if( omniORB::traceInvocationReturns ) {
+    omniORB::logger l;
+    l << "Return from local call \'" << call_desc.op() << "\' to "
+      << id << '\n';
+  }
+  return 1;
+}
+
+
 int
 omniOrbPOA::objectExists(const _CORBA_Octet*, int)
 {
@@ -2353,6 +2441,7 @@ omniOrbPOA::omniOrbPOA(const char* name,
 
   switch (policies.threading) {
   case TP_ORB_CTRL:
+    pd_fastCalls = orbParameters::fastLocalCalls;
     break;
   case TP_SINGLE_THREAD:
     pd_call_lock = new omni_rmutex();
@@ -2543,8 +2632,9 @@ omniOrbPOA::pm_waitForReqCmpltnOrSttChnge(omniOrbPOAManager::State state)
   omni::internalLock->lock();
 
   pd_signalOnZeroInvocations++;
+  LOCALID_FENCE();
 
-  while( pd_rq_state == (int) state && pd_nReqActive )
+  while( pd_rq_state == (int) state && (pd_nReqActive || pd_nReqFast) )
     pd_signal->wait();
 
   pd_signalOnZeroInvocations--;
@@ -3111,14 +3201,12 @@ omniOrbPOA::synchronise_request(omniLocalIdentity* lid)
   }
 
   // Check to see if the object has been deactivated while we've been
-  // holding. If so, throw a TRANSIENT exception.
-
-  CORBA::Boolean deactivated;
-  pd_lock.lock();
-  deactivated = lid->deactivated();
-  pd_lock.unlock();
+  // holding. If so, throw a TRANSIENT exception. The flag is only set
+  // with <omni::internalLock> held, so <pd_lock> is not needed, and
+  // must not be taken here: deactivate_object() takes <pd_lock>
+  // before <omni::internalLock>.
 
-  if (deactivated) {
+  if (lid->deactivated()) {
     // We have to do startRequest() here, since the identity
     // will do endInvocation() when we pass through there.
     startRequest();
@@ -129,6 +129,9 @@
 #include <dynamicLib.h>
 #include <exceptiondefs.h>
 #include <giopStream.h>
+#include <giopRope.h>
+#include <giopStrand.h>
+#include <GIOP_C.h>
 
 OMNI_NAMESPACE_BEGIN(omni)
 
@@ -175,21 +178,46 @@ omniRemoteIdentity::dispatch(omniCallDescriptor& call_desc)
   }
 
   IOP_C_Holder iop_client(pd_ior,key(),keysize(),pd_rope,&call_desc);
-  cdrStream& s = ((IOP_C&)iop_client).getStream();
 
- again:
-  call_desc.initialiseCall(s);
+  do {
+    call_desc.initialiseCall(((IOP_C&)iop_client).getStream());
+
+    iop_client->InitialiseRequest();
+
+    omniAsyncCall* ac = call_desc.asyncCall();
+    if (ac) {
+      // The reply is received by the strand's async reply task, which
+      // takes over the GIOP_C and a reference to this identity.
+      omni::internalLock->lock();
+      pd_refCount++;
+      omni::internalLock->unlock();
 
-  iop_client->InitialiseRequest();
+      ac->pd_identity = this;
+      ac->pd_sent     = 1;
+
+      GIOP_C* g = (GIOP_C*)iop_client._retn();
+      ((giopStrand&)*(giopStream*)g).addAsyncCall(g);
+      return;
+    }
+
+    // Wait for the reply.
+  } while (receiveReply(iop_client, call_desc));
+}
 
-  // Wait for the reply.
-  GIOP::ReplyStatusType rc = iop_client->ReceiveReply();
+
+CORBA::Boolean
+omniRemoteIdentity::receiveReply(IOP_C& iop_client,
+				 omniCallDescriptor& call_desc)
+{
+  cdrStream& s = iop_client.getStream();
+
+  GIOP::ReplyStatusType rc = iop_client.ReceiveReply();
 
   switch (rc) {
   case GIOP::NO_EXCEPTION:
     // Unmarshal any result and out/inout arguments.
     call_desc.unmarshalReturnedValues(s);
-    iop_client->RequestCompleted();
+    iop_client.RequestCompleted();
 
     if (omniORB::traceInvocationReturns) {
       omniORB::logger l;
@@ -205,8 +233,7 @@ omniRemoteIdentity::dispatch(omniCallDescriptor& call_desc)
       }
       // Retrieve the Interface Repository ID of the exception.
       CORBA::String_var repoId(s.unmarshalRawString());
-      call_desc.userException(iop_client->getStream(), &(IOP_C&)iop_client,
-			      repoId);
+      call_desc.userException(s, &iop_client, repoId);
       // Usually, the userException() call throws a user exception or
       // a system exception. In the DII case, it just stores the
       // exception and returns.
@@ -218,7 +245,7 @@ omniRemoteIdentity::dispatch(omniCallDescriptor& call_desc)
   case GIOP::LOCATION_FORWARD_PERM:
     {
       CORBA::Object_var obj(CORBA::Object::_unmarshalObjRef(s));
-      iop_client->RequestCompleted();
+      iop_client.RequestCompleted();
       if (omniORB::traceInvocationReturns) {
 	omniORB::logger l;
 	l << "Finish '" << call_desc.op() << "' (location forward)\n";
@@ -232,7 +259,7 @@ omniRemoteIdentity::dispatch(omniCallDescriptor& call_desc)
       GIOP::AddressingDisposition v;
       v <<= s;
       pd_ior->addr_mode(v);
-      iop_client->RequestCompleted();
+      iop_client.RequestCompleted();
       if (omniORB::traceInvocationReturns) {
 	omniORB::logger l;
 	l << "Finish '" << call_desc.op() << "' (needs addressing mode)\n";
@@ -242,7 +269,7 @@ omniRemoteIdentity::dispatch(omniCallDescriptor& call_desc)
 	log << "Remote invocation: GIOP::NEEDS_ADDRESSING_MODE: "
 	    << (int) v << " retry request.\n";
       }
-      goto again;
+      return 1;
     }
 
   case GIOP::SYSTEM_EXCEPTION:
@@ -250,6 +277,50 @@ omniRemoteIdentity::dispatch(omniCallDescriptor& call_desc)
     break;
 
   }
+  return 0;
+}
+
+
+void
+omniRemoteIdentity::receiveAsyncReply(GIOP_C* g)
+{
+  omniCallDescriptor& call_desc = *g->calldescriptor();
+  omniAsyncCall*      ac        = call_desc.asyncCall();
+  omniRemoteIdentity* id        = ac->pd_identity;
+  CORBA::Exception*   ex        = 0;
+
+  // Once the request has been sent its arguments are gone, so a reply
+  // asking for the request to be sent again ends the call.
+  try {
+    if (id->receiveReply(*g, call_desc))
+      ex = new CORBA::TRANSIENT(TRANSIENT_FailedOnForwarded,
+				CORBA::COMPLETED_NO);
+  }
+  catch (omniORB::LOCATION_FORWARD& fwd) {
+    if (!CORBA::is_nil(fwd.get_obj()))
+      omni::locationForward(ac->pd_objref, fwd.get_obj()->_PR_getobj(),
+			    fwd.is_permanent());
+    ex = new CORBA::TRANSIENT(TRANSIENT_FailedOnForwarded,
+			      CORBA::COMPLETED_NO);
+  }
+  catch (const giopStream::CommFailure& cf) {
+    if (is_COMM_FAILURE_minor(cf.minor()))
+      ex = new CORBA::COMM_FAILURE(cf.minor(), cf.completed());
+    else
+      ex = new CORBA::TRANSIENT(cf.minor(), cf.completed());
+  }
+  catch (CORBA::Exception& e) {
+    ex = CORBA::Exception::_duplicate(&e);
+  }
+
+  g->rope()->releaseClient(g);
+
+  ac->pd_identity = 0;
+  omni::internalLock->lock();
+  if (--id->pd_refCount == 0) delete id;
+  omni::internalLock->unlock();
+
+  ac->complete(ex);
 }
 
 
@@ -0,0 +1,139 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// shmActive.cc               Created on: 17 Oct 2026
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//	*** PROPRIETORY INTERFACE ***
+//
+#include <omniORB4/CORBA.h>
+#include <omniORB4/giopEndpoint.h>
+#include <SocketCollection.h>
+#include <shm/shmConnection.h>
+#include <shm/shmEndpoint.h>
+#include <omniORB4/linkHacks.h>
+
+OMNI_EXPORT_LINK_FORCE_SYMBOL(shmActive);
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+/////////////////////////////////////////////////////////////////////////
+static shmActiveCollection myCollection;
+
+/////////////////////////////////////////////////////////////////////////
+shmActiveCollection::shmActiveCollection(): pd_n_sockets(0),pd_shutdown(0) {}
+
+/////////////////////////////////////////////////////////////////////////
+shmActiveCollection::~shmActiveCollection() {}
+
+/////////////////////////////////////////////////////////////////////////
+const char*
+shmActiveCollection::type() const {
+  return "giop:shm";
+}
+
+/////////////////////////////////////////////////////////////////////////
+void
+shmActiveCollection::Monitor(giopConnection::notifyReadable_t func,
+			     void* cookie) {
+
+  pd_callback_func = func;
+  pd_callback_cookie = cookie;
+
+  CORBA::Boolean doit;
+  while (!isEmpty()) {
+    if (!Select()) break;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+shmActiveCollection::notifyReadable(SocketHolder* conn) {
+
+  pd_callback_func(pd_callback_cookie,(shmConnection*)conn);
+  return 1;
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+void
+shmActiveCollection::addMonitor(SocketHandle_t) {
+  omni_tracedmutex_lock sync(pd_lock);
+  pd_n_sockets++;
+  pd_shutdown = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////
+void
+shmActiveCollection::removeMonitor(SocketHandle_t) {
+  omni_tracedmutex_lock sync(pd_lock);
+  pd_n_sockets--;
+}
+
+/////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+shmActiveCollection::isEmpty() const {
+  omni_tracedmutex_lock sync((omni_tracedmutex&)pd_lock);
+  return (pd_n_sockets == 0 || pd_shutdown);
+}
+
+/////////////////////////////////////////////////////////////////////////
+void
+shmActiveCollection::deactivate() {
+  omni_tracedmutex_lock sync(pd_lock);
+  pd_shutdown = 1;
+  wakeUp();
+}
+
+/////////////////////////////////////////////////////////////////////////
+shmActiveConnection::shmActiveConnection(const shmChannel& ch,
+					 const char* filename) :
+  shmConnection(ch,&myCollection,filename,1), pd_registered(0) {
+}
+
+/////////////////////////////////////////////////////////////////////////
+shmActiveConnection::~shmActiveConnection() {
+  if (pd_registered) {
+    myCollection.removeMonitor(pd_socket);
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+giopActiveCollection*
+shmActiveConnection::registerMonitor() {
+
+  if (pd_registered) return &myCollection;
+
+  pd_registered = 1;
+  myCollection.addMonitor(pd_socket);
+  return &myCollection;
+}
+
+/////////////////////////////////////////////////////////////////////////
+giopConnection&
+shmActiveConnection::getConnection() {
+  return *this;
+}
+
+
+OMNI_NAMESPACE_END(omni)
@@ -0,0 +1,131 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// shmAddress.cc              Created on: 17 Oct 2026
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//	*** PROPRIETORY INTERFACE ***
+//
+
+#include <omniORB4/CORBA.h>
+#include <omniORB4/giopEndpoint.h>
+#include <shm/shmConnection.h>
+#include <shm/shmAddress.h>
+#include <stdio.h>
+#include <omniORB4/linkHacks.h>
+#include <sys/un.h>
+
+OMNI_EXPORT_LINK_FORCE_SYMBOL(shmAddress);
+
+#ifndef AF_LOCAL
+#  ifdef  AF_UNIX
+#    define AF_LOCAL AF_UNIX
+#  endif
+#endif
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+/////////////////////////////////////////////////////////////////////////
+static SocketHandle_t
+shmConnectSocket(const char* filename)
+{
+  struct sockaddr_un raddr;
+  SocketHandle_t sock;
+
+  if ((sock = socket(AF_LOCAL,SOCK_STREAM,0)) == RC_INVALID_SOCKET) {
+    return RC_INVALID_SOCKET;
+  }
+
+  memset((void*)&raddr,0,sizeof(raddr));
+  raddr.sun_family = AF_LOCAL;
+  strncpy(raddr.sun_path, filename, sizeof(raddr.sun_path) - 1);
+
+  if (::connect(sock,(struct sockaddr *)&raddr,
+                     sizeof(raddr)) == RC_SOCKET_ERROR) {
+    CLOSESOCKET(sock);
+    return RC_INVALID_SOCKET;
+  }
+  return sock;
+}
+
+/////////////////////////////////////////////////////////////////////////
+shmAddress::shmAddress(const char* filename) {
+
+  pd_filename = (const char*) filename;
+  pd_address_string = shmConnection::shmToString(filename);
+}
+
+/////////////////////////////////////////////////////////////////////////
+const char*
+shmAddress::type() const {
+  return "giop:shm";
+}
+
+/////////////////////////////////////////////////////////////////////////
+const char*
+shmAddress::address() const {
+  return pd_address_string;
+}
+
+/////////////////////////////////////////////////////////////////////////
+giopAddress*
+shmAddress::duplicate() const {
+  return new shmAddress(pd_filename);
+}
+
+/////////////////////////////////////////////////////////////////////////
+giopActiveConnection*
+shmAddress::Connect(unsigned long deadline_secs,
+		    unsigned long deadline_nanosecs,
+		    CORBA::ULong) const {
+
+  SocketHandle_t sock = shmConnectSocket(pd_filename);
+  if (sock == RC_INVALID_SOCKET)
+    return 0;
+
+  shmChannel ch;
+  if (!shmChannel::connect(sock,ch,deadline_secs,deadline_nanosecs)) {
+    if (omniORB::trace(5)) {
+      omniORB::logger log;
+      log << "Shared memory handshake with " << pd_address_string
+	  << " failed.\n";
+    }
+    CLOSESOCKET(sock);
+    return 0;
+  }
+  return new shmActiveConnection(ch,pd_filename);
+}
+
+/////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+shmAddress::Poke() const {
+
+  SocketHandle_t sock = shmConnectSocket(pd_filename);
+  if (sock == RC_INVALID_SOCKET)
+    return 0;
+
+  CLOSESOCKET(sock);
+  return 1;
+}
+
+
+OMNI_NAMESPACE_END(omni)
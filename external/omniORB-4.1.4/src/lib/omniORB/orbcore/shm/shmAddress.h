@@ -0,0 +1,57 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// shmAddress.h               Created on: 17 Oct 2026
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//	*** PROPRIETORY INTERFACE ***
+//
+
+#ifndef __SHMADDRESS_H__
+#define __SHMADDRESS_H__
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+class shmAddress : public giopAddress {
+ public:
+
+  shmAddress(const char* filename);
+  const char* type() const;
+  const char* address() const;
+  giopAddress* duplicate() const;
+  giopActiveConnection* Connect(unsigned long deadline_secs = 0,
+				unsigned long deadline_nanosecs = 0,
+				CORBA::ULong  strand_flags = 0) const;
+  CORBA::Boolean Poke() const;
+  ~shmAddress() {}
+
+ private:
+  CORBA::String_var  pd_address_string;
+  CORBA::String_var  pd_filename;
+
+  shmAddress();
+  shmAddress(const shmAddress&);
+};
+
+OMNI_NAMESPACE_END(omni)
+
+#endif // __SHMADDRESS_H__
@@ -0,0 +1,667 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// shmConnection.cc           Created on: 17 Oct 2026
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//	*** PROPRIETORY INTERFACE ***
+//
+
+#include <omniORB4/CORBA.h>
+#include <omniORB4/giopEndpoint.h>
+#include <orbParameters.h>
+#include <SocketCollection.h>
+#include <shm/shmConnection.h>
+#include <stdio.h>
+#include <limits.h>
+#include <omniORB4/linkHacks.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <linux/futex.h>
+
+OMNI_EXPORT_LINK_FORCE_SYMBOL(shmConnection);
+
+#ifndef MFD_CLOEXEC
+#  define MFD_CLOEXEC 0x0001U
+#endif
+
+#define SHM_MAGIC   0x4f53484d  // "OSHM"
+#define SHM_VERSION 1
+
+// A writer waiting for space wakes up this often to check that the
+// peer is still there.
+#define SHM_WRITE_WAIT_SLICE_MS 100
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+struct shmHello {
+  CORBA::ULong magic;
+  CORBA::ULong version;
+  CORBA::ULong ringSize;
+};
+
+/////////////////////////////////////////////////////////////////////////
+static inline int
+shmFutex(volatile CORBA::ULong* addr, int op, CORBA::ULong val,
+	 const struct timespec* timeout)
+{
+  return syscall(SYS_futex, (void*)addr, op, (int)val, timeout, 0, 0);
+}
+
+/////////////////////////////////////////////////////////////////////////
+static inline void
+shmSignal(int fd)
+{
+  CORBA::ULongLong one = 1;
+  while (::write(fd, &one, sizeof(one)) < 0 && errno == EINTR);
+}
+
+/////////////////////////////////////////////////////////////////////////
+static inline void
+shmDrain(int fd)
+{
+  CORBA::ULongLong count;
+  while (::read(fd, &count, sizeof(count)) < 0 && errno == EINTR);
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+shmChannel::shmChannel()
+  : sock(RC_INVALID_SOCKET), epfd(-1), rxEvent(-1), txEvent(-1),
+    seg(0), length(0), rx(0), rxData(0), tx(0), txData(0), ringSize(0)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////
+void
+shmChannel::release()
+{
+  if (seg) {
+    munmap((void*)seg, length);
+    seg = 0;
+  }
+  if (epfd    >= 0) { ::close(epfd);    epfd    = -1; }
+  if (rxEvent >= 0) { ::close(rxEvent); rxEvent = -1; }
+  if (txEvent >= 0) { ::close(txEvent); txEvent = -1; }
+  if (sock != RC_INVALID_SOCKET) {
+    CLOSESOCKET(sock);
+    sock = RC_INVALID_SOCKET;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+shmChannel::setup(CORBA::Boolean isServer)
+{
+  char* data = (char*)seg + sizeof(shmSegment);
+
+  if (isServer) {
+    rx = &seg->ring[0]; rxData = data;
+    tx = &seg->ring[1]; txData = data + ringSize;
+  }
+  else {
+    rx = &seg->ring[1]; rxData = data + ringSize;
+    tx = &seg->ring[0]; txData = data;
+  }
+
+  if ((epfd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+    return 0;
+
+  struct epoll_event ev;
+  memset((void*)&ev, 0, sizeof(ev));
+  ev.events  = EPOLLIN;
+  ev.data.fd = rxEvent;
+  if (epoll_ctl(epfd, EPOLL_CTL_ADD, rxEvent, &ev) < 0)
+    return 0;
+
+  ev.events  = EPOLLIN | EPOLLRDHUP;
+  ev.data.fd = sock;
+  if (epoll_ctl(epfd, EPOLL_CTL_ADD, sock, &ev) < 0)
+    return 0;
+
+  return 1;
+}
+
+/////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+shmChannel::accept(SocketHandle_t s, shmChannel& ch)
+{
+#if defined(SYS_memfd_create)
+  CORBA::ULong ringSize = orbParameters::shmTransportBufferSize;
+  size_t       length   = sizeof(shmSegment) + 2 * (size_t)ringSize;
+
+  int memfd   = syscall(SYS_memfd_create, "omniORB-shm", MFD_CLOEXEC);
+  int srvRx   = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  int cliRx   = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  void* base  = MAP_FAILED;
+
+  if (memfd >= 0 && srvRx >= 0 && cliRx >= 0 &&
+      ftruncate(memfd, length) == 0) {
+
+    base = mmap(0, length, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+  }
+  if (base == MAP_FAILED) {
+    if (omniORB::trace(5)) {
+      omniORB::logger log;
+      log << "Cannot create shared memory segment: errno " << errno << "\n";
+    }
+    if (memfd >= 0) ::close(memfd);
+    if (srvRx >= 0) ::close(srvRx);
+    if (cliRx >= 0) ::close(cliRx);
+    return 0;
+  }
+
+  shmSegment* seg = (shmSegment*)base;
+  seg->magic    = SHM_MAGIC;
+  seg->version  = SHM_VERSION;
+  seg->ringSize = ringSize;
+
+  // Send the segment and the client's two eventfds.
+  shmHello hello;
+  hello.magic    = SHM_MAGIC;
+  hello.version  = SHM_VERSION;
+  hello.ringSize = ringSize;
+
+  struct iovec iov;
+  iov.iov_base = (void*)&hello;
+  iov.iov_len  = sizeof(hello);
+
+  union {
+    struct cmsghdr align;
+    char           buf[CMSG_SPACE(3 * sizeof(int))];
+  } control;
+  memset((void*)&control, 0, sizeof(control));
+
+  struct msghdr msg;
+  memset((void*)&msg, 0, sizeof(msg));
+  msg.msg_iov        = &iov;
+  msg.msg_iovlen     = 1;
+  msg.msg_control    = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type  = SCM_RIGHTS;
+  cmsg->cmsg_len   = CMSG_LEN(3 * sizeof(int));
+  int fds[3] = { memfd, cliRx, srvRx };
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  int rc;
+  do {
+    rc = ::sendmsg(s, &msg, MSG_NOSIGNAL);
+  } while (rc < 0 && errno == EINTR);
+
+  ::close(memfd);
+
+  if (rc != (int)sizeof(hello)) {
+    if (omniORB::trace(5)) {
+      omniORB::logger log;
+      log << "Cannot send shared memory segment to client: errno "
+	  << errno << "\n";
+    }
+    munmap(base, length);
+    ::close(srvRx);
+    ::close(cliRx);
+    return 0;
+  }
+
+  ch.sock     = s;
+  ch.seg      = seg;
+  ch.length   = length;
+  ch.ringSize = ringSize;
+  ch.rxEvent  = srvRx;
+  ch.txEvent  = cliRx;
+
+  if (!ch.setup(1)) {
+    ch.sock = RC_INVALID_SOCKET;
+    ch.release();
+    return 0;
+  }
+  SocketSetCloseOnExec(s);
+  return 1;
+#else
+  omniORB::logs(5, "Shared memory transport needs memfd_create().");
+  return 0;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+shmChannel::connect(SocketHandle_t s, shmChannel& ch,
+		    unsigned long deadline_secs,
+		    unsigned long deadline_nanosecs)
+{
+  // Wait for the server's hello.
+  while (1) {
+    int timeout = -1;
+
+    if (deadline_secs || deadline_nanosecs) {
+      struct timeval t;
+      SocketSetTimeOut(deadline_secs, deadline_nanosecs, t);
+      if (t.tv_sec == 0 && t.tv_usec == 0)
+	return 0;
+      timeout = t.tv_sec * 1000 + (t.tv_usec + 999) / 1000;
+    }
+    struct pollfd fds;
+    fds.fd     = s;
+    fds.events = POLLIN;
+    int rc = poll(&fds, 1, timeout);
+    if (rc > 0)
+      break;
+    if (rc == 0 || errno != EINTR)
+      return 0;
+  }
+
+  shmHello hello;
+  struct iovec iov;
+  iov.iov_base = (void*)&hello;
+  iov.iov_len  = sizeof(hello);
+
+  union {
+    struct cmsghdr align;
+    char           buf[CMSG_SPACE(3 * sizeof(int))];
+  } control;
+
+  struct msghdr msg;
+  memset((void*)&msg, 0, sizeof(msg));
+  msg.msg_iov        = &iov;
+  msg.msg_iovlen     = 1;
+  msg.msg_control    = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  int rc;
+  do {
+    rc = ::recvmsg(s, &msg, MSG_CMSG_CLOEXEC);
+  } while (rc < 0 && errno == EINTR);
+
+  int fds[3] = { -1, -1, -1 };
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg && cmsg->cmsg_level == SOL_SOCKET &&
+      cmsg->cmsg_type == SCM_RIGHTS &&
+      cmsg->cmsg_len == CMSG_LEN(sizeof(fds))) {
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+  }
+
+  CORBA::Boolean ok = (rc == (int)sizeof(hello) && fds[0] >= 0 &&
+		       !(msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) &&
+		       hello.magic == SHM_MAGIC &&
+		       hello.version == SHM_VERSION &&
+		       hello.ringSize >= 8192 &&
+		       (hello.ringSize & (hello.ringSize - 1)) == 0);
+
+  size_t length = ok ? sizeof(shmSegment) + 2 * (size_t)hello.ringSize : 0;
+  void*  base   = MAP_FAILED;
+
+  if (ok) {
+    struct stat sb;
+    if (fstat(fds[0], &sb) == 0 && (size_t)sb.st_size == length)
+      base = mmap(0, length, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+  }
+  if (fds[0] >= 0) ::close(fds[0]);
+
+  if (base == MAP_FAILED) {
+    if (fds[1] >= 0) ::close(fds[1]);
+    if (fds[2] >= 0) ::close(fds[2]);
+    return 0;
+  }
+
+  ch.sock     = s;
+  ch.seg      = (shmSegment*)base;
+  ch.length   = length;
+  ch.ringSize = hello.ringSize;
+  ch.rxEvent  = fds[1];
+  ch.txEvent  = fds[2];
+
+  if (ch.seg->magic != SHM_MAGIC || ch.seg->ringSize != hello.ringSize ||
+      !ch.setup(0)) {
+    ch.sock = RC_INVALID_SOCKET;
+    ch.release();
+    return 0;
+  }
+  SocketSetCloseOnExec(s);
+  return 1;
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+shmConnection::peerClosed() {
+
+  if (pd_peerGone || pd_channel.seg->closed)
+    return 1;
+
+  char c;
+  if (::recv(pd_channel.sock, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0)
+    pd_peerGone = 1;
+
+  return pd_peerGone;
+}
+
+/////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+shmConnection::armReader() {
+
+  shmRing* rx = pd_channel.rx;
+
+  shmDrain(pd_channel.rxEvent);
+  rx->rdWaiting = 1;
+  __sync_synchronize();
+
+  if (rx->wr != pd_rxRd) {
+    shmSignal(pd_channel.rxEvent);
+    return 1;
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////
+int
+shmConnection::Send(void* buf, size_t sz,
+		    unsigned long deadline_secs,
+		    unsigned long deadline_nanosecs) {
+
+  SendBuffer b;
+  b.buf = buf;
+  b.sz  = sz;
+  return Sendv(&b, 1, deadline_secs, deadline_nanosecs);
+}
+
+/////////////////////////////////////////////////////////////////////////
+int
+shmConnection::Sendv(const SendBuffer* bufs, int count,
+		     unsigned long deadline_secs,
+		     unsigned long deadline_nanosecs) {
+
+  shmRing* tx = pd_channel.tx;
+
+  do {
+    if (pd_shutdown || pd_channel.seg->closed || pd_peerGone)
+      return -1;
+
+    CORBA::ULong rd = tx->rd;
+    __sync_synchronize();
+    CORBA::ULong space = pd_channel.ringSize - (pd_txWr - rd);
+
+    if (space) {
+      // Copy as much of the gather list as fits.
+      CORBA::ULong total = 0;
+
+      for (int i=0; i < count && space; i++) {
+	const char*  src = (const char*)bufs[i].buf;
+	CORBA::ULong len = bufs[i].sz < space ? bufs[i].sz : space;
+
+	while (len) {
+	  CORBA::ULong off   = pd_txWr & pd_mask;
+	  CORBA::ULong chunk = pd_channel.ringSize - off;
+	  if (chunk > len) chunk = len;
+	  memcpy(pd_channel.txData + off, src, chunk);
+	  src     += chunk;
+	  len     -= chunk;
+	  space   -= chunk;
+	  total   += chunk;
+	  pd_txWr += chunk;
+	}
+      }
+      __sync_synchronize();
+      tx->wr = pd_txWr;
+      __sync_synchronize();
+
+      if (tx->rdWaiting && __sync_bool_compare_and_swap(&tx->rdWaiting, 1, 0))
+	shmSignal(pd_channel.txEvent);
+
+      return (int)total;
+    }
+
+    // The ring is full. Ask the reader to wake us when it makes space.
+    tx->wrWaiting = 1;
+    __sync_synchronize();
+    if (tx->rd != rd)
+      continue;
+
+    long slice = SHM_WRITE_WAIT_SLICE_MS;
+    CORBA::Boolean last = 0;
+
+    if (deadline_secs || deadline_nanosecs) {
+      struct timeval t;
+      SocketSetTimeOut(deadline_secs, deadline_nanosecs, t);
+      if (t.tv_sec == 0 && t.tv_usec == 0) {
+	// Already timeout.
+	return 0;
+      }
+      long ms = t.tv_sec * 1000 + (t.tv_usec + 999) / 1000;
+      if (ms <= slice) {
+	slice = ms;
+	last  = 1;
+      }
+    }
+    struct timespec ts;
+    ts.tv_sec  = slice / 1000;
+    ts.tv_nsec = (slice % 1000) * 1000000;
+
+    if (shmFutex(&tx->rd, FUTEX_WAIT, rd, &ts) < 0 && errno == ETIMEDOUT) {
+      if (last)
+	return 0;
+      if (peerClosed())
+	return -1;
+    }
+  } while(1);
+}
+
+/////////////////////////////////////////////////////////////////////////
+int
+shmConnection::Recv(void* buf, size_t sz,
+		    unsigned long deadline_secs,
+		    unsigned long deadline_nanosecs) {
+
+  shmRing* rx = pd_channel.rx;
+
+  do {
+    CORBA::ULong wr = rx->wr;
+    __sync_synchronize();
+    CORBA::ULong avail = wr - pd_rxRd;
+
+    if (avail) {
+      if (avail > sz) avail = sz;
+
+      char*        dst = (char*)buf;
+      CORBA::ULong len = avail;
+
+      while (len) {
+	CORBA::ULong off   = pd_rxRd & pd_mask;
+	CORBA::ULong chunk = pd_channel.ringSize - off;
+	if (chunk > len) chunk = len;
+	memcpy(dst, pd_channel.rxData + off, chunk);
+	dst     += chunk;
+	len     -= chunk;
+	pd_rxRd += chunk;
+      }
+      __sync_synchronize();
+      rx->rd = pd_rxRd;
+      __sync_synchronize();
+
+      if (rx->wrWaiting && __sync_bool_compare_and_swap(&rx->wrWaiting, 1, 0))
+	shmFutex(&rx->rd, FUTEX_WAKE, INT_MAX, 0);
+
+      return (int)avail;
+    }
+
+    if (pd_shutdown || pd_channel.seg->closed || pd_peerGone)
+      return -1;
+
+    // Nothing to read. Ask the writer to signal us, then check again
+    // in case data arrived before it saw the request.
+    rx->rdWaiting = 1;
+    __sync_synchronize();
+    if (rx->wr != pd_rxRd)
+      continue;
+
+    int timeout = -1;
+
+    if (deadline_secs || deadline_nanosecs) {
+      struct timeval t;
+      SocketSetTimeOut(deadline_secs, deadline_nanosecs, t);
+      if (t.tv_sec == 0 && t.tv_usec == 0) {
+	// Already timeout.
+	return 0;
+      }
+      timeout = t.tv_sec * 1000 + (t.tv_usec + 999) / 1000;
+    }
+
+    struct epoll_event ev[2];
+    int n = epoll_wait(pd_channel.epfd, ev, 2, timeout);
+    if (n == 0) {
+      // Time out!
+      return 0;
+    }
+    else if (n < 0) {
+      if (errno == EINTR)
+	continue;
+      return -1;
+    }
+    for (int i=0; i < n; i++) {
+      if (ev[i].data.fd == pd_channel.rxEvent) {
+	shmDrain(pd_channel.rxEvent);
+      }
+      else if (ev[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+	pd_peerGone = 1;
+      }
+      else {
+	peerClosed();
+      }
+    }
+  } while(1);
+}
+
+/////////////////////////////////////////////////////////////////////////
+void
+shmConnection::Shutdown() {
+  pd_shutdown = 1;
+  pd_channel.seg->closed = 1;
+  __sync_synchronize();
+
+  // Shutting down the socket wakes readers on both sides; writers
+  // waiting for space are woken through the futexes.
+  SHUTDOWNSOCKET(pd_channel.sock);
+  shmFutex(&pd_channel.tx->rd, FUTEX_WAKE, INT_MAX, 0);
+  shmFutex(&pd_channel.rx->rd, FUTEX_WAKE, INT_MAX, 0);
+}
+
+/////////////////////////////////////////////////////////////////////////
+const char*
+shmConnection::myaddress() {
+  return (const char*)pd_myaddress;
+}
+
+/////////////////////////////////////////////////////////////////////////
+const char*
+shmConnection::peeraddress() {
+  return (const char*)pd_peeraddress;
+}
+
+/////////////////////////////////////////////////////////////////////////
+shmConnection::shmConnection(const shmChannel& ch,
+			     SocketCollection* belong_to,
+			     const char* filename,
+			     CORBA::Boolean isActive) :
+  SocketHolder(ch.epfd), pd_channel(ch), pd_mask(ch.ringSize - 1),
+  pd_peerGone(0) {
+
+  pd_txWr = pd_channel.tx->wr;
+  pd_rxRd = pd_channel.rx->rd;
+
+  static CORBA::ULong suffix = 0;
+
+  CORBA::String_var filename_1;
+  filename_1 = CORBA::string_alloc(strlen(filename)+12);
+  sprintf(filename_1,"%s %08x",filename,(unsigned int)++suffix);
+
+  if (isActive) {
+    pd_myaddress = shmToString(filename_1);
+    pd_peeraddress = shmToString(filename);
+  }
+  else {
+    pd_myaddress = shmToString(filename);
+    pd_peeraddress = shmToString(filename_1);
+  }
+
+  belong_to->addSocket(this);
+}
+
+/////////////////////////////////////////////////////////////////////////
+shmConnection::~shmConnection() {
+  clearSelectable();
+  pd_belong_to->removeSocket(this);
+  pd_channel.release();
+}
+
+/////////////////////////////////////////////////////////////////////////
+void
+shmConnection::setSelectable(int now,
+			     CORBA::Boolean data_in_buffer) {
+
+  armReader();
+  SocketHolder::setSelectable(now,data_in_buffer);
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+void
+shmConnection::clearSelectable() {
+
+  SocketHolder::clearSelectable();
+}
+
+/////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+shmConnection::isSelectable() {
+  return pd_belong_to->isSelectable(pd_socket);
+}
+
+/////////////////////////////////////////////////////////////////////////
+CORBA::Boolean
+shmConnection::Peek() {
+  armReader();
+  return SocketHolder::Peek();
+}
+
+/////////////////////////////////////////////////////////////////////////
+char*
+shmConnection::shmToString(const char* filename) {
+
+  const char* format = "giop:shm:%s";
+
+  CORBA::ULong len = strlen(filename);
+  if (len == 0) {
+    filename = "<not bound>";
+    len = strlen(filename);
+  }
+  len += strlen(format);
+  CORBA::String_var addrstr(CORBA::string_alloc(len));
+  sprintf(addrstr,format,(const char*)filename);
+  return addrstr._retn();
+}
+
+
+OMNI_NAMESPACE_END(omni)
@@ -0,0 +1,191 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// shmConnection.h            Created on: 17 Oct 2026
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//	*** PROPRIETORY INTERFACE ***
+//
+
+#ifndef __SHMCONNECTION_H__
+#define __SHMCONNECTION_H__
+
+#include <SocketCollection.h>
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+//
+// A shared memory connection is set up over a unix domain socket. The
+// server creates an anonymous shared memory segment holding two ring
+// buffers, one for each direction, and two eventfds, and passes all
+// three descriptors to the client over the socket. From then on GIOP
+// data only goes through the rings. The socket stays open so each side
+// notices if the other goes away.
+//
+// The reader of a ring asks to be woken by setting rdWaiting; the
+// writer then signals the reader's eventfd after its next write. The
+// eventfd and the socket are combined in a per-connection epoll set,
+// which is the descriptor given to the SocketCollection, so the
+// connection can be watched like any socket. A writer that finds its
+// ring full sets wrWaiting and sleeps on a futex on the ring's read
+// index, which the reader wakes once it has made space.
+
+struct shmRing {
+  volatile CORBA::ULong wr;        // Bytes written, modulo 2^32.
+  volatile CORBA::ULong rdWaiting; // Reader wants its eventfd signalled.
+  CORBA::Octet          pad0[56];
+  volatile CORBA::ULong rd;        // Bytes read, modulo 2^32. Futex word.
+  volatile CORBA::ULong wrWaiting; // Writer is waiting on the rd futex.
+  CORBA::Octet          pad1[56];
+};
+
+struct shmSegment {
+  CORBA::ULong          magic;
+  CORBA::ULong          version;
+  CORBA::ULong          ringSize;
+  volatile CORBA::ULong closed;    // Set by the side that shuts down.
+  CORBA::Octet          pad[48];
+  shmRing               ring[2];   // [0] client to server,
+				   // [1] server to client.
+  // The ring data follows, ring 0 first.
+};
+
+
+class shmChannel {
+public:
+  shmChannel();
+
+  static CORBA::Boolean accept(SocketHandle_t sock, shmChannel& ch);
+  // Server side. Create the shared memory and eventfds for a newly
+  // accepted unix socket and send them to the client. Returns false
+  // if anything fails, in which case <ch> holds nothing and the caller
+  // still owns <sock>.
+
+  static CORBA::Boolean connect(SocketHandle_t sock, shmChannel& ch,
+				unsigned long deadline_secs,
+				unsigned long deadline_nanosecs);
+  // Client side. Receive the descriptors sent by accept() and map the
+  // shared memory. Returns false on failure or if the deadline
+  // expires, with the same ownership rules as accept().
+
+  void release();
+  // Unmap the memory and close all descriptors.
+
+  SocketHandle_t sock;     // The unix socket.
+  int            epfd;     // epoll set of rxEvent and sock.
+  int            rxEvent;  // Signalled by the peer when it writes to rx.
+  int            txEvent;  // Signalled by us when we write to tx.
+  shmSegment*    seg;
+  size_t         length;
+  shmRing*       rx;
+  char*          rxData;
+  shmRing*       tx;
+  char*          txData;
+  CORBA::ULong   ringSize;
+
+private:
+  CORBA::Boolean setup(CORBA::Boolean isServer);
+};
+
+
+class shmEndpoint;
+
+class shmConnection : public giopConnection, public SocketHolder {
+ public:
+
+  int Send(void* buf, size_t sz,
+	   unsigned long deadline_secs = 0,
+	   unsigned long deadline_nanosecs = 0);
+
+  int Sendv(const SendBuffer* bufs, int count,
+	    unsigned long deadline_secs = 0,
+	    unsigned long deadline_nanosecs = 0);
+
+  int Recv(void* buf, size_t sz,
+	   unsigned long deadline_secs = 0,
+	   unsigned long deadline_nanosecs = 0);
+
+  void Shutdown();
+
+  const char* myaddress();
+
+  const char* peeraddress();
+
+  void setSelectable(int now = 0,CORBA::Boolean data_in_buffer = 0);
+
+  void clearSelectable();
+
+  CORBA::Boolean isSelectable();
+
+  CORBA::Boolean Peek();
+
+  SocketHandle_t handle() const { return pd_socket; }
+
+  shmConnection(const shmChannel& ch, SocketCollection*,
+		const char* filename, CORBA::Boolean isActive);
+  // Takes ownership of everything in <ch>.
+
+  ~shmConnection();
+
+  static char* shmToString(const char* filename);
+
+  friend class shmEndpoint;
+
+ private:
+  shmChannel        pd_channel;
+  CORBA::ULong      pd_mask;      // ringSize - 1
+  CORBA::ULong      pd_txWr;      // Our copy of pd_channel.tx->wr
+  CORBA::ULong      pd_rxRd;      // Our copy of pd_channel.rx->rd
+  CORBA::Boolean    pd_peerGone;  // The socket has reached end of file
+  CORBA::String_var pd_myaddress;
+  CORBA::String_var pd_peeraddress;
+
+  CORBA::Boolean armReader();
+  // Ask the peer to signal rxEvent when it next writes, first
+  // discarding any stale signal. If data is already waiting, signal
+  // rxEvent ourselves so the epoll set reports it. Returns true if
+  // data is waiting.
+
+  CORBA::Boolean peerClosed();
+  // True if the peer has shut down or exited.
+};
+
+
+class shmActiveConnection : public giopActiveConnection, public shmConnection {
+public:
+  giopActiveCollection* registerMonitor();
+  giopConnection& getConnection();
+
+  shmActiveConnection(const shmChannel& ch, const char* filename);
+  ~shmActiveConnection();
+
+private:
+  CORBA::Boolean pd_registered;
+
+  shmActiveConnection(const shmActiveConnection&);
+  shmActiveConnection& operator=(const shmActiveConnection&);
+};
+
+
+OMNI_NAMESPACE_END(omni)
+
+#endif //__SHMCONNECTION_H__
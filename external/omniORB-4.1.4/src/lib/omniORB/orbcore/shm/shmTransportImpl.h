@@ -0,0 +1,52 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// shmTransportImpl.h         Created on: 17 Oct 2026
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//	*** PROPRIETORY INTERFACE ***
+//
+#ifndef __SHMTRANSPORTIMPL_H__
+#define __SHMTRANSPORTIMPL_H__
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+class shmTransportImpl : public giopTransportImpl {
+ public:
+
+  shmTransportImpl();
+  ~shmTransportImpl();
+  
+  giopEndpoint*  toEndpoint(const char* param);
+  giopAddress*   toAddress(const char* param);
+  CORBA::Boolean isValid(const char* param);
+  CORBA::Boolean addToIOR(const char* param);
+  const omnivector<const char*>* getInterfaceAddress();
+
+ private:
+  shmTransportImpl(const shmTransportImpl&);
+  shmTransportImpl& operator=(const shmTransportImpl&);
+};
+
+OMNI_NAMESPACE_END(omni)
+
+#endif // __SHMTRANSPORTIMPL_H__
@@ -90,6 +90,12 @@ public:
 	   unsigned long deadline_secs = 0,
 	   unsigned long deadline_nanosecs = 0);
 
+#if defined(USE_WRITEV)
+  int Sendv(const SendBuffer* bufs, int count,
+	    unsigned long deadline_secs = 0,
+	    unsigned long deadline_nanosecs = 0);
+#endif
+
   void Shutdown();
 
   const char* myaddress();
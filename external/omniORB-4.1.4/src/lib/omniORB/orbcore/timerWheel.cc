@@ -0,0 +1,561 @@
+// -*- Mode: C++; -*-
+//                            Package   : omniORB
+// timerWheel.cc              Created on: 2026/10/17
+//
+//    Copyright (C) 2026 omniORB contributors
+//
+//    This file is part of the omniORB library
+//
+//    The omniORB library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 2 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; if not, write to the Free
+//    Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//    02111-1307, USA
+//
+//
+// Description:
+//    Hierarchical timer wheel.
+//
+//    Timers are kept in LEVELS levels of LEVEL_SLOTS slots each. A
+//    tick is one millisecond. Level 0 holds the timers due in the next
+//    LEVEL_SLOTS ticks, one slot per tick; each slot of level n covers
+//    LEVEL_SLOTS times as many ticks as a slot of level n-1. When the
+//    time reaches the start of a slot of level n > 0, its timers are
+//    moved down to the level that now fits them, and the timers in a
+//    slot of level 0 expire when the time reaches it. A timer further
+//    in the future than the wheel covers is parked in the top level
+//    and moved again when its slot is reached.
+//
+//    Scheduling and cancelling a timer take constant time. A bitmap of
+//    the occupied slots of each level lets the task find the next slot
+//    with anything in it without visiting the empty ones, so it sleeps
+//    until then.
+//
+
+#include <omniORB4/CORBA.h>
+#include <initialiser.h>
+#include <invoker.h>
+#include <timerWheel.h>
+
+OMNI_NAMESPACE_BEGIN(omni)
+
+#define LEVEL_BITS  6
+#define LEVEL_SLOTS (1 << LEVEL_BITS)
+#define LEVEL_MASK  (LEVEL_SLOTS - 1)
+#define LEVELS      5
+
+static const CORBA::ULongLong MAX_DELTA =
+  ((CORBA::ULongLong)1 << (LEVEL_BITS * LEVELS));
+// About 12 days.
+
+static const CORBA::ULongLong NO_EVENT = ~(CORBA::ULongLong)0;
+
+
+static inline CORBA::ULongLong
+toTicks(unsigned long secs, unsigned long nanosecs)
+{
+  return (CORBA::ULongLong)secs * 1000 + (nanosecs + 999999) / 1000000;
+}
+
+static inline CORBA::ULongLong
+nowTicks()
+{
+  unsigned long secs, nanosecs;
+  omni_thread::get_time(&secs, &nanosecs);
+  return (CORBA::ULongLong)secs * 1000 + nanosecs / 1000000;
+}
+
+static inline int
+lowestBit(CORBA::ULongLong v)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll(v);
+#else
+  int n = 0;
+  while (!(v & 1)) {
+    v >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+static inline CORBA::ULongLong
+rotateRight(CORBA::ULongLong v, int n)
+{
+  return n ? (v >> n) | (v << (LEVEL_SLOTS - n)) : v;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//             The wheel                                                  //
+////////////////////////////////////////////////////////////////////////////
+
+class timerWheelTask : public omniTask {
+public:
+  timerWheelTask() : omniTask(omniTask::AnyTime) {}
+  ~timerWheelTask() {}
+
+  void execute();
+
+  static void start();
+
+  static void terminate();
+  // Stop the task, then cancel every timer still pending, calling its
+  // stopped().
+
+  static omni_tracedmutex*     mutex;
+  static omni_tracedcondition* cond;
+  static CORBA::Boolean        running;
+
+  static void insert(omniTimer* t);
+  static void remove(omniTimer* t);
+  static void advance(CORBA::ULongLong to);
+  static CORBA::ULongLong nextEvent();
+
+  static omniTimer*       slots[LEVELS][LEVEL_SLOTS];
+  static CORBA::ULongLong occupied[LEVELS];
+  static CORBA::ULong     npending;
+
+  static CORBA::ULongLong current;
+  // Every timer due at or before this tick has expired.
+
+  static CORBA::ULongLong wakeAt;
+  // The tick the task is asleep until, NO_EVENT if it sleeps until
+  // signalled, or 0 if it is awake.
+
+private:
+  static CORBA::Boolean   shutdown;
+  static timerWheelTask*  theTask;
+
+  static omniTimer* take(int level, int index);
+  static void process(CORBA::ULongLong tick);
+};
+
+omni_tracedmutex*     timerWheelTask::mutex = 0;
+omni_tracedcondition* timerWheelTask::cond = 0;
+CORBA::Boolean        timerWheelTask::running = 0;
+omniTimer*            timerWheelTask::slots[LEVELS][LEVEL_SLOTS];
+CORBA::ULongLong      timerWheelTask::occupied[LEVELS];
+CORBA::ULong          timerWheelTask::npending = 0;
+CORBA::ULongLong      timerWheelTask::current = 0;
+CORBA::ULongLong      timerWheelTask::wakeAt = 0;
+CORBA::Boolean        timerWheelTask::shutdown = 0;
+timerWheelTask*       timerWheelTask::theTask = 0;
+
+
+void
+timerWheelTask::insert(omniTimer* t)
+{
+  // The timer's expiry must not be before <current>. It is only equal
+  // to it while the slots for the tick <current> are being processed.
+  CORBA::ULongLong expiry = t->pd_expiry;
+  CORBA::ULongLong delta  = expiry - current;
+
+  if (delta >= MAX_DELTA) {
+    delta  = MAX_DELTA - 1;
+    expiry = current + delta;
+  }
+  int level = 0;
+  while (delta >> (LEVEL_BITS * (level + 1)))
+    level++;
+
+  int index = (int)(expiry >> (LEVEL_BITS * level)) & LEVEL_MASK;
+
+  omniTimer** head = &slots[level][index];
+  t->pd_next = *head;
+  t->pd_prev = head;
+  if (*head)
+    (*head)->pd_prev = &t->pd_next;
+  *head = t;
+
+  t->pd_slot = level * LEVEL_SLOTS + index;
+  occupied[level] |= (CORBA::ULongLong)1 << index;
+  npending++;
+}
+
+void
+timerWheelTask::remove(omniTimer* t)
+{
+  *t->pd_prev = t->pd_next;
+  if (t->pd_next)
+    t->pd_next->pd_prev = t->pd_prev;
+
+  int level = t->pd_slot / LEVEL_SLOTS;
+  int index = t->pd_slot % LEVEL_SLOTS;
+  if (!slots[level][index])
+    occupied[level] &= ~((CORBA::ULongLong)1 << index);
+
+  t->pd_next = 0;
+  t->pd_prev = 0;
+  npending--;
+}
+
+omniTimer*
+timerWheelTask::take(int level, int index)
+{
+  // Empty a slot, returning its timers. They still look pending.
+  omniTimer* list = slots[level][index];
+  slots[level][index] = 0;
+  occupied[level] &= ~((CORBA::ULongLong)1 << index);
+  return list;
+}
+
+CORBA::ULongLong
+timerWheelTask::nextEvent()
+{
+  // The first tick after <current> at which a slot with timers in it
+  // is reached.
+  CORBA::ULongLong next = NO_EVENT;
+
+  for (int level = 0; level < LEVELS; level++) {
+    if (!occupied[level])
+      continue;
+
+    int shift = LEVEL_BITS * level;
+    CORBA::ULongLong slot = (current >> shift) + 1;
+    CORBA::ULongLong bits = rotateRight(occupied[level],
+					(int)(slot & LEVEL_MASK));
+    CORBA::ULongLong tick = (slot + lowestBit(bits)) << shift;
+    if (tick < next)
+      next = tick;
+  }
+  return next;
+}
+
+void
+timerWheelTask::process(CORBA::ULongLong tick)
+{
+  current = tick;
+
+  // Move down the timers of each level whose slot starts at this tick.
+  for (int level = 1; level < LEVELS; level++) {
+    int shift = LEVEL_BITS * level;
+    if (tick & (((CORBA::ULongLong)1 << shift) - 1))
+      break;
+
+    omniTimer* t = take(level, (int)(tick >> shift) & LEVEL_MASK);
+    while (t) {
+      omniTimer* next = t->pd_next;
+      npending--;
+      insert(t);
+      t = next;
+    }
+  }
+
+  // Expire the timers due now.
+  omniTimer* t = take(0, (int)tick & LEVEL_MASK);
+  while (t) {
+    omniTimer* next = t->pd_next;
+    t->pd_next = 0;
+    t->pd_prev = 0;
+    npending--;
+    t->expire();
+    t = next;
+  }
+}
+
+void
+timerWheelTask::advance(CORBA::ULongLong to)
+{
+  while (1) {
+    CORBA::ULongLong tick = nextEvent();
+    if (tick > to)
+      break;
+    process(tick);
+  }
+  if (to > current)
+    current = to;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//             Task                                                       //
+////////////////////////////////////////////////////////////////////////////
+
+void
+timerWheelTask::execute()
+{
+  omniORB::logs(25, "Timer wheel task execute.");
+
+  {
+    omni_tracedmutex_lock sync(*mutex);
+
+    while (!shutdown) {
+      wakeAt = 0;
+      advance(nowTicks());
+
+      CORBA::ULongLong next = nextEvent();
+      wakeAt = next;
+      if (next == NO_EVENT)
+	cond->wait();
+      else
+	cond->timedwait((unsigned long)(next / 1000),
+			(unsigned long)(next % 1000) * 1000000);
+    }
+    theTask = 0;
+    cond->broadcast();
+  }
+  delete this;
+}
+
+void
+timerWheelTask::start()
+{
+  if (!mutex) {
+    mutex = new omni_tracedmutex();
+    cond  = new omni_tracedcondition(mutex);
+  }
+  omni_tracedmutex_lock sync(*mutex);
+  shutdown = 0;
+  if (!theTask) {
+    current = nowTicks();
+    theTask = new timerWheelTask();
+    if (!orbAsyncInvoker->insert(theTask)) {
+      delete theTask;
+      theTask = 0;
+      omniORB::logs(1, "Unable to start the timer wheel task. Idle "
+		    "connections will not be closed.");
+      return;
+    }
+  }
+  running = 1;
+}
+
+void
+timerWheelTask::terminate()
+{
+  if (!mutex)
+    return;
+
+  omni_tracedmutex_lock sync(*mutex);
+  running  = 0;
+  shutdown = 1;
+  if (theTask) {
+    cond->broadcast();
+    while (theTask)
+      cond->wait();
+  }
+
+  // Cancel whatever is left. Call deadlines must not be cut short, so
+  // the timers are not expired, but each is told that the wheel has
+  // stopped, so that no thread waits for a timer that would never go
+  // off. A timer that cannot get the lock it needs reschedules itself,
+  // so release ours to let its holder carry on.
+  while (npending) {
+    for (int level = 0; level < LEVELS; level++) {
+      while (occupied[level]) {
+	omniTimer* t = take(level, lowestBit(occupied[level]));
+	while (t) {
+	  omniTimer* next = t->pd_next;
+	  t->pd_next = 0;
+	  t->pd_prev = 0;
+	  npending--;
+	  t->stopped();
+	  t = next;
+	}
+      }
+    }
+    if (npending) {
+      mutex->unlock();
+      omni_thread::yield();
+      mutex->lock();
+    }
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//             omniTimerWheel                                             //
+////////////////////////////////////////////////////////////////////////////
+
+CORBA::Boolean
+omniTimerWheel::schedule(omniTimer* t, CORBA::ULong msecs)
+{
+  unsigned long secs, nanosecs;
+  omni_thread::get_time(&secs, &nanosecs, msecs / 1000,
+			(msecs % 1000) * 1000000);
+  return scheduleAt(t, secs, nanosecs);
+}
+
+CORBA::Boolean
+omniTimerWheel::scheduleAt(omniTimer* t,
+			   unsigned long secs, unsigned long nanosecs)
+{
+  if (!timerWheelTask::mutex)
+    return 0;
+
+  omni_tracedmutex_lock sync(*timerWheelTask::mutex);
+
+  if (!timerWheelTask::running)
+    return 0;
+
+  if (t->pd_prev)
+    timerWheelTask::remove(t);
+
+  if (!timerWheelTask::npending && timerWheelTask::wakeAt == NO_EVENT) {
+    // The task may have been asleep for a long time. With nothing in
+    // the wheel, it can catch up without looking at any slots.
+    CORBA::ULongLong now = nowTicks();
+    if (now > timerWheelTask::current)
+      timerWheelTask::current = now;
+  }
+
+  CORBA::ULongLong expiry = toTicks(secs, nanosecs);
+  if (expiry <= timerWheelTask::current)
+    expiry = timerWheelTask::current + 1;
+  t->pd_expiry = expiry;
+  timerWheelTask::insert(t);
+
+  if (expiry < timerWheelTask::wakeAt)
+    timerWheelTask::cond->signal();
+
+  return 1;
+}
+
+CORBA::Boolean
+omniTimerWheel::cancel(omniTimer* t)
+{
+  if (!timerWheelTask::mutex)
+    return 0;
+
+  omni_tracedmutex_lock sync(*timerWheelTask::mutex);
+
+  if (!t->pd_prev)
+    return 0;
+
+  timerWheelTask::remove(t);
+  return 1;
+}
+
+CORBA::ULongLong
+omniTimerWheel::now()
+{
+  return nowTicks();
+}
+
+void
+omniTimerWheel::reschedule(omniTimer* t, CORBA::ULong msecs)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(*timerWheelTask::mutex, 1);
+  OMNIORB_ASSERT(!t->pd_prev);
+
+  t->pd_expiry = timerWheelTask::current + (msecs ? msecs : 1);
+  timerWheelTask::insert(t);
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+//             Waiting                                                    //
+////////////////////////////////////////////////////////////////////////////
+
+class condTimer : public omniTimer {
+public:
+  condTimer(omni_tracedcondition& cond, omni_tracedmutex& mutex)
+    : pd_cond(cond), pd_mutex(mutex), pd_expired(0) {}
+
+  void expire() {
+    if (!pd_mutex.trylock()) {
+      omniTimerWheel::reschedule(this, 1);
+      return;
+    }
+    pd_expired = 1;
+    pd_cond.broadcast();
+    pd_mutex.unlock();
+  }
+
+  void stopped() {
+    // Wake the waiter without timing it out. timedwait() then reports
+    // a wakeup, and its caller waits again without the wheel.
+    if (!pd_mutex.trylock()) {
+      omniTimerWheel::reschedule(this, 1);
+      return;
+    }
+    pd_cond.broadcast();
+    pd_mutex.unlock();
+  }
+
+  CORBA::Boolean expired() const { return pd_expired; }
+
+private:
+  omni_tracedcondition& pd_cond;
+  omni_tracedmutex&     pd_mutex;
+  CORBA::Boolean        pd_expired;
+};
+
+int
+omniTimerWheel::timedwait(omni_tracedcondition& cond, omni_tracedmutex& mutex,
+			  unsigned long secs, unsigned long nanosecs)
+{
+  ASSERT_OMNI_TRACEDMUTEX_HELD(mutex, 1);
+
+  unsigned long now_secs, now_nanosecs;
+  omni_thread::get_time(&now_secs, &now_nanosecs);
+  if (secs < now_secs || (secs == now_secs && nanosecs <= now_nanosecs))
+    return 0;
+
+  condTimer t(cond, mutex);
+  if (!scheduleAt(&t, secs, nanosecs))
+    return cond.timedwait(secs, nanosecs);
+
+  // The timer cannot expire before we are waiting, since it needs the
+  // mutex to do so.
+  cond.wait();
+  cancel(&t);
+  return !t.expired();
+}
+
+void
+omniTimerWheel::sleep(CORBA::ULong msecs)
+{
+  omni_tracedmutex     mutex;
+  omni_tracedcondition cond(&mutex);
+
+  unsigned long secs, nanosecs;
+  omni_thread::get_time(&secs, &nanosecs, msecs / 1000,
+			(msecs % 1000) * 1000000);
+
+  omni_tracedmutex_lock sync(mutex);
+  while (timedwait(cond, mutex, secs, nanosecs)) {
+    // Woken without timing out, which only happens when the timer
+    // wheel stops.
+    if (!timerWheelTask::mutex)
+      break;
+    omni_tracedmutex_lock wsync(*timerWheelTask::mutex);
+    if (!timerWheelTask::running)
+      break;
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//            Module initialiser                                           //
+/////////////////////////////////////////////////////////////////////////////
+
+class omni_timerWheel_initialiser : public omniInitialiser {
+public:
+
+  void attach() {
+    timerWheelTask::start();
+  }
+
+  void detach() {
+    omniORB::logs(25, "Terminate timer wheel.");
+    timerWheelTask::terminate();
+  }
+};
+
+static omni_timerWheel_initialiser initialiser;
+
+omniInitialiser& omni_timerWheel_initialiser_ = initialiser;
+
+OMNI_NAMESPACE_END(omni)
@@ -195,6 +195,44 @@ omni_tracedmutex::lock()
 }
 
 
+int
+omni_tracedmutex::trylock()
+{
+  if( pd_deleted ) {
+    {
+      omniORB::logger log;
+      log << "Assertion failed -- attempt to lock deleted mutex.\n"
+	  << bug_msg;
+    }
+    BOMB_OUT();
+  }
+
+  omni_thread* me = omni_thread::self();
+
+  omni_mutex_lock sync(pd_lock);
+
+  if( me && pd_holder == me ) {
+    {
+      omniORB::logger log;
+      log << "Assertion failed -- attempt to lock mutex when already held.\n"
+	  << bug_msg;
+    }
+    BOMB_OUT();
+  }
+
+  if( pd_holder )  return 0;
+
+  pd_holder = me ? me : (omni_thread*) 1;
+
+  if (pd_logname) {
+    omniORB::logger l;
+    l << pd_logname << ": thread " << (me ? me->id() : -1)
+      << " locks with trylock()\n";
+  }
+  return 1;
+}
+
+
 void
 omni_tracedmutex::unlock()
 {
@@ -254,7 +254,8 @@ public:
 
   CORBA::Boolean match(const char* endpoint) { 
 
-    if (strncmp(endpoint,"giop:unix",9) == 0) return 1;
+    if (strncmp(endpoint,"giop:unix",9) == 0 ||
+        strncmp(endpoint,"giop:shm",8) == 0) return 1;
 
     // Otherwise, we want to check if this endpoint matches one of our
     // addresses.
@@ -291,7 +292,8 @@ public:
 
   CORBA::Boolean match(const char* endpoint) { 
 
-    if (strncmp(endpoint,"giop:unix",9) == 0) {
+    if (strncmp(endpoint,"giop:unix",9) == 0 ||
+        strncmp(endpoint,"giop:shm",8) == 0) {
       // local transport. Does this rule apply to this host's 
       // IP address(es)? 
       const omnivector<const char*>* ifaddrs;
@@ -376,7 +378,8 @@ public:
 
   CORBA::Boolean match(const char* endpoint)
   {
-    if (strncmp(endpoint,"giop:unix",9) == 0) {
+    if (strncmp(endpoint,"giop:unix",9) == 0 ||
+        strncmp(endpoint,"giop:shm",8) == 0) {
       // local transport. Does this rule apply to this host's 
       // IP address(es)? 
       const omnivector<const char*>* ifaddrs;
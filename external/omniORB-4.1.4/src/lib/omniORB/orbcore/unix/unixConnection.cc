@@ -102,41 +102,9 @@ unixConnection::Send(void* buf, size_t sz,
 
   do {
 
-    struct timeval t;
-
-    if (deadline_secs || deadline_nanosecs) {
-      SocketSetTimeOut(deadline_secs,deadline_nanosecs,t);
-      if (t.tv_sec == 0 && t.tv_usec == 0) {
-	// Already timeout.
-	return 0;
-      }
-      else {
-#if defined(USE_POLL)
-	struct pollfd fds;
-	fds.fd = pd_socket;
-	fds.events = POLLOUT;
-	tx = poll(&fds,1,t.tv_sec*1000+(t.tv_usec/1000));
-#else
-	fd_set fds, efds;
-	FD_ZERO(&fds);
-	FD_ZERO(&efds);
-	FD_SET(pd_socket,&fds);
-	FD_SET(pd_socket,&efds);
-	tx = select(pd_socket+1,0,&fds,&efds,&t);
-#endif
-	if (tx == 0) {
-	  // Time out!
-	  return 0;
-	}
-	else if (tx == RC_SOCKET_ERROR) {
-	  if (ERRNO == RC_EINTR)
-	    continue;
-	  else {
-	    return -1;
-	  }
-	}
-      }
-    }
+    tx = waitWritable(deadline_secs,deadline_nanosecs);
+    if (tx <= 0)
+      return tx;
 
     // Reach here if we can write without blocking or we don't
     // care if we block here.
@@ -157,6 +125,58 @@ unixConnection::Send(void* buf, size_t sz,
 
 }
 
+#if defined(USE_WRITEV)
+/////////////////////////////////////////////////////////////////////////
+int
+unixConnection::Sendv(const SendBuffer* bufs, int count,
+		      unsigned long deadline_secs,
+		      unsigned long deadline_nanosecs) {
+
+  // Gather as many buffers as fit in one writev(), within the
+  // maxSocketSend limit.
+  struct iovec iov[16];
+  int    n = 0;
+  size_t total = 0;
+
+  for (int i=0; i < count && n < 16; i++) {
+    size_t sz = bufs[i].sz;
+    if (!sz) continue;
+    if (sz > orbParameters::maxSocketSend - total)
+      sz = orbParameters::maxSocketSend - total;
+    iov[n].iov_base = (char*)bufs[i].buf;
+    iov[n].iov_len  = sz;
+    n++;
+    total += sz;
+    if (total == orbParameters::maxSocketSend) break;
+  }
+
+  int tx;
+
+  do {
+
+    tx = waitWritable(deadline_secs,deadline_nanosecs);
+    if (tx <= 0)
+      return tx;
+
+    // Reach here if we can write without blocking or we don't
+    // care if we block here.
+    if ((tx = ::writev(pd_socket,iov,n)) == RC_SOCKET_ERROR) {
+      if (ERRNO == RC_EINTR)
+	continue;
+      else
+	return -1;
+    }
+    else if (tx == 0)
+      return -1;
+
+    break;
+
+  } while(1);
+
+  return tx;
+}
+#endif
+
 /////////////////////////////////////////////////////////////////////////
 int
 unixConnection::Recv(void* buf, size_t sz,
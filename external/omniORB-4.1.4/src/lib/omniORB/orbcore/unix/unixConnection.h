@@ -71,6 +71,12 @@ class unixConnection : public giopConnection, public SocketHolder {
 	   unsigned long deadline_secs = 0,
 	   unsigned long deadline_nanosecs = 0);
 
+#if defined(USE_WRITEV)
+  int Sendv(const SendBuffer* bufs, int count,
+	    unsigned long deadline_secs = 0,
+	    unsigned long deadline_nanosecs = 0);
+#endif
+
   void Shutdown();
 
   const char* myaddress();
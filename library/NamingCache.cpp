@@ -0,0 +1,533 @@
+#include "NamingCache.h"
+
+#include <exception>
+#include <ostream>
+
+#include <omniORB4/minorCode.h>
+
+// The exception handlers installed on cached references find their entry
+// through a Tag. The handlers stay installed for as long as the
+// references live, which may be longer than the cache, so tags are
+// never freed; the destructor only detaches them from the cache. There
+// is one tag per name ever cached.
+struct NamingCache::Tag
+{
+  std::mutex   lock;
+  NamingCache* cache;
+  std::string  key;
+};
+
+
+NamingCache::NamingCache(CosNaming::NamingContext_ptr root,
+                         const Options& options)
+  : pd_root(CosNaming::NamingContext::_duplicate(root)),
+    pd_options(options),
+    pd_stopping(false),
+    pd_hits(0), pd_staleHits(0), pd_misses(0),
+    pd_refreshes(0), pd_invalidations(0), pd_errors(0)
+{
+  unsigned threads = options.lookupThreads ? options.lookupThreads : 1;
+  for (unsigned i = 0; i < threads; i++)
+    pd_workers.emplace_back(&NamingCache::worker, this);
+}
+
+
+NamingCache::~NamingCache()
+{
+  {
+    std::lock_guard<std::mutex> l(pd_taskLock);
+    pd_stopping = true;
+  }
+  pd_taskReady.notify_all();
+  for (auto& t : pd_workers)
+    t.join();
+
+  for (auto& t : pd_tags) {
+    std::lock_guard<std::mutex> l(t.second->lock);
+    t.second->cache = 0;
+  }
+}
+
+
+CORBA::Object_ptr NamingCache::resolve(const CosNaming::Name& name)
+{
+  return lookup(toString(name), name);
+}
+
+
+CORBA::Object_ptr NamingCache::resolve(const char* name)
+{
+  CosNaming::Name_var n = toName(name);
+  return resolve(n.in());
+}
+
+
+std::vector<CORBA::Object_var>
+NamingCache::resolve(const std::vector<CosNaming::Name>& names)
+{
+  std::vector<CORBA::Object_var> result(names.size());
+  std::vector<std::string>       keys(names.size());
+  std::vector<size_t>            missing;
+
+  {
+    std::lock_guard<std::mutex> l(pd_lock);
+    for (size_t i = 0; i < names.size(); i++) {
+      keys[i]   = toString(names[i]);
+      result[i] = cached(keys[i], names[i]);
+      if (CORBA::is_nil(result[i]))
+        missing.push_back(i);
+    }
+  }
+  if (missing.empty())
+    return result;
+
+  // CosNaming has no way to resolve several names in one call, so the
+  // lookups are spread over the worker threads, with this thread doing
+  // one of them itself.
+  std::mutex                        doneLock;
+  std::condition_variable           doneCond;
+  size_t                            pending = missing.size();
+  std::exception_ptr                failure;
+
+  auto resolveOne = [&](size_t i) {
+    CORBA::Object_var  obj;
+    std::exception_ptr ex;
+    try {
+      obj = lookup(keys[i], names[i]);
+    }
+    catch (CosNaming::NamingContext::NotFound&) {
+    }
+    catch (...) {
+      ex = std::current_exception();
+    }
+    std::lock_guard<std::mutex> l(doneLock);
+    result[i] = obj._retn();
+    if (ex && !failure)
+      failure = ex;
+    if (--pending == 0)
+      doneCond.notify_all();
+  };
+
+  for (size_t m = 1; m < missing.size(); m++) {
+    size_t i = missing[m];
+    submit([&resolveOne, i]() { resolveOne(i); });
+  }
+  resolveOne(missing[0]);
+
+  std::unique_lock<std::mutex> l(doneLock);
+  doneCond.wait(l, [&]() { return pending == 0; });
+
+  if (failure)
+    std::rethrow_exception(failure);
+
+  return result;
+}
+
+
+void NamingCache::invalidate(const CosNaming::Name& name)
+{
+  invalidate(toString(name));
+}
+
+
+void NamingCache::clear()
+{
+  std::lock_guard<std::mutex> l(pd_lock);
+  for (auto it = pd_entries.begin(); it != pd_entries.end(); ) {
+    Entry& e = it->second;
+    if (e.lookingUp || e.refreshing) {
+      e.ref = CORBA::Object::_nil();
+      e.narrowed.clear();
+      ++it;
+    }
+    else {
+      it = pd_entries.erase(it);
+    }
+  }
+}
+
+
+NamingCache::Stats NamingCache::stats() const
+{
+  Stats s;
+  s.hits          = pd_hits;
+  s.staleHits     = pd_staleHits;
+  s.misses        = pd_misses;
+  s.refreshes     = pd_refreshes;
+  s.invalidations = pd_invalidations;
+  s.errors        = pd_errors;
+  return s;
+}
+
+
+// Stringified names follow the Interoperable Naming Service: components
+// are separated by '/', the id and kind by '.', and '\' escapes the
+// next character.
+
+CosNaming::Name* NamingCache::toName(const char* sn)
+{
+  if (!sn || !*sn)
+    throw CosNaming::NamingContext::InvalidName();
+
+  CosNaming::Name_var name = new CosNaming::Name;
+  std::string id, kind;
+  bool        inKind = false;
+
+  for (const char* p = sn; ; p++) {
+    char c = *p;
+
+    if (c == '\\') {
+      if (!*++p)
+        throw CosNaming::NamingContext::InvalidName();
+      (inKind ? kind : id) += *p;
+    }
+    else if (c == '/' || c == '\0') {
+      if (id.empty() && !inKind)
+        throw CosNaming::NamingContext::InvalidName();
+
+      CORBA::ULong len = name->length();
+      name->length(len + 1);
+      name[len].id   = id.c_str();
+      name[len].kind = kind.c_str();
+
+      if (c == '\0')
+        break;
+      id.clear();
+      kind.clear();
+      inKind = false;
+    }
+    else if (c == '.') {
+      if (inKind)
+        throw CosNaming::NamingContext::InvalidName();
+      inKind = true;
+    }
+    else {
+      (inKind ? kind : id) += c;
+    }
+  }
+  return name._retn();
+}
+
+
+static void escape(std::string& out, const char* s)
+{
+  for (; *s; s++) {
+    if (*s == '/' || *s == '.' || *s == '\\')
+      out += '\\';
+    out += *s;
+  }
+}
+
+
+std::string NamingCache::toString(const CosNaming::Name& name)
+{
+  std::string s;
+  for (CORBA::ULong i = 0; i < name.length(); i++) {
+    if (i)
+      s += '/';
+    const char* id   = name[i].id;
+    const char* kind = name[i].kind;
+    escape(s, id);
+    if (*kind || !*id) {
+      s += '.';
+      escape(s, kind);
+    }
+  }
+  return s;
+}
+
+
+// Return the cached reference for key if it can still be used, or nil.
+// A stale entry is queued for a background lookup. Called with pd_lock
+// held.
+
+CORBA::Object_ptr NamingCache::cached(const std::string&     key,
+                                      const CosNaming::Name& name)
+{
+  auto it = pd_entries.find(key);
+  if (it == pd_entries.end() || CORBA::is_nil(it->second.ref))
+    return CORBA::Object::_nil();
+
+  Entry& e   = it->second;
+  auto   age = Clock::now() - e.fetched;
+
+  if (age >= pd_options.ttl + pd_options.stale)
+    return CORBA::Object::_nil();
+
+  if (age >= pd_options.ttl) {
+    pd_staleHits++;
+    if (!e.refreshing && !e.lookingUp) {
+      e.refreshing = true;
+      submit([this, key, name]() { refresh(key, name); });
+    }
+  }
+  pd_hits++;
+  return CORBA::Object::_duplicate(e.ref);
+}
+
+
+CORBA::Object_ptr NamingCache::lookup(const std::string&     key,
+                                      const CosNaming::Name& name)
+{
+  {
+    std::unique_lock<std::mutex> l(pd_lock);
+    for (;;) {
+      CORBA::Object_ptr obj = cached(key, name);
+      if (!CORBA::is_nil(obj))
+        return obj;
+
+      Entry& e = pd_entries[key];
+      if (!e.lookingUp) {
+        e.lookingUp = true;
+        break;
+      }
+      // Another thread is looking the name up; use its answer.
+      pd_lookupDone.wait(l);
+    }
+  }
+  pd_misses++;
+
+  Clock::time_point started = Clock::now();
+  CORBA::Object_var obj;
+  try {
+    obj = pd_root->resolve(name);
+  }
+  catch (...) {
+    pd_errors++;
+    std::lock_guard<std::mutex> l(pd_lock);
+    auto it = pd_entries.find(key);
+    if (it != pd_entries.end()) {
+      it->second.lookingUp = false;
+      if (CORBA::is_nil(it->second.ref) && !it->second.refreshing)
+        pd_entries.erase(it);
+    }
+    pd_lookupDone.notify_all();
+    throw;
+  }
+  store(key, obj, started);
+  return obj._retn();
+}
+
+
+CORBA::Object_ptr NamingCache::resolveNarrowed(const CosNaming::Name& name,
+                                               const char*            repoId,
+                                               Narrower               narrow)
+{
+  std::string       key = toString(name);
+  CORBA::Object_var obj = lookup(key, name);
+
+  {
+    std::lock_guard<std::mutex> l(pd_lock);
+    auto it = pd_entries.find(key);
+    if (it != pd_entries.end() && it->second.ref.in() == obj.in()) {
+      auto n = it->second.narrowed.find(repoId);
+      if (n != it->second.narrowed.end())
+        return CORBA::Object::_duplicate(n->second);
+    }
+  }
+
+  // Narrowing may need a remote _is_a(), so it is done without the lock.
+  // The narrowed reference is a different object reference, and needs
+  // the exception handlers installing too.
+  CORBA::Object_var narrowed = narrow(obj);
+  if (!CORBA::is_nil(narrowed))
+    watch(key, narrowed);
+
+  std::lock_guard<std::mutex> l(pd_lock);
+  auto it = pd_entries.find(key);
+  if (it != pd_entries.end() && it->second.ref.in() == obj.in())
+    it->second.narrowed[repoId] = CORBA::Object::_duplicate(narrowed);
+
+  return narrowed._retn();
+}
+
+
+// Record the result of a lookup begun at started, unless a later lookup
+// has already been recorded, and clear the entry's lookingUp flag.
+
+void NamingCache::store(const std::string& key, CORBA::Object_ptr obj,
+                        Clock::time_point started)
+{
+  // The handlers go on before anyone else can see the reference.
+  watch(key, obj);
+
+  {
+    std::lock_guard<std::mutex> l(pd_lock);
+    Entry& e = pd_entries[key];
+    e.lookingUp = false;
+
+    if (CORBA::is_nil(e.ref) || e.fetched <= started) {
+      // Keep the reference callers already have if the binding has not
+      // changed, so the narrowed references stay valid.
+      if (CORBA::is_nil(e.ref) || !e.ref->_is_equivalent(obj)) {
+        e.ref = CORBA::Object::_duplicate(obj);
+        e.narrowed.clear();
+      }
+      e.fetched = started;
+    }
+  }
+  pd_lookupDone.notify_all();
+}
+
+
+void NamingCache::refresh(const std::string& key, const CosNaming::Name& name)
+{
+  Clock::time_point started = Clock::now();
+  CORBA::Object_var obj;
+  try {
+    obj = pd_root->resolve(name);
+    pd_refreshes++;
+  }
+  catch (CosNaming::NamingContext::NotFound&) {
+    // The name has been unbound.
+    pd_refreshes++;
+    std::lock_guard<std::mutex> l(pd_lock);
+    auto it = pd_entries.find(key);
+    if (it != pd_entries.end()) {
+      if (it->second.lookingUp) {
+        it->second.refreshing = false;
+      }
+      else {
+        pd_entries.erase(it);
+      }
+    }
+    return;
+  }
+  catch (...) {
+    // Keep serving the stale entry until it expires; the next hit on
+    // it tries again.
+    pd_errors++;
+    std::lock_guard<std::mutex> l(pd_lock);
+    auto it = pd_entries.find(key);
+    if (it != pd_entries.end())
+      it->second.refreshing = false;
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> l(pd_lock);
+    auto it = pd_entries.find(key);
+    if (it == pd_entries.end())
+      return;
+    it->second.refreshing = false;
+
+    // store() clears lookingUp, which belongs to another thread.
+    if (it->second.lookingUp)
+      return;
+    it->second.lookingUp = true;
+  }
+  store(key, obj, started);
+}
+
+
+void NamingCache::invalidate(const std::string& key)
+{
+  std::lock_guard<std::mutex> l(pd_lock);
+  auto it = pd_entries.find(key);
+  if (it == pd_entries.end() || CORBA::is_nil(it->second.ref))
+    return;
+
+  pd_invalidations++;
+  Entry& e = it->second;
+  if (e.lookingUp || e.refreshing) {
+    e.ref = CORBA::Object::_nil();
+    e.narrowed.clear();
+  }
+  else {
+    pd_entries.erase(it);
+  }
+}
+
+
+void NamingCache::watch(const std::string& key, CORBA::Object_ptr obj)
+{
+  if (CORBA::is_nil(obj))
+    return;
+
+  Tag* tag;
+  {
+    std::lock_guard<std::mutex> l(pd_lock);
+    Tag*& t = pd_tags[key];
+    if (!t) {
+      t = new Tag;
+      t->cache = this;
+      t->key   = key;
+    }
+    tag = t;
+  }
+  omniORB::installTransientExceptionHandler(obj, tag, transientHandler);
+  omniORB::installSystemExceptionHandler(obj, tag, systemHandler);
+}
+
+
+CORBA::Boolean NamingCache::transientHandler(void* cookie,
+                                             CORBA::ULong retries,
+                                             const CORBA::TRANSIENT& ex)
+{
+  Tag* tag = (Tag*)cookie;
+  {
+    std::lock_guard<std::mutex> l(tag->lock);
+    if (tag->cache)
+      tag->cache->invalidate(tag->key);
+  }
+
+  // As omniORB's default handler, retry a reference that has been
+  // forwarded, since it falls back to the original location.
+  if (ex.minor() == omni::TRANSIENT_FailedOnForwarded) {
+    unsigned long secs = retries < 30 ? retries : 30;
+    if (secs)
+      omni_thread::sleep(secs, 0);
+    return 1;
+  }
+  return 0;
+}
+
+
+CORBA::Boolean NamingCache::systemHandler(void* cookie, CORBA::ULong,
+                                          const CORBA::SystemException& ex)
+{
+  if (CORBA::OBJECT_NOT_EXIST::_downcast(&ex)) {
+    Tag* tag = (Tag*)cookie;
+    std::lock_guard<std::mutex> l(tag->lock);
+    if (tag->cache)
+      tag->cache->invalidate(tag->key);
+  }
+  return 0;
+}
+
+
+void NamingCache::submit(std::function<void()> task)
+{
+  {
+    std::lock_guard<std::mutex> l(pd_taskLock);
+    pd_tasks.push_back(std::move(task));
+  }
+  pd_taskReady.notify_one();
+}
+
+
+void NamingCache::worker()
+{
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> l(pd_taskLock);
+      pd_taskReady.wait(l, [this]() { return pd_stopping || !pd_tasks.empty(); });
+      if (pd_stopping)
+        return;
+      task = std::move(pd_tasks.front());
+      pd_tasks.pop_front();
+    }
+    task();
+  }
+}
+
+
+std::ostream& operator<<(std::ostream& os, const NamingCache::Stats& s)
+{
+  return os << "hits " << s.hits << " (stale " << s.staleHits << ")"
+            << ", misses " << s.misses
+            << ", refreshes " << s.refreshes
+            << ", invalidations " << s.invalidations
+            << ", errors " << s.errors;
+}
@@ -0,0 +1,194 @@
+// A caching client for the CORBA naming service.
+//
+// NamingCache remembers the object references that names resolve to, so
+// that a client which looks the same names up again and again only goes
+// to the naming service when it has to:
+//
+//  - An entry younger than the TTL is returned straight from the cache.
+//
+//  - An entry older than the TTL is still returned, but is looked up
+//    again in the background, so that a change of binding is picked up
+//    without callers waiting for it. Once an entry is older than the TTL
+//    plus the stale period, callers wait for a fresh lookup instead.
+//
+//  - References handed out by the cache have exception handlers
+//    installed. If a call on one raises TRANSIENT or OBJECT_NOT_EXIST,
+//    the entry is dropped, so the next resolve() looks the name up again
+//    and finds the object's new reference if it has been restarted.
+//
+//  - Threads missing on the same name share one lookup, and a vector of
+//    names is resolved with the lookups it needs running concurrently.
+//
+// Names may be given as CosNaming::Name or in the stringified form of
+// the Interoperable Naming Service, e.g. "test.my_context/Echo.Object".
+//
+// Hit and miss counts are available from stats().
+//
+// A NamingCache must be destroyed before the ORB is. References it has
+// handed out stay valid afterwards, but no longer invalidate anything.
+
+#ifndef NAMING_CACHE_H
+#define NAMING_CACHE_H
+
+#include <omniORB4/CORBA.h>
+#include <omniORB4/Naming.hh>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class NamingCache
+{
+public:
+  struct Options
+  {
+    // Entries older than this are looked up again in the background.
+    std::chrono::milliseconds ttl;
+
+    // Entries older than ttl + stale are looked up again before use.
+    std::chrono::milliseconds stale;
+
+    // Threads doing background and batched lookups.
+    unsigned lookupThreads;
+
+    Options()
+      : ttl(std::chrono::seconds(30)), stale(std::chrono::seconds(300)),
+        lookupThreads(4)
+    {}
+  };
+
+  struct Stats
+  {
+    uint64_t hits;          // answered from the cache
+    uint64_t staleHits;     // of those, answered with an entry past its TTL
+    uint64_t misses;        // had to wait for a lookup
+    uint64_t refreshes;     // background lookups done
+    uint64_t invalidations; // entries dropped after a failed call
+    uint64_t errors;        // lookups that failed
+  };
+
+  explicit NamingCache(CosNaming::NamingContext_ptr root,
+                       const Options& options = Options());
+  ~NamingCache();
+
+  NamingCache(const NamingCache&) = delete;
+  NamingCache& operator=(const NamingCache&) = delete;
+
+  // Return a new reference to the object bound to the name. Raises the
+  // same exceptions as NamingContext::resolve when the name has to be
+  // looked up.
+  CORBA::Object_ptr resolve(const CosNaming::Name& name);
+  CORBA::Object_ptr resolve(const char* name);
+
+  // As above, narrowed to T. The narrowed reference is cached too, so
+  // that narrowing does not cost a remote _is_a() each time. Returns nil
+  // if the object is not a T.
+  template <class T>
+  typename T::_ptr_type resolve(const CosNaming::Name& name)
+  {
+    CORBA::Object_var obj = resolveNarrowed(name, T::_PD_repoId,
+                                            &narrowTo<T>);
+    return T::_narrow(obj);
+  }
+
+  template <class T>
+  typename T::_ptr_type resolve(const char* name)
+  {
+    CosNaming::Name_var n = toName(name);
+    return resolve<T>(n.in());
+  }
+
+  // Resolve several names at once. The lookups needed are done
+  // concurrently. Names that are not bound give nil references; other
+  // errors are raised once all the lookups have finished.
+  std::vector<CORBA::Object_var>
+  resolve(const std::vector<CosNaming::Name>& names);
+
+  // Forget the entry for a name, or everything.
+  void invalidate(const CosNaming::Name& name);
+  void clear();
+
+  Stats stats() const;
+
+  // Conversions between a CosNaming::Name and its stringified form.
+  static CosNaming::Name* toName(const char* name);
+  static std::string      toString(const CosNaming::Name& name);
+
+private:
+  typedef std::chrono::steady_clock Clock;
+  typedef CORBA::Object_ptr (*Narrower)(CORBA::Object_ptr);
+
+  template <class T>
+  static CORBA::Object_ptr narrowTo(CORBA::Object_ptr obj)
+  {
+    return T::_narrow(obj);
+  }
+
+  struct Tag;
+
+  struct Entry
+  {
+    CORBA::Object_var ref;
+    Clock::time_point fetched;
+    bool              lookingUp;   // a thread is looking the name up
+    bool              refreshing;  // a background lookup is queued
+
+    // References narrowed from ref, by repository id.
+    std::unordered_map<std::string, CORBA::Object_var> narrowed;
+
+    Entry() : lookingUp(false), refreshing(false) {}
+  };
+
+  CORBA::Object_ptr cached(const std::string& key,
+                           const CosNaming::Name& name);
+  CORBA::Object_ptr lookup(const std::string& key,
+                           const CosNaming::Name& name);
+  CORBA::Object_ptr resolveNarrowed(const CosNaming::Name& name,
+                                    const char* repoId, Narrower narrow);
+  void store(const std::string& key, CORBA::Object_ptr obj,
+             Clock::time_point started);
+  void refresh(const std::string& key, const CosNaming::Name& name);
+  void invalidate(const std::string& key);
+  void watch(const std::string& key, CORBA::Object_ptr obj);
+  void submit(std::function<void()> task);
+  void worker();
+
+  static CORBA::Boolean transientHandler(void* cookie, CORBA::ULong retries,
+                                         const CORBA::TRANSIENT& ex);
+  static CORBA::Boolean systemHandler(void* cookie, CORBA::ULong retries,
+                                      const CORBA::SystemException& ex);
+
+  CosNaming::NamingContext_var pd_root;
+  Options                      pd_options;
+
+  mutable std::mutex                     pd_lock;
+  std::condition_variable                pd_lookupDone;
+  std::unordered_map<std::string, Entry> pd_entries;
+  std::unordered_map<std::string, Tag*>  pd_tags;
+
+  std::mutex                        pd_taskLock;
+  std::condition_variable           pd_taskReady;
+  std::deque<std::function<void()>> pd_tasks;
+  std::vector<std::thread>          pd_workers;
+  bool                              pd_stopping;
+
+  std::atomic<uint64_t> pd_hits;
+  std::atomic<uint64_t> pd_staleHits;
+  std::atomic<uint64_t> pd_misses;
+  std::atomic<uint64_t> pd_refreshes;
+  std::atomic<uint64_t> pd_invalidations;
+  std::atomic<uint64_t> pd_errors;
+};
+
+std::ostream& operator<<(std::ostream& os, const NamingCache::Stats& stats);
+
+#endif